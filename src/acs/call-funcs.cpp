@@ -370,6 +370,33 @@ static bool ACS_ActivatorIsLocal(ACSVM::Thread *thread)
 	return false;
 }
 
+/*--------------------------------------------------
+	static bool ACS_ThingTouchesSector(const mobj_t *mo, const sector_t *sec)
+
+		Helper function for ACS_SectorThingCounter.
+		Checks the sectors an object is touching.
+
+	Input Arguments:-
+		mo: The object to check.
+		sec: The sector to look for.
+
+	Return:-
+		true if the object touches the sector,
+		otherwise false.
+--------------------------------------------------*/
+static bool ACS_ThingTouchesSector(const mobj_t *mo, const sector_t *sec)
+{
+	for (msecnode_t *node = mo->touching_sectorlist; node; node = node->m_sectorlist_next) // sectors this thing touches
+	{
+		if (node->m_sector == sec)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /*--------------------------------------------------
 	static UINT32 ACS_SectorThingCounter(sector_t *sec, mtag_t thingTag, bool (*filter)(mobj_t *))
 
@@ -390,6 +417,34 @@ static UINT32 ACS_SectorThingCounter(sector_t *sec, mtag_t thingTag, bool (*filt
 {
 	UINT32 count = 0;
 
+	if (thingTag > 0)
+	{
+		// Few things share a tag, but a busy sector can be touched
+		// by hundreds. Walk the tag's hash chain instead.
+		mobj_t *mo = nullptr;
+
+		while ((mo = P_FindMobjFromTID(thingTag, mo, nullptr)) != nullptr)
+		{
+			if (ACS_ThingTouchesSector(mo, sec) == false)
+			{
+				continue;
+			}
+
+			if (mo->z > sec->ceilingheight
+				|| mo->z + mo->height < sec->floorheight)
+			{
+				continue;
+			}
+
+			if (filter(mo) == true)
+			{
+				count++;
+			}
+		}
+
+		return count;
+	}
+
 	for (msecnode_t *node = sec->touching_thinglist; node; node = node->m_thinglist_next) // things touching this sector
 	{
 		mobj_t *mo = node->m_thing;
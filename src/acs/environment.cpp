@@ -27,11 +27,13 @@
 #include "../w_wad.h"
 #include "../z_zone.h"
 #include "../p_local.h"
+#include "../i_system.h"
 #include "../k_dialogue.hpp"
 
 #include "environment.hpp"
 #include "thread.hpp"
 #include "call-funcs.hpp"
+#include "profile.hpp"
 #include "../cxxutil.hpp"
 
 using namespace srb2::acs;
@@ -61,50 +63,50 @@ Environment::Environment()
 	// - https://github.com/DavidPH/ACSVM/blob/master/ACSVM/CodeList.hpp
 
 	//  0 to 56: Implemented by ACSVM
-	addCodeDataACS0( 57, {"",        2, addCallFunc(CallFunc_Random)});
-	addCodeDataACS0( 58, {"WW",      0, addCallFunc(CallFunc_Random)});
-	addCodeDataACS0( 59, {"",        2, addCallFunc(CallFunc_ThingCount)});
-	addCodeDataACS0( 60, {"WW",      0, addCallFunc(CallFunc_ThingCount)});
-	addCodeDataACS0( 61, {"",        1, addCallFunc(CallFunc_TagWait)});
-	addCodeDataACS0( 62, {"W",       0, addCallFunc(CallFunc_TagWait)});
-	addCodeDataACS0( 63, {"",        1, addCallFunc(CallFunc_PolyWait)});
-	addCodeDataACS0( 64, {"W",       0, addCallFunc(CallFunc_PolyWait)});
-	addCodeDataACS0( 65, {"",        2, addCallFunc(CallFunc_ChangeFloor)});
-	addCodeDataACS0( 66, {"WWS",     0, addCallFunc(CallFunc_ChangeFloor)});
-	addCodeDataACS0( 67, {"",        2, addCallFunc(CallFunc_ChangeCeiling)});
-	addCodeDataACS0( 68, {"WWS",     0, addCallFunc(CallFunc_ChangeCeiling)});
+	addCodeDataACS0( 57, {"",        2, addCallFunc(CallFunc_Random, "Random")});
+	addCodeDataACS0( 58, {"WW",      0, addCallFunc(CallFunc_Random, "Random")});
+	addCodeDataACS0( 59, {"",        2, addCallFunc(CallFunc_ThingCount, "ThingCount")});
+	addCodeDataACS0( 60, {"WW",      0, addCallFunc(CallFunc_ThingCount, "ThingCount")});
+	addCodeDataACS0( 61, {"",        1, addCallFunc(CallFunc_TagWait, "TagWait")});
+	addCodeDataACS0( 62, {"W",       0, addCallFunc(CallFunc_TagWait, "TagWait")});
+	addCodeDataACS0( 63, {"",        1, addCallFunc(CallFunc_PolyWait, "PolyWait")});
+	addCodeDataACS0( 64, {"W",       0, addCallFunc(CallFunc_PolyWait, "PolyWait")});
+	addCodeDataACS0( 65, {"",        2, addCallFunc(CallFunc_ChangeFloor, "ChangeFloor")});
+	addCodeDataACS0( 66, {"WWS",     0, addCallFunc(CallFunc_ChangeFloor, "ChangeFloor")});
+	addCodeDataACS0( 67, {"",        2, addCallFunc(CallFunc_ChangeCeiling, "ChangeCeiling")});
+	addCodeDataACS0( 68, {"WWS",     0, addCallFunc(CallFunc_ChangeCeiling, "ChangeCeiling")});
 	// 69 to 79: Implemented by ACSVM
-	addCodeDataACS0( 80, {"",        0, addCallFunc(CallFunc_LineSide)});
+	addCodeDataACS0( 80, {"",        0, addCallFunc(CallFunc_LineSide, "LineSide")});
 	// 81 to 82: Implemented by ACSVM
-	addCodeDataACS0( 83, {"",        0, addCallFunc(CallFunc_ClearLineSpecial)});
+	addCodeDataACS0( 83, {"",        0, addCallFunc(CallFunc_ClearLineSpecial, "ClearLineSpecial")});
 	// 84 to 85: Implemented by ACSVM
-	addCodeDataACS0( 86, {"",        0, addCallFunc(CallFunc_EndPrint)});
+	addCodeDataACS0( 86, {"",        0, addCallFunc(CallFunc_EndPrint, "EndPrint")});
 	// 87 to 89: Implemented by ACSVM
-	addCodeDataACS0( 90, {"",        0, addCallFunc(CallFunc_PlayerCount)});
-	addCodeDataACS0( 91, {"",        0, addCallFunc(CallFunc_GameType)});
-	addCodeDataACS0( 92, {"",        0, addCallFunc(CallFunc_GameSpeed)});
-	addCodeDataACS0( 93, {"",        0, addCallFunc(CallFunc_Timer)});
-	addCodeDataACS0( 94, {"",        2, addCallFunc(CallFunc_SectorSound)});
-	addCodeDataACS0( 95, {"",        2, addCallFunc(CallFunc_AmbientSound)});
+	addCodeDataACS0( 90, {"",        0, addCallFunc(CallFunc_PlayerCount, "PlayerCount")});
+	addCodeDataACS0( 91, {"",        0, addCallFunc(CallFunc_GameType, "GameType")});
+	addCodeDataACS0( 92, {"",        0, addCallFunc(CallFunc_GameSpeed, "GameSpeed")});
+	addCodeDataACS0( 93, {"",        0, addCallFunc(CallFunc_Timer, "Timer")});
+	addCodeDataACS0( 94, {"",        2, addCallFunc(CallFunc_SectorSound, "SectorSound")});
+	addCodeDataACS0( 95, {"",        2, addCallFunc(CallFunc_AmbientSound, "AmbientSound")});
 
-	addCodeDataACS0( 97, {"",        4, addCallFunc(CallFunc_SetLineTexture)});
+	addCodeDataACS0( 97, {"",        4, addCallFunc(CallFunc_SetLineTexture, "SetLineTexture")});
 
-	addCodeDataACS0( 99, {"",        7, addCallFunc(CallFunc_SetLineSpecial)});
-	addCodeDataACS0(100, {"",        3, addCallFunc(CallFunc_ThingSound)});
-	addCodeDataACS0(101, {"",        0, addCallFunc(CallFunc_EndPrintBold)});
+	addCodeDataACS0( 99, {"",        7, addCallFunc(CallFunc_SetLineSpecial, "SetLineSpecial")});
+	addCodeDataACS0(100, {"",        3, addCallFunc(CallFunc_ThingSound, "ThingSound")});
+	addCodeDataACS0(101, {"",        0, addCallFunc(CallFunc_EndPrintBold, "EndPrintBold")});
 
-	addCodeDataACS0(118, {"",        0, addCallFunc(CallFunc_IsNetworkGame)});
-	addCodeDataACS0(119, {"",        0, addCallFunc(CallFunc_PlayerTeam)});
-	addCodeDataACS0(120, {"",        0, addCallFunc(CallFunc_PlayerRings)});
+	addCodeDataACS0(118, {"",        0, addCallFunc(CallFunc_IsNetworkGame, "IsNetworkGame")});
+	addCodeDataACS0(119, {"",        0, addCallFunc(CallFunc_PlayerTeam, "PlayerTeam")});
+	addCodeDataACS0(120, {"",        0, addCallFunc(CallFunc_PlayerRings, "PlayerRings")});
 
-	addCodeDataACS0(122, {"",        0, addCallFunc(CallFunc_PlayerScore)});
+	addCodeDataACS0(122, {"",        0, addCallFunc(CallFunc_PlayerScore, "PlayerScore")});
 
 	// 136 to 137: Implemented by ACSVM
 
 	// 157: Implemented by ACSVM
 
 	// 167 to 173: Implemented by ACSVM
-	addCodeDataACS0(174, {"BB",      0, addCallFunc(CallFunc_Random)});
+	addCodeDataACS0(174, {"BB",      0, addCallFunc(CallFunc_Random, "Random")});
 	// 175 to 179: Implemented by ACSVM
 
 	// 181 to 189: Implemented by ACSVM
@@ -113,15 +115,15 @@ Environment::Environment()
 
 	// 225 to 243: Implemented by ACSVM
 
-	addCodeDataACS0(247, {"",        0, addCallFunc(CallFunc_PlayerNumber)});
-	addCodeDataACS0(248, {"",        0, addCallFunc(CallFunc_ActivatorTID)});
+	addCodeDataACS0(247, {"",        0, addCallFunc(CallFunc_PlayerNumber, "PlayerNumber")});
+	addCodeDataACS0(248, {"",        0, addCallFunc(CallFunc_ActivatorTID, "ActivatorTID")});
 
 	// 253: Implemented by ACSVM
 
 	// 256 to 257: Implemented by ACSVM
 
 	// 263: Implemented by ACSVM
-	addCodeDataACS0(270, {"",        0, addCallFunc(CallFunc_EndLog)});
+	addCodeDataACS0(270, {"",        0, addCallFunc(CallFunc_EndLog, "EndLog")});
 	// 273 to 275: Implemented by ACSVM
 
 	// 291 to 325: Implemented by ACSVM
@@ -136,73 +138,100 @@ Environment::Environment()
 	// This style is preferred for added functions
 	// that aren't mimicing one from Hexen's or ZDoom's
 	// ACS implementations.
-	addFuncDataACS0(   1, addCallFunc(CallFunc_GetLineProperty));
-	addFuncDataACS0(   2, addCallFunc(CallFunc_SetLineProperty));
-	addFuncDataACS0(   3, addCallFunc(CallFunc_GetLineUserProperty));
-	addFuncDataACS0(   4, addCallFunc(CallFunc_GetSectorProperty));
-	addFuncDataACS0(   5, addCallFunc(CallFunc_SetSectorProperty));
-	addFuncDataACS0(   6, addCallFunc(CallFunc_GetSectorUserProperty));
-	addFuncDataACS0(   7, addCallFunc(CallFunc_GetSideProperty));
-	addFuncDataACS0(   8, addCallFunc(CallFunc_SetSideProperty));
-	addFuncDataACS0(   9, addCallFunc(CallFunc_GetSideUserProperty));
-	addFuncDataACS0(  10, addCallFunc(CallFunc_GetThingProperty));
-	addFuncDataACS0(  11, addCallFunc(CallFunc_SetThingProperty));
-	addFuncDataACS0(  12, addCallFunc(CallFunc_GetThingUserProperty));
-	//addFuncDataACS0(  13, addCallFunc(CallFunc_GetPlayerProperty));
-	//addFuncDataACS0(  14, addCallFunc(CallFunc_SetPlayerProperty));
-	//addFuncDataACS0(  15, addCallFunc(CallFunc_GetPolyobjProperty));
-	//addFuncDataACS0(  16, addCallFunc(CallFunc_SetPolyobjProperty));
-
-	addFuncDataACS0( 100, addCallFunc(CallFunc_strcmp));
-	addFuncDataACS0( 101, addCallFunc(CallFunc_strcasecmp));
-
-	addFuncDataACS0( 300, addCallFunc(CallFunc_CountEnemies));
-	addFuncDataACS0( 301, addCallFunc(CallFunc_CountPushables));
-	addFuncDataACS0( 302, addCallFunc(CallFunc_HaveUnlockableTrigger));
-	addFuncDataACS0( 303, addCallFunc(CallFunc_HaveUnlockable));
-	addFuncDataACS0( 304, addCallFunc(CallFunc_PlayerSkin));
-	addFuncDataACS0( 305, addCallFunc(CallFunc_GetObjectDye));
-	addFuncDataACS0( 306, addCallFunc(CallFunc_PlayerEmeralds));
-	addFuncDataACS0( 307, addCallFunc(CallFunc_PlayerLap));
-	addFuncDataACS0( 308, addCallFunc(CallFunc_LowestLap));
-	addFuncDataACS0( 309, addCallFunc(CallFunc_EncoreMode));
-	addFuncDataACS0( 310, addCallFunc(CallFunc_PrisonBreak));
-	addFuncDataACS0( 311, addCallFunc(CallFunc_TimeAttack));
-	addFuncDataACS0( 312, addCallFunc(CallFunc_ThingCount));
-	addFuncDataACS0( 313, addCallFunc(CallFunc_GrandPrix));
-	addFuncDataACS0( 314, addCallFunc(CallFunc_GetGrabbedSprayCan));
-	addFuncDataACS0( 315, addCallFunc(CallFunc_PlayerBot));
-	addFuncDataACS0( 316, addCallFunc(CallFunc_PositionStart));
-	addFuncDataACS0( 317, addCallFunc(CallFunc_FreePlay));
-	addFuncDataACS0( 318, addCallFunc(CallFunc_CheckTutorialChallenge));
-	addFuncDataACS0( 319, addCallFunc(CallFunc_PlayerLosing));
-	addFuncDataACS0( 320, addCallFunc(CallFunc_PlayerExiting));
-
-	addFuncDataACS0( 500, addCallFunc(CallFunc_CameraWait));
-	addFuncDataACS0( 501, addCallFunc(CallFunc_PodiumPosition));
-	addFuncDataACS0( 502, addCallFunc(CallFunc_PodiumFinish));
-	addFuncDataACS0( 503, addCallFunc(CallFunc_SetLineRenderStyle));
-	addFuncDataACS0( 504, addCallFunc(CallFunc_MapWarp));
-	addFuncDataACS0( 505, addCallFunc(CallFunc_AddBot));
-	addFuncDataACS0( 506, addCallFunc(CallFunc_StopLevelExit));
-	addFuncDataACS0( 507, addCallFunc(CallFunc_ExitLevel));
-	addFuncDataACS0( 508, addCallFunc(CallFunc_MusicPlay));
-	addFuncDataACS0( 509, addCallFunc(CallFunc_MusicStopAll));
-	addFuncDataACS0( 510, addCallFunc(CallFunc_MusicRemap));
-	addFuncDataACS0( 511, addCallFunc(CallFunc_Freeze));
-	addFuncDataACS0( 512, addCallFunc(CallFunc_MusicDim));
-
-	addFuncDataACS0( 600, addCallFunc(CallFunc_DialogueSetSpeaker));
-	addFuncDataACS0( 601, addCallFunc(CallFunc_DialogueSetCustomSpeaker));
-	addFuncDataACS0( 602, addCallFunc(CallFunc_DialogueNewText));
-	addFuncDataACS0( 603, addCallFunc(CallFunc_DialogueWaitDismiss));
-	addFuncDataACS0( 604, addCallFunc(CallFunc_DialogueWaitText));
-	addFuncDataACS0( 605, addCallFunc(CallFunc_DialogueAutoDismiss));
-
-	addFuncDataACS0( 700, addCallFunc(CallFunc_AddMessage));
-	addFuncDataACS0( 701, addCallFunc(CallFunc_AddMessageForPlayer));
-	addFuncDataACS0( 702, addCallFunc(CallFunc_ClearPersistentMessages));
-	addFuncDataACS0( 703, addCallFunc(CallFunc_ClearPersistentMessageForPlayer));
+	addFuncDataACS0(   1, addCallFunc(CallFunc_GetLineProperty, "GetLineProperty"));
+	addFuncDataACS0(   2, addCallFunc(CallFunc_SetLineProperty, "SetLineProperty"));
+	addFuncDataACS0(   3, addCallFunc(CallFunc_GetLineUserProperty, "GetLineUserProperty"));
+	addFuncDataACS0(   4, addCallFunc(CallFunc_GetSectorProperty, "GetSectorProperty"));
+	addFuncDataACS0(   5, addCallFunc(CallFunc_SetSectorProperty, "SetSectorProperty"));
+	addFuncDataACS0(   6, addCallFunc(CallFunc_GetSectorUserProperty, "GetSectorUserProperty"));
+	addFuncDataACS0(   7, addCallFunc(CallFunc_GetSideProperty, "GetSideProperty"));
+	addFuncDataACS0(   8, addCallFunc(CallFunc_SetSideProperty, "SetSideProperty"));
+	addFuncDataACS0(   9, addCallFunc(CallFunc_GetSideUserProperty, "GetSideUserProperty"));
+	addFuncDataACS0(  10, addCallFunc(CallFunc_GetThingProperty, "GetThingProperty"));
+	addFuncDataACS0(  11, addCallFunc(CallFunc_SetThingProperty, "SetThingProperty"));
+	addFuncDataACS0(  12, addCallFunc(CallFunc_GetThingUserProperty, "GetThingUserProperty"));
+	//addFuncDataACS0(  13, addCallFunc(CallFunc_GetPlayerProperty, "GetPlayerProperty"));
+	//addFuncDataACS0(  14, addCallFunc(CallFunc_SetPlayerProperty, "SetPlayerProperty"));
+	//addFuncDataACS0(  15, addCallFunc(CallFunc_GetPolyobjProperty, "GetPolyobjProperty"));
+	//addFuncDataACS0(  16, addCallFunc(CallFunc_SetPolyobjProperty, "SetPolyobjProperty"));
+
+	addFuncDataACS0( 100, addCallFunc(CallFunc_strcmp, "strcmp"));
+	addFuncDataACS0( 101, addCallFunc(CallFunc_strcasecmp, "strcasecmp"));
+
+	addFuncDataACS0( 300, addCallFunc(CallFunc_CountEnemies, "CountEnemies"));
+	addFuncDataACS0( 301, addCallFunc(CallFunc_CountPushables, "CountPushables"));
+	addFuncDataACS0( 302, addCallFunc(CallFunc_HaveUnlockableTrigger, "HaveUnlockableTrigger"));
+	addFuncDataACS0( 303, addCallFunc(CallFunc_HaveUnlockable, "HaveUnlockable"));
+	addFuncDataACS0( 304, addCallFunc(CallFunc_PlayerSkin, "PlayerSkin"));
+	addFuncDataACS0( 305, addCallFunc(CallFunc_GetObjectDye, "GetObjectDye"));
+	addFuncDataACS0( 306, addCallFunc(CallFunc_PlayerEmeralds, "PlayerEmeralds"));
+	addFuncDataACS0( 307, addCallFunc(CallFunc_PlayerLap, "PlayerLap"));
+	addFuncDataACS0( 308, addCallFunc(CallFunc_LowestLap, "LowestLap"));
+	addFuncDataACS0( 309, addCallFunc(CallFunc_EncoreMode, "EncoreMode"));
+	addFuncDataACS0( 310, addCallFunc(CallFunc_PrisonBreak, "PrisonBreak"));
+	addFuncDataACS0( 311, addCallFunc(CallFunc_TimeAttack, "TimeAttack"));
+	addFuncDataACS0( 312, addCallFunc(CallFunc_ThingCount, "ThingCount"));
+	addFuncDataACS0( 313, addCallFunc(CallFunc_GrandPrix, "GrandPrix"));
+	addFuncDataACS0( 314, addCallFunc(CallFunc_GetGrabbedSprayCan, "GetGrabbedSprayCan"));
+	addFuncDataACS0( 315, addCallFunc(CallFunc_PlayerBot, "PlayerBot"));
+	addFuncDataACS0( 316, addCallFunc(CallFunc_PositionStart, "PositionStart"));
+	addFuncDataACS0( 317, addCallFunc(CallFunc_FreePlay, "FreePlay"));
+	addFuncDataACS0( 318, addCallFunc(CallFunc_CheckTutorialChallenge, "CheckTutorialChallenge"));
+	addFuncDataACS0( 319, addCallFunc(CallFunc_PlayerLosing, "PlayerLosing"));
+	addFuncDataACS0( 320, addCallFunc(CallFunc_PlayerExiting, "PlayerExiting"));
+
+	addFuncDataACS0( 500, addCallFunc(CallFunc_CameraWait, "CameraWait"));
+	addFuncDataACS0( 501, addCallFunc(CallFunc_PodiumPosition, "PodiumPosition"));
+	addFuncDataACS0( 502, addCallFunc(CallFunc_PodiumFinish, "PodiumFinish"));
+	addFuncDataACS0( 503, addCallFunc(CallFunc_SetLineRenderStyle, "SetLineRenderStyle"));
+	addFuncDataACS0( 504, addCallFunc(CallFunc_MapWarp, "MapWarp"));
+	addFuncDataACS0( 505, addCallFunc(CallFunc_AddBot, "AddBot"));
+	addFuncDataACS0( 506, addCallFunc(CallFunc_StopLevelExit, "StopLevelExit"));
+	addFuncDataACS0( 507, addCallFunc(CallFunc_ExitLevel, "ExitLevel"));
+	addFuncDataACS0( 508, addCallFunc(CallFunc_MusicPlay, "MusicPlay"));
+	addFuncDataACS0( 509, addCallFunc(CallFunc_MusicStopAll, "MusicStopAll"));
+	addFuncDataACS0( 510, addCallFunc(CallFunc_MusicRemap, "MusicRemap"));
+	addFuncDataACS0( 511, addCallFunc(CallFunc_Freeze, "Freeze"));
+	addFuncDataACS0( 512, addCallFunc(CallFunc_MusicDim, "MusicDim"));
+
+	addFuncDataACS0( 600, addCallFunc(CallFunc_DialogueSetSpeaker, "DialogueSetSpeaker"));
+	addFuncDataACS0( 601, addCallFunc(CallFunc_DialogueSetCustomSpeaker, "DialogueSetCustomSpeaker"));
+	addFuncDataACS0( 602, addCallFunc(CallFunc_DialogueNewText, "DialogueNewText"));
+	addFuncDataACS0( 603, addCallFunc(CallFunc_DialogueWaitDismiss, "DialogueWaitDismiss"));
+	addFuncDataACS0( 604, addCallFunc(CallFunc_DialogueWaitText, "DialogueWaitText"));
+	addFuncDataACS0( 605, addCallFunc(CallFunc_DialogueAutoDismiss, "DialogueAutoDismiss"));
+
+	addFuncDataACS0( 700, addCallFunc(CallFunc_AddMessage, "AddMessage"));
+	addFuncDataACS0( 701, addCallFunc(CallFunc_AddMessageForPlayer, "AddMessageForPlayer"));
+	addFuncDataACS0( 702, addCallFunc(CallFunc_ClearPersistentMessages, "ClearPersistentMessages"));
+	addFuncDataACS0( 703, addCallFunc(CallFunc_ClearPersistentMessageForPlayer, "ClearPersistentMessageForPlayer"));
+}
+
+ACSVM::Word Environment::addCallFunc(ACSVM::CallFunc func, const char *name)
+{
+	ACSVM::Word idx = ACSVM::Environment::addCallFunc(func);
+
+	if (idx >= callFuncNames.size())
+	{
+		callFuncNames.resize(idx + 1, nullptr);
+	}
+
+	callFuncNames[idx] = name;
+	return idx;
+}
+
+bool Environment::callFunc(ACSVM::Thread *thread, ACSVM::Word func, const ACSVM::Word *argV, ACSVM::Word argC)
+{
+	if (g_profiling == false)
+	{
+		return ACSVM::Environment::callFunc(thread, func, argV, argC);
+	}
+
+	const precise_t start = I_GetPreciseTime();
+	const bool result = ACSVM::Environment::callFunc(thread, func, argV, argC);
+
+	ProfileCallFunc(func, (func < callFuncNames.size()) ? callFuncNames[func] : nullptr, I_GetPreciseTime() - start);
+	return result;
 }
 
 ACSVM::Thread *Environment::allocThread()
@@ -14,6 +14,8 @@
 #ifndef __SRB2_ACS_ENVIRONMENT_HPP__
 #define __SRB2_ACS_ENVIRONMENT_HPP__
 
+#include <vector>
+
 #include "acsvm.hpp"
 
 namespace srb2::acs {
@@ -34,10 +36,20 @@ public:
 
 	virtual void printKill(ACSVM::Thread *thread, ACSVM::Word type, ACSVM::Word data);
 
+	virtual bool callFunc(ACSVM::Thread *thread, ACSVM::Word func, const ACSVM::Word *argV, ACSVM::Word argC);
+
+	using ACSVM::Environment::addCallFunc;
+
+	// Same, but named for the profiler.
+	ACSVM::Word addCallFunc(ACSVM::CallFunc func, const char *name);
+
 protected:
 	virtual void loadModule(ACSVM::Module *module);
 
 	virtual ACSVM::ModuleName getModuleName(char const *str, std::size_t len);
+
+private:
+	std::vector<const char *> callFuncNames;
 };
 
 }
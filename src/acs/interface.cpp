@@ -35,6 +35,7 @@
 #include "environment.hpp"
 #include "thread.hpp"
 #include "stream.hpp"
+#include "profile.hpp"
 
 #include "../cxxutil.hpp"
 
@@ -90,6 +91,8 @@ void ACS_InvalidateMapScope(void)
 	// Conclude current map scope.
 	map = hub->getMapScope(0); // This is where you'd put in mapID if you add hub support.
 	map->reset();
+
+	ProfileForgetScripts();
 }
 
 /*--------------------------------------------------
@@ -394,6 +397,8 @@ void ACS_Tick(void)
 {
 	Environment *env = &ACSEnv;
 
+	ACS_ProfileTic();
+
 	if (env->hasActiveThread() == true)
 	{
 		env->exec();
@@ -233,6 +233,55 @@ void ACS_RunGameOverScript(void);
 void ACS_Tick(void);
 
 
+/*--------------------------------------------------
+	void ACS_ProfileTic(void);
+
+		Starts a new tic of profiling data, keeping
+		the last one for ACS_GetProfile. Profiling is
+		on while the perfstats overlay shows ACS, or
+		between "acsprofile start" and "acsprofile stop".
+--------------------------------------------------*/
+
+void ACS_ProfileTic(void);
+
+
+/*--------------------------------------------------
+	size_t ACS_GetProfile(acsprofileinfo_t *out, size_t max);
+
+		Gets what each script and function cost in the
+		last profiled tic, most expensive first.
+
+	Input Arguments:-
+		out: Array to fill.
+		max: Length of the array.
+
+	Return:-
+		Number of entries filled.
+--------------------------------------------------*/
+
+struct acsprofileinfo_t
+{
+	const char *name;	// Valid until "acsprofile start" clears the profile.
+	boolean callfunc;	// A CallFunc, rather than a script.
+	precise_t time;		// Inclusive of anything called.
+	UINT32 runs;		// Times a script resumed, or a function was called.
+	UINT32 codes;		// Instructions executed; scripts only.
+};
+
+size_t ACS_GetProfile(acsprofileinfo_t *out, size_t max);
+
+
+/*--------------------------------------------------
+	void ACS_Profile_f(void);
+
+		"acsprofile start" clears totals and begins
+		profiling; "acsprofile stop" ends it and saves
+		the totals to a file in srb2home.
+--------------------------------------------------*/
+
+void ACS_Profile_f(void);
+
+
 /*--------------------------------------------------
 	boolean ACS_Execute(const INT32 *args, size_t numArgs, const char *const *stringArgs, size_t numStringArgs, activator_t *activator);
 
@@ -0,0 +1,293 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  profile.cpp
+/// \brief Action Code Script: Per-script and per-function profiler
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "acsvm.hpp"
+
+#include "profile.hpp"
+#include "interface.h"
+
+#include "../doomtype.h"
+#include "../doomdef.h"
+#include "../command.h"
+#include "../d_main.h"
+#include "../d_netcmd.h"
+#include "../i_system.h"
+#include "../m_perfstats.h"
+
+using namespace srb2::acs;
+
+bool srb2::acs::g_profiling = false;
+
+namespace
+{
+
+struct ProfileCounts
+{
+	precise_t time = 0;
+	UINT64 runs = 0;
+	UINT64 codes = 0;
+};
+
+struct ProfileEntry
+{
+	std::string name;
+	bool callfunc = false;
+
+	ProfileCounts total;
+	ProfileCounts tic;
+	ProfileCounts lastTic;
+};
+
+bool g_profileCommand = false;
+
+// A deque, so that names stay put while it grows.
+std::deque<ProfileEntry> g_entries;
+std::unordered_map<std::string, ProfileEntry *> g_byName;
+std::unordered_map<const ACSVM::Script *, ProfileEntry *> g_byScript;
+std::vector<ProfileEntry *> g_byFunc;
+
+ProfileEntry *ProfileFind(const std::string &name, bool callfunc)
+{
+	auto it = g_byName.find(name);
+
+	if (it != g_byName.end())
+	{
+		return it->second;
+	}
+
+	ProfileEntry &entry = g_entries.emplace_back();
+	entry.name = name;
+	entry.callfunc = callfunc;
+	g_byName.emplace(name, &entry);
+	return &entry;
+}
+
+std::string ProfileScriptName(const ACSVM::Script *script)
+{
+	std::string name;
+
+	if (script->module->name.s != nullptr)
+	{
+		name = std::string(script->module->name.s->str) + ":";
+	}
+
+	if (script->name.s != nullptr && script->name.s->len)
+	{
+		name += "\"" + std::string(script->name.s->str) + "\"";
+	}
+	else
+	{
+		name += std::to_string((int)script->name.i);
+	}
+
+	return name;
+}
+
+void ProfileAdd(ProfileEntry *entry, precise_t time, UINT64 codes)
+{
+	entry->tic.time += time;
+	entry->tic.runs++;
+	entry->tic.codes += codes;
+
+	entry->total.time += time;
+	entry->total.runs++;
+	entry->total.codes += codes;
+}
+
+void ProfileClear()
+{
+	g_byFunc.clear();
+	g_byScript.clear();
+	g_byName.clear();
+	g_entries.clear();
+}
+
+bool ProfileSave(const char *path)
+{
+	const double precision = I_GetPrecisePrecision() / 1000.0;
+	std::vector<const ProfileEntry *> sorted;
+	FILE *f = fopen(path, "w");
+
+	if (f == nullptr)
+	{
+		return false;
+	}
+
+	for (const ProfileEntry &entry : g_entries)
+	{
+		sorted.push_back(&entry);
+	}
+
+	std::sort(
+		sorted.begin(), sorted.end(),
+		[](const ProfileEntry *a, const ProfileEntry *b) { return a->total.time > b->total.time; }
+	);
+
+	fprintf(f, "# Times are inclusive: a script's include the functions it called.\n");
+	fprintf(f, "%-8s %-40s %10s %12s %12s %12s\n", "kind", "name", "runs", "codes", "total ms", "avg us");
+
+	for (const ProfileEntry *entry : sorted)
+	{
+		const double ms = entry->total.time / precision;
+
+		fprintf(
+			f, "%-8s %-40s %10llu %12llu %12.3f %12.3f\n",
+			entry->callfunc ? "function" : "script",
+			entry->name.c_str(),
+			(unsigned long long)entry->total.runs,
+			(unsigned long long)entry->total.codes,
+			ms,
+			entry->total.runs ? ms * 1000.0 / entry->total.runs : 0.0
+		);
+	}
+
+	fclose(f);
+	return true;
+}
+
+}
+
+void srb2::acs::ProfileScript(const ACSVM::Script *script, precise_t time, ACSVM::Word codes)
+{
+	auto it = g_byScript.find(script);
+	ProfileEntry *entry = nullptr;
+
+	if (it != g_byScript.end())
+	{
+		entry = it->second;
+	}
+	else
+	{
+		entry = ProfileFind(ProfileScriptName(script), false);
+		g_byScript.emplace(script, entry);
+	}
+
+	ProfileAdd(entry, time, codes);
+}
+
+void srb2::acs::ProfileCallFunc(ACSVM::Word func, const char *name, precise_t time)
+{
+	if (func >= g_byFunc.size())
+	{
+		g_byFunc.resize(func + 1, nullptr);
+	}
+
+	if (g_byFunc[func] == nullptr)
+	{
+		g_byFunc[func] = ProfileFind((name != nullptr) ? name : ("CallFunc " + std::to_string(func)), true);
+	}
+
+	ProfileAdd(g_byFunc[func], time, 0);
+}
+
+void srb2::acs::ProfileForgetScripts()
+{
+	g_byScript.clear();
+}
+
+/*--------------------------------------------------
+	void ACS_ProfileTic(void)
+
+		See header file for description.
+--------------------------------------------------*/
+void ACS_ProfileTic(void)
+{
+	g_profiling = (g_profileCommand || cv_perfstats.value == PS_ACS);
+
+	for (ProfileEntry &entry : g_entries)
+	{
+		entry.lastTic = entry.tic;
+		entry.tic = {};
+	}
+}
+
+/*--------------------------------------------------
+	size_t ACS_GetProfile(acsprofileinfo_t *out, size_t max)
+
+		See header file for description.
+--------------------------------------------------*/
+size_t ACS_GetProfile(acsprofileinfo_t *out, size_t max)
+{
+	std::vector<const ProfileEntry *> sorted;
+
+	for (const ProfileEntry &entry : g_entries)
+	{
+		if (entry.lastTic.runs)
+		{
+			sorted.push_back(&entry);
+		}
+	}
+
+	max = std::min(max, sorted.size());
+	std::partial_sort(
+		sorted.begin(), sorted.begin() + max, sorted.end(),
+		[](const ProfileEntry *a, const ProfileEntry *b) { return a->lastTic.time > b->lastTic.time; }
+	);
+
+	for (size_t i = 0; i < max; i++)
+	{
+		out[i].name = sorted[i]->name.c_str();
+		out[i].callfunc = sorted[i]->callfunc;
+		out[i].time = sorted[i]->lastTic.time;
+		out[i].runs = static_cast<UINT32>(sorted[i]->lastTic.runs);
+		out[i].codes = static_cast<UINT32>(sorted[i]->lastTic.codes);
+	}
+
+	return max;
+}
+
+/*--------------------------------------------------
+	void ACS_Profile_f(void)
+
+		See header file for description.
+--------------------------------------------------*/
+void ACS_Profile_f(void)
+{
+	const char *path = va("%s" PATHSEP "%s", srb2home, "acsprofile.txt");
+
+	if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "start"))
+	{
+		ProfileClear();
+		g_profileCommand = g_profiling = true;
+		CONS_Printf("Profiling ACS; \"acsprofile stop\" saves the results.\n");
+	}
+	else if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "stop"))
+	{
+		if (g_profileCommand == false)
+		{
+			CONS_Printf("ACS isn't being profiled.\n");
+			return;
+		}
+
+		g_profileCommand = false;
+		g_profiling = (cv_perfstats.value == PS_ACS);
+
+		if (ProfileSave(path))
+		{
+			CONS_Printf("ACS profile saved to '%s'\n", path);
+		}
+		else
+		{
+			CONS_Alert(CONS_ERROR, "Couldn't save the ACS profile to '%s'\n", path);
+		}
+	}
+	else
+	{
+		CONS_Printf("acsprofile <start/stop>: times each ACS script and function, saving to %s\n", path);
+	}
+}
@@ -0,0 +1,38 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  profile.hpp
+/// \brief Action Code Script: Per-script and per-function profiler
+
+#ifndef __SRB2_ACS_PROFILE_HPP__
+#define __SRB2_ACS_PROFILE_HPP__
+
+#include "acsvm.hpp"
+
+extern "C" {
+#include "../doomtype.h"
+}
+
+namespace srb2::acs {
+
+// Set once a tic, by ACS_ProfileTic; everything else
+// checks this before reading the clock.
+extern bool g_profiling;
+
+// Time is inclusive: a script's includes the functions it
+// called, and the scripts those started immediately.
+void ProfileScript(const ACSVM::Script *script, precise_t time, ACSVM::Word codes);
+
+void ProfileCallFunc(ACSVM::Word func, const char *name, precise_t time);
+
+// Script pointers go stale once a map's modules are freed.
+void ProfileForgetScripts();
+
+}
+
+#endif // __SRB2_ACS_PROFILE_HPP__
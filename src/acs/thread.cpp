@@ -14,6 +14,7 @@
 #include "acsvm.hpp"
 
 #include "thread.hpp"
+#include "profile.hpp"
 
 #include "../doomtype.h"
 #include "../doomdef.h"
@@ -25,6 +26,7 @@
 #include "../r_defs.h"
 #include "../r_state.h"
 #include "../p_polyobj.h"
+#include "../i_system.h"
 
 using namespace srb2::acs;
 
@@ -46,6 +48,26 @@ void Thread::start(
 	result = 1;
 }
 
+void Thread::exec()
+{
+	if (g_profiling == false)
+	{
+		ACSVM::Thread::exec();
+		return;
+	}
+
+	const ACSVM::Script *const profileScript = script;
+	const ACSVM::Word codes = codeCount;
+	const precise_t start = I_GetPreciseTime();
+
+	ACSVM::Thread::exec();
+
+	if (profileScript != nullptr)
+	{
+		ProfileScript(profileScript, I_GetPreciseTime() - start, codeCount - codes);
+	}
+}
+
 void Thread::stop()
 {
 	ACSVM::Thread::stop();
@@ -138,6 +138,8 @@ public:
 
 	virtual ACSVM::ThreadInfo const *getInfo() const { return &info; }
 
+	virtual void exec();
+
 	virtual void start(
 		ACSVM::Script *script, ACSVM::MapScope *map,
 		const ACSVM::ThreadInfo *info, const ACSVM::Word *argV, ACSVM::Word argC
@@ -45,7 +45,8 @@ namespace ACSVM
       scopeMod{nullptr},
       script  {nullptr},
       delay   {0},
-      result  {0}
+      result  {0},
+      codeCount{0}
    {
    }
 
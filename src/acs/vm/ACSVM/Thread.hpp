@@ -102,7 +102,7 @@ namespace ACSVM
       Thread(Environment *env);
       virtual ~Thread();
 
-      void exec();
+      virtual void exec();
 
       virtual ThreadInfo const *getInfo() const;
 
@@ -141,6 +141,7 @@ namespace ACSVM
       Script      *script;  // Current execution Script.
       Word         delay;   // Execution delay tics.
       Word         result;  // Code-defined thread result.
+      Word         codeCount; // Instructions executed, wrapping.
 
 
       static constexpr std::size_t CallStkSize =   8;
@@ -78,7 +78,7 @@
 // NextCase
 //
 #if ACSVM_DynamicGoto
-#define NextCase() goto *cases[*codePtr++]
+#define NextCase() do {++codeCount; goto *cases[*codePtr++];} while(0)
 #else
 #define NextCase() goto next_case
 #endif
@@ -315,7 +315,7 @@ namespace ACSVM
       #if ACSVM_DynamicGoto
       NextCase();
       #else
-      next_case: switch(*codePtr++)
+      next_case: ++codeCount; switch(*codePtr++)
       #endif
       {
       DeclCase(Nop):
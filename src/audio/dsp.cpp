@@ -0,0 +1,171 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "dsp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SRB2_AUDIO_DSP_SSE2
+#include <emmintrin.h>
+#endif
+
+using std::size_t;
+
+using srb2::audio::Sample;
+
+void srb2::audio::dsp_zero(float* dst, size_t count) noexcept
+{
+	if (count == 0)
+	{
+		return;
+	}
+	std::memset(dst, 0, count * sizeof(float));
+}
+
+void srb2::audio::dsp_mix(float* dst, const float* src, size_t count) noexcept
+{
+	size_t i = 0;
+#ifdef SRB2_AUDIO_DSP_SSE2
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 a0 = _mm_loadu_ps(dst + i);
+		__m128 a1 = _mm_loadu_ps(dst + i + 4);
+		__m128 b0 = _mm_loadu_ps(src + i);
+		__m128 b1 = _mm_loadu_ps(src + i + 4);
+		_mm_storeu_ps(dst + i, _mm_add_ps(a0, b0));
+		_mm_storeu_ps(dst + i + 4, _mm_add_ps(a1, b1));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		dst[i] += src[i];
+	}
+}
+
+void srb2::audio::dsp_scale(float* dst, const float* src, float gain, size_t count) noexcept
+{
+	size_t i = 0;
+#ifdef SRB2_AUDIO_DSP_SSE2
+	__m128 g = _mm_set1_ps(gain);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 a0 = _mm_loadu_ps(src + i);
+		__m128 a1 = _mm_loadu_ps(src + i + 4);
+		_mm_storeu_ps(dst + i, _mm_mul_ps(a0, g));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(a1, g));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		dst[i] = src[i] * gain;
+	}
+}
+
+void srb2::audio::dsp_mix_mono_to_stereo(float* dst, const float* src, float left, float right, size_t frames) noexcept
+{
+	size_t i = 0;
+#ifdef SRB2_AUDIO_DSP_SSE2
+	// Each iteration pans 4 mono frames into 8 interleaved output floats
+	__m128 pan = _mm_setr_ps(left, right, left, right);
+	for (; i + 4 <= frames; i += 4)
+	{
+		__m128 mono = _mm_loadu_ps(src + i);
+		__m128 lo = _mm_unpacklo_ps(mono, mono); // s0 s0 s1 s1
+		__m128 hi = _mm_unpackhi_ps(mono, mono); // s2 s2 s3 s3
+		float* out = dst + i * 2;
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(lo, pan)));
+		_mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(hi, pan)));
+	}
+#endif
+	for (; i < frames; i++)
+	{
+		dst[i * 2] += src[i] * left;
+		dst[i * 2 + 1] += src[i] * right;
+	}
+}
+
+void srb2::audio::dsp_clamp(float* dst, size_t count) noexcept
+{
+	size_t i = 0;
+#ifdef SRB2_AUDIO_DSP_SSE2
+	__m128 lo = _mm_set1_ps(-1.f);
+	__m128 hi = _mm_set1_ps(1.f);
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(dst + i), lo), hi));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		dst[i] = std::clamp(dst[i], -1.f, 1.f);
+	}
+}
+
+template <size_t C>
+size_t srb2::audio::dsp_resample_linear(
+	Sample<C>* dst,
+	size_t dst_frames,
+	const Sample<C>* src,
+	size_t src_frames,
+	double& pos,
+	float step
+) noexcept
+{
+	if (src_frames < 2)
+	{
+		return 0;
+	}
+
+	const double limit = static_cast<double>(src_frames - 1);
+	if (pos >= limit)
+	{
+		return 0;
+	}
+
+	// Work out up front how many frames can be produced from this block so the loop body never branches on refill
+	size_t frames = dst_frames;
+	if (step > 0.f)
+	{
+		double available = std::ceil((limit - pos) / step);
+		if (available < static_cast<double>(frames))
+		{
+			frames = static_cast<size_t>(available);
+		}
+	}
+
+	const double start = pos;
+	for (size_t i = 0; i < frames; i++)
+	{
+		double p = start + static_cast<double>(i) * step;
+		size_t index = std::min(static_cast<size_t>(p), src_frames - 2);
+		float frac = static_cast<float>(p - static_cast<double>(index));
+#ifdef SRB2_AUDIO_DSP_SSE2
+		if constexpr (C == 2)
+		{
+			// Frames index and index + 1 are adjacent: one load covers both ends of the interpolation
+			__m128 ab = _mm_loadu_ps(sample_floats(src + index));
+			__m128 b = _mm_movehl_ps(ab, ab);
+			__m128 r = _mm_add_ps(ab, _mm_mul_ps(_mm_sub_ps(b, ab), _mm_set1_ps(frac)));
+			_mm_storel_pi(reinterpret_cast<__m64*>(sample_floats(dst + i)), r);
+			continue;
+		}
+#endif
+		dst[i] = (src[index + 1] - src[index]) * frac + src[index];
+	}
+
+	pos = start + static_cast<double>(frames) * step;
+	return frames;
+}
+
+template size_t srb2::audio::dsp_resample_linear<1>(Sample<1>*, size_t, const Sample<1>*, size_t, double&, float) noexcept;
+template size_t srb2::audio::dsp_resample_linear<2>(Sample<2>*, size_t, const Sample<2>*, size_t, double&, float) noexcept;
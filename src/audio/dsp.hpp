@@ -0,0 +1,71 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_DSP_HPP__
+#define __SRB2_AUDIO_DSP_HPP__
+
+#include <cstddef>
+
+#include "source.hpp"
+
+namespace srb2::audio
+{
+
+// Bulk kernels used by the mixing graph. Samples are interleaved frames of C floats, so every kernel below
+// operates on flat float arrays and uses SSE where the target supports it, falling back to scalar loops.
+
+template <size_t C>
+inline float* sample_floats(Sample<C>* samples) noexcept
+{
+	static_assert(sizeof(Sample<C>) == sizeof(float) * C);
+	return reinterpret_cast<float*>(samples);
+}
+
+template <size_t C>
+inline const float* sample_floats(const Sample<C>* samples) noexcept
+{
+	static_assert(sizeof(Sample<C>) == sizeof(float) * C);
+	return reinterpret_cast<const float*>(samples);
+}
+
+/// dst[i] = 0
+void dsp_zero(float* dst, std::size_t count) noexcept;
+
+/// dst[i] += src[i]
+void dsp_mix(float* dst, const float* src, std::size_t count) noexcept;
+
+/// dst[i] = src[i] * gain
+void dsp_scale(float* dst, const float* src, float gain, std::size_t count) noexcept;
+
+/// Pans a mono source into an interleaved stereo destination: dst[2i] += src[i] * left, dst[2i+1] += src[i] * right
+void dsp_mix_mono_to_stereo(float* dst, const float* src, float left, float right, std::size_t frames) noexcept;
+
+/// dst[i] = clamp(dst[i], -1, 1)
+void dsp_clamp(float* dst, std::size_t count) noexcept;
+
+/// Linearly interpolates src into dst, starting at fractional frame position pos and advancing by step per output
+/// frame. Stops before an output would need to read past src[src_frames - 1]; pos is updated in place.
+/// @return the number of frames written to dst
+template <size_t C>
+std::size_t dsp_resample_linear(
+	Sample<C>* dst,
+	std::size_t dst_frames,
+	const Sample<C>* src,
+	std::size_t src_frames,
+	double& pos,
+	float step
+) noexcept;
+
+extern template std::size_t dsp_resample_linear<1>(Sample<1>*, std::size_t, const Sample<1>*, std::size_t, double&, float) noexcept;
+extern template std::size_t dsp_resample_linear<2>(Sample<2>*, std::size_t, const Sample<2>*, std::size_t, double&, float) noexcept;
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_DSP_HPP__
@@ -11,26 +11,41 @@
 #include "gain.hpp"
 
 #include <algorithm>
+#include <cmath>
+
+#include "dsp.hpp"
 
 using std::size_t;
 
 using srb2::audio::Filter;
 using srb2::audio::Gain;
 using srb2::audio::Sample;
+using srb2::audio::dsp_scale;
+using srb2::audio::sample_floats;
 
 constexpr const float kGainInterpolationAlpha = 0.8f;
+constexpr const float kGainSettleEpsilon = 1e-6f;
 
 template <size_t C>
 size_t Gain<C>::filter(tcb::span<Sample<C>> input_buffer, tcb::span<Sample<C>> buffer)
 {
 	size_t written = std::min(buffer.size(), input_buffer.size());
-	for (size_t i = 0; i < written; i++)
+	size_t i = 0;
+
+	// Ramp toward the new gain per-sample until it settles, then scale the rest of the buffer in bulk
+	for (; i < written && gain_ != new_gain_; i++)
 	{
 		buffer[i] = input_buffer[i];
 		buffer[i] *= gain_;
 		gain_ += (new_gain_ - gain_) * kGainInterpolationAlpha;
+		if (std::abs(new_gain_ - gain_) < kGainSettleEpsilon)
+		{
+			gain_ = new_gain_;
+		}
 	}
 
+	dsp_scale(sample_floats(buffer.data() + i), sample_floats(input_buffer.data() + i), gain_, (written - i) * C);
+
 	return written;
 }
 
@@ -12,45 +12,30 @@
 
 #include <algorithm>
 
+#include "dsp.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
 using srb2::audio::Mixer;
 using srb2::audio::Sample;
 using srb2::audio::Source;
-
-namespace
-{
-
-template <size_t C>
-void default_init_sample_buffer(Sample<C>* buffer, size_t size)
-{
-	std::for_each(buffer, buffer + size, [](auto& i) { i = Sample<C> {}; });
-}
-
-template <size_t C>
-void mix_sample_buffers(Sample<C>* dst, size_t size, Sample<C>* src, size_t src_size)
-{
-	for (size_t i = 0; i < size && i < src_size; i++)
-	{
-		dst[i] += src[i];
-	}
-}
-
-} // namespace
+using srb2::audio::dsp_mix;
+using srb2::audio::dsp_zero;
+using srb2::audio::sample_floats;
 
 template <size_t C>
 size_t Mixer<C>::generate(tcb::span<Sample<C>> buffer)
 {
 	buffer_.resize(buffer.size());
 
-	default_init_sample_buffer<C>(buffer.data(), buffer.size());
+	dsp_zero(sample_floats(buffer.data()), buffer.size() * C);
 
 	for (auto& source : sources_)
 	{
 		size_t read = source->generate(buffer_);
 
-		mix_sample_buffers<C>(buffer.data(), buffer.size(), buffer_.data(), read);
+		dsp_mix(sample_floats(buffer.data()), sample_floats(buffer_.data()), std::min(read, buffer.size()) * C);
 	}
 
 	// because we initialized the out-buffer, we always generate size samples
@@ -11,12 +11,17 @@
 #include "music_player.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <exception>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -26,6 +31,7 @@
 #include "../io/streams.hpp"
 #include "ogg_player.hpp"
 #include "resample.hpp"
+#include "sample_ring.hpp"
 #include "xmp_player.hpp"
 
 using std::array;
@@ -37,57 +43,124 @@ using std::vector;
 using srb2::audio::MusicPlayer;
 using srb2::audio::Resampler;
 using srb2::audio::Sample;
+using srb2::audio::SampleRing;
 using srb2::audio::Source;
 using namespace srb2;
 
+namespace
+{
+
+// Music is decoded by a worker thread into a ring several hundred milliseconds ahead of the audio callback, so
+// the callback only copies samples out and applies the fade. Decoder slowdowns are absorbed by the ring instead
+// of becoming underruns, and the SDL audio lock is never held across a decode.
+constexpr const size_t kStreamFrames = 16384; // ~370 ms at 44.1 kHz
+constexpr const size_t kDecodeChunkFrames = 1024;
+constexpr const size_t kPositionMarks = kStreamFrames / kDecodeChunkFrames * 2;
+constexpr const auto kWorkerIdleWait = std::chrono::milliseconds(10);
+// A wedged decoder must not hang an offline render forever
+constexpr const auto kWaitDecodedTimeout = std::chrono::seconds(1);
+constexpr const uint64_t kNoEndOfStream = UINT64_MAX;
+
+} // namespace
+
 class MusicPlayer::Impl
 {
 public:
 	Impl() = default;
 	Impl(tcb::span<std::byte> data) : Impl() { _load(data); }
 
+	Impl(const Impl&) = delete;
+	Impl& operator=(const Impl&) = delete;
+
+	~Impl()
+	{
+		if (worker_.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> _(command_mutex_);
+				alive_ = false;
+			}
+			command_cond_.notify_one();
+			worker_.join();
+		}
+	}
+
+	// Called from the audio callback. Must never block on the worker.
 	size_t generate(tcb::span<Sample<2>> buffer)
 	{
-		if (!resampler_)
+		if (!worker_.joinable())
 			return 0;
 
+		// Samples decoded before the most recent play, stop or seek are stale. Until the worker has caught up to
+		// that request there is nothing valid to play, so output silence rather than the old stream.
+		bool caught_up = stream_epoch_.load(std::memory_order_acquire) == requested_epoch_;
+		if (caught_up)
+		{
+			ring_->skip_to(discard_until_.load(std::memory_order_acquire));
+		}
+
 		if (!playing_)
 			return 0;
 
-		size_t total_written = 0;
-
-		while (total_written < buffer.size())
+		if (!caught_up)
 		{
-			const size_t generated = resampler_->generate(buffer.subspan(total_written));
+			std::fill(buffer.begin(), buffer.end(), Sample<2> {});
+			return buffer.size();
+		}
 
-			// To avoid a branch preventing optimizations, we're always going to apply
-			// the fade gain, even if it would clamp anyway.
-			for (std::size_t i = 0; i < generated; i++)
-			{
-				buffer[total_written + i] *= current_fade_gain(i);
-			}
+		size_t total_written = ring_->pop(buffer);
 
-			gain_samples_ = std::min(gain_samples_ + generated, gain_samples_target_);
+		// To avoid a branch preventing optimizations, we're always going to apply
+		// the fade gain, even if it would clamp anyway.
+		for (std::size_t i = 0; i < total_written; i++)
+		{
+			buffer[i] *= current_fade_gain(i);
+		}
 
-			if (gain_samples_ >= gain_samples_target_)
-			{
-				fading_ = false;
-				gain_samples_ = gain_samples_target_;
-				gain_ = gain_target_;
-			}
+		gain_samples_ = std::min(gain_samples_ + total_written, gain_samples_target_);
 
-			total_written += generated;
+		if (gain_samples_ >= gain_samples_target_)
+		{
+			fading_ = false;
+			gain_samples_ = gain_samples_target_;
+			gain_ = gain_target_;
+		}
 
-			if (generated == 0)
+		if (total_written < buffer.size())
+		{
+			if (ring_->read_index() >= end_of_stream_.load(std::memory_order_acquire))
 			{
 				playing_ = false;
-				break;
+				return total_written;
 			}
+
+			// Underrun: the worker fell behind. Keep playing and pad with silence.
+			std::fill(buffer.begin() + total_written, buffer.end(), Sample<2> {});
+			total_written = buffer.size();
 		}
 
 		return total_written;
 	}
 
+	// For consumers running faster than realtime. Never call from the audio callback.
+	void wait_decoded()
+	{
+		if (!worker_.joinable() || !playing_)
+			return;
+
+		const auto deadline = std::chrono::steady_clock::now() + kWaitDecodedTimeout;
+		while (std::chrono::steady_clock::now() < deadline)
+		{
+			bool caught_up = stream_epoch_.load(std::memory_order_acquire) == requested_epoch_;
+			bool ended = ring_->write_index() >= end_of_stream_.load(std::memory_order_acquire);
+			if (caught_up && (ended || ring_->free() < kDecodeChunkFrames))
+				return;
+
+			command_cond_.notify_one();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
 	void _load(tcb::span<std::byte> data)
 	{
 		ogg_inst_ = nullptr;
@@ -131,126 +204,116 @@ public:
 		playing_ = false;
 
 		internal_gain(1.f);
-	}
 
-	void play(bool looping)
-	{
+		if (!resampler_)
+			return;
+
+		// These don't change once loaded, so they are cached before the worker takes ownership of the decoder.
 		if (ogg_inst_)
 		{
-			ogg_inst_->looping(looping);
+			music_type_ = audio::MusicType::kOgg;
+			duration_seconds_ = ogg_inst_->duration_seconds();
+			loop_point_seconds_ = ogg_inst_->loop_point_seconds();
 			ogg_inst_->playing(true);
-			playing_ = true;
-			ogg_inst_->reset();
 		}
-		else if (xmp_inst_)
+		else
 		{
-			xmp_inst_->looping(looping);
-			playing_ = true;
-			xmp_inst_->reset();
+			music_type_ = audio::MusicType::kMod;
+			duration_seconds_ = xmp_inst_->duration_seconds();
 		}
+
+		// The worker starts prerolling the beginning of the song immediately, so the first play() after a
+		// music_manager transition has audio ready without waiting on the decoder.
+		ring_ = std::make_unique<SampleRing<2>>(kStreamFrames);
+		alive_ = true;
+		worker_ = std::thread([this] { worker(); });
 	}
 
-	void unpause()
+	void play(bool looping)
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->playing(true);
-			playing_ = true;
-		}
-		else if (xmp_inst_)
+		if (!worker_.joinable())
+			return;
+
+		playing_ = true;
+
+		if (!started_)
 		{
-			playing_ = true;
+			// Keep the preroll: the decoder is still at the start of the song
+			started_ = true;
+			send({Command::kStart, looping, 0.f, requested_epoch_});
+			return;
 		}
+
+		position_hint_ = 0.f;
+		send({Command::kRestart, looping, 0.f, ++requested_epoch_});
 	}
 
-	void pause()
+	void unpause()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->playing(false);
-			playing_ = false;
-		}
-		else if (xmp_inst_)
-		{
-			playing_ = false;
-		}
+		if (worker_.joinable())
+			playing_ = true;
 	}
 
-	void stop()
+	void pause()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->reset();
-			ogg_inst_->playing(false);
-			playing_ = false;
-		}
-		else if (xmp_inst_)
-		{
-			xmp_inst_->reset();
+		if (worker_.joinable())
 			playing_ = false;
-		}
 	}
 
-	void seek(float position_seconds)
+	void stop()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->seek(position_seconds);
-			return;
-		}
-		if (xmp_inst_)
-		{
-			xmp_inst_->seek(position_seconds);
+		if (!worker_.joinable())
 			return;
-		}
-	}
 
-	bool playing() const
-	{
-		if (ogg_inst_)
-			return ogg_inst_->playing();
-		else if (xmp_inst_)
-			return playing_;
-
-		return false;
+		playing_ = false;
+		started_ = true;
+		position_hint_ = 0.f;
+		send({Command::kStop, false, 0.f, ++requested_epoch_});
 	}
 
-	std::optional<audio::MusicType> music_type() const
+	void seek(float position_seconds)
 	{
-		if (ogg_inst_)
-			return audio::MusicType::kOgg;
-		else if (xmp_inst_)
-			return audio::MusicType::kMod;
+		if (!worker_.joinable())
+			return;
 
-		return std::nullopt;
+		started_ = true;
+		position_hint_ = position_seconds;
+		send({Command::kSeek, false, position_seconds, ++requested_epoch_});
 	}
 
-	std::optional<float> duration_seconds() const
-	{
-		if (ogg_inst_)
-			return ogg_inst_->duration_seconds();
-		if (xmp_inst_)
-			return xmp_inst_->duration_seconds();
+	bool playing() const { return playing_; }
 
-		return std::nullopt;
-	}
+	std::optional<audio::MusicType> music_type() const { return music_type_; }
 
-	std::optional<float> loop_point_seconds() const
-	{
-		if (ogg_inst_)
-			return ogg_inst_->loop_point_seconds();
+	std::optional<float> duration_seconds() const { return duration_seconds_; }
 
-		return std::nullopt;
-	}
+	std::optional<float> loop_point_seconds() const { return loop_point_seconds_; }
 
 	std::optional<float> position_seconds() const
 	{
-		if (ogg_inst_)
-			return ogg_inst_->position_seconds();
-		if (xmp_inst_)
-			return xmp_inst_->position_seconds();
+		if (!music_type_)
+			return std::nullopt;
+
+		if (stream_epoch_.load(std::memory_order_acquire) != requested_epoch_)
+			return position_hint_;
+
+		// Translate the callback's read position back into decoder time using the marks the worker left at the
+		// start of each decoded chunk. This stays correct across loop points, unlike subtracting the buffer size.
+		uint64_t read = ring_->read_index();
+		std::lock_guard<std::mutex> _(position_mutex_);
+		const PositionMark* best = nullptr;
+		for (const PositionMark& mark : position_marks_)
+		{
+			if (mark.epoch != requested_epoch_ || mark.write_index > read)
+				continue;
+			if (best == nullptr || mark.write_index > best->write_index)
+				best = &mark;
+		}
 
-		return std::nullopt;
+		if (best == nullptr)
+			return position_hint_;
+
+		return best->position_seconds + (read - best->write_index) / 44100.f;
 	}
 
 	void fade_to(float gain, float seconds) { fade_from_to(current_fade_gain(0), gain, seconds); }
@@ -272,8 +335,11 @@ public:
 
 	void loop_point_seconds(float loop_point)
 	{
-		if (ogg_inst_)
-			ogg_inst_->loop_point_seconds(loop_point);
+		if (music_type_ != audio::MusicType::kOgg)
+			return;
+
+		loop_point_seconds_ = loop_point;
+		send({Command::kLoopPoint, false, loop_point, requested_epoch_});
 	}
 
 	void internal_gain(float gain)
@@ -286,12 +352,62 @@ public:
 	}
 
 private:
+	struct Command
+	{
+		enum Kind
+		{
+			kStart,
+			kRestart,
+			kStop,
+			kSeek,
+			kLoopPoint,
+		};
+
+		Kind kind;
+		bool looping;
+		float seconds;
+		uint32_t epoch;
+	};
+
+	struct PositionMark
+	{
+		uint32_t epoch;
+		uint64_t write_index;
+		float position_seconds;
+	};
+
+	// Decoder state. Once the worker is running, only the worker touches these.
 	std::shared_ptr<OggPlayer<2>> ogg_inst_;
 	std::shared_ptr<XmpPlayer<2>> xmp_inst_;
 	std::optional<Resampler<2>> resampler_;
-	bool playing_ {false};
 	bool looping_ {false};
 
+	// Worker control
+	std::thread worker_;
+	std::mutex command_mutex_;
+	std::condition_variable command_cond_;
+	std::vector<Command> commands_;
+	bool alive_ {false};
+
+	// Stream shared between the worker (producer) and audio callback (consumer)
+	std::unique_ptr<SampleRing<2>> ring_;
+	std::atomic<uint64_t> discard_until_ {0};
+	std::atomic<uint64_t> end_of_stream_ {kNoEndOfStream};
+	std::atomic<uint32_t> stream_epoch_ {0};
+
+	mutable std::mutex position_mutex_;
+	std::array<PositionMark, kPositionMarks> position_marks_ {};
+	size_t next_position_mark_ {0};
+
+	// Front-end state. The game thread and the audio callback are serialized by the SDL audio lock.
+	uint32_t requested_epoch_ {0};
+	bool started_ {false};
+	bool playing_ {false};
+	float position_hint_ {0.f};
+	std::optional<audio::MusicType> music_type_;
+	std::optional<float> duration_seconds_;
+	std::optional<float> loop_point_seconds_;
+
 	// fade control
 	float gain_target_ {1.f};
 	float gain_ {1.f};
@@ -305,6 +421,198 @@ private:
 									  static_cast<double>(gain_samples_target_);
 		return (gain_target_ - gain_) * std::clamp(alpha, 0.f, 1.f) + gain_;
 	}
+
+	void send(Command command)
+	{
+		{
+			std::lock_guard<std::mutex> _(command_mutex_);
+			commands_.push_back(command);
+		}
+		command_cond_.notify_one();
+	}
+
+	float decoder_position_seconds() const
+	{
+		if (ogg_inst_)
+			return ogg_inst_->position_seconds();
+		if (xmp_inst_)
+			return xmp_inst_->position_seconds();
+		return 0.f;
+	}
+
+	void decoder_looping(bool looping)
+	{
+		looping_ = looping;
+		if (ogg_inst_)
+		{
+			ogg_inst_->looping(looping);
+			ogg_inst_->playing(true);
+		}
+		else if (xmp_inst_)
+		{
+			xmp_inst_->looping(looping);
+		}
+	}
+
+	void decoder_reset()
+	{
+		if (ogg_inst_)
+		{
+			ogg_inst_->reset();
+			ogg_inst_->playing(true);
+		}
+		else if (xmp_inst_)
+		{
+			xmp_inst_->reset();
+		}
+	}
+
+	// Restart decoding at the loop point after the preroll ran off the end of a short song.
+	void decoder_loop()
+	{
+		if (ogg_inst_)
+		{
+			ogg_inst_->seek(ogg_inst_->loop_point_seconds().value_or(0.f));
+			ogg_inst_->playing(true);
+		}
+		else if (xmp_inst_)
+		{
+			xmp_inst_->reset();
+		}
+	}
+
+	void discard_stream(uint32_t epoch)
+	{
+		discard_until_.store(ring_->write_index(), std::memory_order_release);
+		end_of_stream_.store(kNoEndOfStream, std::memory_order_release);
+		stream_epoch_.store(epoch, std::memory_order_release);
+	}
+
+	void worker()
+	{
+		std::vector<Command> commands;
+		std::vector<Sample<2>> chunk(kDecodeChunkFrames);
+		uint32_t epoch = 0;
+		bool decoding = true;
+		bool started = false;
+		bool hit_end = false;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(command_mutex_);
+				if (alive_ && commands_.empty() && (!decoding || ring_->free() < kDecodeChunkFrames))
+				{
+					// The callback doesn't signal when it drains the ring, so poll at a fraction of its length
+					command_cond_.wait_for(lock, kWorkerIdleWait);
+				}
+				if (!alive_)
+					break;
+				commands.swap(commands_);
+			}
+
+			for (const Command& command : commands)
+			{
+				switch (command.kind)
+				{
+				case Command::kStart:
+					started = true;
+					decoder_looping(command.looping);
+					if (hit_end)
+					{
+						// The whole song already fit in the preroll
+						hit_end = false;
+						if (command.looping)
+						{
+							decoder_loop();
+							decoding = true;
+						}
+						else
+						{
+							end_of_stream_.store(ring_->write_index(), std::memory_order_release);
+						}
+					}
+					break;
+				case Command::kRestart:
+					started = true;
+					hit_end = false;
+					decoder_looping(command.looping);
+					decoder_reset();
+					decoding = true;
+					epoch = command.epoch;
+					discard_stream(epoch);
+					break;
+				case Command::kStop:
+					hit_end = false;
+					decoder_reset();
+					decoding = false;
+					epoch = command.epoch;
+					discard_stream(epoch);
+					break;
+				case Command::kSeek:
+					hit_end = false;
+					if (ogg_inst_)
+					{
+						ogg_inst_->seek(command.seconds);
+						ogg_inst_->playing(true);
+					}
+					else if (xmp_inst_)
+					{
+						xmp_inst_->seek(command.seconds);
+					}
+					decoding = true;
+					epoch = command.epoch;
+					discard_stream(epoch);
+					break;
+				case Command::kLoopPoint:
+					if (ogg_inst_)
+						ogg_inst_->loop_point_seconds(command.seconds);
+					break;
+				}
+			}
+			commands.clear();
+
+			while (decoding && ring_->free() >= kDecodeChunkFrames)
+			{
+				{
+					std::lock_guard<std::mutex> _(position_mutex_);
+					position_marks_[next_position_mark_] = {epoch, ring_->write_index(), decoder_position_seconds()};
+					next_position_mark_ = (next_position_mark_ + 1) % kPositionMarks;
+				}
+
+				size_t read = 0;
+				try
+				{
+					read = resampler_->generate(tcb::span {chunk});
+				}
+				catch (...)
+				{
+					// Treat a decoder failure as the end of the song rather than killing the thread
+				}
+
+				ring_->push(tcb::span<const Sample<2>> {chunk.data(), read});
+
+				if (read < kDecodeChunkFrames)
+				{
+					decoding = false;
+					if (started)
+					{
+						end_of_stream_.store(ring_->write_index(), std::memory_order_release);
+					}
+					else
+					{
+						hit_end = true;
+					}
+					break;
+				}
+
+				// Commands take priority over filling the rest of the ring
+				std::lock_guard<std::mutex> _(command_mutex_);
+				if (!commands_.empty() || !alive_)
+					break;
+			}
+		}
+	}
 };
 
 // The special member functions MUST be declared in this unit, where Impl is complete.
@@ -361,6 +669,13 @@ bool MusicPlayer::playing() const
 	return impl_->playing();
 }
 
+void MusicPlayer::wait_decoded()
+{
+	SRB2_ASSERT(impl_ != nullptr);
+
+	impl_->wait_decoded();
+}
+
 size_t MusicPlayer::generate(tcb::span<Sample<2>> buffer)
 {
 	SRB2_ASSERT(impl_ != nullptr);
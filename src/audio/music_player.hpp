@@ -59,6 +59,9 @@ public:
 	std::optional<float> position_seconds() const;
 	bool fading() const;
 
+	/// Blocks until the decoder has filled its read-ahead or reached the end of the song.
+	void wait_decoded();
+
 	virtual ~MusicPlayer() final;
 
 private:
@@ -126,7 +126,7 @@ template <size_t C>
 void OggPlayer<C>::loop_point_seconds(float loop_point)
 {
 	std::size_t rate = sample_rate();
-	loop_point = static_cast<std::size_t>(std::round(loop_point * rate));
+	loop_point_ = static_cast<std::size_t>(std::round(loop_point * rate));
 }
 
 template <size_t C>
@@ -16,12 +16,16 @@
 #include <utility>
 #include <vector>
 
+#include "dsp.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 using std::vector;
 
 using namespace srb2::audio;
 
+constexpr const size_t kRefillFrames = 512;
+
 template <size_t C>
 Resampler<C>::Resampler(std::shared_ptr<Source<C>>&& source, float ratio)
 	: source_(std::forward<std::shared_ptr<Source<C>>>(source)), ratio_(ratio)
@@ -55,36 +59,45 @@ size_t Resampler<C>::generate(tcb::span<Sample<C>> buffer)
 	while (written < buffer.size())
 	{
 		// do we need a refill?
-		if (buf_.size() == 0 || pos_ >= static_cast<int>(buf_.size() - 1))
+		if (buf_.size() < 2 || pos_ >= static_cast<double>(buf_.size() - 1))
 		{
-			pos_ -= buf_.size();
-			last_ = buf_.size() == 0 ? Sample<C> {} : buf_.back();
-			buf_.clear();
-			buf_.resize(512);
-			size_t source_read = source_->generate(buf_);
-			buf_.resize(source_read);
-			if (source_read == 0)
+			if (!refill())
 			{
 				break;
 			}
-		}
-
-		if (pos_ < 0)
-		{
-			buffer[written] = (buf_[0] - last_) * pos_frac_ + last_;
-			advance(ratio_);
-			written++;
 			continue;
 		}
 
-		buffer[written] = (buf_[pos_ + 1] - buf_[pos_]) * pos_frac_ + buf_[pos_];
-		advance(ratio_);
-		written++;
+		written += dsp_resample_linear<C>(
+			buffer.data() + written,
+			buffer.size() - written,
+			buf_.data(),
+			buf_.size(),
+			pos_,
+			ratio_
+		);
 	}
 
 	return written;
 }
 
+template <size_t C>
+bool Resampler<C>::refill()
+{
+	Sample<C> history = buf_.empty() ? Sample<C> {} : buf_.back();
+	if (!buf_.empty())
+	{
+		pos_ -= static_cast<double>(buf_.size() - 1);
+	}
+
+	buf_.resize(kRefillFrames + 1);
+	buf_[0] = history;
+	size_t source_read = source_->generate(tcb::span {buf_.data() + 1, kRefillFrames});
+	buf_.resize(source_read + 1);
+
+	return source_read > 0;
+}
+
 template <size_t C>
 void Resampler<C>::ratio(float new_ratio)
 {
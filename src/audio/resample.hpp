@@ -44,21 +44,11 @@ public:
 private:
 	std::shared_ptr<Source<C>> source_;
 	float ratio_ {1.f};
+	// buf_[0] is the final frame of the previous block, kept so interpolation can straddle block boundaries
 	std::vector<Sample<C>> buf_;
-	Sample<C> last_;
-	int pos_ {0};
-	float pos_frac_ {0.f};
+	double pos_ {1.0};
 
-	void advance(float samples)
-	{
-		pos_frac_ += samples;
-		float integer;
-		std::modf(pos_frac_, &integer);
-		pos_ += integer;
-		pos_frac_ -= integer;
-	}
-
-	void refill();
+	bool refill();
 };
 
 extern template class Resampler<1>;
@@ -0,0 +1,101 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_SAMPLE_RING_HPP__
+#define __SRB2_AUDIO_SAMPLE_RING_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <tcb/span.hpp>
+
+#include "../cxxutil.hpp"
+#include "source.hpp"
+
+namespace srb2::audio
+{
+
+/// Lock-free single-producer, single-consumer ring of samples. Read and write positions are monotonic 64-bit
+/// counters, so they can be compared across wraparound and used as stream timestamps.
+template <size_t C>
+class SampleRing
+{
+	std::unique_ptr<Sample<C>[]> buf_;
+	std::size_t capacity_;
+	std::size_t mask_;
+	std::atomic<uint64_t> read_ {0};
+	std::atomic<uint64_t> write_ {0};
+
+public:
+	explicit SampleRing(std::size_t capacity)
+		: buf_(std::make_unique<Sample<C>[]>(capacity)), capacity_(capacity), mask_(capacity - 1)
+	{
+		SRB2_ASSERT(capacity && !(capacity & (capacity - 1)));
+	}
+
+	SampleRing(const SampleRing&) = delete;
+	SampleRing& operator=(const SampleRing&) = delete;
+
+	std::size_t capacity() const noexcept { return capacity_; }
+	uint64_t read_index() const noexcept { return read_.load(std::memory_order_acquire); }
+	uint64_t write_index() const noexcept { return write_.load(std::memory_order_acquire); }
+
+	/// Producer only. Number of samples that can be pushed without overwriting unread data.
+	std::size_t free() const noexcept
+	{
+		return capacity_ - static_cast<std::size_t>(write_.load(std::memory_order_relaxed) - read_index());
+	}
+
+	/// Producer only.
+	/// @return the number of samples actually pushed
+	std::size_t push(tcb::span<const Sample<C>> samples) noexcept
+	{
+		uint64_t w = write_.load(std::memory_order_relaxed);
+		std::size_t count = std::min(samples.size(), free());
+		for (std::size_t i = 0; i < count; i++)
+		{
+			buf_[(w + i) & mask_] = samples[i];
+		}
+		write_.store(w + count, std::memory_order_release);
+		return count;
+	}
+
+	/// Consumer only.
+	/// @return the number of samples actually popped
+	std::size_t pop(tcb::span<Sample<C>> out) noexcept
+	{
+		uint64_t r = read_.load(std::memory_order_relaxed);
+		std::size_t count = std::min(out.size(), static_cast<std::size_t>(write_index() - r));
+		for (std::size_t i = 0; i < count; i++)
+		{
+			out[i] = buf_[(r + i) & mask_];
+		}
+		read_.store(r + count, std::memory_order_release);
+		return count;
+	}
+
+	/// Consumer only. Drops unread samples up to, but not past, the given stream position.
+	void skip_to(uint64_t index) noexcept
+	{
+		uint64_t r = read_.load(std::memory_order_relaxed);
+		index = std::min(index, write_index());
+		if (index > r)
+		{
+			read_.store(index, std::memory_order_release);
+		}
+	}
+};
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_SAMPLE_RING_HPP__
@@ -14,14 +14,25 @@
 #include <cmath>
 #include <memory>
 
+#include "dsp.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
 using srb2::audio::Sample;
 using srb2::audio::SoundEffectPlayer;
 using srb2::audio::Source;
+using srb2::audio::dsp_mix_mono_to_stereo;
+using srb2::audio::dsp_zero;
+using srb2::audio::sample_floats;
 
 size_t SoundEffectPlayer::generate(tcb::span<Sample<2>> buffer)
+{
+	dsp_zero(sample_floats(buffer.data()), buffer.size() * 2);
+	return mix(buffer);
+}
+
+size_t SoundEffectPlayer::mix(tcb::span<Sample<2>> buffer)
 {
 	if (!chunk_)
 		return 0;
@@ -30,18 +41,15 @@ size_t SoundEffectPlayer::generate(tcb::span<Sample<2>> buffer)
 		return 0;
 	}
 
-	size_t written = 0;
-	for (; position_ < chunk_->samples.size() && written < buffer.size(); position_++)
-	{
-		float mono_sample = chunk_->samples[position_].amplitudes[0];
-
-		float sep_pan = ((sep_ + 1.f) / 2.f) * (3.14159 / 2.f);
-
-		float left_scale = std::cos(sep_pan);
-		float right_scale = std::sin(sep_pan);
-		buffer[written] = {mono_sample * volume_ * left_scale, mono_sample * volume_ * right_scale};
-		written += 1;
-	}
+	size_t written = std::min(chunk_->samples.size() - position_, buffer.size());
+	dsp_mix_mono_to_stereo(
+		sample_floats(buffer.data()),
+		sample_floats(chunk_->samples.data() + position_),
+		left_scale_,
+		right_scale_,
+		written
+	);
+	position_ += written;
 	return written;
 }
 
@@ -56,6 +64,10 @@ void SoundEffectPlayer::update(float volume, float sep)
 {
 	volume_ = volume;
 	sep_ = sep;
+
+	float sep_pan = ((sep_ + 1.f) / 2.f) * (3.14159 / 2.f);
+	left_scale_ = std::cos(sep_pan) * volume_;
+	right_scale_ = std::sin(sep_pan) * volume_;
 }
 
 void SoundEffectPlayer::reset()
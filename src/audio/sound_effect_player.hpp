@@ -26,6 +26,10 @@ class SoundEffectPlayer : public Source<2>
 public:
 	virtual std::size_t generate(tcb::span<Sample<2>> buffer) override final;
 
+	/// Pan and add this voice's samples into buffer, rather than overwriting it.
+	/// @return the number of samples mixed
+	std::size_t mix(tcb::span<Sample<2>> buffer);
+
 	virtual ~SoundEffectPlayer() final;
 
 	void start(const SoundChunk* chunk, float volume, float sep);
@@ -36,12 +40,14 @@ public:
 	bool is_playing_chunk(const SoundChunk* chunk) const;
 
 private:
-	float volume_;
-	float sep_;
+	float volume_ {0.f};
+	float sep_ {0.f};
+	float left_scale_ {0.f};
+	float right_scale_ {0.f};
 
-	std::size_t position_;
+	std::size_t position_ {0};
 
-	const SoundChunk* chunk_;
+	const SoundChunk* chunk_ {nullptr};
 };
 
 } // namespace srb2::audio
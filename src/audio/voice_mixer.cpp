@@ -0,0 +1,55 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "voice_mixer.hpp"
+
+#include "dsp.hpp"
+
+using std::size_t;
+
+using srb2::audio::Sample;
+using srb2::audio::SoundChunk;
+using srb2::audio::SoundEffectPlayer;
+using srb2::audio::VoiceMixer;
+
+VoiceMixer::VoiceMixer(size_t voices) : voices_(std::make_unique<SoundEffectPlayer[]>(voices)), size_(voices)
+{
+}
+
+VoiceMixer::~VoiceMixer() = default;
+
+size_t VoiceMixer::generate(tcb::span<Sample<2>> buffer)
+{
+	dsp_zero(sample_floats(buffer.data()), buffer.size() * 2);
+
+	for (size_t i = 0; i < size_; i++)
+	{
+		SoundEffectPlayer& voice = voices_[i];
+		if (voice.finished())
+		{
+			continue;
+		}
+		voice.mix(buffer);
+	}
+
+	// because we initialized the out-buffer, we always generate size samples
+	return buffer.size();
+}
+
+void VoiceMixer::stop_chunk(const SoundChunk* chunk)
+{
+	for (size_t i = 0; i < size_; i++)
+	{
+		if (voices_[i].is_playing_chunk(chunk))
+		{
+			voices_[i].reset();
+		}
+	}
+}
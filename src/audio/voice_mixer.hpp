@@ -0,0 +1,54 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_VOICE_MIXER_HPP__
+#define __SRB2_AUDIO_VOICE_MIXER_HPP__
+
+#include <cstddef>
+#include <memory>
+
+#include <tcb/span.hpp>
+
+#include "sound_effect_player.hpp"
+#include "source.hpp"
+
+namespace srb2::audio
+{
+
+/// Mixes a fixed set of sound effect voices. Unlike Mixer, the voices are owned in one contiguous array and summed
+/// directly into the output buffer without per-voice virtual dispatch or intermediate buffers.
+class VoiceMixer : public Source<2>
+{
+public:
+	explicit VoiceMixer(std::size_t voices);
+	VoiceMixer(const VoiceMixer&) = delete;
+	VoiceMixer(VoiceMixer&&) = delete;
+	virtual ~VoiceMixer();
+
+	VoiceMixer& operator=(const VoiceMixer&) = delete;
+	VoiceMixer& operator=(VoiceMixer&&) = delete;
+
+	virtual std::size_t generate(tcb::span<Sample<2>> buffer) override final;
+
+	std::size_t size() const noexcept { return size_; }
+	SoundEffectPlayer& operator[](std::size_t index) noexcept { return voices_[index]; }
+	const SoundEffectPlayer& operator[](std::size_t index) const noexcept { return voices_[index]; }
+
+	/// Stop every voice currently playing chunk.
+	void stop_chunk(const SoundChunk* chunk);
+
+private:
+	std::unique_ptr<SoundEffectPlayer[]> voices_;
+	std::size_t size_;
+};
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_VOICE_MIXER_HPP__
@@ -0,0 +1,201 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "encode_pipeline.hpp"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include <tracy/tracy/Tracy.hpp>
+
+#include "../cxxutil.hpp"
+#include "thread_pool.h"
+
+using namespace srb2;
+
+struct EncodePipeline::State
+{
+	struct Finished
+	{
+		Buffer output;
+		WriteFn write;
+	};
+
+	std::mutex mutex;
+	std::condition_variable cond; // signaled when a slot is freed or a frame is written
+
+	std::size_t slots;
+	std::size_t slots_in_use = 0;
+	std::vector<Buffer> free_inputs;
+	std::vector<Buffer> free_outputs;
+
+	uint64_t next_submit = 0;
+	uint64_t next_write = 0;
+	std::map<uint64_t, Finished> finished;
+	bool writing = false;
+
+	explicit State(std::size_t slots_) : slots(slots_) {}
+
+	void release_input(Buffer&& buffer)
+	{
+		{
+			std::lock_guard<std::mutex> _(mutex);
+			free_inputs.push_back(std::move(buffer));
+			slots_in_use--;
+		}
+		cond.notify_all();
+	}
+
+	Buffer take_output()
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		if (free_outputs.empty())
+		{
+			return {};
+		}
+		Buffer buffer = std::move(free_outputs.back());
+		free_outputs.pop_back();
+		buffer.clear();
+		return buffer;
+	}
+
+	void finish(uint64_t seq, Buffer&& output, WriteFn&& write)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.emplace(seq, Finished {std::move(output), std::move(write)});
+
+		// Whoever holds the writer role drains every frame that is ready in order; anyone finishing meanwhile
+		// only parks their output.
+		if (writing)
+		{
+			return;
+		}
+		writing = true;
+
+		for (auto it = finished.find(next_write); it != finished.end(); it = finished.find(next_write))
+		{
+			Finished frame = std::move(it->second);
+			finished.erase(it);
+
+			lock.unlock();
+			try
+			{
+				ZoneScopedN("EncodePipeline write");
+				frame.write(frame.output);
+			}
+			catch (...)
+			{
+			}
+			lock.lock();
+
+			free_outputs.push_back(std::move(frame.output));
+			next_write++;
+			cond.notify_all();
+		}
+
+		writing = false;
+	}
+};
+
+EncodePipeline::EncodePipeline(std::size_t slots) : state_(std::make_shared<State>(slots))
+{
+	SRB2_ASSERT(slots > 0);
+}
+
+EncodePipeline::~EncodePipeline()
+{
+	drain();
+}
+
+EncodePipeline::Frame EncodePipeline::acquire(bool wait)
+{
+	Buffer buffer;
+
+	{
+		std::unique_lock<std::mutex> lock(state_->mutex);
+		if (state_->slots_in_use >= state_->slots)
+		{
+			if (!wait)
+			{
+				return nullptr;
+			}
+			state_->cond.wait(lock, [this] { return state_->slots_in_use < state_->slots; });
+		}
+
+		state_->slots_in_use++;
+		if (!state_->free_inputs.empty())
+		{
+			buffer = std::move(state_->free_inputs.back());
+			state_->free_inputs.pop_back();
+		}
+	}
+
+	// The deleter holds the state, so slots released after the pipeline is gone are still safe.
+	std::shared_ptr<State> state = state_;
+	return Frame(new Buffer(std::move(buffer)), [state](Buffer* slot)
+	{
+		state->release_input(std::move(*slot));
+		delete slot;
+	});
+}
+
+void EncodePipeline::submit(Frame input, EncodeFn encode, WriteFn write)
+{
+	SRB2_ASSERT(input != nullptr);
+
+	uint64_t seq;
+	{
+		std::lock_guard<std::mutex> _(state_->mutex);
+		seq = state_->next_submit++;
+	}
+
+	auto job = [state = state_, seq, input = std::move(input), encode = std::move(encode), write = std::move(write)]() mutable
+	{
+		Buffer output = state->take_output();
+		try
+		{
+			ZoneScopedN("EncodePipeline encode");
+			encode(*input, output);
+		}
+		catch (...)
+		{
+			output.clear();
+		}
+
+		// Free the slot (and anything the encoder held on to) before writing, so the producer isn't held up by
+		// file IO.
+		input.reset();
+		encode = nullptr;
+		state->finish(seq, std::move(output), std::move(write));
+	};
+
+	if (!g_main_threadpool)
+	{
+		job();
+		return;
+	}
+
+	g_main_threadpool->schedule(std::move(job));
+	g_main_threadpool->notify();
+}
+
+void EncodePipeline::drain()
+{
+	std::unique_lock<std::mutex> lock(state_->mutex);
+	state_->cond.wait(lock, [this] { return state_->next_write == state_->next_submit; });
+}
+
+std::size_t EncodePipeline::pending() const
+{
+	std::lock_guard<std::mutex> _(state_->mutex);
+	return static_cast<std::size_t>(state_->next_submit - state_->next_write);
+}
@@ -0,0 +1,70 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_CORE_ENCODE_PIPELINE_HPP__
+#define __SRB2_CORE_ENCODE_PIPELINE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace srb2
+{
+
+/// Compresses captured frames on the main thread pool and hands the results to a single writer in submission
+/// order. Input buffers come from a fixed pool of frame slots, so a full pipeline pushes back on the producer
+/// (which can drop the frame) instead of growing without bound or blocking rendering.
+class EncodePipeline
+{
+public:
+	using Buffer = std::vector<uint8_t>;
+
+	/// A pooled frame slot. The slot returns to the pool when the last reference is released, so an encoder may
+	/// keep a previous frame alive to diff against.
+	using Frame = std::shared_ptr<Buffer>;
+
+	/// Runs on a pool thread. Leaving output empty reports a failed encode to the writer.
+	using EncodeFn = std::function<void(const Buffer& input, Buffer& output)>;
+
+	/// Runs on whichever thread finished the frame, one frame at a time, in submission order.
+	using WriteFn = std::function<void(const Buffer& output)>;
+
+	explicit EncodePipeline(std::size_t slots);
+	EncodePipeline(const EncodePipeline&) = delete;
+	EncodePipeline& operator=(const EncodePipeline&) = delete;
+
+	/// Drains outstanding frames.
+	~EncodePipeline();
+
+	/// Main thread only.
+	/// @param wait block until a slot is free instead of giving up
+	/// @return a frame slot with unspecified contents, or null if every slot is in use
+	Frame acquire(bool wait = false);
+
+	/// Main thread only.
+	void submit(Frame input, EncodeFn encode, WriteFn write);
+
+	/// Blocks until every submitted frame has been written.
+	void drain();
+
+	/// Frames submitted but not yet written.
+	std::size_t pending() const;
+
+private:
+	struct State;
+
+	std::shared_ptr<State> state_;
+};
+
+} // namespace srb2
+
+#endif // __SRB2_CORE_ENCODE_PIPELINE_HPP__
@@ -21,12 +21,16 @@
 #include <tracy/tracy/Tracy.hpp>
 
 #include "../cxxutil.hpp"
+#include "../i_system.h"
 #include "../m_argv.h"
+#include "../m_trace.h"
 
 using namespace srb2;
 
 static void do_work(ThreadPool::Task& work)
 {
+	const precise_t start = I_GetPreciseTime();
+
 	try
 	{
 		ZoneScoped;
@@ -37,6 +41,8 @@ static void do_work(ThreadPool::Task& work)
 		// can't do anything
 	}
 
+	M_TraceEvent("ThreadPool task", start);
+
 	(work.deleter)(work.raw.data());
 	if (work.pseudosema)
 	{
@@ -56,6 +62,7 @@ static void pool_executor(
 	{
 		std::string thread_name = fmt::format("Thread Pool Thread {}", thread_index);
 		tracy::SetThreadName(thread_name.c_str());
+		M_TraceThreadName(thread_name.c_str());
 	}
 
 	int spins = 0;
@@ -273,6 +280,28 @@ void ThreadPool::wait_sema(const Sema& sema)
 	}
 }
 
+bool ThreadPool::work_one()
+{
+	if (immediate_mode_)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < work_queues_.size(); i++)
+	{
+		auto& q = work_queues_[i];
+
+		std::optional<Task> work;
+		if ((work = q->pop()).has_value())
+		{
+			do_work(*work);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void ThreadPool::shutdown()
 {
 	if (immediate_mode_)
@@ -344,3 +373,44 @@ void I_ThreadPoolWaitIdle(void)
 
 	g_main_threadpool->wait_idle();
 }
+
+struct srb2tpbatch_t
+{
+	ThreadPool::Sema sema;
+};
+
+srb2tpbatch_t* I_ThreadPoolStartBatch(srb2cbatchthunk_t thunk, void* data, size_t count)
+{
+	srb2tpbatch_t* batch = new srb2tpbatch_t;
+
+	if (!g_main_threadpool)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			(thunk)(data, i);
+		}
+		return batch;
+	}
+
+	g_main_threadpool->begin_sema();
+	for (size_t i = 0; i < count; i++)
+	{
+		g_main_threadpool->schedule([=]() {
+			(thunk)(data, i);
+		});
+	}
+	batch->sema = g_main_threadpool->end_sema();
+	g_main_threadpool->notify_sema(batch->sema);
+
+	return batch;
+}
+
+void I_ThreadPoolFinishBatch(srb2tpbatch_t* batch)
+{
+	if (g_main_threadpool)
+	{
+		g_main_threadpool->wait_sema(batch->sema);
+	}
+
+	delete batch;
+}
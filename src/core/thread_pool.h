@@ -85,11 +85,32 @@ public:
 	void notify_sema(const Sema& sema);
 	void wait_idle();
 	void wait_sema(const Sema& sema);
+	/// Run one queued task on the calling thread; false if there were none
+	bool work_one();
 	void shutdown();
+
+	/// Number of worker threads
+	size_t size() const noexcept { return threads_.size(); }
 };
 
 extern std::unique_ptr<ThreadPool> g_main_threadpool;
 
+/// Schedule on the main pool and notify it, or run right here if there's no pool.
+/// Main thread only, like ThreadPool::schedule.
+template <typename T>
+void schedule_or_run(T&& thunk)
+{
+	if (g_main_threadpool)
+	{
+		g_main_threadpool->schedule(std::forward<T>(thunk));
+		g_main_threadpool->notify();
+	}
+	else
+	{
+		thunk();
+	}
+}
+
 template <typename F>
 void callable_caller(F* f)
 {
@@ -156,6 +177,16 @@ void I_ThreadPoolShutdown(void);
 void I_ThreadPoolSubmit(srb2cthunk_t thunk, void* data);
 void I_ThreadPoolWaitIdle(void);
 
+typedef void (*srb2cbatchthunk_t)(void*, size_t);
+typedef struct srb2tpbatch_t srb2tpbatch_t;
+
+/// Runs thunk(data, i) for every i below count on the pool, without waiting for it to finish.
+/// Without a pool, it all runs right here.
+srb2tpbatch_t* I_ThreadPoolStartBatch(srb2cbatchthunk_t thunk, void* data, size_t count);
+
+/// Waits for a batch to finish, working through the pool's queue meanwhile, and frees it.
+void I_ThreadPoolFinishBatch(srb2tpbatch_t* batch);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
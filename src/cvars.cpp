@@ -390,6 +390,9 @@ static CV_PossibleValue_t ghost2_cons_t[] = {{0, "Hide"}, {1, "Show"}, {0, NULL}
 consvar_t cv_ghost_guest     = Player("ghost_guest",     "Show").values(ghost2_cons_t);
 consvar_t cv_ghost_staff     = Player("ghost_staff",     "Show").values(ghost2_cons_t);
 
+// megabytes of converted graphics kept on disk, see r_gfxcache.cpp
+consvar_t cv_gfxcache_budget = Player("gfxcache_budget", "256").min_max(0, 4096);
+
 void ItemFinder_OnChange(void);
 consvar_t cv_itemfinder = Player("itemfinder", "Off").flags(CV_NOSHOWHELP).on_off().onchange(ItemFinder_OnChange).dont_save();
 
@@ -589,6 +592,12 @@ consvar_t cv_sleep = Server("cpusleep", "1").min_max(0, 1000/TICRATE);
 	consvar_t cv_stunserver = Server("stunserver", "stun.l.google.com:19302");
 #endif
 
+// see m_trace.cpp; tracelog_size is in megabytes per file
+void TraceEvents_OnChange(void);
+consvar_t cv_traceevents = Server("traceevents", "On").on_off().onchange(TraceEvents_OnChange);
+consvar_t cv_tracelog = Server("tracelog", "Off").on_off();
+consvar_t cv_tracelog_size = Server("tracelog_size", "16").min_max(1, 1024);
+
 
 //
 // Netvars - synced in netgames, also saved.
@@ -48,6 +48,9 @@
 #include "lua_hook.h"
 #include "md5.h"
 #include "m_perfstats.h"
+#include "m_trace.h"
+#include "d_soak.h"
+#include "g_demoanalysis.h"
 #include "monocypher/monocypher.h"
 #include "stun.h"
 
@@ -182,6 +185,7 @@ uint8_t lastChallengeAll[CHALLENGELENGTH]; // The message we asked EVERYONE to s
 uint8_t lastReceivedSignature[MAXPLAYERS][SIGNATURELENGTH]; // Everyone's response to lastChallengeAll
 uint8_t knownWhenChallenged[MAXPLAYERS][PUBKEYLENGTH]; // Everyone a client saw at the moment a challenge should be initiated
 boolean expectChallenge = false; // Were we in-game before a client-to-client challenge should have been sent?
+static int resultsallfirst; // Slot of the next PT_RESULTSALL's first signature
 
 uint8_t priorKeys[MAXPLAYERS][PUBKEYLENGTH]; // Make a note of keys before consuming a new gamestate, and if the server tries to send us a gamestate where keys differ, assume shenanigans
 
@@ -293,6 +297,91 @@ static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
 	return ret+n;
 }
 
+// PT_SERVERTICS only carries the ticcmds that have something in them, so
+// empty slots cost a bit each instead of a whole ticcmd.
+static boolean ServerTicsHasCmd(tic_t tic, INT32 slot)
+{
+	static const ticcmd_t empty;
+
+	return slot < doomcom->numslots
+		&& memcmp(&netcmds[tic%BACKUPTICS][slot], &empty, sizeof empty);
+}
+
+static size_t ServerTicsCmdSize(tic_t tic)
+{
+	size_t size = SERVERTICS_SLOTBYTES;
+	INT32 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (ServerTicsHasCmd(tic, i))
+			size += sizeof (ticcmd_t);
+	}
+
+	return size;
+}
+
+static UINT8 *ServerTicsWriteCmds(UINT8 *p, tic_t tic)
+{
+	UINT8 *slots = p;
+	INT32 i;
+
+	memset(slots, 0, SERVERTICS_SLOTBYTES);
+	p += SERVERTICS_SLOTBYTES;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (!ServerTicsHasCmd(tic, i))
+			continue;
+
+		slots[i / 8] |= 1 << (i % 8);
+		p = G_DcpyTiccmd(p, &netcmds[tic%BACKUPTICS][i], sizeof (ticcmd_t));
+	}
+
+	return p;
+}
+
+// Returns NULL if the tic runs past end.
+static UINT8 *ServerTicsSkipCmds(UINT8 *p, const UINT8 *end)
+{
+	size_t size = SERVERTICS_SLOTBYTES;
+	INT32 i;
+
+	if (end - p < SERVERTICS_SLOTBYTES)
+		return NULL;
+
+	for (i = 0; i < SERVERTICS_SLOTBYTES; i++)
+	{
+		UINT8 bits;
+
+		for (bits = p[i]; bits; bits &= bits - 1)
+			size += sizeof (ticcmd_t);
+	}
+
+	if ((size_t)(end - p) < size)
+		return NULL;
+
+	return p + size;
+}
+
+static UINT8 *ServerTicsReadCmds(UINT8 *p, tic_t tic)
+{
+	const UINT8 *slots = p;
+	INT32 i;
+
+	p += SERVERTICS_SLOTBYTES;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (slots[i / 8] & (1 << (i % 8)))
+			p = G_ScpyTiccmd(&netcmds[tic%BACKUPTICS][i], p, sizeof (ticcmd_t));
+		else
+			memset(&netcmds[tic%BACKUPTICS][i], 0, sizeof (ticcmd_t));
+	}
+
+	return p;
+}
+
 
 
 // Some software don't support largest packet
@@ -5079,7 +5168,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 				// check if tic that we are making isn't too large else we cannot send it :(
 				// doomcom->numslots+1 "+1" since doomcom->numslots can change within this time and sent time
 				j = software_MAXPACKETLENGTH
-					- (incoming_size + 3 + BASESERVERTICSSIZE
+					- (incoming_size + 3 + BASESERVERTICSSIZE + SERVERTICS_SLOTBYTES
 					+ (doomcom->numslots+1)*sizeof(ticcmd_t));
 
 				// search a tic that have enougth space in the ticcmd
@@ -5210,12 +5299,30 @@ static void HandlePacketFromPlayer(SINT8 node)
 				break;
 			}
 
+			if (netbuffer->u.serverpak.slotbytes != SERVERTICS_SLOTBYTES)
+			{
+				DEBFILE(va("PT_SERVERTICS for %d players, expected %d\n", netbuffer->u.serverpak.slotbytes * 8, MAXPLAYERS));
+				break;
+			}
+
 			realstart = ExpandTics(netbuffer->u.serverpak.starttic, maketic);
 			realend = realstart + netbuffer->u.serverpak.numtics;
 
 			if (!txtpak)
-				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
-					* netbuffer->u.serverpak.numtics];
+			{
+				const UINT8 *end = (UINT8 *)netbuffer + doomcom->datalength;
+				tic_t i;
+
+				txtpak = netbuffer->u.serverpak.cmds;
+				for (i = 0; txtpak && i < netbuffer->u.serverpak.numtics; i++)
+					txtpak = ServerTicsSkipCmds(txtpak, end);
+
+				if (!txtpak)
+				{
+					DEBFILE("PT_SERVERTICS is cut short\n");
+					break;
+				}
+			}
 
 			if (realend > gametic + CLIENTBACKUPTICS)
 				realend = gametic + CLIENTBACKUPTICS;
@@ -5224,7 +5331,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 			if (realstart <= neededtic && realend > neededtic)
 			{
 				tic_t i, j;
-				pak = (UINT8 *)&netbuffer->u.serverpak.cmds;
+				pak = netbuffer->u.serverpak.cmds;
 
 				for (i = realstart; i < realend; i++)
 				{
@@ -5232,8 +5339,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 					D_Clearticcmd(i);
 
 					// copy the tics
-					pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
-						netbuffer->u.serverpak.numslots*sizeof (ticcmd_t));
+					pak = ServerTicsReadCmds(pak, i);
 
 					// copy the textcmds
 					numtxtpak = *txtpak++;
@@ -5415,7 +5521,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 			uint8_t allZero[PUBKEYLENGTH];
 			memset(allZero, 0, sizeof(PUBKEYLENGTH));
 
-			for (resultsplayer = 0; resultsplayer < MAXPLAYERS; resultsplayer++)
+			for (resultsplayer = resultsallfirst; resultsplayer < resultsallfirst + RESULTSALL_SLOTS && resultsplayer < MAXPLAYERS; resultsplayer++)
 			{
 				if (!playeringame[resultsplayer])
 				{
@@ -5438,16 +5544,21 @@ static void HandlePacketFromPlayer(SINT8 node)
 				}
 				else
 				{
-					if (crypto_eddsa_check(netbuffer->u.resultsall.signature[resultsplayer],
+					if (crypto_eddsa_check(netbuffer->u.resultsall.signature[resultsplayer - resultsallfirst],
 						knownWhenChallenged[resultsplayer], lastChallengeAll, sizeof(lastChallengeAll)))
 					{
 						CONS_Alert(CONS_WARNING, "PT_RESULTSALL had invalid signature %s for node %d player %d split %d, something doesn't add up!\n",
-							GetPrettyRRID(netbuffer->u.resultsall.signature[resultsplayer], true), playernode[resultsplayer], resultsplayer, players[resultsplayer].splitscreenindex);
+							GetPrettyRRID(netbuffer->u.resultsall.signature[resultsplayer - resultsallfirst], true), playernode[resultsplayer], resultsplayer, players[resultsplayer].splitscreenindex);
 						HandleSigfail("Server sent invalid client signature.");
 						break;
 					}
 				}
 			}
+
+			resultsallfirst += RESULTSALL_SLOTS;
+			if (resultsallfirst < MAXPLAYERS)
+				break; // more to come
+
 			csprng(lastChallengeAll, sizeof(lastChallengeAll));
 			expectChallenge = false;
 			break;
@@ -5889,7 +6000,7 @@ static void SV_SendTics(void)
 			packsize = BASESERVERTICSSIZE;
 			for (i = realfirsttic; i < lasttictosend; i++)
 			{
-				packsize += sizeof (ticcmd_t) * doomcom->numslots;
+				packsize += ServerTicsCmdSize(i);
 				packsize += TotalTextCmdPerTic(i);
 
 				if (packsize > software_MAXPACKETLENGTH)
@@ -5922,12 +6033,12 @@ static void SV_SendTics(void)
 			netbuffer->packettype = PT_SERVERTICS;
 			netbuffer->u.serverpak.starttic = (UINT8)realfirsttic;
 			netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
-			netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
-			bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+			netbuffer->u.serverpak.slotbytes = SERVERTICS_SLOTBYTES;
+			bufpos = netbuffer->u.serverpak.cmds;
 
 			for (i = realfirsttic; i < lasttictosend; i++)
 			{
-				bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
+				bufpos = ServerTicsWriteCmds(bufpos, i);
 			}
 
 			// add textcmds
@@ -6019,6 +6130,7 @@ static void SV_Maketic(void)
 
 			ps_bots[i].isBot = true;
 			ps_bots[i].total = I_GetPreciseTime() - t;
+			M_TraceEvent("K_BuildBotTiccmd", t);
 			ps_botticcmd_time += ps_bots[i].total;
 			continue;
 		}
@@ -6166,6 +6278,9 @@ boolean TryRunTics(tic_t realtics)
 			consistancy[gametic % BACKUPTICS] = Consistancy();
 
 			ps_tictime = I_GetPreciseTime() - ps_tictime;
+			M_TraceDuration("Tic", ps_tictime);
+			D_SoakTic(ps_tictime);
+			G_DemoAnalysisTic(ps_tictime, consistancy[gametic % BACKUPTICS]);
 
 			// Leave a certain amount of tics present in the net buffer as long as we've ran at least one tic this frame.
 			if (client && gamestate == GS_LEVEL && leveltime > 1 && neededtic <= gametic + cv_netticbuffer.value)
@@ -6425,7 +6540,7 @@ static void KickUnverifiedPlayers(void)
 //
 static void SendChallengeResults(void)
 {
-	int i;
+	int i, first;
 	netbuffer->packettype = PT_RESULTSALL;
 
 	#ifdef DEVELOP
@@ -6440,33 +6555,36 @@ static void SendChallengeResults(void)
 	uint8_t allZero[SIGNATURELENGTH];
 	memset(allZero, 0, sizeof(allZero));
 
-	memset(&netbuffer->u.resultsall, 0, sizeof(netbuffer->u.resultsall));
-
-	for (i = 0; i < MAXPLAYERS; i++)
+	for (first = 0; first < MAXPLAYERS; first += RESULTSALL_SLOTS)
 	{
-		if (!playeringame[i])
-			continue;
+		memset(&netbuffer->u.resultsall, 0, sizeof(netbuffer->u.resultsall));
 
-		// Don't try to transmit signatures for players who didn't get here in time to send one.
-		// (Everyone who had their chance should have been kicked by KickUnverifiedPlayers by now.)
-		if (memcmp(lastReceivedSignature[i], allZero, SIGNATURELENGTH) == 0)
-			continue;
+		for (i = first; i < first + RESULTSALL_SLOTS && i < MAXPLAYERS; i++)
+		{
+			if (!playeringame[i])
+				continue;
 
-		memcpy(netbuffer->u.resultsall.signature[i], lastReceivedSignature[i], sizeof(netbuffer->u.resultsall.signature[i]));
-		#ifdef DEVELOP
-			if (cv_badresults.value)
-			{
-				CV_AddValue(&cv_badresults, -1);
-				CONS_Alert(CONS_WARNING, "cv_badresults enabled, scrubbing signature from PT_RESULTSALL\n");
-				memset(netbuffer->u.resultsall.signature[i], 0, sizeof(netbuffer->u.resultsall.signature[i]));
-			}
-		#endif
-	}
+			// Don't try to transmit signatures for players who didn't get here in time to send one.
+			// (Everyone who had their chance should have been kicked by KickUnverifiedPlayers by now.)
+			if (memcmp(lastReceivedSignature[i], allZero, SIGNATURELENGTH) == 0)
+				continue;
 
-	for (i = 0; i < MAXNETNODES; i++)
-	{
-		if (nodeingame[i])
-			HSendPacket(i, true, 0, sizeof(resultsall_pak));
+			memcpy(netbuffer->u.resultsall.signature[i - first], lastReceivedSignature[i], sizeof(netbuffer->u.resultsall.signature[i - first]));
+			#ifdef DEVELOP
+				if (cv_badresults.value)
+				{
+					CV_AddValue(&cv_badresults, -1);
+					CONS_Alert(CONS_WARNING, "cv_badresults enabled, scrubbing signature from PT_RESULTSALL\n");
+					memset(netbuffer->u.resultsall.signature[i - first], 0, sizeof(netbuffer->u.resultsall.signature[i - first]));
+				}
+			#endif
+		}
+
+		for (i = 0; i < MAXNETNODES; i++)
+		{
+			if (nodeingame[i])
+				HSendPacket(i, true, 0, sizeof(resultsall_pak));
+		}
 	}
 }
 
@@ -6477,6 +6595,7 @@ static void CheckPresentPlayers(void)
 {
 	int i;
 	memset(knownWhenChallenged, 0, sizeof(knownWhenChallenged));
+	resultsallfirst = 0;
 
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -6600,6 +6719,14 @@ void NetKeepAlive(void)
 	FileSendTicker();
 }
 
+// Handle whatever has arrived since the last update, without waiting for a new tic.
+// Ticcmds land in the tic that's being built, and acks go out right away.
+void NetUpdatePackets(void)
+{
+	GetPackets();
+	Net_AckTicker();
+}
+
 // If a tree falls in the forest but nobody is around to hear it, does it make a tic?
 #define DEDICATEDIDLETIME (10*TICRATE)
 
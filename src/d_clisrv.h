@@ -34,7 +34,7 @@ The 'packet version' is used to distinguish packet formats.
 This version is independent of VERSION and SUBVERSION. Different
 applications may follow different packet versions.
 */
-#define PACKETVERSION 0
+#define PACKETVERSION (1 + (MAXPLAYERS != 16 ? MAXPLAYERS : 0))
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -200,14 +200,17 @@ struct client4cmd_pak
 
 // Server to client packet
 // this packet is too large
+// Each tic is a bitmap of the slots that have a ticcmd, then those ticcmds; the textcmds for every tic follow
 struct servertics_pak
 {
 	UINT8 starttic;
 	UINT8 numtics;
-	UINT8 numslots; // "Slots filled": Highest player number in use plus one.
-	ticcmd_t cmds[45]; // Normally [BACKUPTIC][MAXPLAYERS] but too large
+	UINT8 slotbytes; // Size of each bitmap, SERVERTICS_SLOTBYTES
+	UINT8 cmds[45 * sizeof (ticcmd_t)]; // Normally [BACKUPTIC][MAXPLAYERS] but too large
 } ATTRPACK;
 
+#define SERVERTICS_SLOTBYTES ((MAXPLAYERS + 7) / 8)
+
 struct serverconfig_pak
 {
 	UINT8 version; // Different versions don't work
@@ -388,9 +391,13 @@ struct responseall_pak
 	uint8_t signature[MAXSPLITSCREENPLAYERS][SIGNATURELENGTH];
 } ATTRPACK;
 
+// Every slot's signature doesn't fit in one packet past 16 players,
+// so they're sent this many at a time, in slot order.
+#define RESULTSALL_SLOTS 16
+
 struct resultsall_pak
 {
-	uint8_t signature[MAXPLAYERS][SIGNATURELENGTH];
+	uint8_t signature[RESULTSALL_SLOTS][SIGNATURELENGTH];
 } ATTRPACK;
 
 struct say_pak
@@ -595,6 +602,7 @@ void SendKick(UINT8 playernum, UINT8 msg);
 // Create any new ticcmds and broadcast to other players.
 void NetKeepAlive(void);
 void NetUpdate(void);
+void NetUpdatePackets(void);
 
 void SV_StartSinglePlayerServer(INT32 dogametype, boolean donetgame);
 boolean SV_SpawnServer(void);
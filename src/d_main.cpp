@@ -42,6 +42,8 @@
 #include "g_game.h"
 #include "hu_stuff.h"
 #include "i_joy.h"
+#include "i_lobby.h"
+#include "i_net.h"
 #include "i_sound.h"
 #include "i_system.h"
 #include "i_time.h"
@@ -69,9 +71,12 @@
 #include "m_cond.h" // condition initialization
 #include "fastcmp.h"
 #include "r_fps.h" // Frame interpolation/uncapped
+#include "r_gfxcache.h"
 #include "keys.h"
 #include "g_input.h" // tutorial mode control scheming
+#include "g_demoanalysis.h"
 #include "m_perfstats.h"
+#include "m_trace.h"
 #include "core/memory.h"
 
 #include "monocypher/monocypher.h"
@@ -147,6 +152,7 @@ static char *startuppwads[MAX_WADFILES];
 boolean devparm = false; // started game with -devparm
 
 boolean g_singletics = false; // timedemo
+boolean g_movieexport = false;
 boolean lastdraw = false;
 
 tic_t g_fast_forward = 0;
@@ -633,6 +639,7 @@ static bool D_Display(bool world)
 				}
 
 				ps_rendercalltime = I_GetPreciseTime() - ps_rendercalltime;
+				M_TraceDuration("Render", ps_rendercalltime);
 				R_RestoreLevelInterpolators();
 			}
 
@@ -750,6 +757,7 @@ static bool D_Display(bool world)
 	CON_Drawer();
 
 	ps_uitime = I_GetPreciseTime() - ps_uitime;
+	M_TraceDuration("UI", ps_uitime);
 
 	//
 	// wipe update
@@ -825,6 +833,7 @@ static bool D_Display(bool world)
 		ps_swaptime = I_GetPreciseTime();
 		I_FinishUpdate(); // page flip or blit buffer
 		ps_swaptime = I_GetPreciseTime() - ps_swaptime;
+		M_TraceDuration("I_FinishUpdate", ps_swaptime);
 	}
 
 	return ranwipe;
@@ -836,6 +845,24 @@ static bool D_Display(bool world)
 
 tic_t rendergametic;
 
+// A dedicated server has nothing to draw, so instead of sleeping off a frame it waits on its
+// sockets. Packets are handled as soon as they arrive, and the loop comes back around as soon
+// as the next tic is due.
+static void D_WaitForNextTic(void)
+{
+	ZoneScoped;
+
+	for (;;)
+	{
+		precise_t untilnexttic = I_GetPreciseTimeUntilNextTic();
+
+		if (untilnexttic == 0 || !I_NetWait(untilnexttic))
+			break;
+
+		NetUpdatePackets();
+	}
+}
+
 void D_SRB2Loop(void)
 {
 	tic_t entertic = 0, oldentertics = 0, realtics = 0, rendertimeout = INFTICS;
@@ -926,13 +953,19 @@ void D_SRB2Loop(void)
 			realtics = realtics * cv_playbackspeed.value;
 		}
 
+		if (g_movieexport)
+		{
+			// Exported movies advance exactly one tic per frame, however long the frame took.
+			realtics = 1;
+		}
+
 #ifdef DEBUGFILE
 		if (!realtics)
 			if (debugload)
 				debugload--;
 #endif
 
-		interp = R_UsingFrameInterpolation() && !dedicated;
+		interp = R_UsingFrameInterpolation() && !dedicated && !g_movieexport;
 		doDisplay = false;
 
 		renderisnewtic = (realtics > 0 || singletics);
@@ -954,6 +987,8 @@ void D_SRB2Loop(void)
 				TryRunTics(realtics);
 			}
 
+			M_TraceUpdate();
+
 			if (lastdraw || singletics || gametic > rendergametic)
 			{
 				rendergametic = gametic;
@@ -1083,6 +1118,11 @@ void D_SRB2Loop(void)
 
 		Music_Tick();
 
+		if (g_movieexport)
+		{
+			M_ExportMovieTic();
+		}
+
 		// Fully completed frame made.
 		finishprecise = I_GetPreciseTime();
 
@@ -1099,7 +1139,7 @@ void D_SRB2Loop(void)
 		//
 		// Wipes run an inner loop and artificially increase
 		// the measured time.
-		if (!ranwipe && frameskip < 3 && deltatics > 1.0)
+		if (!ranwipe && !g_movieexport && frameskip < 3 && deltatics > 1.0)
 		{
 			frameskip++;
 		}
@@ -1145,7 +1185,11 @@ void D_SRB2Loop(void)
 			skiplaggyworld = false;
 		}
 
-		if (!singletics)
+		if (dedicated && I_NetWait && !singletics)
+		{
+			D_WaitForNextTic();
+		}
+		else if (!singletics)
 		{
 			INT64 elapsed = (INT64)(finishprecise - enterprecise);
 
@@ -1478,6 +1522,9 @@ void D_SRB2Main(void)
 #endif
 	boolean autostart = false;
 	INT32 newgametype = -1;
+	INT32 lobby = 0;
+
+	M_TraceThreadName("Main");
 
 	/* break the version string into version numbers, for netplay */
 	D_ConvertVersionNumbers();
@@ -1841,6 +1888,9 @@ void D_SRB2Main(void)
 
 	CON_SetLoadingProgress(LOADED_CONFIG);
 
+	// Needs the config for its budget; pages the cache in while everything below loads
+	R_InitGfxCache();
+
 	CONS_Printf("R_InitTextureData()...\n");
 	R_InitTextureData(); // seperated out from below because it takes ages by itself
 	CON_SetLoadingProgress(LOADED_INITTEXTUREDATA);
@@ -1970,6 +2020,9 @@ void D_SRB2Main(void)
 		}
 	}
 
+	// Everything loaded up to here is shared between lobbies
+	lobby = I_StartLobbies();
+
 	// init all NETWORK
 	CONS_Printf("D_CheckNetGame(): Checking network game status.\n");
 	if (D_CheckNetGame())
@@ -1991,7 +2044,13 @@ void D_SRB2Main(void)
 
 	// user settings come before "+" parameters.
 	if (dedicated)
+	{
 		COM_ImmedExecute(va("exec \"%s" PATHSEP "ringserv.cfg\"\n", srb2home));
+
+		// and then this lobby's own
+		if (lobby)
+			COM_ImmedExecute(va("exec \"%s\" -noerror\n", configfile));
+	}
 	else
 		COM_ImmedExecute(va("exec \"%s" PATHSEP "ringexec.cfg\" -noerror\n", srb2home));
 
@@ -2002,6 +2061,8 @@ void D_SRB2Main(void)
 	p = M_CheckParm("-playdemo");
 	if (!p)
 		p = M_CheckParm("-timedemo");
+	if (!p)
+		p = M_CheckParm("-analyzedemo");
 	if (p && M_IsNextParm())
 	{
 		char tmp[MAX_WADPATH];
@@ -2023,8 +2084,25 @@ void D_SRB2Main(void)
 
 		if (M_CheckParm("-playdemo"))
 		{
-			demo.quitafterplaying = true; // quit after one demo
-			G_DeferedPlayDemo(tmp);
+			if (M_CheckParm("-exportmovie"))
+			{
+				CONS_Printf(M_GetText("Exporting demo to video.\n"));
+				G_ExportDemo(tmp);
+			}
+			else
+			{
+				demo.quitafterplaying = true; // quit after one demo
+				G_DeferedPlayDemo(tmp);
+			}
+		}
+		else if (M_CheckParm("-analyzedemo"))
+		{
+			const char *outpath = NULL;
+
+			if (M_CheckParm("-analysisout") && M_IsNextParm())
+				outpath = M_GetNextParm();
+
+			G_AnalyzeDemo(tmp, outpath);
 		}
 		else
 			G_TimeDemo(tmp);
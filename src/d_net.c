@@ -76,6 +76,7 @@ boolean (*I_NetGet)(void) = NULL;
 void (*I_NetSend)(void) = NULL;
 boolean (*I_NetCanSend)(void) = NULL;
 boolean (*I_NetCanGet)(void) = NULL;
+boolean (*I_NetWait)(precise_t duration) = NULL;
 void (*I_NetCloseSocket)(void) = NULL;
 void (*I_NetFreeNodenum)(INT32 nodenum) = NULL;
 SINT8 (*I_NetMakeNodewPort)(const char *address, const char* port) = NULL;
@@ -92,6 +93,7 @@ bannednode_t *bannednode = NULL;
 static tic_t statstarttic;
 INT32 getbytes = 0;
 INT64 sendbytes = 0;
+INT64 recvbytes = 0;
 static INT32 retransmit = 0, duppacket = 0;
 static INT32 sendackpacket = 0, getackpacket = 0;
 INT32 ticruned = 0, ticmiss = 0;
@@ -844,11 +846,12 @@ static void DebugPrintpacket(const char *header)
 		case PT_SERVERTICS:
 		{
 			servertics_pak *serverpak = &netbuffer->u.serverpak;
-			UINT8 *cmd = (UINT8 *)(&serverpak->cmds[serverpak->numslots * serverpak->numtics]);
+			UINT8 *cmd = serverpak->cmds;
 			size_t ntxtcmd = &((UINT8 *)netbuffer)[doomcom->datalength] - cmd;
 
-			fprintf(debugfile, "    firsttic %u ply %d tics %d ntxtcmd %s\n",
-				(UINT32)serverpak->starttic, serverpak->numslots, serverpak->numtics, sizeu1(ntxtcmd));
+			// The ticcmds are variable size now, so this dumps them along with the textcmds
+			fprintf(debugfile, "    firsttic %u slots %d tics %d size %s\n",
+				(UINT32)serverpak->starttic, serverpak->slotbytes * 8, serverpak->numtics, sizeu1(ntxtcmd));
 			/// \todo Display more readable information about net commands
 			fprintfstringnewline((char *)cmd, ntxtcmd);
 			/*fprintfstring((char *)cmd, 3);
@@ -1210,6 +1213,7 @@ boolean HGetPacket(void)
 			return false;
 
 		getbytes += packetheaderlength + doomcom->datalength; // For stat
+		recvbytes += packetheaderlength + doomcom->datalength;
 
 		if (doomcom->remotenode >= MAXNETNODES)
 		{
@@ -1332,6 +1336,7 @@ boolean D_CheckNetGame(void)
 	I_NetGet = Internal_Get;
 	I_NetSend = Internal_Send;
 	I_NetCanSend = NULL;
+	I_NetWait = NULL;
 	I_NetCloseSocket = NULL;
 	I_NetFreeNodenum = Internal_FreeNodenum;
 	I_NetMakeNodewPort = NULL;
@@ -1542,6 +1547,7 @@ void D_CloseConnection(void)
 		I_NetGet = Internal_Get;
 		I_NetSend = Internal_Send;
 		I_NetCanSend = NULL;
+		I_NetWait = NULL;
 		I_NetCloseSocket = NULL;
 		I_NetFreeNodenum = Internal_FreeNodenum;
 		I_NetMakeNodewPort = NULL;
@@ -42,6 +42,7 @@ extern INT32 packetheaderlength;
 boolean Net_GetNetStat(void);
 extern INT32 getbytes;
 extern INT64 sendbytes; // Realtime updated
+extern INT64 recvbytes; // Realtime updated
 
 #define PACKETMEASUREWINDOW (TICRATE*2)
 extern boolean packetloss[MAXPLAYERS][PACKETMEASUREWINDOW];
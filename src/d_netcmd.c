@@ -73,6 +73,9 @@
 #include "k_bans.h"
 #include "k_director.h"
 #include "k_credits.h"
+#include "m_trace.h"
+#include "d_soak.h"
+#include "acs/interface.h"
 
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 #include "m_avrecorder.h"
@@ -241,6 +244,7 @@ CV_PossibleValue_t perfstats_cons_t[] = {
 	{PS_LOGIC, "Logic"},
 	{PS_BOT, "Bots"},
 	{PS_THINKFRAME, "ThinkFrame"},
+	{PS_ACS, "ACS"},
 	{0, NULL}
 };
 
@@ -420,6 +424,9 @@ void D_RegisterServerCommands(void)
 	COM_AddCommand("quit", Command_Quit_f);
 
 	COM_AddCommand("saveconfig", Command_SaveConfig_f);
+	COM_AddCommand("tracedump", M_TraceDump_f);
+	COM_AddCommand("soaktest", D_SoakTest_f);
+	COM_AddCommand("acsprofile", ACS_Profile_f);
 	COM_AddCommand("loadconfig", Command_LoadConfig_f);
 	COM_AddCommand("changeconfig", Command_ChangeConfig_f);
 	COM_AddDebugCommand("isgamemodified", Command_Isgamemodified_f); // test
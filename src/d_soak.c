@@ -0,0 +1,126 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  d_soak.c
+/// \brief Soak test: a full server of bots, timed
+///
+///        Fills every slot up to MAXPLAYERS with bots, then reports how long
+///        the tics took and how much went over the wire, so builds with a
+///        larger MAXPLAYERS can be checked against the tic budget.
+
+#include "d_soak.h"
+#include "command.h"
+#include "console.h"
+#include "d_clisrv.h"
+#include "d_net.h"
+#include "d_netcmd.h"
+#include "doomstat.h"
+
+static struct
+{
+	boolean running;
+	tic_t tics; // left to count
+	tic_t counted;
+	precise_t total;
+	precise_t worst;
+	INT64 sendstart;
+	INT64 recvstart;
+	INT32 oldmaxplayers; // put back once it's over
+	INT32 oldkartbot;
+} soak;
+
+static void D_SoakReport(void)
+{
+	const double precision = (double)I_GetPrecisePrecision();
+	const double seconds = (double)soak.counted / TICRATE;
+
+	soak.running = false;
+
+	CV_SetValue(&cv_maxplayers, soak.oldmaxplayers);
+	CV_SetValue(&cv_kartbot, soak.oldkartbot);
+
+	if (!soak.counted)
+		return;
+
+	CONS_Printf("Soak test: %d players, %u tics\n", D_NumPlayers(), soak.counted);
+	CONS_Printf("  tic time: %.3f ms average, %.3f ms worst (budget %.3f ms)\n",
+		(double)soak.total * 1000.0 / precision / soak.counted,
+		(double)soak.worst * 1000.0 / precision,
+		1000.0 / TICRATE);
+	CONS_Printf("  sent %.1f KB/s, received %.1f KB/s\n",
+		(double)(sendbytes - soak.sendstart) / 1024.0 / seconds,
+		(double)(recvbytes - soak.recvstart) / 1024.0 / seconds);
+}
+
+void D_SoakTest_f(void)
+{
+	INT32 seconds = 60;
+
+	if (!server)
+	{
+		CONS_Printf("Only the server can run a soak test.\n");
+		return;
+	}
+
+	if (gamestate != GS_LEVEL)
+	{
+		CONS_Printf("You must be in a level to use this.\n");
+		return;
+	}
+
+	if (COM_Argc() > 1)
+		seconds = atoi(COM_Argv(1));
+
+	if (seconds <= 0)
+	{
+		if (soak.running)
+			D_SoakReport();
+		return;
+	}
+
+	if (!soak.running)
+	{
+		soak.oldmaxplayers = cv_maxplayers.value;
+		soak.oldkartbot = cv_kartbot.value;
+	}
+
+	// K_UpdateMatchRaceBots takes it from here
+	CV_SetValue(&cv_maxplayers, MAXPLAYERS);
+	if (!cv_kartbot.value)
+		CV_SetValue(&cv_kartbot, 9);
+
+	soak.running = true;
+	soak.tics = seconds * TICRATE;
+	soak.counted = 0;
+	soak.total = soak.worst = 0;
+	soak.sendstart = sendbytes;
+	soak.recvstart = recvbytes;
+
+	CONS_Printf("Soak testing for %d seconds, up to %d players...\n", seconds, MAXPLAYERS);
+}
+
+void D_SoakTic(precise_t tictime)
+{
+	if (!soak.running)
+		return;
+
+	if (gamestate != GS_LEVEL)
+	{
+		D_SoakReport();
+		return;
+	}
+
+	soak.total += tictime;
+	if (tictime > soak.worst)
+		soak.worst = tictime;
+
+	soak.counted++;
+
+	if (--soak.tics == 0)
+		D_SoakReport();
+}
@@ -0,0 +1,32 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  d_soak.h
+/// \brief Soak test: a full server of bots, timed
+
+#ifndef __D_SOAK_H__
+#define __D_SOAK_H__
+
+#include "doomdef.h"
+#include "i_system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// soaktest [seconds]
+void D_SoakTest_f(void);
+
+// Counts one game tic that took tictime.
+void D_SoakTic(precise_t tictime);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __D_SOAK_H__
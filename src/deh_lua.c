@@ -25,6 +25,7 @@
 #include "dehacked.h"
 #include "deh_lua.h"
 #include "deh_tables.h"
+#include "deh_symbols.h"
 #include "deh_soc.h" // freeslotusage
 
 // freeslot takes a name (string only!)
@@ -96,6 +97,7 @@ static inline int lib_freeslot(lua_State *L)
 				strncpy(sprnames[j],word,4);
 				//sprnames[j][4] = 0;
 				used_spr[(j-SPR_FIRSTFREESLOT)/8] |= 1<<(j%8); // Okay, this sprite slot has been named now.
+				DEH_AddFreeslotSymbol(DEHSYM_SPRITE, sprnames[j], j);
 				lua_pushinteger(L, j);
 				r++;
 				break;
@@ -111,6 +113,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("State S_%s allocated.\n",word);
 					FREE_STATES[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_STATES[i],word);
+					DEH_AddFreeslotSymbol(DEHSYM_STATE, FREE_STATES[i], S_FIRSTFREESLOT + i);
 					freeslotusage[0][0]++;
 					lua_pushinteger(L, S_FIRSTFREESLOT + i);
 					r++;
@@ -127,6 +130,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("MobjType MT_%s allocated.\n",word);
 					FREE_MOBJS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_MOBJS[i],word);
+					DEH_AddFreeslotSymbol(DEHSYM_MOBJTYPE, FREE_MOBJS[i], MT_FIRSTFREESLOT + i);
 					freeslotusage[1][0]++;
 					lua_pushinteger(L, MT_FIRSTFREESLOT + i);
 					r++;
@@ -143,6 +147,7 @@ static inline int lib_freeslot(lua_State *L)
 					CONS_Printf("Skincolor SKINCOLOR_%s allocated.\n",word);
 					FREE_SKINCOLORS[i] = Z_Malloc(strlen(word)+1, PU_STATIC, NULL);
 					strcpy(FREE_SKINCOLORS[i],word);
+					DEH_AddFreeslotSymbol(DEHSYM_SKINCOLOR, FREE_SKINCOLORS[i], SKINCOLOR_FIRSTFREESLOT + i);
 					skincolors[i].cache_spraycan = UINT16_MAX;
 					numskincolors++;
 					lua_pushinteger(L, SKINCOLOR_FIRSTFREESLOT + i);
@@ -251,6 +256,7 @@ static inline int lib_getenum(lua_State *L)
 {
 	const char *word, *p;
 	fixed_t i;
+	lua_Integer value;
 	boolean mathlib = lua_toboolean(L, lua_upvalueindex(1));
 	if (lua_type(L,2) != LUA_TSTRING)
 		return 0;
@@ -266,31 +272,28 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("MF_", word, 3)) {
 		p = word+3;
-		for (i = 0; MOBJFLAG_LIST[i]; i++)
-			if (fastcmp(p, MOBJFLAG_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_MOBJFLAG, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "mobjflag '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("MF2_", word, 4)) {
 		p = word+4;
-		for (i = 0; MOBJFLAG2_LIST[i]; i++)
-			if (fastcmp(p, MOBJFLAG2_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_MOBJFLAG2, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "mobjflag2 '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("MFE_", word, 4)) {
 		p = word+4;
-		for (i = 0; MOBJEFLAG_LIST[i]; i++)
-			if (fastcmp(p, MOBJEFLAG_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_MOBJEFLAG, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "mobjeflag '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -306,11 +309,10 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("PF_", word, 3)) {
 		p = word+3;
-		for (i = 0; PLAYERFLAG_LIST[i]; i++)
-			if (fastcmp(p, PLAYERFLAG_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_PLAYERFLAG, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "playerflag '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -331,11 +333,10 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("GTR_", word, 4)) {
 		p = word+4;
-		for (i = 0; GAMETYPERULE_LIST[i]; i++)
-			if (fastcmp(p, GAMETYPERULE_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_GAMETYPERULE, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "game type rule '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -351,11 +352,10 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("ML_", word, 3)) {
 		p = word+3;
-		for (i = 0; ML_LIST[i]; i++)
-			if (fastcmp(p, ML_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1<<i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_LINEFLAG, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		// Aliases
 		if (fastcmp(p, "EFFECT1"))
 		{
@@ -387,11 +387,10 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("MSF_", word, 4)) {
 		p = word + 4;
-		for (i = 0; MSF_LIST[i]; i++)
-			if (fastcmp(p, MSF_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1 << i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SECTORFLAG, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (fastcmp(p, "FLIPSPECIAL_BOTH"))
 		{
 			lua_pushinteger(L, (lua_Integer)MSF_FLIPSPECIAL_BOTH);
@@ -402,31 +401,28 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("SSF_", word, 4)) {
 		p = word + 4;
-		for (i = 0; SSF_LIST[i]; i++)
-			if (fastcmp(p, SSF_LIST[i])) {
-				lua_pushinteger(L, ((lua_Integer)1 << i));
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SECTORSPECIALFLAG, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "sector special flag '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("SD_", word, 3)) {
 		p = word + 3;
-		for (i = 0; SD_LIST[i]; i++)
-			if (fastcmp(p, SD_LIST[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SECTORDAMAGE, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "sector damagetype '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (fastncmp("TO_", word, 3)) {
 		p = word + 3;
-		for (i = 0; TO_LIST[i]; i++)
-			if (fastcmp(p, TO_LIST[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SECTORTRIGGER, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "sector triggerer '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -437,19 +433,10 @@ static inline int lib_getenum(lua_State *L)
 			lua_pushinteger(L, S_FIRSTFREESLOT);
 			return 1;
 		}
-		for (i = 0; i < NUMSTATEFREESLOTS; i++) {
-			if (!FREE_STATES[i])
-				break;
-			if (fastcmp(p, FREE_STATES[i])) {
-				lua_pushinteger(L, S_FIRSTFREESLOT+i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_STATE, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
 		}
-		for (i = 0; i < S_FIRSTFREESLOT; i++)
-			if (fastcmp(p, STATE_LIST[i]+2)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "state '%s' does not exist.\n", word);
 	}
 	else if (fastncmp("MT_",word,3)) {
@@ -459,19 +446,10 @@ static inline int lib_getenum(lua_State *L)
 			lua_pushinteger(L, MT_FIRSTFREESLOT);
 			return 1;
 		}
-		for (i = 0; i < NUMMOBJFREESLOTS; i++) {
-			if (!FREE_MOBJS[i])
-				break;
-			if (fastcmp(p, FREE_MOBJS[i])) {
-				lua_pushinteger(L, MT_FIRSTFREESLOT+i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_MOBJTYPE, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
 		}
-		for (i = 0; i < MT_FIRSTFREESLOT; i++)
-			if (fastcmp(p, MOBJTYPE_LIST[i]+3)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "mobjtype '%s' does not exist.\n", word);
 	}
 	else if (fastncmp("SPR_",word,4)) {
@@ -481,11 +459,10 @@ static inline int lib_getenum(lua_State *L)
 			lua_pushinteger(L, SPR_FIRSTFREESLOT);
 			return 1;
 		}
-		for (i = 0; i < NUMSPRITES; i++)
-			if (!sprnames[i][4] && fastncmp(p,sprnames[i],4)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SPRITE, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "sprite '%s' could not be found.\n", word);
 		return 0;
 	}
@@ -512,65 +489,51 @@ static inline int lib_getenum(lua_State *L)
 	}
 	else if (fastncmp("sfx_",word,4)) {
 		p = word+4;
-		for (i = 0; i < NUMSFX; i++)
-			if (S_sfx[i].name && fastcmp(p, S_sfx[i].name)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SFX, p, &value) && fastcmp(p, S_sfx[value].name)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		return 0;
 	}
 	else if (mathlib && fastncmp("SFX_",word,4)) { // SOCs are ALL CAPS!
 		p = word+4;
-		for (i = 0; i < NUMSFX; i++)
-			if (S_sfx[i].name && fasticmp(p, S_sfx[i].name)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SFX, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		return luaL_error(L, "sfx '%s' could not be found.\n", word);
 	}
 	else if (mathlib && fastncmp("DS",word,2)) {
 		p = word+2;
-		for (i = 0; i < NUMSFX; i++)
-			if (S_sfx[i].name && fasticmp(p, S_sfx[i].name)) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SFX, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		if (mathlib) return luaL_error(L, "sfx '%s' could not be found.\n", word);
 		return 0;
 	}
 	else if (!mathlib && fastncmp("khud_",word,5)) {
 		p = word+5;
-		for (i = 0; i < NUMKARTHUD; i++)
-			if (fasticmp(p, KARTHUD_LIST[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_KARTHUD, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		return luaL_error(L, "karthud '%s' could not be found.\n", word);
 	}
 	else if (mathlib && fastncmp("KHUD_",word,5)) { // SOCs are ALL CAPS!
 		p = word+5;
-		for (i = 0; i < NUMKARTHUD; i++)
-			if (fastcmp(p, KARTHUD_LIST[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_KARTHUD, p, &value) && fastcmp(p, KARTHUD_LIST[value])) {
+			lua_pushinteger(L, value);
+			return 1;
+		}
 		return luaL_error(L, "karthud '%s' could not be found.\n", word);
 	}
 	else if (fastncmp("SKINCOLOR_",word,10)) {
 		p = word+10;
-		for (i = 0; i < NUMCOLORFREESLOTS; i++) {
-			if (!FREE_SKINCOLORS[i])
-				break;
-			if (fastcmp(p, FREE_SKINCOLORS[i])) {
-				lua_pushinteger(L, SKINCOLOR_FIRSTFREESLOT+i);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_SKINCOLOR, p, &value)) {
+			lua_pushinteger(L, value);
+			return 1;
 		}
-		for (i = 0; i < SKINCOLOR_FIRSTFREESLOT; i++)
-			if (fastcmp(p, COLOR_ENUMS[i])) {
-				lua_pushinteger(L, i);
-				return 1;
-			}
 		return luaL_error(L, "skincolor '%s' could not be found.\n", word);
 	}
 	else if (fastncmp("PRECIP_",word,7)) {
@@ -605,12 +568,11 @@ static inline int lib_getenum(lua_State *L)
 
 		// Hardcoded actions as callable Lua functions!
 		// Retrieving them from this metatable allows them to be case-insensitive!
-		for (i = 0; actionpointers[i].name; i++)
-			if (fasticmp(word, actionpointers[i].name)) {
-				// We push the actionf_t* itself as userdata!
-				LUA_PushUserdata(L, &actionpointers[i].action, META_ACTION);
-				return 1;
-			}
+		if (DEH_FindSymbol(DEHSYM_ACTION, word, &value)) {
+			// We push the actionf_t* itself as userdata!
+			LUA_PushUserdata(L, &actionpointers[value].action, META_ACTION);
+			return 1;
+		}
 		return 0;
 	}
 	else if (!mathlib && fastcmp("super",word))
@@ -628,11 +590,10 @@ static inline int lib_getenum(lua_State *L)
 		return 0;
 	}
 
-	for (i = 0; INT_CONST[i].n; i++)
-		if (fastcmp(word,INT_CONST[i].n)) {
-			lua_pushinteger(L, INT_CONST[i].v);
-			return 1;
-		}
+	if (DEH_FindSymbol(DEHSYM_CONSTANT, word, &value)) {
+		lua_pushinteger(L, value);
+		return 1;
+	}
 
 	if (mathlib) return luaL_error(L, "constant '%s' could not be parsed.\n", word);
 
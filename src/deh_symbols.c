@@ -0,0 +1,319 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  deh_symbols.c
+/// \brief Hashed lookup of DeHackEd constants, for SOC and Lua alike
+///
+///        Every name that get_mobjtype and friends, and Lua's global constant
+///        lookup, used to find by walking a table goes into one open-addressed
+///        hash table, built the first time anything is looked up. Freeslots are
+///        added as they're claimed, following the same precedence the linear
+///        searches had: the first builtin of a name wins, and a freeslot beats
+///        a builtin but not an earlier freeslot.
+///
+///        Sprite and sound slots can be renamed underneath the table, so those
+///        entries are checked against the slot when found, and fall back to the
+///        old search when they no longer hold.
+
+#include "doomdef.h"
+#include "d_player.h" // NUMKARTHUD
+#include "fastcmp.h"
+#include "info.h"
+#include "sounds.h"
+#include "z_zone.h"
+
+#include "deh_symbols.h"
+#include "deh_tables.h"
+
+struct dehsymbol_t
+{
+	const char *name; // NULL for an empty slot
+	UINT32 hash;
+	UINT8 kind;
+	boolean freeslot;
+	lua_Integer value;
+};
+
+static struct
+{
+	struct dehsymbol_t *symbols;
+	size_t capacity; // power of two, kept at least twice count
+	size_t count;
+} symtable;
+
+static boolean DEH_SymbolFoldsCase(dehsymbolkind_t kind)
+{
+	return (kind == DEHSYM_SFX || kind == DEHSYM_KARTHUD || kind == DEHSYM_ACTION);
+}
+
+// These are keyed on a copy of the name, since their slots can be renamed.
+static boolean DEH_SymbolIsMutable(dehsymbolkind_t kind)
+{
+	return (kind == DEHSYM_SPRITE || kind == DEHSYM_SFX);
+}
+
+static boolean DEH_SpriteNameComplete(const char *name)
+{
+	return (name[0] && name[1] && name[2] && name[3]);
+}
+
+// FNV-1a, over the kind and then the name
+static UINT32 DEH_HashSymbol(dehsymbolkind_t kind, const char *name)
+{
+	const boolean fold = DEH_SymbolFoldsCase(kind);
+	size_t n = (kind == DEHSYM_SPRITE) ? 4 : SIZE_MAX;
+	UINT32 hash = (2166136261u ^ (UINT32)kind) * 16777619u;
+
+	for (; *name && n; name++, n--)
+	{
+		hash ^= (UINT8)(fold ? toupper(*name) : *name);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static boolean DEH_SymbolMatches(const struct dehsymbol_t *sym, dehsymbolkind_t kind, UINT32 hash, const char *name)
+{
+	if (sym->kind != kind || sym->hash != hash)
+		return false;
+
+	if (kind == DEHSYM_SPRITE)
+		return (memcmp(sym->name, name, 4) == 0);
+
+	if (DEH_SymbolFoldsCase(kind))
+		return fasticmp(sym->name, name);
+
+	return fastcmp(sym->name, name);
+}
+
+// Whether the slot this symbol was found in still goes by that name
+static boolean DEH_SymbolStillNamed(const struct dehsymbol_t *sym)
+{
+	switch (sym->kind)
+	{
+		case DEHSYM_SPRITE:
+			return (!sprnames[sym->value][4] && memcmp(sprnames[sym->value], sym->name, 4) == 0);
+		case DEHSYM_SFX:
+			return (S_sfx[sym->value].name && fasticmp(S_sfx[sym->value].name, sym->name));
+		default:
+			return true;
+	}
+}
+
+static struct dehsymbol_t *DEH_SymbolSlot(dehsymbolkind_t kind, UINT32 hash, const char *name)
+{
+	const size_t mask = symtable.capacity - 1;
+	size_t i = hash & mask;
+
+	while (symtable.symbols[i].name && !DEH_SymbolMatches(&symtable.symbols[i], kind, hash, name))
+		i = (i + 1) & mask;
+
+	return &symtable.symbols[i];
+}
+
+static void DEH_GrowSymbols(void)
+{
+	struct dehsymbol_t *old = symtable.symbols;
+	const size_t oldcapacity = symtable.capacity;
+	size_t i;
+
+	symtable.capacity = oldcapacity ? oldcapacity * 2 : 16384;
+	symtable.symbols = Z_Calloc(symtable.capacity * sizeof (struct dehsymbol_t), PU_STATIC, NULL);
+
+	for (i = 0; i < oldcapacity; i++)
+	{
+		if (old[i].name)
+			*DEH_SymbolSlot(old[i].kind, old[i].hash, old[i].name) = old[i];
+	}
+
+	if (old)
+		Z_Free(old);
+}
+
+static void DEH_SetSymbol(dehsymbolkind_t kind, const char *name, lua_Integer value, boolean freeslot, boolean replace)
+{
+	UINT32 hash;
+	struct dehsymbol_t *sym;
+
+	if (!name || !*name || (kind == DEHSYM_SPRITE && !DEH_SpriteNameComplete(name)))
+		return;
+
+	if ((symtable.count + 1) * 2 > symtable.capacity)
+		DEH_GrowSymbols();
+
+	hash = DEH_HashSymbol(kind, name);
+	sym = DEH_SymbolSlot(kind, hash, name);
+
+	if (sym->name)
+	{
+		if (replace)
+		{
+			sym->value = value;
+			sym->freeslot = freeslot;
+		}
+		return;
+	}
+
+	if (kind == DEHSYM_SPRITE)
+	{
+		char *copy = Z_Malloc(5, PU_STATIC, NULL);
+		memcpy(copy, name, 4);
+		copy[4] = '\0';
+		name = copy;
+	}
+	else if (DEH_SymbolIsMutable(kind))
+	{
+		name = Z_StrDup(name);
+	}
+
+	sym->name = name;
+	sym->hash = hash;
+	sym->kind = kind;
+	sym->freeslot = freeslot;
+	sym->value = value;
+	symtable.count++;
+}
+
+static void DEH_AddFlagSymbols(dehsymbolkind_t kind, const char *const *list)
+{
+	INT32 i;
+
+	for (i = 0; list[i]; i++)
+		DEH_SetSymbol(kind, list[i], ((lua_Integer)1 << i), false, false);
+}
+
+static void DEH_BuildSymbols(void)
+{
+	INT32 i;
+
+	DEH_GrowSymbols();
+
+	for (i = 0; i < S_FIRSTFREESLOT; i++)
+		DEH_SetSymbol(DEHSYM_STATE, STATE_LIST[i] + 2, i, false, false);
+	for (i = 0; i < MT_FIRSTFREESLOT; i++)
+		DEH_SetSymbol(DEHSYM_MOBJTYPE, MOBJTYPE_LIST[i] + 3, i, false, false);
+	for (i = 0; i < SKINCOLOR_FIRSTFREESLOT; i++)
+		DEH_SetSymbol(DEHSYM_SKINCOLOR, COLOR_ENUMS[i], i, false, false);
+	for (i = 0; i < NUMSPRITES; i++)
+	{
+		if (!sprnames[i][4])
+			DEH_SetSymbol(DEHSYM_SPRITE, sprnames[i], i, false, false);
+	}
+	for (i = 0; i < NUMSFX; i++)
+		DEH_SetSymbol(DEHSYM_SFX, S_sfx[i].name, i, false, false);
+
+	DEH_AddFlagSymbols(DEHSYM_MOBJFLAG, MOBJFLAG_LIST);
+	DEH_AddFlagSymbols(DEHSYM_MOBJFLAG2, MOBJFLAG2_LIST);
+	DEH_AddFlagSymbols(DEHSYM_MOBJEFLAG, MOBJEFLAG_LIST);
+	DEH_AddFlagSymbols(DEHSYM_PLAYERFLAG, PLAYERFLAG_LIST);
+	DEH_AddFlagSymbols(DEHSYM_GAMETYPERULE, GAMETYPERULE_LIST);
+	DEH_AddFlagSymbols(DEHSYM_LINEFLAG, ML_LIST);
+	DEH_AddFlagSymbols(DEHSYM_SECTORFLAG, MSF_LIST);
+	DEH_AddFlagSymbols(DEHSYM_SECTORSPECIALFLAG, SSF_LIST);
+
+	// Not flags, just indices
+	for (i = 0; SD_LIST[i]; i++)
+		DEH_SetSymbol(DEHSYM_SECTORDAMAGE, SD_LIST[i], i, false, false);
+	for (i = 0; TO_LIST[i]; i++)
+		DEH_SetSymbol(DEHSYM_SECTORTRIGGER, TO_LIST[i], i, false, false);
+	for (i = 0; i < NUMKARTHUD; i++)
+		DEH_SetSymbol(DEHSYM_KARTHUD, KARTHUD_LIST[i], i, false, false);
+	for (i = 0; actionpointers[i].name; i++)
+		DEH_SetSymbol(DEHSYM_ACTION, actionpointers[i].name, i, false, false);
+	for (i = 0; INT_CONST[i].n; i++)
+		DEH_SetSymbol(DEHSYM_CONSTANT, INT_CONST[i].n, INT_CONST[i].v, false, false);
+
+	// Anything claimed before the first lookup
+	for (i = 0; i < NUMSTATEFREESLOTS && FREE_STATES[i]; i++)
+		DEH_AddFreeslotSymbol(DEHSYM_STATE, FREE_STATES[i], S_FIRSTFREESLOT + i);
+	for (i = 0; i < NUMMOBJFREESLOTS && FREE_MOBJS[i]; i++)
+		DEH_AddFreeslotSymbol(DEHSYM_MOBJTYPE, FREE_MOBJS[i], MT_FIRSTFREESLOT + i);
+	for (i = 0; i < NUMCOLORFREESLOTS && FREE_SKINCOLORS[i]; i++)
+		DEH_AddFreeslotSymbol(DEHSYM_SKINCOLOR, FREE_SKINCOLORS[i], SKINCOLOR_FIRSTFREESLOT + i);
+}
+
+boolean DEH_FindSymbol(dehsymbolkind_t kind, const char *name, lua_Integer *value)
+{
+	UINT32 hash;
+	const struct dehsymbol_t *sym;
+	INT32 i;
+
+	if (kind == DEHSYM_SPRITE && !DEH_SpriteNameComplete(name))
+		return false;
+
+	if (!symtable.symbols)
+		DEH_BuildSymbols();
+
+	hash = DEH_HashSymbol(kind, name);
+	sym = DEH_SymbolSlot(kind, hash, name);
+
+	if (sym->name && DEH_SymbolStillNamed(sym))
+	{
+		*value = sym->value;
+		return true;
+	}
+
+	// The slot was renamed, or the name moved to another one
+	if (kind == DEHSYM_SPRITE)
+	{
+		for (i = 0; i < NUMSPRITES; i++)
+		{
+			if (!sprnames[i][4] && memcmp(name, sprnames[i], 4) == 0)
+				break;
+		}
+		if (i == NUMSPRITES)
+			return false;
+	}
+	else if (kind == DEHSYM_SFX)
+	{
+		for (i = 0; i < NUMSFX; i++)
+		{
+			if (S_sfx[i].name && fasticmp(name, S_sfx[i].name))
+				break;
+		}
+		if (i == NUMSFX)
+			return false;
+	}
+	else
+	{
+		return false;
+	}
+
+	DEH_SetSymbol(kind, name, i, false, true);
+	*value = i;
+	return true;
+}
+
+void DEH_AddFreeslotSymbol(dehsymbolkind_t kind, const char *name, lua_Integer value)
+{
+	struct dehsymbol_t *sym;
+
+	if (!symtable.symbols)
+	{
+		// Building picks this one up along with the rest
+		DEH_BuildSymbols();
+		return;
+	}
+
+	if (DEH_SymbolIsMutable(kind))
+	{
+		// Searches went in slot order, so the name stays with its old slot
+		// for as long as that slot holds it
+		if (kind == DEHSYM_SPRITE && !DEH_SpriteNameComplete(name))
+			return;
+
+		sym = DEH_SymbolSlot(kind, DEH_HashSymbol(kind, name), name);
+		DEH_SetSymbol(kind, name, value, true, !(sym->name && DEH_SymbolStillNamed(sym)));
+		return;
+	}
+
+	// Freeslots were searched before the builtins, in order
+	sym = DEH_SymbolSlot(kind, DEH_HashSymbol(kind, name), name);
+	DEH_SetSymbol(kind, name, value, true, !(sym->name && sym->freeslot));
+}
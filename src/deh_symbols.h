@@ -0,0 +1,58 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  deh_symbols.h
+/// \brief Hashed lookup of DeHackEd constants, for SOC and Lua alike
+
+#ifndef __DEH_SYMBOLS_H__
+#define __DEH_SYMBOLS_H__
+
+#include "doomdef.h"
+#include "lua_script.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+	DEHSYM_STATE,
+	DEHSYM_MOBJTYPE,
+	DEHSYM_SKINCOLOR,
+	DEHSYM_SPRITE,
+	DEHSYM_SFX,
+	DEHSYM_MOBJFLAG,
+	DEHSYM_MOBJFLAG2,
+	DEHSYM_MOBJEFLAG,
+	DEHSYM_PLAYERFLAG,
+	DEHSYM_GAMETYPERULE,
+	DEHSYM_LINEFLAG,
+	DEHSYM_SECTORFLAG,
+	DEHSYM_SECTORSPECIALFLAG,
+	DEHSYM_SECTORDAMAGE,
+	DEHSYM_SECTORTRIGGER,
+	DEHSYM_KARTHUD,
+	DEHSYM_ACTION, // index into actionpointers
+	DEHSYM_CONSTANT, // INT_CONST, by full name
+	NUMDEHSYMBOLKINDS
+} dehsymbolkind_t;
+
+// Finds name, without its prefix (MT_, S_...), among the constants of that
+// kind. Flags come back as their bit, not their index. Sprites match on their
+// first four characters; sounds, kart HUD entries and actions ignore case.
+boolean DEH_FindSymbol(dehsymbolkind_t kind, const char *name, lua_Integer *value);
+
+// Adds a freeslot as it is claimed. name must outlive the table, as the
+// FREE_ arrays and sprnames do.
+void DEH_AddFreeslotSymbol(dehsymbolkind_t kind, const char *name, lua_Integer value);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __DEH_SYMBOLS_H__
@@ -162,10 +162,20 @@ extern char logfilename[1024];
 // =========================================================================
 
 // The maximum number of players, multiplayer/networking.
-// NOTE: it needs more than this to increase the number of players...
+// Set SRB2_CONFIG_MAXPLAYERS to build for bigger lobbies; only builds
+// with the same value can play together (see PACKETVERSION).
 
+#ifndef MAXPLAYERS
 #define MAXPLAYERS 16
+#endif
 #define PLAYERSMASK (MAXPLAYERS-1)
+
+// Past 32, playeringame no longer fits the 32-bit mask savegames
+// store it in, and player starts run into other map thing types.
+#if MAXPLAYERS != 16 && MAXPLAYERS != 32
+#error MAXPLAYERS must be 16 or 32
+#endif
+
 #define MAXPLAYERNAME 21
 #define MAXSPLITSCREENPLAYERS 4 // Max number of players on a single computer
 #define MAXGAMEPADS (MAXSPLITSCREENPLAYERS * 2) // Number of gamepads we'll be allowing
@@ -939,6 +939,7 @@ extern INT16 wipetypepost;
 
 // debug flag to cancel adaptiveness
 extern boolean g_singletics;
+extern boolean g_movieexport; // -exportmovie: replay is recorded offline, unpaced
 extern tic_t g_fast_forward;
 extern tic_t g_fast_forward_clock_stop;
 
@@ -13,6 +13,7 @@
 #include "doomdef.h"
 #include "hu_stuff.h"
 #include "font.h"
+#include "v_video.h" // V_ClearStringLayouts
 #include "z_zone.h"
 
 font_t       fontv[MAX_FONTS];
@@ -44,6 +45,8 @@ Font_Load (void)
 	{
 		FontCache(&fontv[i]);
 	}
+
+	V_ClearStringLayouts();
 }
 
 int
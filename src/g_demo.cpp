@@ -50,6 +50,8 @@
 #include "md5.h" // demo checksums
 #include "p_saveg.h" // savebuffer_t
 #include "g_party.h"
+#include "g_demoanalysis.h"
+#include "g_demostream.hpp"
 
 // SRB2Kart
 #include "d_netfil.h" // nameonly
@@ -120,6 +122,8 @@ static char demoname[MAX_WADPATH];
 static savebuffer_t demobuf = {0};
 static UINT8 *demotime_p, *demoinfo_p;
 static UINT16 demoflags;
+static boolean demostreaming; // body goes to g_demostream.cpp a chunk at a time
+static size_t demoheadersize, demoflushed;
 boolean demosynced = true; // console warning message
 
 struct demovars_s demo;
@@ -171,8 +175,9 @@ demoghost *ghosts = NULL;
 //   - Slope physics changed with a scaling fix
 // - 0x000C (Ring Racers v2.2)
 // - 0x000D (Ring Racers v2.3)
+//   - The body was stored flat, with no chunk index.
 
-#define DEMOVERSION 0x000D
+#define DEMOVERSION 0x000E
 
 boolean G_CompatLevel(UINT16 level)
 {
@@ -275,6 +280,8 @@ void G_ReadDemoExtraData(void)
 	char name[64];
 	static_assert(sizeof name >= std::max({MAXPLAYERNAME+1u, SKINNAMESIZE+1u, MAXCOLORNAME+1u}));
 
+	srb2::demo_stream_prepare(demobuf.p);
+
 	if (leveltime > starttime)
 	{
 		rewind_t *rewind = CL_SaveRewindPoint(demobuf.p - demobuf.buffer);
@@ -282,6 +289,7 @@ void G_ReadDemoExtraData(void)
 		{
 			memcpy(rewind->oldcmd, oldcmd, sizeof (oldcmd));
 			memcpy(rewind->oldghost, oldghost, sizeof (oldghost));
+			G_SaveRewindMobjs(rewind->leveltime);
 		}
 	}
 
@@ -456,12 +464,30 @@ void G_ReadDemoExtraData(void)
 	}
 }
 
+// Hands the body written so far to g_demostream.cpp once there's a chunk of it.
+// Only called between tics, so every chunk ends on one. Once the end marker is
+// down, G_SaveDemo takes the rest.
+static void G_FlushDemoChunk(void)
+{
+	UINT8 *body = demobuf.buffer + demoheadersize;
+
+	if (!demostreaming || !demobuf.p || *(UINT32 *)demoinfo_p != 0
+		|| (size_t)(demobuf.p - body) < srb2::kDemoChunkSize)
+		return;
+
+	srb2::demo_stream_write(body, demobuf.p - body);
+	demoflushed += demobuf.p - body;
+	demobuf.p = body;
+}
+
 void G_WriteDemoExtraData(void)
 {
 	INT32 i, j;
 	char name[64];
 	static_assert(sizeof name >= std::max({MAXPLAYERNAME+1u, SKINNAMESIZE+1u, MAXCOLORNAME+1u}));
 
+	G_FlushDemoChunk();
+
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (demo_extradata[i])
@@ -577,6 +603,8 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 	if (!demobuf.p || !demo.deferstart)
 		return;
 
+	srb2::demo_stream_prepare(demobuf.p);
+
 	ziptic = READUINT16(demobuf.p);
 
 	if (ziptic & ZT_FWD)
@@ -1050,6 +1078,8 @@ void G_ConsAllGhostTics(void)
 	if (!demobuf.p || !demo.deferstart)
 		return;
 
+	srb2::demo_stream_prepare(demobuf.p);
+
 	p = READUINT8(demobuf.p);
 
 	while (p != 0xFF)
@@ -1626,138 +1656,7 @@ skippedghosttic:
 	}
 }
 
-// Demo rewinding functions
-typedef struct rewindinfo_s {
-	tic_t leveltime;
-
-	struct {
-		boolean ingame;
-		player_t player;
-		mobj_t mobj;
-	} playerinfo[MAXPLAYERS];
-
-	struct rewindinfo_s *prev;
-} rewindinfo_t;
-
-static tic_t currentrewindnum;
-static rewindinfo_t *rewindhead = NULL; // Reverse chronological order
-
-void G_InitDemoRewind(void)
-{
-	CL_ClearRewinds();
-
-	while (rewindhead)
-	{
-		rewindinfo_t *p = rewindhead->prev;
-		Z_Free(rewindhead);
-		rewindhead = p;
-	}
-
-	currentrewindnum = 0;
-}
-
-void G_StoreRewindInfo(void)
-{
-	static UINT8 timetolog = 8;
-	rewindinfo_t *info;
-	size_t i;
-
-	if (timetolog-- > 0)
-		return;
-	timetolog = 8;
-
-	info = static_cast<rewindinfo_t*>(Z_Calloc(sizeof(rewindinfo_t), PU_STATIC, NULL));
-
-	for (i = 0; i < MAXPLAYERS; i++)
-	{
-		if (!playeringame[i] || players[i].spectator)
-		{
-			info->playerinfo[i].ingame = false;
-			continue;
-		}
-
-		info->playerinfo[i].ingame = true;
-		memcpy(&info->playerinfo[i].player, &players[i], sizeof(player_t));
-		if (players[i].mo)
-			memcpy(&info->playerinfo[i].mobj, players[i].mo, sizeof(mobj_t));
-	}
-
-	info->leveltime = leveltime;
-	info->prev = rewindhead;
-	rewindhead = info;
-}
-
-void G_PreviewRewind(tic_t previewtime)
-{
-	SINT8 i;
-	//size_t j;
-	fixed_t tweenvalue = 0;
-	rewindinfo_t *info = rewindhead, *next_info = rewindhead;
-
-	if (!info)
-		return;
-
-	while (info->leveltime > previewtime && info->prev)
-	{
-		next_info = info;
-		info = info->prev;
-	}
-	if (info != next_info)
-		tweenvalue = FixedDiv(previewtime - info->leveltime, next_info->leveltime - info->leveltime);
-
-
-	for (i = 0; i < MAXPLAYERS; i++)
-	{
-		if (!playeringame[i] || players[i].spectator)
-		{
-			if (info->playerinfo[i].player.mo)
-			{
-				//@TODO spawn temp object to act as a player display
-			}
-
-			continue;
-		}
-
-		if (!info->playerinfo[i].ingame || !info->playerinfo[i].player.mo)
-		{
-			if (players[i].mo)
-				players[i].mo->renderflags |= RF_DONTDRAW;
-
-			continue;
-		}
-
-		if (!players[i].mo)
-			continue; //@TODO spawn temp object to act as a player display
-
-		players[i].mo->renderflags &= ~RF_DONTDRAW;
-
-		P_UnsetThingPosition(players[i].mo);
-#define TWEEN(pr) info->playerinfo[i].mobj.pr + FixedMul((INT32) (next_info->playerinfo[i].mobj.pr - info->playerinfo[i].mobj.pr), tweenvalue)
-		players[i].mo->x = TWEEN(x);
-		players[i].mo->y = TWEEN(y);
-		players[i].mo->z = TWEEN(z);
-		players[i].mo->angle = TWEEN(angle);
-#undef TWEEN
-		P_SetThingPosition(players[i].mo);
-
-		players[i].drawangle = info->playerinfo[i].player.drawangle + FixedMul((INT32) (next_info->playerinfo[i].player.drawangle - info->playerinfo[i].player.drawangle), tweenvalue);
-
-		players[i].mo->sprite = info->playerinfo[i].mobj.sprite;
-		players[i].mo->sprite2 = info->playerinfo[i].mobj.sprite2;
-		players[i].mo->frame = info->playerinfo[i].mobj.frame;
-
-		players[i].mo->hitlag = info->playerinfo[i].mobj.hitlag;
-
-		players[i].realtime = info->playerinfo[i].player.realtime;
-		// Genuinely CANNOT be fucked. I can redo lua and I can redo netsaves but I draw the line at this abysmal hack.
-		/*for (j = 0; j < NUMKARTSTUFF; j++)
-			players[i].kartstuff[j] = info->playerinfo[i].player.kartstuff[j];*/
-	}
-
-	for (i = splitscreen; i >= 0; i--)
-		P_ResetCamera(&players[displayplayers[i]], &camera[i]);
-}
-
+// Demo rewinding functions; the preview is in g_demorewind.cpp
 void G_ConfirmRewind(tic_t rewindtime)
 {
 	SINT8 i;
@@ -1786,6 +1685,7 @@ void G_ConfirmRewind(tic_t rewindtime)
 
 		if (rewind)
 		{
+			G_LoadRewindMobjs(rewind->leveltime);
 			demobuf.p = demobuf.buffer + rewind->demopos;
 			memcpy(oldcmd, rewind->oldcmd, sizeof (oldcmd));
 			memcpy(oldghost, rewind->oldghost, sizeof (oldghost));
@@ -1837,7 +1737,11 @@ void G_RecordDemo(const char *name)
 
 	strcpy(demoname, name);
 	strcat(demoname, ".lmp");
-	maxsize = 1024 * 1024 * cv_netdemosize.value;
+
+	// Netgames can go on for hours, so their replays are streamed to disk as they're
+	// recorded. Record Attack keeps the whole thing in memory, for its ghosts.
+	demostreaming = multiplayer && !modeattacking;
+	maxsize = demostreaming ? srb2::kDemoStreamWindow : 1024 * 1024 * cv_netdemosize.value;
 
 //	if (demobuf.buffer)
 //		Z_Free(demobuf.buffer);
@@ -2382,6 +2286,19 @@ void G_BeginRecording(void)
 	if (demoflags & DF_LUAVARS)
 		LUA_Archive(&demobuf, false);
 
+	if (demostreaming)
+	{
+		// The header stays in the buffer for G_SaveDemo to finish; the body after it is flushed a chunk at a time.
+		demoheadersize = demobuf.p - demobuf.buffer;
+		demoflushed = 0;
+
+		if (!srb2::demo_stream_begin(demoname, demobuf.buffer, demoheadersize))
+		{
+			CONS_Alert(CONS_WARNING, M_GetText("Couldn't write %s; recording to memory instead.\n"), demoname);
+			demostreaming = false;
+		}
+	}
+
 	memset(&oldcmd,0,sizeof(oldcmd));
 	memset(&oldghost,0,sizeof(oldghost));
 	memset(&ghostext,0,sizeof(ghostext));
@@ -2428,7 +2345,7 @@ void srb2::write_current_demo_standings(const srb2::StandingsJson& standings)
 void srb2::write_current_demo_end_marker()
 {
 	WRITEUINT8(demobuf.p, DEMOMARKER); // add the demo end marker
-	*(UINT32 *)demoinfo_p = demobuf.p - demobuf.buffer;
+	*(UINT32 *)demoinfo_p = demobuf.p - demobuf.buffer + demoflushed;
 }
 
 void G_SetDemoTime(UINT32 ptime, UINT32 plap)
@@ -2530,6 +2447,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -2633,9 +2551,48 @@ static bool load_ubjson_standing(menudemo_t* pdemo, tcb::span<std::byte> slice,
 	return true;
 }
 
+static void G_LoadDemoInfoFromBuffer(menudemo_t *pdemo, savebuffer_t *buffer, boolean allownonmultiplayer);
+
 void G_LoadDemoInfo(menudemo_t *pdemo, boolean allownonmultiplayer)
 {
 	savebuffer_t info = {0};
+
+	if (!P_SaveBufferFromFile(&info, pdemo->filepath))
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Failed to read file '%s'.\n"), pdemo->filepath);
+		pdemo->type = MD_INVALID;
+		sprintf(pdemo->title, "INVALID REPLAY");
+		return;
+	}
+
+	G_LoadDemoInfoFromBuffer(pdemo, &info, allownonmultiplayer);
+}
+
+void G_LoadDemoInfoFromMemory(menudemo_t *pdemo, const UINT8 *data, size_t size, boolean allownonmultiplayer)
+{
+	savebuffer_t info = {0};
+
+	// Same layout as P_SaveBufferFromFile, terminator included
+	if (size == 0 || !P_SaveBufferAlloc(&info, size + 1))
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Failed to read file '%s'.\n"), pdemo->filepath);
+		pdemo->type = MD_INVALID;
+		sprintf(pdemo->title, "INVALID REPLAY");
+		return;
+	}
+
+	M_Memcpy(info.buffer, data, size);
+	info.buffer[size] = '\0';
+	info.size = size;
+	info.end = info.buffer + size;
+
+	G_LoadDemoInfoFromBuffer(pdemo, &info, allownonmultiplayer);
+}
+
+// Takes ownership of buffer.
+static void G_LoadDemoInfoFromBuffer(menudemo_t *pdemo, savebuffer_t *buffer, boolean allownonmultiplayer)
+{
+	savebuffer_t info = *buffer;
 	UINT8 *extrainfo_p;
 	UINT8 version, subversion, worknumskins, skinid;
 	UINT16 pdemoflags;
@@ -2645,10 +2602,10 @@ void G_LoadDemoInfo(menudemo_t *pdemo, boolean allownonmultiplayer)
 	char mapname[MAXMAPLUMPNAME],gtname[MAXGAMETYPELENGTH];
 	INT32 i;
 
-	if (!P_SaveBufferFromFile(&info, pdemo->filepath))
+	// The menu only needs the header and standings, which are stored as they are
+	if (srb2::demo_stream_is_chunked(&info) && !srb2::demo_stream_load(&info, srb2::DemoStreamLoad::kHeader))
 	{
-		CONS_Alert(CONS_ERROR, M_GetText("Failed to read file '%s'.\n"), pdemo->filepath);
-		goto badreplay;
+		goto corrupt;
 	}
 
 	if (info.size < 12)
@@ -2682,6 +2639,7 @@ void G_LoadDemoInfo(menudemo_t *pdemo, boolean allownonmultiplayer)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		if (P_SaveBufferRemaining(&info) < 64)
 		{
 			goto corrupt;
@@ -2960,6 +2918,10 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 
 	G_InitDemoRewind();
 
+	// Anything still decoding belongs to the buffer about to be replaced
+	if (defdemoname != NULL || deflumpnum != LUMPERROR)
+		srb2::demo_stream_close();
+
 	gtname[MAXGAMETYPELENGTH-1] = '\0';
 
 	if (deflumpnum != LUMPERROR)
@@ -3090,6 +3052,16 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 	gameaction = ga_nothing;
 	demo.playback = true;
 	demo.buffer = &demobuf;
+	if (srb2::demo_stream_is_chunked(&demobuf) && !srb2::demo_stream_load(&demobuf, srb2::DemoStreamLoad::kOnDemand))
+	{
+		snprintf(msg, 1024, M_GetText("%s is damaged.\n"), pdemoname);
+		CONS_Alert(CONS_ERROR, "%s", msg);
+		M_StartMessage("Demo Playback", msg, NULL, MM_NOTHING, NULL, "Return to Menu");
+		Z_Free(pdemoname);
+		Z_Free(demobuf.buffer);
+		demo.playback = false;
+		return;
+	}
 	if (memcmp(demobuf.p, DEMOHEADER, 12))
 	{
 		snprintf(msg, 1024, M_GetText("%s is not a Ring Racers replay file.\n"), pdemoname);
@@ -3112,6 +3084,7 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -3556,6 +3529,13 @@ void G_AddGhost(savebuffer_t *buffer, const char *defdemoname)
 	UINT8 worknumskins;
 	democharlist_t *skinlist = NULL;
 
+	if (srb2::demo_stream_is_chunked(buffer) && !srb2::demo_stream_load(buffer, srb2::DemoStreamLoad::kAll))
+	{
+		CONS_Alert(CONS_NOTICE, M_GetText("Ghost %s: Replay is damaged.\n"), defdemoname);
+		P_SaveBufferFree(buffer);
+		return;
+	}
+
 	p = buffer->buffer;
 
 	// read demo header
@@ -3577,6 +3557,7 @@ void G_AddGhost(savebuffer_t *buffer, const char *defdemoname)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -3840,6 +3821,7 @@ staffbrief_t *G_GetStaffGhostBrief(UINT8 *buffer)
 		case 0x000A: // 2.0, 2.1
 		case 0x000B: // 2.2 indev (staff ghosts)
 		case 0x000C: // 2.2
+		case 0x000D: // 2.3
 			break;
 
 		// too old, cannot support.
@@ -3944,6 +3926,22 @@ void G_TimeDemo(const char *name)
 	G_DeferedPlayDemo(name);
 }
 
+//
+// G_ExportDemo
+// Plays a demo back as fast as it can be drawn, recording it
+// to a movie. The game quits once it has been written out.
+//
+void G_ExportDemo(const char *name)
+{
+	restorecv_vidwait = cv_vidwait.value;
+	if (cv_vidwait.value)
+		CV_Set(&cv_vidwait, "0");
+	g_movieexport = true;
+	g_singletics = true;
+	demo.quitafterplaying = true;
+	G_DeferedPlayDemo(name);
+}
+
 void G_DoneLevelLoad(void)
 {
 	CONS_Printf(M_GetText("Loaded level in %f sec\n"), (double)(I_GetTime() - demostarttime) / TICRATE);
@@ -4041,6 +4039,7 @@ static void G_StopTimingDemo(void)
 // called from stopdemo command, map command, and g_checkdemoStatus.
 void G_StopDemo(void)
 {
+	srb2::demo_stream_close();
 	Z_Free(demobuf.buffer);
 	demobuf.buffer = NULL;
 	demo.playback = false;
@@ -4074,8 +4073,24 @@ boolean G_CheckDemoStatus(void)
 
 	if (demo.playback)
 	{
+		if (G_DemoAnalysisActive())
+		{
+			G_StopDemoAnalysis();
+		}
+
 		if (demo.quitafterplaying)
+		{
+			if (g_movieexport)
+			{
+				// Finish writing before quitting
+				M_StopMovie();
+
+				if (restorecv_vidwait != cv_vidwait.value)
+					CV_SetValue(&cv_vidwait, restorecv_vidwait);
+			}
+
 			I_Quit();
+		}
 
 		// When this replay was recorded, the player skipped
 		// the Tally and ended the demo early.
@@ -4119,9 +4134,7 @@ boolean G_CheckDemoStatus(void)
 		return true;
 	}
 
-	Z_Free(demobuf.buffer);
-
-	demo.recording = false;
+	G_ResetDemoRecording();
 	demo.waitingfortally = false;
 
 	return false;
@@ -4129,6 +4142,10 @@ boolean G_CheckDemoStatus(void)
 
 void G_ResetDemoRecording(void)
 {
+	if (demostreaming)
+		srb2::demo_stream_abort();
+	demostreaming = false;
+
 	Z_Free(demobuf.buffer);
 	demo.recording = false;
 }
@@ -4148,7 +4165,7 @@ void G_SaveDemo(void)
 	if (demoinfo_p && *(UINT32 *)demoinfo_p == 0)
 	{
 		WRITEUINT8(demobuf.p, DEMOMARKER); // add the demo end marker
-		*(UINT32 *)demoinfo_p = demobuf.p - demobuf.buffer;
+		*(UINT32 *)demoinfo_p = demobuf.p - demobuf.buffer + demoflushed;
 	}
 	WRITEUINT8(demobuf.p, DW_END); // Mark end of demo extra data.
 
@@ -4222,10 +4239,33 @@ void G_SaveDemo(void)
 		*p = M_RandomByte(); // This MD5 was chosen by fair dice roll and most likely < 50% correct.
 #else
 	// Make a checksum of everything after the checksum in the file up to the end of the standard data. Extrainfo is freely modifiable.
-	md5_buffer((char *)p+16, (demobuf.buffer + length) - (p+16), p);
+	if (!demostreaming)
+		md5_buffer((char *)p+16, (demobuf.buffer + length) - (p+16), p);
 #endif
 
-	bool saved = FIL_WriteFile(demoname, demobuf.buffer, demobuf.p - demobuf.buffer); // finally output the file.
+	bool saved;
+
+	if (demostreaming)
+	{
+		UINT8 *body = demobuf.buffer + demoheadersize;
+		UINT8 *extrainfo = demobuf.buffer + (length - demoflushed);
+		UINT8 digest[16];
+
+		saved = srb2::demo_stream_end(body, extrainfo - body, digest);
+
+#ifndef NOMD5
+		// Most of the body is only on disk by now, so the checksum covers a digest of it instead.
+		std::vector<UINT8> sum(p+16, body);
+		sum.insert(sum.end(), digest, digest + sizeof digest);
+		md5_buffer((char *)sum.data(), sum.size(), p);
+#endif
+
+		saved = saved && srb2::demo_stream_save(demoname, demobuf.buffer, demoheadersize, extrainfo, demobuf.p - extrainfo);
+	}
+	else
+	{
+		saved = FIL_WriteFile(demoname, demobuf.buffer, demobuf.p - demobuf.buffer); // finally output the file.
+	}
 	G_ResetDemoRecording();
 
 	if (!modeattacking)
@@ -190,6 +190,9 @@ void G_GhostTicker(void);
 void G_InitDemoRewind(void);
 void G_StoreRewindInfo(void);
 void G_PreviewRewind(tic_t previewtime);
+void G_ForgetRewindMobj(mobj_t *mobj); // P_RemoveMobj
+void G_SaveRewindMobjs(tic_t time); // CL_SaveRewindPoint
+void G_LoadRewindMobjs(tic_t time); // CL_RewindToTime
 void G_ConfirmRewind(tic_t rewindtime);
 
 struct DemoBufferSizes
@@ -228,6 +231,7 @@ void G_DeferedPlayDemo(const char *demo);
 void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum);
 #define G_DoPlayDemo(defdemoname) G_DoPlayDemoEx(defdemoname, LUMPERROR)
 void G_TimeDemo(const char *name);
+void G_ExportDemo(const char *name);
 void G_AddGhost(savebuffer_t *buffer, const char *defdemoname);
 staffbrief_t *G_GetStaffGhostBrief(UINT8 *buffer);
 void G_FreeGhosts(void);
@@ -237,6 +241,9 @@ void G_StopDemo(void);
 boolean G_CheckDemoStatus(void);
 
 void G_LoadDemoInfo(menudemo_t *pdemo, boolean allownonmultiplayer);
+
+// Same, for a file already read into memory. pdemo->filepath is only used in messages.
+void G_LoadDemoInfoFromMemory(menudemo_t *pdemo, const UINT8 *data, size_t size, boolean allownonmultiplayer);
 void G_DeferedPlayDemo(const char *demo);
 
 void G_SaveDemo(void);
@@ -0,0 +1,168 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demoanalysis.c
+/// \brief Replay analysis: a demo played flat out, timed tic by tic
+///
+///        Meant for comparing builds on machines without a display: the same
+///        demo gives the same tics, so the rows line up between runs, and the
+///        consistency column shows where two builds stopped agreeing.
+
+#include "g_demoanalysis.h"
+#include "console.h"
+#include "d_main.h"
+#include "d_netfil.h"
+#include "doomstat.h"
+#include "g_demo.h"
+#include "g_game.h"
+#include "i_time.h"
+#include "m_perfstats.h"
+#include "p_local.h"
+
+static struct
+{
+	boolean active;
+	boolean json;
+	FILE *file;
+	char path[MAX_WADPATH];
+	UINT32 rows;
+} analysis;
+
+static const char *const analysiscolumns[] = {
+	"tic", "leveltime", "tic_us",
+	"polyobj_us", "main_us", "mobj_us", "dynslope_us", "thinkers_us",
+	"playerthink_us", "botticcmd_us", "lua_us", "acs_us",
+	"mobjs", "consistency",
+};
+
+#define NUMANALYSISCOLUMNS (sizeof analysiscolumns / sizeof *analysiscolumns)
+
+static UINT32 G_CountMobjs(void)
+{
+	thinker_t *th;
+	UINT32 count = 0;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
+			count++;
+	}
+
+	return count;
+}
+
+void G_AnalyzeDemo(const char *name, const char *outpath)
+{
+	size_t len;
+
+	if (outpath)
+		strlcpy(analysis.path, outpath, sizeof analysis.path);
+	else
+	{
+		char base[MAX_WADPATH];
+		char *ext;
+
+		strlcpy(base, name, sizeof base);
+		nameonly(base);
+		if ((ext = strrchr(base, '.')) != NULL)
+			*ext = '\0';
+		snprintf(analysis.path, sizeof analysis.path, "%s" PATHSEP "%s-analysis.csv", srb2home, base);
+	}
+
+	len = strlen(analysis.path);
+	analysis.json = (len > 5 && !stricmp(analysis.path + len - 5, ".json"));
+
+	analysis.file = fopen(analysis.path, "w");
+	if (!analysis.file)
+	{
+		I_Error("Couldn't write the replay analysis to '%s'", analysis.path);
+		return;
+	}
+
+	if (analysis.json)
+		fputs("[", analysis.file);
+	else
+	{
+		size_t i;
+		for (i = 0; i < NUMANALYSISCOLUMNS; i++)
+			fprintf(analysis.file, "%s%s", i ? "," : "", analysiscolumns[i]);
+		fputs("\n", analysis.file);
+	}
+
+	analysis.active = true;
+	analysis.rows = 0;
+
+	// Flat out, with nothing drawn
+	nodrawers = true;
+	g_singletics = true;
+	demo.quitafterplaying = true;
+	demostarttime = I_GetTime();
+	G_DeferedPlayDemo(name);
+}
+
+boolean G_DemoAnalysisActive(void)
+{
+	return analysis.active;
+}
+
+void G_DemoAnalysisTic(precise_t tictime, INT16 consistency)
+{
+	const precise_t precision = I_GetPrecisePrecision() / 1000000;
+	long values[NUMANALYSISCOLUMNS];
+	size_t i;
+
+	if (!analysis.active || !demo.playback || gamestate != GS_LEVEL)
+		return;
+
+	values[0] = (long)gametic;
+	values[1] = (long)leveltime;
+	values[2] = (long)(tictime / precision);
+	values[3] = (long)(ps_thlist_times[THINK_POLYOBJ] / precision);
+	values[4] = (long)(ps_thlist_times[THINK_MAIN] / precision);
+	values[5] = (long)(ps_thlist_times[THINK_MOBJ] / precision);
+	values[6] = (long)(ps_thlist_times[THINK_DYNSLOPE] / precision);
+	values[7] = (long)(ps_thinkertime / precision);
+	values[8] = (long)(ps_playerthink_time / precision);
+	values[9] = (long)(ps_botticcmd_time / precision);
+	values[10] = (long)(ps_lua_thinkframe_time / precision);
+	values[11] = (long)(ps_acs_time / precision);
+	values[12] = (long)G_CountMobjs();
+	values[13] = (long)(UINT16)consistency;
+
+	if (analysis.json)
+	{
+		fputs(analysis.rows ? ",\n{" : "\n{", analysis.file);
+		for (i = 0; i < NUMANALYSISCOLUMNS; i++)
+			fprintf(analysis.file, "%s\"%s\":%ld", i ? "," : "", analysiscolumns[i], values[i]);
+		fputs("}", analysis.file);
+	}
+	else
+	{
+		for (i = 0; i < NUMANALYSISCOLUMNS; i++)
+			fprintf(analysis.file, "%s%ld", i ? "," : "", values[i]);
+		fputs("\n", analysis.file);
+	}
+
+	analysis.rows++;
+}
+
+void G_StopDemoAnalysis(void)
+{
+	if (!analysis.active)
+		return;
+
+	if (analysis.json)
+		fputs("\n]\n", analysis.file);
+
+	fclose(analysis.file);
+	analysis.file = NULL;
+	analysis.active = false;
+
+	CONS_Printf("Analyzed %u tics in %f seconds, saved to '%s'\n",
+		analysis.rows, (double)(I_GetTime() - demostarttime) / TICRATE, analysis.path);
+}
@@ -0,0 +1,40 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demoanalysis.h
+/// \brief Replay analysis: a demo played flat out, timed tic by tic
+
+#ifndef __G_DEMOANALYSIS_H__
+#define __G_DEMOANALYSIS_H__
+
+#include "doomdef.h"
+#include "i_system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// -analyzedemo <file> [-analysisout <file>]
+// Plays the demo with nothing drawn, writing one row per tic to a CSV, or
+// JSON if the output ends in .json, then quits. Pair it with -dedicated to
+// run without a display.
+void G_AnalyzeDemo(const char *name, const char *outpath);
+
+boolean G_DemoAnalysisActive(void);
+
+// Records one game tic that took tictime, ending on consistency.
+void G_DemoAnalysisTic(precise_t tictime, INT16 consistency);
+
+// Closes the output; the demo has ended.
+void G_StopDemoAnalysis(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __G_DEMOANALYSIS_H__
@@ -0,0 +1,561 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demorewind.cpp
+/// \brief Demo rewind preview: level state recorded as it changes
+///
+///        Every few tics, each mobj, player and sector is compared against
+///        the last state recorded for it, and only what changed is kept.
+///        Scrubbing from one snapshot to another then only touches the
+///        objects that changed in between, instead of loading a savegame.
+///        G_ConfirmRewind still does the real load once a time is picked.
+///
+///        Once the log grows past kMaxRecords, the oldest half of the
+///        snapshots is folded into one, so the preview only reaches back
+///        so far in a long replay.
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "d_clisrv.h"
+#include "d_player.h"
+#include "g_demo.h"
+#include "g_game.h"
+#include "p_local.h"
+#include "p_saveg.h"
+#include "r_fps.h"
+#include "r_state.h"
+
+namespace
+{
+
+// G_PreviewRewind steps leveltime back this many tics at a time.
+constexpr tic_t kSnapshotInterval = 4;
+
+constexpr UINT32 kNone = UINT32_MAX;
+
+// Across all three tracks; a mobj record is about 44 bytes.
+constexpr std::size_t kMaxRecords = 1 << 18;
+
+template <typename State>
+class Track
+{
+public:
+	std::size_t size() const { return records_.size(); }
+
+	void clear()
+	{
+		records_.clear();
+		latest_.clear();
+	}
+
+	// Only kept if it differs from the last state recorded for this object.
+	void record(UINT32 object, const State& state)
+	{
+		if (object >= latest_.size())
+		{
+			latest_.resize(object + 1, kNone);
+		}
+
+		UINT32& latest = latest_[object];
+
+		if (latest != kNone && records_[latest].state == state)
+		{
+			return;
+		}
+
+		records_.push_back({object, latest, state});
+		latest = static_cast<UINT32>(records_.size() - 1);
+	}
+
+	const State* latest(UINT32 object) const
+	{
+		if (object >= latest_.size() || latest_[object] == kNone)
+		{
+			return nullptr;
+		}
+
+		return &records_[latest_[object]].state;
+	}
+
+	// Forget everything recorded from record n on.
+	void truncate(std::size_t n)
+	{
+		while (records_.size() > n)
+		{
+			latest_[records_.back().object] = records_.back().prev;
+			records_.pop_back();
+		}
+	}
+
+	// Folds the first n records into one per object, each as it was at
+	// the end of them. Returns how many records that left.
+	std::size_t fold(std::size_t n)
+	{
+		std::vector<Record> folded;
+		std::vector<UINT32> last(latest_.size(), kNone);
+		std::vector<UINT32> moved(n, kNone);
+
+		for (std::size_t i = 0; i < n; i++)
+		{
+			last[records_[i].object] = static_cast<UINT32>(i);
+		}
+
+		for (std::size_t i = 0; i < n; i++)
+		{
+			const Record& r = records_[i];
+
+			if (last[r.object] == i)
+			{
+				moved[i] = static_cast<UINT32>(folded.size());
+				folded.push_back({r.object, kNone, r.state});
+			}
+		}
+
+		const std::size_t base = folded.size();
+		auto remap = [&](UINT32 i) -> UINT32
+		{
+			if (i == kNone)
+			{
+				return kNone;
+			}
+
+			return i < n ? moved[i] : static_cast<UINT32>(i - n + base);
+		};
+
+		for (std::size_t i = n; i < records_.size(); i++)
+		{
+			const Record& r = records_[i];
+			folded.push_back({r.object, remap(r.prev), r.state});
+		}
+
+		for (UINT32& latest : latest_)
+		{
+			latest = remap(latest);
+		}
+
+		records_ = std::move(folded);
+		return base;
+	}
+
+	// Newest first, so each object ends up as it was before begin.
+	// state is null for objects that didn't exist yet.
+	template <typename F>
+	void undo(std::size_t begin, std::size_t end, F&& apply) const
+	{
+		for (std::size_t i = end; i-- > begin;)
+		{
+			const Record& r = records_[i];
+			apply(r.object, r.prev != kNone ? &records_[r.prev].state : nullptr);
+		}
+	}
+
+private:
+	struct Record
+	{
+		UINT32 object;
+		UINT32 prev; // this object's previous record
+		State state;
+	};
+
+	std::vector<Record> records_;
+	std::vector<UINT32> latest_;
+};
+
+struct MobjState
+{
+	fixed_t x, y, z;
+	angle_t angle;
+	UINT32 frame;
+	UINT32 renderflags;
+	INT32 hitlag;
+	spritenum_t sprite;
+	UINT8 sprite2;
+
+	explicit MobjState(const mobj_t* mo) :
+		x(mo->x), y(mo->y), z(mo->z),
+		angle(mo->angle),
+		frame(mo->frame),
+		renderflags(mo->renderflags),
+		hitlag(mo->hitlag),
+		sprite(mo->sprite),
+		sprite2(mo->sprite2)
+	{
+	}
+
+	bool operator==(const MobjState& b) const
+	{
+		return x == b.x && y == b.y && z == b.z && angle == b.angle && frame == b.frame &&
+			renderflags == b.renderflags && hitlag == b.hitlag && sprite == b.sprite && sprite2 == b.sprite2;
+	}
+};
+
+struct PlayerState
+{
+	angle_t drawangle;
+	tic_t realtime;
+
+	bool operator==(const PlayerState& b) const { return drawangle == b.drawangle && realtime == b.realtime; }
+};
+
+struct SectorState
+{
+	fixed_t floorheight;
+	fixed_t ceilingheight;
+
+	bool operator==(const SectorState& b) const
+	{
+		return floorheight == b.floorheight && ceilingheight == b.ceilingheight;
+	}
+};
+
+struct Snapshot
+{
+	tic_t leveltime;
+
+	// Record counts at the end of this snapshot
+	std::size_t mobjs;
+	std::size_t players;
+	std::size_t sectors;
+};
+
+struct RewindPreview
+{
+	Track<MobjState> mobjs;
+	Track<PlayerState> players;
+	Track<SectorState> sectors;
+
+	std::vector<Snapshot> snapshots;
+
+	// How many snapshots the level currently shows; less
+	// than all of them while previewing.
+	std::size_t shown = 0;
+
+	// Mobjs are numbered as they're first seen. Removed
+	// ones are null, so a reused pointer gets a new number.
+	std::unordered_map<const mobj_t*, UINT32> mobjslots;
+	std::vector<mobj_t*> mobjlist;
+
+	// The slot of each mobjnum in a rewind point's savegame, so
+	// the mobjs it loads can take over their old numbers.
+	std::map<tic_t, std::vector<UINT32>> rewindpoints;
+
+	// A rewind point was just loaded, so what's older than it still holds.
+	bool rebound = false;
+
+	void clear()
+	{
+		mobjs.clear();
+		players.clear();
+		sectors.clear();
+		snapshots.clear();
+		shown = 0;
+		mobjslots.clear();
+		mobjlist.clear();
+		rewindpoints.clear();
+		rebound = false;
+	}
+
+	// Forget the snapshots from this time on.
+	void truncate(tic_t time)
+	{
+		const std::size_t keep = std::lower_bound(
+			snapshots.begin(),
+			snapshots.end(),
+			time,
+			[](const Snapshot& s, tic_t t) { return s.leveltime < t; }
+		) - snapshots.begin();
+		const Snapshot e = end(keep);
+
+		mobjs.truncate(e.mobjs);
+		players.truncate(e.players);
+		sectors.truncate(e.sectors);
+		snapshots.resize(keep);
+		shown = keep;
+	}
+
+	// Folds the oldest half of the snapshots into the one after them.
+	void fold()
+	{
+		const std::size_t drop = snapshots.size() / 2;
+
+		if (drop == 0)
+		{
+			return;
+		}
+
+		const Snapshot at = snapshots[drop];
+		const std::size_t m = mobjs.fold(at.mobjs);
+		const std::size_t p = players.fold(at.players);
+		const std::size_t s = sectors.fold(at.sectors);
+
+		snapshots.erase(snapshots.begin(), snapshots.begin() + drop);
+
+		for (Snapshot& snap : snapshots)
+		{
+			snap.mobjs = snap.mobjs - at.mobjs + m;
+			snap.players = snap.players - at.players + p;
+			snap.sectors = snap.sectors - at.sectors + s;
+		}
+
+		shown = snapshots.size();
+	}
+
+	UINT32 slot(mobj_t* mo)
+	{
+		auto [it, inserted] = mobjslots.try_emplace(mo, static_cast<UINT32>(mobjlist.size()));
+
+		if (inserted)
+		{
+			mobjlist.push_back(mo);
+		}
+
+		return it->second;
+	}
+
+	// Record counts at the end of the first n snapshots
+	Snapshot end(std::size_t n) const { return n ? snapshots[n - 1] : Snapshot {}; }
+};
+
+RewindPreview g_rewind;
+
+void apply_mobj(UINT32 object, const MobjState* state)
+{
+	mobj_t* mo = g_rewind.mobjlist[object];
+
+	if (mo == nullptr)
+	{
+		return; // gone since
+	}
+
+	if (state == nullptr)
+	{
+		mo->renderflags |= RF_DONTDRAW; // not spawned yet
+		return;
+	}
+
+	if (mo->x != state->x || mo->y != state->y)
+	{
+		P_UnsetThingPosition(mo);
+		mo->x = state->x;
+		mo->y = state->y;
+		P_SetThingPosition(mo);
+	}
+
+	mo->z = state->z;
+	mo->angle = state->angle;
+	mo->frame = state->frame;
+	mo->renderflags = state->renderflags;
+	mo->hitlag = state->hitlag;
+	mo->sprite = state->sprite;
+	mo->sprite2 = state->sprite2;
+
+	R_ResetMobjInterpolationState(mo);
+}
+
+void apply_player(UINT32 object, const PlayerState* state)
+{
+	if (state == nullptr || !playeringame[object])
+	{
+		return;
+	}
+
+	players[object].drawangle = players[object].old_drawangle = state->drawangle;
+	players[object].realtime = state->realtime;
+}
+
+void apply_sector(UINT32 object, const SectorState* state)
+{
+	if (state == nullptr || object >= numsectors)
+	{
+		return;
+	}
+
+	sector_t* sector = &sectors[object];
+
+	sector->floorheight = state->floorheight;
+	sector->ceilingheight = state->ceilingheight;
+	sector->moved = true;
+
+	R_ClearSectorInterpolatorState(sector);
+}
+
+}; // namespace
+
+void G_InitDemoRewind(void)
+{
+	CL_ClearRewinds();
+	g_rewind.clear();
+}
+
+void G_StoreRewindInfo(void)
+{
+	thinker_t *th;
+	size_t i;
+
+	if (leveltime % kSnapshotInterval)
+		return;
+
+	// The level was reloaded: G_ConfirmRewind keeps what came before
+	// the rewind point, but anything else starts over.
+	if (!g_rewind.snapshots.empty() && g_rewind.snapshots.back().leveltime >= leveltime)
+	{
+		if (g_rewind.rebound)
+			g_rewind.truncate(leveltime);
+		else
+			g_rewind.clear();
+	}
+
+	g_rewind.rebound = false;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		mobj_t *mo = (mobj_t *)th;
+		UINT32 slot;
+
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		slot = g_rewind.slot(mo);
+
+		// Not drawn, so where it is doesn't matter until it shows up again
+		if ((mo->flags & MF_NOSECTOR) || (mo->renderflags & RF_DONTDRAW) == RF_DONTDRAW)
+		{
+			const MobjState *last = g_rewind.mobjs.latest(slot);
+
+			if (last != nullptr)
+			{
+				MobjState state = *last;
+				state.renderflags = mo->renderflags;
+				g_rewind.mobjs.record(slot, state);
+				continue;
+			}
+		}
+
+		g_rewind.mobjs.record(slot, MobjState(mo));
+	}
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (!playeringame[i] || players[i].spectator)
+			continue;
+
+		g_rewind.players.record(i, {players[i].drawangle, players[i].realtime});
+	}
+
+	for (i = 0; i < numsectors; i++)
+		g_rewind.sectors.record(i, {sectors[i].floorheight, sectors[i].ceilingheight});
+
+	g_rewind.snapshots.push_back({leveltime, g_rewind.mobjs.size(), g_rewind.players.size(), g_rewind.sectors.size()});
+	g_rewind.shown = g_rewind.snapshots.size();
+
+	if (g_rewind.mobjs.size() + g_rewind.players.size() + g_rewind.sectors.size() > kMaxRecords)
+		g_rewind.fold();
+}
+
+void G_PreviewRewind(tic_t previewtime)
+{
+	SINT8 i;
+	const std::size_t target = std::upper_bound(
+		g_rewind.snapshots.begin(),
+		g_rewind.snapshots.end(),
+		previewtime,
+		[](tic_t t, const Snapshot& s) { return t < s.leveltime; }
+	) - g_rewind.snapshots.begin();
+
+	// The first snapshot is as far back as the preview goes
+	const std::size_t shown = std::max<std::size_t>(target, 1);
+
+	if (g_rewind.snapshots.empty())
+		return;
+
+	// Only ever backwards; the present is what's already loaded
+	if (shown < g_rewind.shown)
+	{
+		const Snapshot from = g_rewind.end(shown);
+		const Snapshot to = g_rewind.end(g_rewind.shown);
+
+		g_rewind.mobjs.undo(from.mobjs, to.mobjs, apply_mobj);
+		g_rewind.players.undo(from.players, to.players, apply_player);
+		g_rewind.sectors.undo(from.sectors, to.sectors, apply_sector);
+
+		g_rewind.shown = shown;
+	}
+
+	for (i = splitscreen; i >= 0; i--)
+		P_ResetCamera(&players[displayplayers[i]], &camera[i]);
+}
+
+void G_SaveRewindMobjs(tic_t time)
+{
+	std::vector<UINT32>& slots = g_rewind.rewindpoints[time];
+	thinker_t *th;
+
+	slots.clear();
+
+	// P_SaveNetGame just numbered these
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		mobj_t *mo = (mobj_t *)th;
+
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed || !TypeIsNetSynced(mo->type))
+			continue;
+
+		if (mo->mobjnum >= slots.size())
+			slots.resize(mo->mobjnum + 1, kNone);
+
+		slots[mo->mobjnum] = g_rewind.slot(mo);
+	}
+}
+
+void G_LoadRewindMobjs(tic_t time)
+{
+	auto it = g_rewind.rewindpoints.find(time);
+	thinker_t *th;
+
+	// Every mobj was just replaced
+	g_rewind.mobjslots.clear();
+	std::fill(g_rewind.mobjlist.begin(), g_rewind.mobjlist.end(), nullptr);
+	g_rewind.rebound = true;
+
+	if (it == g_rewind.rewindpoints.end())
+		return;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		mobj_t *mo = (mobj_t *)th;
+
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed || !TypeIsNetSynced(mo->type))
+			continue;
+
+		if (mo->mobjnum < it->second.size() && it->second[mo->mobjnum] != kNone)
+		{
+			g_rewind.mobjlist[it->second[mo->mobjnum]] = mo;
+			g_rewind.mobjslots[mo] = it->second[mo->mobjnum];
+		}
+	}
+
+	// CL_RewindToTime freed the rewind points after this one
+	g_rewind.rewindpoints.erase(g_rewind.rewindpoints.upper_bound(time), g_rewind.rewindpoints.end());
+}
+
+void G_ForgetRewindMobj(mobj_t *mobj)
+{
+	auto it = g_rewind.mobjslots.find(mobj);
+
+	if (it == g_rewind.mobjslots.end())
+		return;
+
+	g_rewind.mobjlist[it->second] = nullptr;
+	g_rewind.mobjslots.erase(it);
+}
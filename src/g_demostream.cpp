@@ -0,0 +1,565 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demostream.cpp
+/// \brief Chunked demo files, compressed while recording and decoded as played
+
+#include "g_demostream.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tracy/tracy/Tracy.hpp>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "core/thread_pool.h"
+
+#include "byteptr.h"
+#include "doomdef.h"
+#include "info.h"
+#include "md5.h"
+#include "p_saveg.h" // savebuffer_t
+#include "z_zone.h"
+
+using namespace srb2;
+
+namespace
+{
+
+constexpr char kTrailerMagic[4] = {'R', 'R', 'D', 'Z'};
+constexpr std::size_t kEntrySize = 5 * 4;
+constexpr std::size_t kTrailerSize = 4 * 4;
+
+// How far past the read position demo_stream_prepare makes sure of, for the odd peek at the next byte
+constexpr std::size_t kPrepareMargin = 1024;
+
+enum : UINT32
+{
+	kStored = 0,
+	kDeflate = 1,
+};
+
+struct Entry
+{
+	UINT32 flatoffset;
+	UINT32 flatsize;
+	UINT32 fileoffset;
+	UINT32 filesize;
+	UINT32 method;
+};
+
+// Recording
+
+struct Writer
+{
+	std::mutex mutex;
+	std::condition_variable idle;
+	std::deque<std::vector<UINT8>> queue;
+	bool running = false;
+
+	// Only touched by whoever is draining the queue, or by the main thread while it's idle
+	FILE* file = nullptr;
+	std::string spool;
+	UINT32 flatoffset = 0;
+	UINT32 fileend = 0;
+	std::vector<Entry> index;
+	std::vector<UINT8> digests;
+	bool failed = false;
+};
+
+std::shared_ptr<Writer> g_writer;
+
+bool append(Writer& w, const void* data, std::size_t size)
+{
+	if (std::fseek(w.file, w.fileend, SEEK_SET) != 0 || std::fwrite(data, 1, size, w.file) != size)
+	{
+		return false;
+	}
+	w.fileend += size;
+	return true;
+}
+
+void write_chunk(Writer& w, const std::vector<UINT8>& chunk)
+{
+	ZoneScoped;
+
+	Entry entry {w.flatoffset, static_cast<UINT32>(chunk.size()), w.fileend, 0, kStored};
+	const void* data = chunk.data();
+	std::size_t size = chunk.size();
+
+	w.digests.resize(w.digests.size() + MD5_LEN);
+	md5_buffer(reinterpret_cast<const char*>(chunk.data()), chunk.size(), w.digests.data() + w.digests.size() - MD5_LEN);
+	w.flatoffset += chunk.size();
+
+#ifdef HAVE_ZLIB
+	std::vector<UINT8> packed(compressBound(chunk.size()));
+	uLongf packedsize = packed.size();
+
+	if (compress2(packed.data(), &packedsize, chunk.data(), chunk.size(), Z_DEFAULT_COMPRESSION) == Z_OK &&
+		packedsize < chunk.size())
+	{
+		entry.method = kDeflate;
+		data = packed.data();
+		size = packedsize;
+	}
+#endif
+
+	entry.filesize = size;
+
+	if (!w.failed && append(w, data, size))
+	{
+		w.index.push_back(entry);
+	}
+	else
+	{
+		w.failed = true;
+	}
+}
+
+void drain(std::shared_ptr<Writer> w)
+{
+	for (;;)
+	{
+		std::vector<UINT8> chunk;
+
+		{
+			std::lock_guard<std::mutex> lock(w->mutex);
+			if (w->queue.empty())
+			{
+				w->running = false;
+				w->idle.notify_all();
+				return;
+			}
+			chunk = std::move(w->queue.front());
+			w->queue.pop_front();
+		}
+
+		write_chunk(*w, chunk);
+	}
+}
+
+void submit(std::shared_ptr<Writer> w, std::vector<UINT8> chunk)
+{
+	std::lock_guard<std::mutex> lock(w->mutex);
+
+	w->queue.push_back(std::move(chunk));
+	if (!w->running)
+	{
+		w->running = true;
+		schedule_or_run([w]() { drain(w); });
+	}
+}
+
+void wait_idle(Writer& w)
+{
+	std::unique_lock<std::mutex> lock(w.mutex);
+	w.idle.wait(lock, [&w] { return !w.running; });
+}
+
+// Playback
+
+enum : UINT8
+{
+	kPending,
+	kDecoding,
+	kDone,
+};
+
+struct Reader
+{
+	std::vector<std::vector<UINT8>> packed; // each chunk's compressed bytes, freed once it's decoded
+	std::vector<Entry> index; // by flatoffset
+	std::unique_ptr<std::atomic<UINT8>[]> state;
+	std::atomic<int> inflight {0};
+	std::atomic<bool> failed {false};
+	UINT8* flat = nullptr;
+	std::size_t flatsize = 0;
+};
+
+std::shared_ptr<Reader> g_reader;
+
+// in is the chunk's bytes in the file
+bool decode(const Entry& entry, const UINT8* in, UINT8* flat)
+{
+	ZoneScoped;
+
+	if (entry.method == kStored)
+	{
+		std::memcpy(flat + entry.flatoffset, in, entry.flatsize);
+		return true;
+	}
+
+#ifdef HAVE_ZLIB
+	uLongf size = entry.flatsize;
+	if (entry.method == kDeflate &&
+		uncompress(flat + entry.flatoffset, &size, in, entry.filesize) == Z_OK &&
+		size == entry.flatsize)
+	{
+		return true;
+	}
+#endif
+
+	std::memset(flat + entry.flatoffset, 0, entry.flatsize);
+	return false;
+}
+
+bool claim(Reader& r, std::size_t i)
+{
+	UINT8 expected = kPending;
+	return r.state[i].compare_exchange_strong(expected, kDecoding, std::memory_order_acquire);
+}
+
+void decode_claimed(Reader& r, std::size_t i)
+{
+	if (!decode(r.index[i], r.packed[i].data(), r.flat))
+	{
+		r.failed.store(true, std::memory_order_relaxed);
+	}
+
+	// Only whoever claimed it touches it
+	std::vector<UINT8>().swap(r.packed[i]);
+	r.state[i].store(kDone, std::memory_order_release);
+}
+
+void ensure(Reader& r, std::size_t i)
+{
+	if (claim(r, i))
+	{
+		decode_claimed(r, i);
+		return;
+	}
+
+	while (r.state[i].load(std::memory_order_acquire) != kDone)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void prefetch(const std::shared_ptr<Reader>& r, std::size_t i)
+{
+	if (i >= r->index.size() || !claim(*r, i))
+	{
+		return;
+	}
+
+	r->inflight.fetch_add(1, std::memory_order_relaxed);
+	schedule_or_run(
+		[r, i]()
+		{
+			decode_claimed(*r, i);
+			r->inflight.fetch_sub(1, std::memory_order_release);
+		}
+	);
+}
+
+bool read_index(const savebuffer_t* save, std::vector<Entry>& index, UINT32& flatsize)
+{
+	if (save->size < kTrailerSize || save->size > UINT32_MAX)
+	{
+		return false;
+	}
+
+	const UINT8* p = save->buffer + save->size - kTrailerSize;
+	if (std::memcmp(p, kTrailerMagic, sizeof kTrailerMagic))
+	{
+		return false;
+	}
+	p += sizeof kTrailerMagic;
+
+	const UINT32 count = READUINT32(p);
+	const UINT32 indexoffset = READUINT32(p);
+	flatsize = READUINT32(p);
+
+	if (indexoffset > save->size - kTrailerSize || (save->size - kTrailerSize - indexoffset) / kEntrySize != count)
+	{
+		return false;
+	}
+
+	p = save->buffer + indexoffset;
+	index.resize(count);
+
+	for (Entry& entry : index)
+	{
+		entry.flatoffset = READUINT32(p);
+		entry.flatsize = READUINT32(p);
+		entry.fileoffset = READUINT32(p);
+		entry.filesize = READUINT32(p);
+		entry.method = READUINT32(p);
+
+		if (entry.flatoffset > flatsize || entry.flatsize > flatsize - entry.flatoffset ||
+			entry.fileoffset > indexoffset || entry.filesize > indexoffset - entry.fileoffset ||
+			(entry.method == kStored && entry.filesize != entry.flatsize))
+		{
+			return false;
+		}
+	}
+
+	std::sort(index.begin(), index.end(), [](const Entry& a, const Entry& b) { return a.flatoffset < b.flatoffset; });
+
+	return true;
+}
+
+} // namespace
+
+bool srb2::demo_stream_begin(const char* path, const UINT8* header, std::size_t size)
+{
+	demo_stream_abort();
+
+	auto w = std::make_shared<Writer>();
+
+	w->spool = std::string {path} + ".part";
+	w->file = std::fopen(w->spool.c_str(), "w+b");
+	if (w->file == nullptr)
+	{
+		return false;
+	}
+
+	if (!append(*w, header, size))
+	{
+		std::fclose(w->file);
+		std::remove(w->spool.c_str());
+		return false;
+	}
+
+	w->flatoffset = size;
+	w->index.push_back({0, static_cast<UINT32>(size), 0, static_cast<UINT32>(size), kStored});
+
+	g_writer = std::move(w);
+	return true;
+}
+
+void srb2::demo_stream_write(const UINT8* data, std::size_t size)
+{
+	if (g_writer && size)
+	{
+		submit(g_writer, std::vector<UINT8>(data, data + size));
+	}
+}
+
+bool srb2::demo_stream_end(const UINT8* data, std::size_t size, UINT8* digest)
+{
+	if (!g_writer)
+	{
+		return false;
+	}
+
+	demo_stream_write(data, size);
+	wait_idle(*g_writer);
+
+	md5_buffer(reinterpret_cast<const char*>(g_writer->digests.data()), g_writer->digests.size(), digest);
+	return !g_writer->failed;
+}
+
+bool srb2::demo_stream_save(const char* path, const UINT8* header, std::size_t headersize, const UINT8* extrainfo, std::size_t extrasize)
+{
+	ZoneScoped;
+
+	if (!g_writer)
+	{
+		return false;
+	}
+
+	std::shared_ptr<Writer> w = std::move(g_writer);
+	wait_idle(*w);
+
+	bool ok = !w->failed && w->index[0].flatsize == headersize;
+
+	if (ok)
+	{
+		ok = std::fseek(w->file, 0, SEEK_SET) == 0 && std::fwrite(header, 1, headersize, w->file) == headersize;
+	}
+
+	if (ok && extrasize)
+	{
+		w->index.push_back({w->flatoffset, static_cast<UINT32>(extrasize), w->fileend, static_cast<UINT32>(extrasize), kStored});
+		ok = append(*w, extrainfo, extrasize);
+		w->flatoffset += extrasize;
+	}
+
+	if (ok)
+	{
+		std::vector<UINT8> tail(w->index.size() * kEntrySize + kTrailerSize);
+		UINT8* p = tail.data();
+
+		for (const Entry& entry : w->index)
+		{
+			WRITEUINT32(p, entry.flatoffset);
+			WRITEUINT32(p, entry.flatsize);
+			WRITEUINT32(p, entry.fileoffset);
+			WRITEUINT32(p, entry.filesize);
+			WRITEUINT32(p, entry.method);
+		}
+
+		WRITEMEM(p, kTrailerMagic, sizeof kTrailerMagic);
+		WRITEUINT32(p, w->index.size());
+		WRITEUINT32(p, w->fileend);
+		WRITEUINT32(p, w->flatoffset);
+
+		ok = append(*w, tail.data(), tail.size());
+	}
+
+	ok = (std::fclose(w->file) == 0) && ok;
+	w->file = nullptr;
+
+	if (ok)
+	{
+		// rename won't replace an existing file everywhere
+		std::remove(path);
+		ok = std::rename(w->spool.c_str(), path) == 0;
+	}
+
+	if (!ok)
+	{
+		std::remove(w->spool.c_str());
+	}
+
+	return ok;
+}
+
+void srb2::demo_stream_abort()
+{
+	if (!g_writer)
+	{
+		return;
+	}
+
+	std::shared_ptr<Writer> w = std::move(g_writer);
+	wait_idle(*w);
+
+	std::fclose(w->file);
+	std::remove(w->spool.c_str());
+}
+
+bool srb2::demo_stream_is_chunked(const savebuffer_t* save)
+{
+	return save->buffer && save->size >= kTrailerSize &&
+		!std::memcmp(save->buffer + save->size - kTrailerSize, kTrailerMagic, sizeof kTrailerMagic);
+}
+
+bool srb2::demo_stream_load(savebuffer_t* save, DemoStreamLoad load)
+{
+	ZoneScoped;
+
+	std::vector<Entry> index;
+	UINT32 flatsize = 0;
+
+	if (!read_index(save, index, flatsize) || flatsize == 0)
+	{
+		return false;
+	}
+
+	UINT8* flat = static_cast<UINT8*>(load == DemoStreamLoad::kHeader ? Z_Calloc(flatsize, PU_STATIC, NULL) : Z_Malloc(flatsize, PU_STATIC, NULL));
+	std::shared_ptr<Reader> r;
+
+	if (load == DemoStreamLoad::kOnDemand)
+	{
+		demo_stream_close();
+
+		r = std::make_shared<Reader>();
+		r->packed.resize(index.size());
+		r->state = std::make_unique<std::atomic<UINT8>[]>(index.size());
+		r->flat = flat;
+		r->flatsize = flatsize;
+	}
+
+	for (std::size_t i = 0; i < index.size(); i++)
+	{
+		if (index[i].method == kStored || load == DemoStreamLoad::kAll)
+		{
+			if (!decode(index[i], save->buffer + index[i].fileoffset, flat))
+			{
+				Z_Free(flat);
+				return false;
+			}
+			if (r)
+			{
+				r->state[i].store(kDone, std::memory_order_relaxed);
+			}
+		}
+		else if (r)
+		{
+			// The file itself is freed below
+			r->packed[i].assign(save->buffer + index[i].fileoffset, save->buffer + index[i].fileoffset + index[i].filesize);
+			r->state[i].store(kPending, std::memory_order_relaxed);
+		}
+	}
+
+	if (r)
+	{
+		r->index = std::move(index);
+		g_reader = std::move(r);
+	}
+
+	Z_Free(save->buffer);
+	save->buffer = save->p = flat;
+	save->size = flatsize;
+	save->end = flat + flatsize;
+
+	return true;
+}
+
+void srb2::demo_stream_prepare(const UINT8* p)
+{
+	Reader* r = g_reader.get();
+
+	if (r == nullptr || p < r->flat || p >= r->flat + r->flatsize)
+	{
+		return;
+	}
+
+	const std::size_t offset = p - r->flat;
+	const std::size_t last = std::min(offset + kPrepareMargin, r->flatsize - 1);
+
+	auto it = std::upper_bound(
+		r->index.begin(),
+		r->index.end(),
+		offset,
+		[](std::size_t off, const Entry& entry) { return off < entry.flatoffset; }
+	);
+	std::size_t i = (it == r->index.begin() ? 0 : (it - r->index.begin()) - 1);
+
+	for (; i < r->index.size() && r->index[i].flatoffset <= last; i++)
+	{
+		ensure(*r, i);
+	}
+
+	prefetch(g_reader, i);
+
+	if (r->failed.exchange(false, std::memory_order_relaxed))
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("Part of this replay couldn't be decompressed.\n"));
+	}
+}
+
+void srb2::demo_stream_close()
+{
+	if (!g_reader)
+	{
+		return;
+	}
+
+	while (g_reader->inflight.load(std::memory_order_acquire) > 0)
+	{
+		std::this_thread::yield();
+	}
+
+	g_reader.reset();
+}
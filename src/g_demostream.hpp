@@ -0,0 +1,76 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  g_demostream.hpp
+/// \brief Chunked demo files, compressed while recording and decoded as played
+
+#ifndef __G_DEMOSTREAM_HPP__
+#define __G_DEMOSTREAM_HPP__
+
+#include <cstddef>
+
+#include "doomtype.h"
+
+struct savebuffer_t;
+
+namespace srb2
+{
+
+/// Body bytes gathered before they're handed off to be compressed.
+constexpr std::size_t kDemoChunkSize = 256 << 10;
+
+/// Size of the recording buffer while streaming: the header, a chunk, and the tics that spill past it.
+constexpr std::size_t kDemoStreamWindow = 2 << 20;
+
+/// A chunked demo starts with the same header as a flat one. The body follows as compressed chunks, each
+/// ending on a tic, then the extra info uncompressed, then an index of everything by its offset in the flat
+/// demo. Loading one turns it back into the flat demo the rest of g_demo.cpp reads.
+///
+/// Recording writes into a spool file next to the demo, which demo_stream_save moves into place; only one
+/// demo is recorded at a time, from the main thread.
+
+/// Opens the spool file for path and writes the header, which demo_stream_save writes over again.
+bool demo_stream_begin(const char* path, const UINT8* header, std::size_t size);
+
+/// Compresses and appends body bytes on the thread pool.
+void demo_stream_write(const UINT8* data, std::size_t size);
+
+/// Appends the last of the body and waits for the chunks still being written.
+/// @param digest filled with an MD5 of the body: of the MD5s of each chunk, since those are all there is by the end
+/// @return false if any chunk failed to write
+bool demo_stream_end(const UINT8* data, std::size_t size, UINT8* digest);
+
+/// Writes the finished header, the extra info and the index, then moves the spool file to path.
+bool demo_stream_save(const char* path, const UINT8* header, std::size_t headersize, const UINT8* extrainfo, std::size_t extrasize);
+
+/// Throws away the recording and its spool file.
+void demo_stream_abort();
+
+enum class DemoStreamLoad
+{
+	kHeader,   ///< only the header and extra info; the body is left zeroed
+	kAll,      ///< everything, right now
+	kOnDemand, ///< chunks as demo_stream_prepare reaches them
+};
+
+bool demo_stream_is_chunked(const savebuffer_t* save);
+
+/// Replaces a chunked file in save with the flat demo it holds.
+/// @return false if the file is damaged; save is left alone
+bool demo_stream_load(savebuffer_t* save, DemoStreamLoad load);
+
+/// Makes sure the body at p has been decoded, and starts on the chunk after it.
+/// Does nothing for anything but the buffer last loaded with kOnDemand.
+void demo_stream_prepare(const UINT8* p);
+
+/// Stops decoding on demand. Must be called before that buffer is freed.
+void demo_stream_close();
+
+} // namespace srb2
+
+#endif // __G_DEMOSTREAM_HPP__
@@ -4490,6 +4490,10 @@ void G_GetNextMap(void)
 	if (nextmap == NEXTMAP_INVALID || (nextmap < NEXTMAP_SPECIAL && (nextmap >= nummapheaders || !mapheaderinfo[nextmap] || mapheaderinfo[nextmap]->lumpnum == LUMPERROR)))
 		I_Error("G_GetNextMap: Internal map ID %d not found (nummapheaders = %d)\n", nextmap, nummapheaders);
 
+	// Read it during the intermission
+	if (nextmap < NEXTMAP_SPECIAL)
+		P_PrefetchLevel(nextmap, encoremode);
+
 #if 0 // This is a surprise tool that will help us later.
 	if (!spec)
 #endif //#if 0
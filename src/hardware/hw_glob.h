@@ -98,7 +98,12 @@ typedef struct gl_vissprite_s
 	INT32 dispoffset; // copy of info->dispoffset, affects ordering but not drawing
 
 	patch_t *gpatch;
-	mobj_t *mobj; // NOTE: This is a precipmobj_t if precip is true !!! Watch out.
+	mobj_t *mobj; // NOTE: This is NULL if precip is true !!! Watch out.
+
+	// Precipitation particles only
+	sector_t *precipsector;
+	fixed_t precipz;
+	UINT32 precipframe;
 } gl_vissprite_t;
 
 void HWR_ObjectLightLevelPost(gl_vissprite_t *spr, const sector_t *sector, INT32 *lightlevel, boolean model);
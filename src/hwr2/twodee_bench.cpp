@@ -0,0 +1,129 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "twodee_bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include <tracy/tracy/Tracy.hpp>
+
+#include "../rhi/null/null_rhi.hpp"
+#include "patch_atlas.hpp"
+#include "resource_management.hpp"
+#include "twodee_renderer.hpp"
+
+using namespace srb2;
+using namespace srb2::hwr2;
+using namespace srb2::rhi;
+
+TwodeeBenchResult srb2::hwr2::benchmark_twodee(const Twodee& frame, uint32_t iterations)
+{
+	ZoneScoped;
+
+	TwodeeBenchResult result;
+
+	for (const Draw2dList& list : frame)
+	{
+		result.lists++;
+		result.cmds += list.cmds.size();
+		result.vertices += list.vertices.size();
+		result.indices += list.indices.size();
+	}
+
+	if (iterations == 0)
+	{
+		return result;
+	}
+
+	// Same setup as the live renderer, minus the GPU
+	NullRhi rhi;
+	PaletteManager palette_manager;
+	FlatTextureManager flat_manager;
+	PatchAtlasCache patch_atlas_cache {2048, 3};
+	TwodeeRenderer renderer {&palette_manager, &flat_manager, &patch_atlas_cache};
+
+	auto replay = [&](double& ms)
+	{
+		// flush consumes the lists it is given
+		Twodee twodee = frame;
+
+		Handle<GraphicsContext> ctx = rhi.begin_graphics();
+		palette_manager.update(rhi, ctx);
+		rhi.begin_default_render_pass(ctx, false);
+
+		// Only the renderer is timed, not the bookkeeping around it
+		rhi.reset_stats();
+		auto start = std::chrono::steady_clock::now();
+		renderer.flush(rhi, ctx, twodee);
+		auto end = std::chrono::steady_clock::now();
+		const NullRhiStats stats = rhi.stats();
+
+		rhi.end_render_pass(ctx);
+		rhi.end_graphics(ctx);
+		palette_manager.destroy_per_frame_resources(rhi);
+		rhi.finish();
+
+		ms = std::chrono::duration<double, std::milli>(end - start).count();
+		return stats;
+	};
+
+	double total_warm_ms = 0.0;
+	result.min_ms = std::numeric_limits<double>::max();
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		double ms;
+		const NullRhiStats stats = replay(ms);
+
+		result.draw_calls = stats.draw_calls;
+		result.pipeline_binds = stats.pipeline_binds;
+		result.binding_sets = stats.binding_sets;
+		result.buffer_upload_bytes = stats.buffer_upload_bytes;
+		result.indices_drawn = stats.vertices_drawn;
+
+		if (i == 0)
+		{
+			result.cold_texture_uploads = stats.texture_uploads;
+			result.cold_texture_upload_bytes = stats.texture_upload_bytes;
+			result.cold_ms = ms;
+			continue;
+		}
+
+		result.warm_texture_uploads += stats.texture_uploads;
+		total_warm_ms += ms;
+		result.min_ms = std::min(result.min_ms, ms);
+		result.max_ms = std::max(result.max_ms, ms);
+	}
+
+	result.iterations = iterations;
+
+	{
+		// Reordering must never cost draw calls, nor drop or duplicate anything
+		double ms;
+		renderer.set_reorder(false);
+		const NullRhiStats stats = replay(ms);
+		result.in_order_draw_calls = stats.draw_calls;
+		result.in_order_pipeline_binds = stats.pipeline_binds;
+		result.in_order_indices_drawn = stats.vertices_drawn;
+	}
+
+	if (iterations > 1)
+	{
+		result.avg_ms = total_warm_ms / (iterations - 1);
+	}
+	else
+	{
+		result.avg_ms = result.min_ms = result.max_ms = result.cold_ms;
+	}
+
+	return result;
+}
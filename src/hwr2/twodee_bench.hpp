@@ -0,0 +1,63 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_HWR2_TWODEE_BENCH_HPP__
+#define __SRB2_HWR2_TWODEE_BENCH_HPP__
+
+#include <cstdint>
+
+#include "twodee.hpp"
+
+namespace srb2::hwr2
+{
+
+struct TwodeeBenchResult
+{
+	uint32_t iterations = 0;
+
+	// Contents of the captured frame
+	uint32_t lists = 0;
+	uint32_t cmds = 0;
+	uint32_t vertices = 0;
+	uint32_t indices = 0;
+
+	// Submitted to the device for each replay
+	uint32_t draw_calls = 0;
+	uint32_t pipeline_binds = 0;
+	uint32_t binding_sets = 0;
+	uint64_t buffer_upload_bytes = 0;
+	uint64_t indices_drawn = 0;
+
+	// The same frame replayed once more with commands kept in submission order, for comparison
+	uint32_t in_order_draw_calls = 0;
+	uint32_t in_order_pipeline_binds = 0;
+	uint64_t in_order_indices_drawn = 0;
+
+	// The first replay starts from empty atlases, so it pays for packing every patch
+	uint32_t cold_texture_uploads = 0;
+	uint64_t cold_texture_upload_bytes = 0;
+	double cold_ms = 0.0;
+
+	// Every later replay. Texture uploads here are per-frame colormaps, or atlases being repacked
+	uint32_t warm_texture_uploads = 0;
+	double avg_ms = 0.0;
+	double min_ms = 0.0;
+	double max_ms = 0.0;
+};
+
+/// @brief Replay a captured frame of 2D drawing through a fresh TwodeeRenderer on a NullRhi, measuring the CPU time
+/// spent batching and packing. The patches and colormaps referenced by the frame must still be alive.
+/// @param frame the draw lists, as they were before being flushed
+/// @param iterations number of replays, including the cold one
+TwodeeBenchResult benchmark_twodee(const Twodee& frame, uint32_t iterations);
+
+} // namespace srb2::hwr2
+
+#endif // __SRB2_HWR2_TWODEE_BENCH_HPP__
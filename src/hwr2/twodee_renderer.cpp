@@ -231,6 +231,198 @@ void TwodeeRenderer::rewrite_patch_quad_vertices(Draw2dList& list, const Draw2dP
 	list.vertices[vtx_offs + 3].v = clipped_vmax;
 }
 
+std::optional<MergedTwodeeCommand::Texture> TwodeeRenderer::texture_for_cmd(const Draw2dCmd& cmd) const
+{
+	auto visitor = srb2::Overload {
+		[&](const Draw2dPatchQuad& cmd) -> std::optional<MergedTwodeeCommand::Texture>
+		{
+			if (cmd.patch == nullptr)
+			{
+				return std::nullopt;
+			}
+			srb2::NotNull<const PatchAtlas*> atlas = patch_atlas_cache_->find_patch(cmd.patch);
+			return atlas->texture();
+		},
+		[&](const Draw2dVertices& cmd) -> std::optional<MergedTwodeeCommand::Texture>
+		{
+			if (cmd.flat_lump == LUMPERROR)
+			{
+				return std::nullopt;
+			}
+			return MergedTwodeeCommandFlatTexture {cmd.flat_lump};
+		}};
+	return std::visit(visitor, cmd);
+}
+
+namespace
+{
+
+struct TwodeeBounds
+{
+	float xmin;
+	float ymin;
+	float xmax;
+	float ymax;
+
+	bool overlaps(const TwodeeBounds& r) const noexcept
+	{
+		return xmin < r.xmax && r.xmin < xmax && ymin < r.ymax && r.ymin < ymax;
+	}
+
+	void add(const TwodeeBounds& r) noexcept
+	{
+		xmin = std::min(xmin, r.xmin);
+		ymin = std::min(ymin, r.ymin);
+		xmax = std::max(xmax, r.xmax);
+		ymax = std::max(ymax, r.ymax);
+	}
+};
+
+// Everything that splits a merged command
+struct TwodeeCmdState
+{
+	TwodeePipelineKey pipeline_key;
+	std::optional<MergedTwodeeCommand::Texture> texture;
+	const uint8_t* colormap;
+
+	bool operator==(const TwodeeCmdState& r) const noexcept
+	{
+		return pipeline_key == r.pipeline_key && texture == r.texture && colormap == r.colormap;
+	}
+};
+
+struct TwodeeBatch
+{
+	TwodeeCmdState state;
+	TwodeeBounds bounds;
+	std::vector<std::size_t> cmds;
+};
+
+// How many batches back a command may move. Keeps the pass linear on long lists that never match.
+constexpr std::size_t kReorderWindow = 16;
+
+TwodeeBounds bounds_for_cmd(const Draw2dList& list, const Draw2dCmd& cmd)
+{
+	TwodeeBounds bounds;
+	auto visitor = srb2::Overload {
+		[&](const Draw2dPatchQuad& cmd)
+		{
+			bounds = {
+				std::min(cmd.xmin, cmd.xmax),
+				std::min(cmd.ymin, cmd.ymax),
+				std::max(cmd.xmin, cmd.xmax),
+				std::max(cmd.ymin, cmd.ymax)
+			};
+			if (cmd.clip)
+			{
+				bounds.xmin = std::max(bounds.xmin, cmd.clip_xmin);
+				bounds.ymin = std::max(bounds.ymin, cmd.clip_ymin);
+				bounds.xmax = std::min(bounds.xmax, cmd.clip_xmax);
+				bounds.ymax = std::min(bounds.ymax, cmd.clip_ymax);
+			}
+		},
+		[&](const Draw2dVertices& cmd)
+		{
+			if (cmd.elements == 0)
+			{
+				bounds = {0.f, 0.f, 0.f, 0.f};
+				return;
+			}
+			const TwodeeVertex& first = list.vertices[cmd.begin_element];
+			bounds = {first.x, first.y, first.x, first.y};
+			for (std::size_t i = cmd.begin_element; i < cmd.begin_element + cmd.elements; i++)
+			{
+				const TwodeeVertex& v = list.vertices[i];
+				bounds.add({v.x, v.y, v.x, v.y});
+			}
+		}};
+	std::visit(visitor, cmd);
+
+	// Lines and filtering can touch the pixel past the edge
+	bounds.xmin -= 1.f;
+	bounds.ymin -= 1.f;
+	bounds.xmax += 1.f;
+	bounds.ymax += 1.f;
+	return bounds;
+}
+
+} // namespace
+
+void TwodeeRenderer::reorder_cmds(Draw2dList& list) const
+{
+	// Each command is moved back to the latest batch drawn with the same state, so long as it doesn't overlap
+	// anything drawn between there and here. Commands that don't overlap can't affect each other's pixels, whatever
+	// their blend mode, so the frame comes out the same with fewer state changes.
+	std::vector<TwodeeBatch> batches;
+	std::vector<std::size_t> index_offsets;
+	index_offsets.reserve(list.cmds.size());
+
+	std::size_t index_offset = 0;
+	for (std::size_t i = 0; i < list.cmds.size(); i++)
+	{
+		const Draw2dCmd& cmd = list.cmds[i];
+		const TwodeeCmdState state = {
+			pipeline_key_for_cmd(cmd),
+			texture_for_cmd(cmd),
+			std::holds_alternative<Draw2dPatchQuad>(cmd) ? std::get<Draw2dPatchQuad>(cmd).colormap : nullptr
+		};
+		const TwodeeBounds bounds = bounds_for_cmd(list, cmd);
+
+		index_offsets.push_back(index_offset);
+		index_offset += hwr2::elements(cmd);
+
+		std::optional<std::size_t> target;
+		for (std::size_t j = batches.size(); j > 0 && batches.size() - j < kReorderWindow; j--)
+		{
+			TwodeeBatch& batch = batches[j - 1];
+			if (batch.state == state)
+			{
+				target = j - 1;
+				break;
+			}
+			if (batch.bounds.overlaps(bounds))
+			{
+				break;
+			}
+		}
+
+		if (!target)
+		{
+			batches.push_back({state, bounds, {}});
+			target = batches.size() - 1;
+		}
+		else
+		{
+			batches[*target].bounds.add(bounds);
+		}
+		batches[*target].cmds.push_back(i);
+	}
+
+	if (batches.size() == list.cmds.size())
+	{
+		// Nothing to gain
+		return;
+	}
+
+	// The indices of each command are contiguous, so they move along with it
+	std::vector<Draw2dCmd> cmds;
+	std::vector<uint16_t> indices;
+	cmds.reserve(list.cmds.size());
+	indices.reserve(list.indices.size());
+	for (const TwodeeBatch& batch : batches)
+	{
+		for (std::size_t i : batch.cmds)
+		{
+			const auto first = list.indices.begin() + index_offsets[i];
+			cmds.push_back(list.cmds[i]);
+			indices.insert(indices.end(), first, first + hwr2::elements(list.cmds[i]));
+		}
+	}
+
+	list.cmds = std::move(cmds);
+	list.indices = std::move(indices);
+}
+
 void TwodeeRenderer::initialize(Rhi& rhi, Handle<GraphicsContext> ctx)
 {
 	{
@@ -364,6 +556,11 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 			ibo = std::get<0>(ibos_[list_index]);
 		}
 
+		if (reorder_)
+		{
+			reorder_cmds(list);
+		}
+
 		// Create a merged command list
 		MergedTwodeeCommandList merged_list;
 		merged_list.vbo = vbo;
@@ -560,6 +757,7 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 	Handle<UniformSet> us_2 = rhi.create_uniform_set(ctx, {tcb::span(g2_uniforms)});
 
 	// Presumably, we're already in a renderpass when flush is called
+	std::optional<TwodeePipelineKey> bound_pipeline_key;
 	for (auto& list : cmd_lists_)
 	{
 		for (auto& cmd : list.cmds)
@@ -571,11 +769,16 @@ void TwodeeRenderer::flush(Rhi& rhi, Handle<GraphicsContext> ctx, Twodee& twodee
 				continue;
 			}
 			SRB2_ASSERT(pipelines_.find(cmd.pipeline_key) != pipelines_.end());
-			Handle<Pipeline> pl = pipelines_[cmd.pipeline_key];
-			rhi.bind_pipeline(ctx, pl);
-			rhi.set_viewport(ctx, {0, 0, static_cast<uint32_t>(vid.width), static_cast<uint32_t>(vid.height)});
-			rhi.bind_uniform_set(ctx, 0, us_1);
-			rhi.bind_uniform_set(ctx, 1, us_2);
+			if (bound_pipeline_key != cmd.pipeline_key)
+			{
+				// Uniforms belong to the pipeline, so they're only bound again along with it
+				Handle<Pipeline> pl = pipelines_[cmd.pipeline_key];
+				rhi.bind_pipeline(ctx, pl);
+				rhi.set_viewport(ctx, {0, 0, static_cast<uint32_t>(vid.width), static_cast<uint32_t>(vid.height)});
+				rhi.bind_uniform_set(ctx, 0, us_1);
+				rhi.bind_uniform_set(ctx, 1, us_2);
+				bound_pipeline_key = cmd.pipeline_key;
+			}
 			rhi.bind_binding_set(ctx, cmd.binding_set);
 			rhi.bind_index_buffer(ctx, list.ibo);
 			rhi.draw_indexed(ctx, cmd.elements, cmd.index_offset);
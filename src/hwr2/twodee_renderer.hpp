@@ -98,8 +98,11 @@ class TwodeeRenderer final
 	rhi::Handle<rhi::Texture> output_;
 	rhi::Handle<rhi::Texture> default_tex_;
 	std::unordered_map<TwodeePipelineKey, rhi::Handle<rhi::Pipeline>> pipelines_;
+	bool reorder_ = true;
 
 	void rewrite_patch_quad_vertices(Draw2dList& list, const Draw2dPatchQuad& cmd) const;
+	std::optional<MergedTwodeeCommand::Texture> texture_for_cmd(const Draw2dCmd& cmd) const;
+	void reorder_cmds(Draw2dList& list) const;
 
 	void initialize(rhi::Rhi& rhi, rhi::Handle<rhi::GraphicsContext> ctx);
 
@@ -115,6 +118,10 @@ public:
 	TwodeeRenderer& operator=(const TwodeeRenderer&) = delete;
 	TwodeeRenderer& operator=(TwodeeRenderer&&);
 
+	/// @brief Allow commands that don't overlap to be drawn out of order, so that ones sharing a pipeline, texture
+	/// and colormap end up in the same draw call. On by default.
+	void set_reorder(bool reorder) noexcept { reorder_ = reorder; }
+
 	/// @brief Flush accumulated Twodee state and perform draws.
 	/// @param rhi
 	/// @param ctx
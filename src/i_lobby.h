@@ -0,0 +1,36 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_lobby.h
+/// \brief Hosting several dedicated lobbies from one loaded process
+
+#ifndef __I_LOBBY_H__
+#define __I_LOBBY_H__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	\brief	With -lobbies <n> on a dedicated server, fork n lobby processes that
+			share everything loaded so far, and stay behind to supervise them.
+
+	Each lobby gets its own port (counting up from -port), log file, config file
+	and gamedata. Lobbies that crash are forked again from the loaded state.
+	The supervisor never returns; it exits once every lobby has quit.
+
+	\return	the lobby number, from 1, or 0 if not hosting lobbies
+*/
+INT32 I_StartLobbies(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __I_LOBBY_H__
@@ -102,6 +102,14 @@ extern boolean (*I_NetGet)(void);
 */
 extern boolean (*I_NetCanGet)(void);
 
+/**	\brief wait for data to arrive, for at most duration
+
+	\param	duration	how long to wait, in precise_t units
+
+	\return	true if there is data waiting, false if the time ran out
+*/
+extern boolean (*I_NetWait)(precise_t duration);
+
 /**	\brief send packet within doomcom struct
 */
 extern void (*I_NetSend)(void);
@@ -60,6 +60,21 @@ void I_ShutdownSound(void);
 */
 void I_UpdateAudioRecorder(void);
 
+/**	\brief	Mixes the given number of tics of audio straight into an offline
+		AVRecorder. The audio device is paused while one is active.
+*/
+void I_RenderOfflineAudio(UINT32 tics);
+
+/**	\brief	Renders a synthetic sound effect and music mix offline, without
+		opening an audio device, and prints timing results.
+
+	\param	seconds	length of audio to render
+	\param	voices	number of simultaneously playing sound effect voices
+
+	\return	void
+*/
+void I_BenchmarkSoundMixer(UINT32 seconds, UINT32 voices);
+
 /// ------------------------
 ///  SFX I/O
 /// ------------------------
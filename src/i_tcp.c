@@ -34,6 +34,12 @@
 
 #include "i_addrinfo.h"
 
+#ifdef __linux__
+	#include <sys/epoll.h>
+	#include <sys/timerfd.h>
+	#define USE_EPOLL
+#endif
+
 #define SELECTTEST
 
 #define DEFAULTPORT "5029"
@@ -534,6 +540,119 @@ static boolean SOCK_CanGet(void)
 }
 #endif
 
+#ifdef USE_EPOLL
+// Built on the first wait after the sockets change. The timer is how the wait ends, since
+// epoll_wait can only time out to the millisecond.
+static int epollfd = -1;
+static int epolltimerfd = -1;
+static boolean epolldirty = true;
+
+static void SOCK_CloseEpoll(void)
+{
+	if (epollfd != -1)
+		close(epollfd);
+	if (epolltimerfd != -1)
+		close(epolltimerfd);
+	epollfd = epolltimerfd = -1;
+	epolldirty = true;
+}
+
+static boolean SOCK_BuildEpoll(void)
+{
+	struct epoll_event ev;
+	size_t i;
+
+	SOCK_CloseEpoll();
+
+	epollfd = epoll_create1(EPOLL_CLOEXEC);
+	epolltimerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+	if (epollfd == -1 || epolltimerfd == -1)
+	{
+		SOCK_CloseEpoll();
+		return false;
+	}
+
+	memset(&ev, 0, sizeof (ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = epolltimerfd;
+	if (epoll_ctl(epollfd, EPOLL_CTL_ADD, epolltimerfd, &ev) == -1)
+	{
+		SOCK_CloseEpoll();
+		return false;
+	}
+
+	for (i = 0; i < mysocketses; i++)
+	{
+		if (mysockets[i] == (SOCKET_TYPE)ERRSOCKET)
+			continue;
+		ev.data.fd = mysockets[i];
+		if (epoll_ctl(epollfd, EPOLL_CTL_ADD, mysockets[i], &ev) == -1 && errno != EEXIST)
+		{
+			SOCK_CloseEpoll();
+			return false;
+		}
+	}
+
+	epolldirty = false;
+	return true;
+}
+#endif
+
+static boolean SOCK_Wait(precise_t duration)
+{
+	const UINT64 precision = I_GetPrecisePrecision();
+	fd_set tset;
+	struct timeval tv;
+	int rselect;
+
+#ifdef USE_EPOLL
+	if (!epolldirty || SOCK_BuildEpoll())
+	{
+		struct itimerspec its;
+		struct epoll_event events[MAXNETNODES+2];
+		boolean canget = false;
+		int n, i;
+
+		memset(&its, 0, sizeof (its));
+		its.it_value.tv_sec = (time_t)(duration / precision);
+		its.it_value.tv_nsec = (long)((duration % precision) * 1000000000 / precision);
+		if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+			its.it_value.tv_nsec = 1; // zero would disarm it
+
+		if (timerfd_settime(epolltimerfd, 0, &its, NULL) == 0)
+		{
+			do
+				n = epoll_wait(epollfd, events, MAXNETNODES+2, -1);
+			while (n == -1 && errno == EINTR);
+
+			// No need to read the timer; arming it again clears it
+			for (i = 0; i < n; i++)
+			{
+				if (events[i].data.fd != epolltimerfd)
+					canget = true;
+			}
+
+			if (n >= 0)
+				return canget;
+		}
+
+		// Something's wrong with it, try select instead
+		SOCK_CloseEpoll();
+	}
+#endif
+
+	tv.tv_sec = (long)(duration / precision);
+	tv.tv_usec = (long)((duration % precision) * 1000000 / precision);
+
+	if (!FD_CPY(&masterset, &tset, mysockets, mysocketses))
+	{
+		I_SleepDuration(duration);
+		return false;
+	}
+	rselect = select(255, &tset, NULL, NULL, &tv);
+	return (rselect >= 1);
+}
+
 static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
 {
 	socklen_t d4 = (socklen_t)sizeof(struct sockaddr_in);
@@ -746,6 +865,9 @@ static boolean UDP_Socket(void)
 		nodesocket[s] = ERRSOCKET;
 	FD_ZERO(&masterset);
 	s = 0;
+#ifdef USE_EPOLL
+	epolldirty = true;
+#endif
 
 	memset(&hints, 0x00, sizeof (hints));
 	hints.ai_flags = AI_NUMERICHOST;
@@ -1019,6 +1141,9 @@ static void SOCK_CloseSocket(void)
 		}
 		mysockets[i] = ERRSOCKET;
 	}
+#ifdef USE_EPOLL
+	SOCK_CloseEpoll();
+#endif
 }
 
 void I_ShutdownTcpDriver(void)
@@ -1168,6 +1293,7 @@ static boolean SOCK_OpenSocket(void)
 	I_NetCanSend = SOCK_CanSend;
 	I_NetCanGet = SOCK_CanGet;
 #endif
+	I_NetWait = SOCK_Wait;
 
 	I_NetRequestHolePunch = SOCK_RequestHolePunch;
 	I_NetRegisterHolePunch = SOCK_RegisterHolePunch;
@@ -101,6 +101,19 @@ void I_UpdateTime(void)
 	}
 }
 
+precise_t I_GetPreciseTimeUntilNextTic(void)
+{
+	const double ticlength = 1.0 / ((double)TICRATE * FIXED_TO_FLOAT(I_GetTimeScale()));
+	const UINT64 precision = I_GetPrecisePrecision();
+	double remaining;
+
+	remaining = ticlength - tictimer - (double)(I_GetPreciseTime() - oldenterprecise) / precision;
+	if (remaining <= 0.0)
+		return 0;
+
+	return (precise_t)ceil(remaining * precision);
+}
+
 void I_SleepDuration(precise_t duration)
 {
 	UINT64 precision = I_GetPrecisePrecision();
@@ -42,6 +42,11 @@ void I_InitializeTime(void);
 void I_UpdateTime(void);
 fixed_t I_GetTimeScale(void);
 
+/** \brief  How long until I_UpdateTime will next see a new tic, at the current time scale.
+            Zero if it already would.
+*/
+precise_t I_GetPreciseTimeUntilNextTic(void);
+
 /** \brief  Block for at minimum the duration specified. This function makes a
             best effort not to oversleep, and will spinloop if sleeping would
 			take too long. However, callers should still check the current time
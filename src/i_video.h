@@ -171,6 +171,12 @@ UINT32 I_GetRefreshRate(void);
 
 void I_CaptureVideoFrame(void);
 
+/**	\brief	Replay the next frame's 2D drawing through the hardware 2D renderer on a null device and report its CPU cost
+
+	\param	iterations	number of replays
+*/
+void I_BenchmarkTwodee(UINT32 iterations);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -19,12 +19,14 @@
 
 #include "command.h"
 #include "cxxutil.hpp"
+#include "d_main.h"
 #include "f_finale.h"
 #include "m_fixed.h"
 #include "m_misc.h"
 #include "hwr2/hardware_state.hpp"
 #include "hwr2/patch_atlas.hpp"
 #include "hwr2/twodee.hpp"
+#include "hwr2/twodee_bench.hpp"
 #include "v_video.h"
 
 // KILL THIS WHEN WE KILL OLD OGL SUPPORT PLEASE
@@ -58,6 +60,7 @@ static Rhi* g_last_known_rhi = nullptr;
 static bool g_imgui_frame_active = false;
 static Handle<GraphicsContext> g_main_graphics_context;
 static HardwareState g_hw_state;
+static UINT32 g_twodee_bench_iterations = 0;
 
 Handle<Rhi> srb2::sys::g_current_rhi = kNullHandle;
 
@@ -210,6 +213,73 @@ void I_CaptureVideoFrame()
 	hw_state->screen_capture->capture(*rhi, ctx);
 }
 
+void I_BenchmarkTwodee(UINT32 iterations)
+{
+	if (rendermode != render_soft)
+	{
+		CONS_Alert(CONS_ERROR, "The 2D benchmark needs the Software renderer.\n");
+		return;
+	}
+
+	g_twodee_bench_iterations = std::max<UINT32>(iterations, 1);
+}
+
+static void run_twodee_benchmark(const Twodee& frame, uint32_t iterations)
+{
+	TwodeeBenchResult r = benchmark_twodee(frame, iterations);
+
+	CONS_Printf(
+		"2D benchmark, %u replays of %u lists: %u cmds, %u vertices, %u indices\n",
+		r.iterations, r.lists, r.cmds, r.vertices, r.indices
+	);
+	CONS_Printf(
+		"%u draw calls, %u pipeline binds, %u binding sets, %s vertex/index bytes per frame\n",
+		r.draw_calls, r.pipeline_binds, r.binding_sets, sizeu1(static_cast<size_t>(r.buffer_upload_bytes))
+	);
+	CONS_Printf(
+		"in submission order: %u draw calls, %u pipeline binds\n",
+		r.in_order_draw_calls, r.in_order_pipeline_binds
+	);
+	if (r.draw_calls > r.in_order_draw_calls || r.indices_drawn != r.in_order_indices_drawn)
+	{
+		CONS_Alert(
+			CONS_WARNING,
+			"Reordered 2D draws came out worse than in order: %u draw calls for %s indices, against %u for %s\n",
+			r.draw_calls, sizeu1(static_cast<size_t>(r.indices_drawn)),
+			r.in_order_draw_calls, sizeu2(static_cast<size_t>(r.in_order_indices_drawn))
+		);
+	}
+	CONS_Printf(
+		"cold: %.3f ms, %u texture uploads (%s bytes)\n",
+		r.cold_ms, r.cold_texture_uploads, sizeu1(static_cast<size_t>(r.cold_texture_upload_bytes))
+	);
+	CONS_Printf(
+		"warm: %.3f ms avg, %.3f min, %.3f max, %u texture uploads\n",
+		r.avg_ms, r.min_ms, r.max_ms, r.warm_texture_uploads
+	);
+
+	// CSV-readable results, like timedemo's, so runs can be compared by a script
+	const char *csvpath = va("%s" PATHSEP "%s", srb2home, "twodeebench.csv");
+	const char *header = "iterations,lists,cmds,vertices,indices,drawcalls,pipelinebinds,bindingsets,bufferbytes,"
+		"coldms,coldtexuploads,coldtexbytes,avgms,minms,maxms,warmtexuploads,vidwidth,vidheight,inorderdrawcalls,inorderpipelinebinds\n";
+	const char *rowformat = "%u,%u,%u,%u,%u,%u,%u,%u,%s,%f,%u,%s,%f,%f,%f,%u,%d,%d,%u,%u\n";
+	boolean headerrow = !FIL_FileExists(csvpath);
+	FILE *f = fopen(csvpath, "a+");
+
+	if (f)
+	{
+		if (headerrow)
+			fputs(header, f);
+		fprintf(f, rowformat,
+			r.iterations, r.lists, r.cmds, r.vertices, r.indices, r.draw_calls, r.pipeline_binds, r.binding_sets,
+			sizeu1(static_cast<size_t>(r.buffer_upload_bytes)), r.cold_ms, r.cold_texture_uploads,
+			sizeu2(static_cast<size_t>(r.cold_texture_upload_bytes)), r.avg_ms, r.min_ms, r.max_ms,
+			r.warm_texture_uploads, vid.width, vid.height, r.in_order_draw_calls, r.in_order_pipeline_binds);
+		fclose(f);
+		CONS_Printf("2D benchmark results saved to '%s'\n", csvpath);
+	}
+}
+
 void I_StartDisplayUpdate(void)
 {
 	if (rendermode == render_none)
@@ -281,6 +351,12 @@ void I_FinishUpdate(void)
 
 	if (ctx != kNullHandle)
 	{
+		if (g_twodee_bench_iterations)
+		{
+			run_twodee_benchmark(g_2d, g_twodee_bench_iterations);
+			g_twodee_bench_iterations = 0;
+		}
+
 		// better hope the drawing code left the context in a render pass, I guess
 		g_hw_state.twodee_renderer->flush(*rhi, ctx, g_2d);
 		rhi->end_render_pass(ctx);
@@ -148,10 +148,8 @@ void K_InitGrandPrixBots(void)
 	}
 	grabskins[usableskins] = MAXSKINS;
 
-#if MAXPLAYERS != 16
-	I_Error("GP bot difficulty levels need rebalanced for the new player count!\n");
-#endif
-
+	// K_GetGPPlayerCount never goes past 16, so only those get a level
+	// in bigger builds too.
 	if (grandprixinfo.masterbots)
 	{
 		// Everyone is max difficulty!!
@@ -11248,6 +11248,137 @@ static void K_KartDrift(player_t *player, boolean onground)
 	else
 		player->pflags &= ~PF_BRAKEDRIFT;
 }
+// Everything K_KartUpdatePosition ranks players by, sorted once per tic, so
+// that each player's position takes a few binary searches rather than a pass
+// over everyone else.
+static struct
+{
+	UINT8 count;
+	UINT64 realtime[MAXPLAYERS];
+	UINT64 laps[MAXPLAYERS];
+	UINT64 distance[MAXPLAYERS];
+	UINT64 lapdistance[MAXPLAYERS]; // laps, then distancetofinish
+	UINT64 battle[MAXPLAYERS]; // roundscore, then emeralds, then bumpers
+} positiontable;
+static boolean positiontablekept; // K_UpdateAllPlayerPositions built it for everyone
+
+static int K_ComparePositionKeys(const void *a, const void *b)
+{
+	const UINT64 x = *(const UINT64 *)a, y = *(const UINT64 *)b;
+	return (x > y) - (x < y);
+}
+
+// Number of keys less than key.
+static UINT8 K_PositionKeysBelow(const UINT64 *keys, UINT8 count, UINT64 key)
+{
+	UINT8 lo = 0, hi = count;
+
+	while (lo < hi)
+	{
+		UINT8 mid = lo + (hi - lo) / 2;
+		if (keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+// Number of keys greater than key.
+static UINT8 K_PositionKeysAbove(const UINT64 *keys, UINT8 count, UINT64 key)
+{
+	return count - K_PositionKeysBelow(keys, count, key + 1);
+}
+
+static void K_BuildPositionTable(void)
+{
+	UINT8 n = 0;
+	INT32 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		player_t *other = &players[i];
+
+		if (!playeringame[i] || other->spectator || !other->mo)
+			continue;
+
+		positiontable.realtime[n] = other->realtime;
+		positiontable.laps[n] = other->laps;
+		positiontable.distance[n] = other->distancetofinish;
+		positiontable.lapdistance[n] = ((UINT64)other->laps << 32) | other->distancetofinish;
+
+		if (!(gametyperules & GTR_CIRCUIT))
+		{
+			positiontable.battle[n] = ((UINT64)other->roundscore << 16)
+				| ((UINT64)K_NumEmeralds(other) << 8)
+				| K_Bumpers(other);
+		}
+
+		n++;
+	}
+
+	positiontable.count = n;
+
+	qsort(positiontable.realtime, n, sizeof (UINT64), K_ComparePositionKeys);
+	qsort(positiontable.laps, n, sizeof (UINT64), K_ComparePositionKeys);
+	qsort(positiontable.distance, n, sizeof (UINT64), K_ComparePositionKeys);
+	qsort(positiontable.lapdistance, n, sizeof (UINT64), K_ComparePositionKeys);
+
+	if (!(gametyperules & GTR_CIRCUIT))
+		qsort(positiontable.battle, n, sizeof (UINT64), K_ComparePositionKeys);
+}
+
+// How many players are ahead of this one, going by the same rules the
+// standings always have.
+static UINT8 K_PlayersAhead(player_t *player)
+{
+	const UINT8 n = positiontable.count;
+
+	if (gametyperules & GTR_CIRCUIT)
+	{
+		if (player->exiting) // End of match standings
+		{
+			// Only time matters
+			return K_PositionKeysBelow(positiontable.realtime, n, player->realtime);
+		}
+		else
+		{
+			// I'm a lap behind this player OR
+			// My distance to the finish line is higher, so I'm behind
+			const UINT64 lapsahead = (UINT64)player->laps + 1;
+			UINT8 both = 0;
+			UINT8 j = K_PositionKeysBelow(positiontable.lapdistance, n, lapsahead << 32);
+
+			// Don't count anyone twice for being both
+			while (j < n)
+			{
+				const UINT64 laps = positiontable.lapdistance[j] >> 32;
+				both += K_PositionKeysBelow(positiontable.lapdistance, n, (laps << 32) | player->distancetofinish) - j;
+				j = K_PositionKeysBelow(positiontable.lapdistance, n, (laps + 1) << 32);
+			}
+
+			return K_PositionKeysAbove(positiontable.laps, n, player->laps)
+				+ K_PositionKeysBelow(positiontable.distance, n, player->distancetofinish)
+				- both;
+		}
+	}
+	else
+	{
+		if (player->exiting) // End of match standings
+		{
+			// Only score matters
+			return K_PositionKeysAbove(positiontable.battle, n, (UINT64)player->roundscore << 16 | 0xFFFF);
+		}
+		else
+		{
+			// First compare all points, then emeralds, then bumpers
+			return K_PositionKeysAbove(positiontable.battle, n,
+				((UINT64)player->roundscore << 16) | ((UINT64)K_NumEmeralds(player) << 8) | K_Bumpers(player));
+		}
+	}
+}
+
 //
 // K_KartUpdatePosition
 //
@@ -11255,7 +11386,6 @@ void K_KartUpdatePosition(player_t *player)
 {
 	fixed_t position = 1;
 	fixed_t oldposition = player->position;
-	fixed_t i;
 	INT32 realplayers = 0;
 
 	if (player->spectator || !player->mo)
@@ -11266,83 +11396,18 @@ void K_KartUpdatePosition(player_t *player)
 		return;
 	}
 
+	if (!positiontablekept)
+		K_BuildPositionTable();
+
+	realplayers = positiontable.count;
+
 	if (K_PodiumSequence() == true)
 	{
 		position = K_GetPodiumPosition(player);
-
-		for (i = 0; i < MAXPLAYERS; i++)
-		{
-			if (!playeringame[i] || players[i].spectator || !players[i].mo)
-				continue;
-
-			realplayers++;
-		}
 	}
 	else
 	{
-		for (i = 0; i < MAXPLAYERS; i++)
-		{
-			if (!playeringame[i] || players[i].spectator || !players[i].mo)
-				continue;
-
-			realplayers++;
-
-			if (gametyperules & GTR_CIRCUIT)
-			{
-				if (player->exiting) // End of match standings
-				{
-					// Only time matters
-					if (players[i].realtime < player->realtime)
-						position++;
-				}
-				else
-				{
-					// I'm a lap behind this player OR
-					// My distance to the finish line is higher, so I'm behind
-					if ((players[i].laps > player->laps)
-						|| (players[i].distancetofinish < player->distancetofinish))
-					{
-						position++;
-					}
-				}
-			}
-			else
-			{
-				if (player->exiting) // End of match standings
-				{
-					// Only score matters
-					if (players[i].roundscore > player->roundscore)
-						position++;
-				}
-				else
-				{
-					UINT8 myEmeralds = K_NumEmeralds(player);
-					UINT8 yourEmeralds = K_NumEmeralds(&players[i]);
-
-					// First compare all points
-					if (players[i].roundscore > player->roundscore)
-					{
-						position++;
-					}
-					else if (players[i].roundscore == player->roundscore)
-					{
-						// Emeralds are a tie breaker
-						if (yourEmeralds > myEmeralds)
-						{
-							position++;
-						}
-						else if (yourEmeralds == myEmeralds)
-						{
-							// Bumpers are the second tier tie breaker
-							if (K_Bumpers(&players[i]) > K_Bumpers(player))
-							{
-								position++;
-							}
-						}
-					}
-				}
-			}
-		}
+		position += K_PlayersAhead(player);
 	}
 
 	if (leveltime < starttime || oldposition == 0)
@@ -11427,6 +11492,9 @@ void K_UpdateAllPlayerPositions(void)
 	}
 
 	// Second loop: Ensure all player positions reflect everyone's distances
+	K_BuildPositionTable();
+	positiontablekept = true;
+
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (playeringame[i] && players[i].mo && !P_MobjWasRemoved(players[i].mo))
@@ -11434,6 +11502,8 @@ void K_UpdateAllPlayerPositions(void)
 			K_KartUpdatePosition(&players[i]);
 		}
 	}
+
+	positiontablekept = false;
 }
 
 //
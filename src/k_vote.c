@@ -1027,6 +1027,9 @@ static void Y_FinalizeVote(const SINT8 level)
 {
 	nextmap = g_voteLevels[level][0];
 	deferencoremode = ((g_voteLevels[level][1] & VOTE_MOD_ENCORE) ==  VOTE_MOD_ENCORE);
+
+	// Read it while the result is shown
+	P_PrefetchLevel(nextmap, deferencoremode);
 }
 
 static void Y_VoteStops(SINT8 pick, SINT8 level)
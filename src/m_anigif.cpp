@@ -0,0 +1,836 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+// Copyright (C) 2020 by Sonic Team Junior.
+// Copyright (C) 2016 by Kay "Kaito" Sinclaire.
+// Copyright (C) 2013 by "Ninji".
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_anigif.cpp
+/// \brief Animated GIF creation movie mode.
+///        Uses an implementation of Lempel–Ziv–Welch (LZW) compression,
+///        which by-the-way: the patents have expired for over ten years ago.
+///
+///        Frames are captured as RGB into pooled slots on the main thread;
+///        palette conversion, region optimization and LZW packing run on the
+///        thread pool, and finished frames are written to the file in order.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "core/encode_pipeline.hpp"
+
+#include "m_anigif.h"
+#include "d_main.h"
+#include "z_zone.h"
+#include "v_video.h"
+#include "i_video.h"
+#include "i_system.h" // I_GetPreciseTime
+#include "m_misc.h"
+#include "st_stuff.h" // st_palette
+
+#ifdef HWRENDER
+#include "hardware/hw_main.h"
+#endif
+
+// GIFs are always little-endian
+#include "byteptr.h"
+
+#ifdef HAVE_ANIGIF
+using srb2::EncodePipeline;
+
+static boolean gif_optimize = false; // So nobody can do something dumb
+static boolean gif_downscale = false; // like changing cvars mid output
+static UINT8 gif_dynamicdelay = (UINT8)0; // and messing something up
+
+// Palette handling
+static boolean gif_localcolortable = false;
+static boolean gif_colorprofile = false;
+static RGBA_t gif_headerpalette[256];
+
+static FILE *gif_out = NULL;
+static INT32 gif_frames = 0;
+static INT32 gif_dropped = 0;
+static precise_t gif_prevframetime = 0;
+static UINT32 gif_delayus = 0; // "us" is microseconds
+static UINT32 gif_captures = 0; // frames offered, including dropped ones
+static UINT32 gif_delayend = 0; // gif_captures at the end of the last frame's delay
+
+static INT32 gif_width, gif_height; // capture size
+static INT16 gif_downscaleamt = 1;
+
+// Frames in flight, counting the previous frame held for
+// optimization. Any more and frames are dropped instead.
+#define GIF_PIPELINEFRAMES 6
+
+static std::unique_ptr<EncodePipeline> gif_pipeline;
+static EncodePipeline::Frame gif_prevframe;
+
+
+
+// COLOR LOOKUP
+// ---
+// Shared by every frame that uses the same palette. The table
+// is built by whichever encode job needs it first.
+struct GIF_lut
+{
+	RGBA_t palette[256];
+	std::once_flag once;
+	colorlookup_t lut;
+};
+
+static std::shared_ptr<GIF_lut> gif_lut;
+
+static std::shared_ptr<GIF_lut> GIF_getlut(const RGBA_t *pal)
+{
+	if (!gif_lut || memcmp(gif_lut->palette, pal, sizeof(RGBA_t) * 256))
+	{
+		gif_lut = std::make_shared<GIF_lut>();
+		memcpy(gif_lut->palette, pal, sizeof(RGBA_t) * 256);
+		gif_lut->lut.init = false;
+	}
+
+	return gif_lut;
+}
+
+
+
+// OPTIMIZE gif output
+// ---
+#define GIF_BPP 3 // frames are RGB
+
+//
+// GIF_optimizecmprow
+// checks a row for modification, and if any is detected, what parts
+// modified input 'last': returns current row if modification detected
+// modified input 'left': returns leftmost known changed pixel
+// modified input 'right': returns rightmost known changed pixel
+//
+static UINT8 GIF_optimizecmprow(const UINT8 *dst, const UINT8 *src, INT32 width, INT32 row,
+	INT32 *last, INT32 *left, INT32 *right)
+{
+	const UINT8 *dp = dst + (width * GIF_BPP * row);
+	const UINT8 *sp = src + (width * GIF_BPP * row);
+	UINT8 doleft = 1, doright = 1;
+	INT32 i = 0;
+
+	if (!memcmp(sp, dp, width * GIF_BPP))
+		return 0; // unchanged.
+
+	*last = row;
+
+	// left side
+	i = 0;
+	if (*left == 0) // edge reached
+		doleft = 0;
+	else if (*left > 0) // left set, nonzero
+	{
+		if (!memcmp(sp, dp, *left * GIF_BPP))
+			doleft = 0; // left side not changed
+	}
+	while (doleft)
+	{
+		if (memcmp(dp + i * GIF_BPP, sp + i * GIF_BPP, GIF_BPP))
+		{
+			doleft = 0;
+			*left = i;
+		}
+		++i;
+	}
+
+	// right side
+	i = width - 1;
+	if (*right == width - 1) // edge reached
+		doright = 0;
+	else if (*right >= 0) // right set, non-end-of-width
+	{
+		if (!memcmp(sp + (*right + 1) * GIF_BPP, dp + (*right + 1) * GIF_BPP, (width - (*right + 1)) * GIF_BPP))
+			doright = 0; // right side not changed
+	}
+	while (doright)
+	{
+		if (memcmp(dp + i * GIF_BPP, sp + i * GIF_BPP, GIF_BPP))
+		{
+			doright = 0;
+			*right = i;
+		}
+		--i;
+	}
+	return 1;
+}
+
+//
+// GIF_optimizeregion
+// attempts to optimize a GIF as it's being written by giving a region
+// containing all of the changed pixels instead of rewriting
+// the entire screen buffer to the GIF file every frame
+// modified input 'x': returns optimal starting x coordinate
+// modified input 'y': returns optimal starting y coordinate
+// modified input 'w': returns optimal width
+// modified input 'h': returns optimal height
+//
+static void GIF_optimizeregion(const UINT8 *dst, const UINT8 *src, INT32 width, INT32 height,
+	INT32 *x, INT32 *y, INT32 *w, INT32 *h)
+{
+	INT32 st = 0, sb = height - 1; // work from both directions
+	INT32 firstchg_t = -1, firstchg_b = -1; // store first changed row.
+	INT32 lastchg_t = -1, lastchg_b = -1; // Store last row... just in case
+	INT32 lmpix = -1, rmpix = -1; // store left and rightmost change
+	UINT8 stopt = 0, stopb = 0;
+
+	while ((!stopt || !stopb) && st < sb)
+	{
+		if (!stopt)
+		{
+			if (GIF_optimizecmprow(dst, src, width, st++, &lastchg_t, &lmpix, &rmpix)
+			 && lmpix == 0 && rmpix == width - 1)
+				stopt = 1;
+			if (firstchg_t < 0 && lastchg_t >= 0)
+				firstchg_t = lastchg_t;
+		}
+		if (!stopb)
+		{
+			if (GIF_optimizecmprow(dst, src, width, sb--, &lastchg_b, &lmpix, &rmpix)
+			 && lmpix == 0 && rmpix == width - 1)
+				stopb = 1;
+			if (firstchg_b < 0 && lastchg_b >= 0)
+				firstchg_b = lastchg_b;
+		}
+	}
+
+	if (lmpix < 0) // NO CHANGE.
+	{
+		// hack: we don't attempt to go back and rewrite the previous
+		// frame's delay, we just make this frame have only a single
+		// pixel so it contains minimal data
+		*x = *y = 0;
+		*w = *h = 1;
+		return;
+	}
+
+	*x = lmpix;
+	*y = (firstchg_t < 0 && lastchg_b >= 0) ? lastchg_b : firstchg_t;
+	*w = rmpix + 1;
+	*h = ((firstchg_b < 0 && lastchg_t >= 0) ? lastchg_t : firstchg_b) + 1;
+
+	*w -= *x;
+	*h -= *y;
+}
+
+
+
+// GIF LZW algorithm
+// ---
+#define GIFLZW_TABLECLR  0x100
+#define GIFLZW_DATAEND   0x101
+#define GIFLZW_DICTSTART 0x102
+#define GIFLZW_MAXCODE 4096
+
+// All of the packing state for one frame, so frames can be
+// packed on several threads at once.
+struct GIF_lzwstate
+{
+	// GIF Bit WRiter
+	UINT8 bwr_buf[256];
+	UINT8 bwr_bufsize;
+	UINT32 bwr_bits_buf;
+	INT32 bwr_bits_num;
+	UINT8 bwr_bits_min;
+
+	UINT16 workingCode;
+	UINT16 nextCodeToAssign;
+	UINT32 hashTable[16384];
+};
+
+//
+// GIF_bwr_flush
+// flushes any bits remaining in the buffer.
+//
+static void GIF_bwrflush(GIF_lzwstate *s)
+{
+	if (s->bwr_bits_num > 0) // will be between 1 and 7
+		s->bwr_buf[s->bwr_bufsize++] = (UINT8)(s->bwr_bits_buf&0xFF);
+	s->bwr_bits_buf = s->bwr_bits_num = 0;
+}
+
+//
+// GIF_bwr_write
+// writes bits into bit buffer,
+// writes into buffer when whole bytes obtained
+//
+static void GIF_bwrwrite(GIF_lzwstate *s, UINT32 idata)
+{
+	s->bwr_bits_buf |= (idata << s->bwr_bits_num);
+	s->bwr_bits_num += s->bwr_bits_min;
+	while (s->bwr_bits_num >= 8)
+	{
+		s->bwr_buf[s->bwr_bufsize++] = (UINT8)(s->bwr_bits_buf&0xFF);
+		s->bwr_bits_buf >>= 8;
+		s->bwr_bits_num -= 8;
+	}
+}
+
+//
+// GIF_prepareLZW
+// prepares the LZW hash table for use
+//
+static void GIF_prepareLZW(GIF_lzwstate *s)
+{
+	s->bwr_bits_min = 9;
+	s->nextCodeToAssign = GIFLZW_DICTSTART;
+	memset(s->hashTable, 0, sizeof(s->hashTable));
+}
+
+//
+// GIF_searchHash
+// searches the LZW hash table for a match
+//
+static char GIF_searchHash(const GIF_lzwstate *s, UINT32 key, UINT32 *pOutput)
+{
+	UINT32 entry, position = (key >> 6) & 0x3FFF;
+
+	while (s->hashTable[position] != 0)
+	{
+		entry = s->hashTable[position];
+		if ((entry >> 12) == key)
+		{
+			*pOutput = (entry & 0xFFF);
+			return 1;
+		}
+
+		position = (position + 1) & 0x3FFF;
+	}
+
+	return 0;
+}
+
+//
+// GIF_addHash
+// stores a hash in the hash table
+//
+static void GIF_addHash(GIF_lzwstate *s, UINT32 key, UINT32 value)
+{
+	UINT32 position = (key >> 6) & 0x3FFF;
+
+	for (;;)
+	{
+		if (s->hashTable[position] == 0)
+		{
+			s->hashTable[position] = (key << 12) | (value & 0xFFF);
+			return;
+		}
+
+		position = (position + 1) & 0x3FFF;
+	}
+}
+
+//
+// GIF_feedByte
+// feeds bytes into the working code,
+// and to the hash table or output from there.
+//
+static void GIF_feedByte(GIF_lzwstate *s, UINT8 pbyte)
+{
+	UINT32 key, hashOutput = 0;
+
+	// Prepare a code with this byte if we have none
+	if (s->workingCode == UINT16_MAX)
+	{
+		s->workingCode = pbyte;
+		return;
+	}
+
+	// If we're here, this means we have a code in progress
+	// Is this string already in the dictionary?
+	key = (s->workingCode << 8) | pbyte;
+
+	if (0 == GIF_searchHash(s, key, &hashOutput))
+	{
+		// It wasn't found.
+		// That means we can output what we already had, and
+		// create a new dictionary entry containing that
+		// plus our new byte.
+		if (s->nextCodeToAssign > (1 << s->bwr_bits_min))
+			++s->bwr_bits_min; // out of room, extend minbits
+
+		GIF_bwrwrite(s, s->workingCode);
+		GIF_addHash(s, key, s->nextCodeToAssign);
+		++s->nextCodeToAssign;
+
+		// Seed the working code with this byte, for the next
+		// round
+		s->workingCode = pbyte;
+		return;
+	}
+
+	// This string is in there, so update our working code!
+	s->workingCode = hashOutput;
+}
+
+//
+// GIF_subblock
+// moves the bit writer's bytes into the output as a data sub-block
+//
+static void GIF_subblock(GIF_lzwstate *s, std::vector<UINT8> &out)
+{
+	out.push_back(s->bwr_bufsize);
+	out.insert(out.end(), s->bwr_buf, s->bwr_buf + s->bwr_bufsize);
+	s->bwr_bufsize = 0;
+}
+
+//
+// GIF_lzw
+// packs an image of palette indices into LZW data sub-blocks
+//
+static void GIF_lzw(GIF_lzwstate *s, const UINT8 *pixels, size_t count, std::vector<UINT8> &out)
+{
+	size_t i;
+
+	GIF_prepareLZW(s);
+	s->bwr_bufsize = 0;
+	s->bwr_bits_buf = 0;
+	s->bwr_bits_num = 0;
+	s->workingCode = UINT16_MAX;
+	out.push_back(s->bwr_bits_min - 1);
+
+	//prewrite a table clear
+	GIF_bwrwrite(s, GIFLZW_TABLECLR);
+
+	for (i = 0; i < count; i++)
+	{
+		GIF_feedByte(s, pixels[i]);
+		if (s->nextCodeToAssign >= GIFLZW_MAXCODE)
+		{
+			GIF_bwrwrite(s, GIFLZW_TABLECLR);
+			GIF_prepareLZW(s);
+		}
+		// Just a bit of overflow prevention
+		if (s->bwr_bufsize >= 248)
+			GIF_subblock(s, out);
+	}
+
+	// 4.15.14 - I failed to account for the possibility that
+	// these two writes could possibly cause minbits increases.
+	// Luckily, we have a guarantee that the first byte CANNOT exceed
+	// the maximum possible code.  So, we do a minbits check here...
+	if (s->nextCodeToAssign++ > (1 << s->bwr_bits_min))
+		++s->bwr_bits_min; // out of room, extend minbits
+	GIF_bwrwrite(s, s->workingCode);
+
+	// And luckily once more, if the data marker somehow IS at
+	// MAXCODE it doesn't matter, because it still marks the
+	// end of the stream and thus no extending will happen!
+	// But still, we need to check minbits again...
+	if (s->nextCodeToAssign++ > (1 << s->bwr_bits_min))
+		++s->bwr_bits_min; // out of room, extend minbits
+	GIF_bwrwrite(s, GIFLZW_DATAEND);
+
+	// Okay, the flush is safe at least.
+	GIF_bwrflush(s);
+	if (s->bwr_bufsize > 0)
+		GIF_subblock(s, out);
+
+	out.push_back(0); //terminator
+}
+
+
+
+// GIF HEADer (okay yeah)
+// ---
+const UINT8 gifhead_base[6] = {0x47,0x49,0x46,0x38,0x39,0x61}; // GIF89a
+const UINT8 gifhead_nsid[19] = {0x21,0xFF,0x0B, // extension block + size
+	0x4E,0x45,0x54,0x53,0x43,0x41,0x50,0x45,0x32,0x2E,0x30, // NETSCAPE2.0
+	0x03,0x01,0xFF,0xFF,0x00}; // sub-block, repetitions
+
+
+//
+// GIF_getpalette
+// determine the palette for the current frame.
+//
+static RGBA_t *GIF_getpalette(size_t palnum)
+{
+	// In hardware mode, always returns the local palette
+#ifdef HWRENDER
+	if (rendermode == render_opengl)
+		return pLocalPalette;
+	else
+#endif
+		return (gif_colorprofile ? &pLocalPalette[palnum*256] : &pMasterPalette[palnum*256]);
+}
+
+//
+// GIF_palwrite
+// writes the gif palette.
+// used both for the header and local color tables.
+//
+static UINT8 *GIF_palwrite(UINT8 *p, const RGBA_t *pal)
+{
+	INT32 i;
+	for (i = 0; i < 256; i++)
+	{
+		WRITEUINT8(p, pal[i].s.red);
+		WRITEUINT8(p, pal[i].s.green);
+		WRITEUINT8(p, pal[i].s.blue);
+	}
+	return p;
+}
+
+//
+// GIF_headwrite
+// writes the gif header to the currently open output file.
+//
+static void GIF_headwrite(void)
+{
+	UINT8 *gifhead = static_cast<UINT8 *>(Z_Malloc(800, PU_STATIC, NULL));
+	UINT8 *p = gifhead;
+	UINT16 rwidth, rheight;
+
+	if (!gif_out)
+		return;
+
+	WRITEMEM(p, gifhead_base, sizeof(gifhead_base));
+
+	// Image width/height
+	gif_width = vid.width;
+	gif_height = vid.height;
+	if (gif_downscale)
+		gif_downscaleamt = vid.dupx;
+	else
+		gif_downscaleamt = 1;
+	rwidth = (gif_width / gif_downscaleamt);
+	rheight = (gif_height / gif_downscaleamt);
+
+	WRITEUINT16(p, rwidth);
+	WRITEUINT16(p, rheight);
+
+	// colors, aspect, etc
+	WRITEUINT8(p, 0xF7); // (0xF7 = 1111 0111)
+	WRITEUINT8(p, 0x00);
+	WRITEUINT8(p, 0x00);
+
+	// write color table
+	p = GIF_palwrite(p, gif_headerpalette);
+
+	// write extension block
+	WRITEMEM(p, gifhead_nsid, sizeof(gifhead_nsid));
+
+	// write to file and be done with it!
+	fwrite(gifhead, 1, 800, gif_out);
+	Z_Free(gifhead);
+}
+
+
+
+// GIF FRAME (surprise!)
+// ---
+const UINT8 gifframe_gchead[4] = {0x21,0xF9,0x04,0x04}; // GCE, bytes, packed byte (no trans = 0 | no input = 0 | don't remove = 4)
+
+// Everything an encode job needs to know about its frame,
+// decided on the main thread when the frame was captured.
+struct GIF_frameinfo
+{
+	INT32 width, height;
+	INT16 downscale;
+	UINT16 delay;
+	boolean palchanged;
+	RGBA_t palette[256]; // only written when palchanged
+	std::shared_ptr<GIF_lut> lut;
+	EncodePipeline::Frame previous; // null if this frame is written whole
+};
+
+//
+// GIF_frameencode
+// packs an RGB frame into a complete GIF image block.
+// runs on the thread pool.
+//
+static void GIF_frameencode(const GIF_frameinfo &info, const EncodePipeline::Buffer &rgb, EncodePipeline::Buffer &out)
+{
+	thread_local std::unique_ptr<GIF_lzwstate> lzw;
+	thread_local std::vector<UINT8> indices;
+	INT32 blitx, blity, blitw, blith;
+	INT32 x, y;
+	const INT16 ds = info.downscale;
+	UINT8 *p;
+	UINT8 head[4 + 4 + 10 + 1 + 256*3];
+
+	if (!lzw)
+		lzw = std::make_unique<GIF_lzwstate>();
+
+	std::call_once(info.lut->once, [&info] { InitColorLUT(&info.lut->lut, info.lut->palette, true); });
+
+	// Compare image data (for optimizing GIF)
+	// If the palette has changed, the entire frame is considered to be different.
+	if (info.previous)
+	{
+		GIF_optimizeregion(rgb.data(), info.previous->data(), info.width, info.height,
+			&blitx, &blity, &blitw, &blith);
+	}
+	else
+	{
+		blitx = blity = 0;
+		blitw = info.width;
+		blith = info.height;
+	}
+
+	if (ds > 1)
+	{
+		// Ensure our downscaled blitx/y starts and ends on a pixel.
+		blitx -= (blitx % ds);
+		blity -= (blity % ds);
+		blitw = ((blitw + (ds - 1)) / ds) * ds;
+		blith = ((blith + (ds - 1)) / ds) * ds;
+	}
+
+	blitx /= ds;
+	blity /= ds;
+	blitw = std::min(blitw / ds, info.width / ds - blitx);
+	blith = std::min(blith / ds, info.height / ds - blity);
+
+	if (blitw <= 0 || blith <= 0)
+	{
+		// Only the pixels lost to downscaling changed
+		blitx = blity = 0;
+		blitw = blith = 1;
+	}
+
+	// Convert the region to palette indices
+	indices.resize((size_t)blitw * blith);
+	for (y = 0; y < blith; y++)
+	{
+		const UINT8 *src = &rgb[(((size_t)(blity + y) * ds * info.width) + ((size_t)blitx * ds)) * GIF_BPP];
+		UINT8 *dst = &indices[(size_t)y * blitw];
+		for (x = 0; x < blitw; x++, src += GIF_BPP * ds)
+			dst[x] = GetColorLUTDirect(&info.lut->lut, src[0], src[1], src[2]);
+	}
+
+	p = head;
+
+	WRITEMEM(p, gifframe_gchead, 4);
+
+	WRITEUINT16(p, info.delay);
+	WRITEUINT8(p, 0);
+	WRITEUINT8(p, 0); // end of GCE
+
+	WRITEUINT8(p, 0x2C);
+	WRITEUINT16(p, (UINT16)blitx);
+	WRITEUINT16(p, (UINT16)blity);
+	WRITEUINT16(p, (UINT16)blitw);
+	WRITEUINT16(p, (UINT16)blith);
+
+	if (info.palchanged)
+	{
+		// The palettes are different, so write the Local Color Table!
+		WRITEUINT8(p, 0x87); // (0x87 = 1000 0111)
+		p = GIF_palwrite(p, info.palette);
+	}
+	else
+		WRITEUINT8(p, 0); // no local table of colors
+
+	out.assign(head, p);
+	GIF_lzw(lzw.get(), indices.data(), indices.size(), out);
+}
+
+//
+// GIF_framewrite
+// captures a frame and queues it for encoding.
+//
+static void GIF_framewrite(INT32 input_width, INT32 input_height, const UINT8 *input)
+{
+	GIF_frameinfo info;
+	EncodePipeline::Frame frame;
+	UINT32 capture = gif_captures++;
+
+	if (!gif_out)
+		return;
+
+	// Frames are the size the header was written for
+	if (input_width != gif_width || input_height != gif_height)
+		return;
+
+	frame = gif_pipeline->acquire();
+	if (!frame)
+	{
+		// Encoding has fallen behind; this frame's time is
+		// added to the next one's delay.
+		++gif_dropped;
+		return;
+	}
+
+	frame->assign(input, input + (size_t)input_width * input_height * GIF_BPP);
+
+	info.width = input_width;
+	info.height = input_height;
+	info.downscale = gif_downscaleamt;
+
+	// Lactozilla: Compare the header's palette with the current frame's palette and see if it changed.
+	if (gif_localcolortable)
+	{
+		RGBA_t *framepalette = GIF_getpalette(std::max(st_palette, 0));
+		info.palchanged = memcmp(gif_headerpalette, framepalette, sizeof(RGBA_t) * 256);
+		memcpy(info.palette, framepalette, sizeof(RGBA_t) * 256);
+		info.lut = GIF_getlut(framepalette);
+	}
+	else
+	{
+		info.palchanged = false;
+		info.lut = GIF_getlut(gif_headerpalette);
+	}
+
+	if (gif_optimize && gif_frames > 0 && !info.palchanged)
+		info.previous = gif_prevframe;
+
+	// The slot stays alive until the next frame is done with it
+	gif_prevframe = gif_optimize ? frame : nullptr;
+
+	{
+		UINT16 delay = 0;
+
+		if (gif_dynamicdelay ==(UINT8) 2)
+		{
+			// golden's attempt at creating a "dynamic delay"
+			UINT16 mingifdelay = 10; // minimum gif delay in milliseconds (keep at 10 because gifs can't get more precise).
+			gif_delayus += (I_GetPreciseTime() - gif_prevframetime) / (I_GetPrecisePrecision() / 1000000); // increase delay by how much time was spent between last measurement
+
+			if (gif_delayus/1000 >= mingifdelay) // delay is big enough to be able to effect gif frame delay?
+			{
+				int frames = (gif_delayus/1000) / mingifdelay; // get amount of frames to delay.
+				delay = frames; // set the delay to delay that amount of frames.
+				gif_delayus -= frames*(mingifdelay*1000); // remove frames by the amount of milliseconds they take. don't reset to 0, the microseconds help consistency.
+			}
+		}
+		else if (gif_dynamicdelay ==(UINT8) 1)
+		{
+			float delayf = ceil(100.0f/NEWTICRATE);
+
+			delay = (UINT16)((I_GetPreciseTime() - gif_prevframetime)) / (I_GetPrecisePrecision() / 1000000) /10/1000;
+
+			if (delay < (UINT16)(delayf))
+				delay = (UINT16)(delayf);
+		}
+		else
+		{
+			// the original code, spanning any dropped frames
+			int d1 = (int)((100.0f/NEWTICRATE)*(capture+1));
+			int d2 = (int)((100.0f/NEWTICRATE)*(gif_delayend));
+			delay = d1-d2;
+		}
+
+		info.delay = delay;
+		gif_delayend = capture + 1;
+	}
+
+	gif_pipeline->submit(
+		std::move(frame),
+		[info = std::move(info)](const EncodePipeline::Buffer &rgb, EncodePipeline::Buffer &out)
+		{
+			GIF_frameencode(info, rgb, out);
+		},
+		[file = gif_out](const EncodePipeline::Buffer &out)
+		{
+			fwrite(out.data(), 1, out.size(), file);
+		}
+	);
+
+	++gif_frames;
+	gif_prevframetime = I_GetPreciseTime();
+}
+
+
+
+// ========================
+// !!! PUBLIC FUNCTIONS !!!
+// ========================
+
+//
+// GIF_open
+// opens a new file for writing.
+//
+INT32 GIF_open(const char *filename)
+{
+	gif_out = fopen(filename, "wb");
+	if (!gif_out)
+		return 0;
+
+	gif_optimize = (!!cv_gif_optimize.value);
+	gif_downscale = (!!cv_gif_downscale.value);
+	gif_dynamicdelay = (UINT8)cv_gif_dynamicdelay.value;
+	gif_localcolortable = (!!cv_gif_localcolortable.value);
+	gif_colorprofile = (!!cv_screenshot_colorprofile.value);
+	memcpy(gif_headerpalette, GIF_getpalette(0), sizeof(gif_headerpalette));
+
+	GIF_headwrite();
+	gif_frames = 0;
+	gif_dropped = 0;
+	gif_captures = 0;
+	gif_delayend = 0;
+	gif_prevframetime = I_GetPreciseTime();
+	gif_delayus = 0;
+	gif_pipeline = std::make_unique<EncodePipeline>(GIF_PIPELINEFRAMES);
+	return 1;
+}
+
+//
+// GIF_frame
+// writes a frame into the output gif
+//
+void GIF_frame(void)
+{
+#ifdef HWRENDER
+	// Copy the current OpenGL frame
+	if (rendermode == render_opengl)
+	{
+		UINT8 *linear = HWR_GetScreenshot();
+		if (linear)
+		{
+			GIF_framewrite(vid.width, vid.height, linear);
+			free(linear);
+		}
+	}
+#endif
+}
+
+//
+// GIF_frame_rgb24
+// writes a frame into the output gif, with existing image data
+//
+void GIF_frame_rgb24(INT32 width, INT32 height, const UINT8 *buffer)
+{
+	GIF_framewrite(width, height, buffer);
+}
+
+//
+// GIF_close
+// closes output GIF
+//
+INT32 GIF_close(void)
+{
+	if (!gif_out)
+		return 0;
+
+	// Every queued frame has to be in the file before the
+	// trailer.
+	gif_prevframe = nullptr;
+	gif_pipeline->drain();
+	gif_pipeline = nullptr;
+	gif_lut = nullptr;
+
+	// final terminator.
+	fwrite(";", 1, 1, gif_out);
+	fclose(gif_out);
+	gif_out = NULL;
+
+	if (gif_dropped)
+		CONS_Printf(M_GetText("Animated gif closed; wrote %d frames (%d dropped)\n"), gif_frames, gif_dropped);
+	else
+		CONS_Printf(M_GetText("Animated gif closed; wrote %d frames\n"), gif_frames);
+	return 1;
+}
+#endif //ifdef HAVE_ANIGIF
@@ -23,6 +23,7 @@
 #include "media/options.hpp"
 
 #include "command.h"
+#include "doomstat.h" // g_movieexport
 #include "i_sound.h"
 #include "m_avrecorder.h"
 #include "m_fixed.h"
@@ -90,6 +91,8 @@ static AVRecorder::Config configure()
 		cfg.max_size = FixedToFloat(cv_movie_size.value) * 1024 * 1024;
 	}
 
+	cfg.offline = g_movieexport;
+
 	if (sound_started && cv_movie_sound.value)
 	{
 		cfg.audio = AVRecorder::Config::Audio { 44100 };
@@ -200,6 +203,13 @@ boolean M_AVRecorder_IsExpired(void)
 	return g_av_recorder->invalid();
 }
 
+void M_AVRecorder_AdvanceOfflineClock(void)
+{
+	SRB2_ASSERT(g_av_recorder != nullptr);
+
+	g_av_recorder->advance_offline_clock();
+}
+
 void M_AVRecorder_DrawFrameRate(void)
 {
 	if (!cv_movie_showfps.value || !g_av_recorder)
@@ -35,6 +35,9 @@ void M_AVRecorder_PrintCurrentConfiguration(void);
 
 void M_AVRecorder_DrawFrameRate(void);
 
+// Offline recorders only (-exportmovie). Moves the recording forward one tic.
+void M_AVRecorder_AdvanceOfflineClock(void);
+
 extern consvar_t
 	cv_movie_custom_resolution,
 	cv_movie_duration,
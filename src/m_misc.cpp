@@ -27,6 +27,10 @@
 #endif
 
 #include <algorithm>
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
 #include <errno.h>
 
 // Extended map support.
@@ -34,6 +38,7 @@
 
 #include "doomdef.h"
 #include "g_game.h"
+#include "g_demo.h"
 #include "m_misc.h"
 #include "hu_stuff.h"
 #include "st_stuff.h"
@@ -45,9 +50,11 @@
 #include "d_main.h"
 #include "m_argv.h"
 #include "i_system.h"
+#include "i_sound.h"
 #include "command.h" // cv_execversion
 
 #include "m_anigif.h"
+#include "core/encode_pipeline.hpp"
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 #include "m_avrecorder.h"
 #include "m_avrecorder.hpp"
@@ -889,95 +896,97 @@ static void M_PNGhdr(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_
 	}
 }
 
-static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_byte movie)
-{
-#ifdef PNG_TEXT_SUPPORTED
 #define SRB2PNGTXT 11 //PNG_KEYWORD_MAX_LENGTH(79) is the max
-	png_text png_infotext[SRB2PNGTXT];
-	char keytxt[SRB2PNGTXT][12] = {
-	"Title", "Description", "Playername", "Mapnum", "Mapname",
-	"Location", "Interface", "Render Mode", "Revision", "Build Date", "Build Time"};
-	char titletxt[] = "Dr. Robotnik's Ring Racers " VERSIONSTRING;
-	png_charp playertxt =  cv_playername[0].zstring;
-	char desctxt[] = "Ring Racers Screenshot";
-	char Movietxt[] = "Ring Racers Movie";
-	size_t i;
-	char interfacetxt[] =
-#ifdef HAVE_SDL
-	 "SDL";
-#else
-	 "Unknown";
-#endif
-	char rendermodetxt[9];
-	char maptext[8];
-	char lvlttltext[48];
-	char locationtxt[40];
-	char ctrevision[40];
-	char ctdate[40];
-	char cttime[40];
 
-	switch (rendermode)
-	{
-		case render_soft:
-			strcpy(rendermodetxt, "Software");
-			break;
-		case render_opengl:
-			strcpy(rendermodetxt, "OpenGL");
-			break;
-		default: // Just in case
-			strcpy(rendermodetxt, "None");
-			break;
-	}
+// Text chunks describe the game at the moment of capture, so they are gathered on the main thread even when the
+// image itself is compressed elsewhere.
+typedef std::array<std::string, SRB2PNGTXT> pngtext_t;
 
-#if 0
-	if (gamestate == GS_LEVEL)
-		snprintf(maptext, 8, "%s", G_BuildMapName(gamemap));
-	else
-#endif
-		snprintf(maptext, 8, "Unknown");
+static pngtext_t M_PNGTextStrings(boolean movie)
+{
+	pngtext_t text;
+	char buf[48];
+
+	text[0] = "Dr. Robotnik's Ring Racers " VERSIONSTRING;
+	text[1] = movie ? "Ring Racers Movie" : "Ring Racers Screenshot";
+	text[2] = cv_playername[0].zstring;
+	text[3] = "Unknown";
 
 	if (gamestate == GS_LEVEL && mapheaderinfo[gamemap-1]->lvlttl[0] != '\0')
-		snprintf(lvlttltext, 48, "%s%s%s",
+	{
+		snprintf(buf, 48, "%s%s%s",
 			mapheaderinfo[gamemap-1]->lvlttl,
 			(mapheaderinfo[gamemap-1]->levelflags & LF_NOZONE) ? "" :
 			(mapheaderinfo[gamemap-1]->zonttl[0] != '\0') ? va(" %s",mapheaderinfo[gamemap-1]->zonttl) : " Zone",
 			(mapheaderinfo[gamemap-1]->actnum > 0) ? va(" %d",mapheaderinfo[gamemap-1]->actnum) : "");
+		text[4] = buf;
+	}
 	else
-		snprintf(lvlttltext, 48, "Unknown");
+		text[4] = "Unknown";
 
 	if (gamestate == GS_LEVEL && players[g_localplayers[0]].mo)
-		snprintf(locationtxt, 40, "X:%d Y:%d Z:%d A:%d",
+	{
+		snprintf(buf, 40, "X:%d Y:%d Z:%d A:%d",
 			players[g_localplayers[0]].mo->x>>FRACBITS,
 			players[g_localplayers[0]].mo->y>>FRACBITS,
 			players[g_localplayers[0]].mo->z>>FRACBITS,
 			FixedInt(AngleFixed(players[g_localplayers[0]].mo->angle)));
+		text[5] = buf;
+	}
 	else
-		snprintf(locationtxt, 40, "Unknown");
+		text[5] = "Unknown";
+
+#ifdef HAVE_SDL
+	text[6] = "SDL";
+#else
+	text[6] = "Unknown";
+#endif
+
+	switch (rendermode)
+	{
+		case render_soft:
+			text[7] = "Software";
+			break;
+		case render_opengl:
+			text[7] = "OpenGL";
+			break;
+		default: // Just in case
+			text[7] = "None";
+			break;
+	}
+
+	text[8] = std::string(comprevision).substr(0, 39);
+	text[9] = std::string(compdate).substr(0, 39);
+	text[10] = std::string(comptime).substr(0, 39);
+
+	return text;
+}
+
+static void M_PNGText(png_structp png_ptr, png_infop png_info_ptr, const pngtext_t &text)
+{
+#ifdef PNG_TEXT_SUPPORTED
+	static const char keytxt[SRB2PNGTXT][12] = {
+	"Title", "Description", "Playername", "Mapnum", "Mapname",
+	"Location", "Interface", "Render Mode", "Revision", "Build Date", "Build Time"};
+	png_text png_infotext[SRB2PNGTXT];
+	size_t i;
 
 	memset(png_infotext,0x00,sizeof (png_infotext));
 
 	for (i = 0; i < SRB2PNGTXT; i++)
-		png_infotext[i].key  = keytxt[i];
-
-	png_infotext[0].text = titletxt;
-	if (movie)
-		png_infotext[1].text = Movietxt;
-	else
-		png_infotext[1].text = desctxt;
-	png_infotext[2].text = playertxt;
-	png_infotext[3].text = maptext;
-	png_infotext[4].text = lvlttltext;
-	png_infotext[5].text = locationtxt;
-	png_infotext[6].text = interfacetxt;
-	png_infotext[7].text = rendermodetxt;
-	png_infotext[8].text = strncpy(ctrevision, comprevision, sizeof(ctrevision)-1);
-	png_infotext[9].text = strncpy(ctdate, compdate, sizeof(ctdate)-1);
-	png_infotext[10].text = strncpy(cttime, comptime, sizeof(cttime)-1);
+	{
+		png_infotext[i].key  = const_cast<png_charp>(keytxt[i]);
+		png_infotext[i].text = const_cast<png_charp>(text[i].c_str());
+	}
 
 	png_set_text(png_ptr, png_info_ptr, png_infotext, SRB2PNGTXT);
-#undef SRB2PNGTXT
+#else
+	(void)png_ptr;
+	(void)png_info_ptr;
+	(void)text;
 #endif
 }
+#undef SRB2PNGTXT
 
 static inline void M_PNGImage(png_structp png_ptr, png_infop png_info_ptr, PNG_CONST png_uint_32 height, png_bytep png_buf)
 {
@@ -1216,7 +1225,7 @@ static boolean M_SetupaPNG(png_const_charp filename, png_bytep pal)
 
 	M_PNGhdr(apng_ptr, apng_info_ptr, vid.width / downscale, vid.height / downscale, pal);
 
-	M_PNGText(apng_ptr, apng_info_ptr, true);
+	M_PNGText(apng_ptr, apng_info_ptr, M_PNGTextStrings(true));
 
 	apng_set_set_acTL_fn(apng_ptr, apng_ainfo_ptr, aPNG_set_acTL);
 
@@ -1541,6 +1550,44 @@ void M_SaveFrame(uint32_t width, uint32_t height, tcb::span<const std::byte> dat
 	}
 }
 
+// Called once per tic while exporting a demo (-exportmovie).
+void M_ExportMovieTic(void)
+{
+#ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
+	static boolean started = false;
+
+	if (!started)
+	{
+		// Wait for the demo to actually begin
+		if (!demo.playback)
+			return;
+
+		started = true;
+		M_StartMovie(MM_AVRECORDER);
+
+		if (moviemode != MM_AVRECORDER)
+			I_Error("Couldn't start exporting demo to video\n");
+	}
+
+	if (moviemode != MM_AVRECORDER)
+		return;
+
+	if (M_AVRecorder_IsExpired())
+	{
+		// Hit movie_duration or movie_size, so end the export early
+		G_CheckDemoStatus();
+		return;
+	}
+
+	// The frame for this tic was captured during drawing, so
+	// only its audio is left before moving the clock along.
+	I_RenderOfflineAudio(1);
+	M_AVRecorder_AdvanceOfflineClock();
+#else
+	I_Error("This build can't export demos to video\n");
+#endif
+}
+
 void M_StopMovie(void)
 {
 #if NUMSCREENS > 2
@@ -1590,6 +1637,96 @@ void M_StopMovie(void)
 //                            SCREEN SHOTS
 // ==========================================================================
 #ifdef USE_PNG
+/** Compression settings, captured on the main thread for encodes that run elsewhere.
+  */
+typedef struct
+{
+	INT32 level, memory, strategy, window_bits;
+} pngzlib_t;
+
+static pngzlib_t M_PNGZlibSettings(void)
+{
+	return {cv_zlib_level.value, cv_zlib_memory.value, cv_zlib_strategy.value, cv_zlib_window_bits.value};
+}
+
+static void PNG_writememory(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+	std::vector<UINT8> *out = static_cast<std::vector<UINT8> *>(png_get_io_ptr(png_ptr));
+	out->insert(out->end(), data, data + length);
+}
+
+static void PNG_flushmemory(png_structp png_ptr)
+{
+	(void)png_ptr;
+}
+
+// Unlike PNG_error, this may run off the main thread, so it only unwinds to the caller.
+FUNCNORETURN static void PNG_errorjmp(png_structp PNG, png_const_charp pngtext)
+{
+	(void)pngtext;
+	longjmp(png_jmpbuf(PNG), 1);
+}
+
+/** Compresses a BGR888 image into a PNG in memory. Touches no game state,
+  * so it is safe to call from any thread.
+  *
+  * \param out    Receives the PNG file, or is left empty on failure.
+  * \param data   The image data.
+  * \param width  Width of the picture.
+  * \param height Height of the picture.
+  * \param text   Text chunks, from M_PNGTextStrings.
+  * \param zlib   Compression settings, from M_PNGZlibSettings.
+  */
+static boolean M_EncodePNG(std::vector<UINT8> &out, const UINT8 *data, int width, int height, const pngtext_t &text, const pngzlib_t &zlib)
+{
+	png_structp png_ptr;
+	png_infop png_info_ptr;
+
+	out.clear();
+
+	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, PNG_errorjmp, NULL);
+	if (!png_ptr)
+		return false;
+
+	png_info_ptr = png_create_info_struct(png_ptr);
+	if (!png_info_ptr)
+	{
+		png_destroy_write_struct(&png_ptr, NULL);
+		return false;
+	}
+
+	if (setjmp(png_jmpbuf(png_ptr)))
+	{
+		png_destroy_write_struct(&png_ptr, &png_info_ptr);
+		out.clear();
+		return false;
+	}
+
+	png_set_write_fn(png_ptr, &out, PNG_writememory, PNG_flushmemory);
+
+#ifdef PNG_SET_USER_LIMITS_SUPPORTED
+	png_set_user_limits(png_ptr, MAXVIDWIDTH, MAXVIDHEIGHT);
+#endif
+
+	png_set_compression_level(png_ptr, zlib.level);
+	png_set_compression_mem_level(png_ptr, zlib.memory);
+	png_set_compression_strategy(png_ptr, zlib.strategy);
+	png_set_compression_window_bits(png_ptr, zlib.window_bits);
+
+	M_PNGhdr(png_ptr, png_info_ptr, width, height, NULL);
+
+	M_PNGText(png_ptr, png_info_ptr, text);
+
+	png_write_info(png_ptr, png_info_ptr);
+
+	M_PNGImage(png_ptr, png_info_ptr, height, const_cast<png_bytep>(data));
+
+	png_write_end(png_ptr, png_info_ptr);
+	png_destroy_write_struct(&png_ptr, &png_info_ptr);
+
+	return true;
+}
+
 /** Writes a PNG file to disk.
   *
   * \param filename Filename to write to.
@@ -1666,7 +1803,7 @@ boolean M_SavePNG(const char *filename, const void *data, int width, int height,
 
 	M_PNGhdr(png_ptr, png_info_ptr, width, height, palette);
 
-	M_PNGText(png_ptr, png_info_ptr, false);
+	M_PNGText(png_ptr, png_info_ptr, M_PNGTextStrings(false));
 
 	png_write_info(png_ptr, png_info_ptr);
 
@@ -1784,9 +1921,109 @@ void M_DoLegacyGLScreenShot(void)
 	M_DoScreenShot(vid.width, vid.height, tcb::span(fake_data, vid.width * vid.height));
 }
 
+#ifdef USE_PNG
+// Screenshots are compressed on the thread pool. A lone screenshot waits for
+// a free slot; screenshot movie frames are dropped while the encoder catches up.
+#define SCREENSHOT_PIPELINEFRAMES 4
+
+struct screenshotresult_t
+{
+	std::string freename;
+	std::string pathname;
+	boolean ok;
+};
+
+static std::mutex screenshot_results_mutex;
+static std::vector<screenshotresult_t> screenshot_results;
+
+static srb2::EncodePipeline &M_ScreenShotPipeline(void)
+{
+	static srb2::EncodePipeline pipeline(SCREENSHOT_PIPELINEFRAMES);
+	return pipeline;
+}
+#endif
+
+static void M_ScreenShotResult(const char *freename, const char *pathname, boolean ret)
+{
+	if (ret)
+	{
+		if (moviemode != MM_SCREENSHOT)
+			CONS_Printf(M_GetText("Screen shot %s saved in %s\n"), freename, pathname);
+	}
+	else
+	{
+		if (freename)
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't create screen shot %s in %s\n"), freename, pathname);
+		else
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't create screen shot in %s (all 10000 slots used!)\n"), pathname);
+
+		if (moviemode == MM_SCREENSHOT)
+			M_StopMovie();
+	}
+}
+
+#ifdef USE_PNG
+static void M_QueueScreenShot(srb2::EncodePipeline::Frame frame, const char *freename, const char *pathname, UINT32 width, UINT32 height, tcb::span<const std::byte> data)
+{
+	const UINT8 *pixels = reinterpret_cast<const UINT8 *>(data.data());
+	std::string filepath = va(pandf,pathname,freename);
+	FILE *file;
+
+	// Claim the name now, or the next screenshot would pick it again before this one is written
+	file = fopen(filepath.c_str(), "wb");
+	if (!file)
+	{
+		M_ScreenShotResult(freename, pathname, false);
+		return;
+	}
+
+	frame->assign(pixels, pixels + data.size_bytes());
+
+	M_ScreenShotPipeline().submit(
+		std::move(frame),
+		[text = M_PNGTextStrings(false), zlib = M_PNGZlibSettings(), width, height]
+		(const srb2::EncodePipeline::Buffer &in, srb2::EncodePipeline::Buffer &out)
+		{
+			M_EncodePNG(out, in.data(), width, height, text, zlib);
+		},
+		[file, filepath, result = screenshotresult_t {freename, pathname, false}]
+		(const srb2::EncodePipeline::Buffer &out) mutable
+		{
+			result.ok = !out.empty() && fwrite(out.data(), 1, out.size(), file) == out.size();
+			if (fclose(file) != 0)
+				result.ok = false;
+			if (!result.ok)
+				remove(filepath.c_str());
+
+			std::lock_guard<std::mutex> _(screenshot_results_mutex);
+			screenshot_results.push_back(std::move(result));
+		}
+	);
+}
+#endif
+
+/** Prints the outcome of screenshots finished on the thread pool.
+  */
+static void M_ReportScreenShots(void)
+{
+#ifdef USE_PNG
+	std::vector<screenshotresult_t> results;
+
+	{
+		std::lock_guard<std::mutex> _(screenshot_results_mutex);
+		results.swap(screenshot_results);
+	}
+
+	for (const screenshotresult_t &result : results)
+		M_ScreenShotResult(result.freename.c_str(), result.pathname.c_str(), result.ok);
+#endif
+}
+
 /** Takes a screenshot.
   * The screenshot is saved as "srb2xxxx.png" where xxxx is the lowest
   * four-digit number for which a file does not already exist.
+  * PNG screenshots are written in the background and reported from
+  * M_ScreenshotTicker.
   *
   * \sa HWR_ScreenShot
   */
@@ -1796,6 +2033,9 @@ void M_DoScreenShot(UINT32 width, UINT32 height, tcb::span<const std::byte> data
 	const char *freename = NULL;
 	char pathname[MAX_WADPATH];
 	boolean ret = false;
+#ifdef USE_PNG
+	srb2::EncodePipeline::Frame frame;
+#endif
 
 	// Don't take multiple screenshots, obviously
 	takescreenshot = false;
@@ -1804,6 +2044,15 @@ void M_DoScreenShot(UINT32 width, UINT32 height, tcb::span<const std::byte> data
 	if (rendermode == render_none)
 		return;
 
+#ifdef USE_PNG
+	if (rendermode != render_opengl)
+	{
+		frame = M_ScreenShotPipeline().acquire(moviemode != MM_SCREENSHOT);
+		if (!frame)
+			return;
+	}
+#endif
+
 	strcpy(pathname, srb2home);
 	strcat(pathname, PATHSEP "media" PATHSEP "screenshots" PATHSEP);
 	M_MkdirEach(pathname, M_PathParts(pathname) - 2, 0755);
@@ -1827,30 +2076,16 @@ void M_DoScreenShot(UINT32 width, UINT32 height, tcb::span<const std::byte> data
 	else
 #endif
 	{
-		const void* pixel_data = static_cast<const void*>(data.data());
 #ifdef USE_PNG
-		ret = M_SavePNG(va(pandf,pathname,freename), pixel_data, width, height, NULL);
+		M_QueueScreenShot(std::move(frame), freename, pathname, width, height, data);
+		return;
 #else
 		ret = WritePCXfile(va(pandf,pathname,freename), linear, vid.width, vid.height, screenshot_palette);
 #endif
 	}
 
 failure:
-	if (ret)
-	{
-		if (moviemode != MM_SCREENSHOT)
-			CONS_Printf(M_GetText("Screen shot %s saved in %s\n"), freename, pathname);
-	}
-	else
-	{
-		if (freename)
-			CONS_Alert(CONS_ERROR, M_GetText("Couldn't create screen shot %s in %s\n"), freename, pathname);
-		else
-			CONS_Alert(CONS_ERROR, M_GetText("Couldn't create screen shot in %s (all 10000 slots used!)\n"), pathname);
-
-		if (moviemode == MM_SCREENSHOT)
-			M_StopMovie();
-	}
+	M_ScreenShotResult(freename, pathname, ret);
 #endif
 }
 
@@ -1858,6 +2093,8 @@ void M_ScreenshotTicker(void)
 {
 	const UINT8 pid = 0; // TODO: should splitscreen players be allowed to use this too?
 
+	M_ReportScreenShots();
+
 	if (M_MenuButtonPressed(pid, MBT_SCREENSHOT))
 	{
 		M_ScreenShot();
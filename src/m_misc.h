@@ -52,6 +52,7 @@ extern consvar_t cv_apng_delay, cv_apng_downscale;
 void M_StartMovie(moviemode_t mode);
 void M_LegacySaveFrame(void);
 void M_StopMovie(void);
+void M_ExportMovieTic(void);
 
 // the file where game vars and settings are saved
 #define CONFIGFILENAME "ringconfig.cfg"
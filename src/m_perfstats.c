@@ -19,7 +19,9 @@
 #include "i_time.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "p_precip.h"
 #include "g_game.h"
+#include "acs/interface.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -57,6 +59,7 @@ precise_t ps_thlist_times[NUM_ACTIVETHINKERLISTS];
 precise_t ps_acs_time = 0;
 
 int ps_checkposition_calls = 0;
+precise_t ps_checkline_time = 0;
 
 precise_t ps_lua_thinkframe_time = 0;
 int ps_lua_mobjhooks = 0;
@@ -169,6 +172,9 @@ static void M_DrawRenderStats(void)
 
 	precise_t extrarendertime;
 
+	// Since the last time this was drawn; the text drawn here counts toward the next
+	int textlayout_hitrate = ps_textlayout_lookups ? (ps_textlayout_hits * 100 / ps_textlayout_lookups) : 0;
+
 	perfstatrow_t frametime_row[] = {
 		{"frmtime", "Frame time:    ", &ps_frametime},
 		{0}
@@ -219,6 +225,11 @@ static void M_DrawRenderStats(void)
 		{0}
 	};
 
+	perfstatrow_t textlayout_row[] = {
+		{"txthit%", "Text cache %:", &textlayout_hitrate},
+		{0}
+	};
+
 	perfstatrow_t batchtime_row[] = {
 		{"batsort", "Batch sort:  ", &ps_hw_batchsorttime},
 		{"batdraw", "Batch render:", &ps_hw_batchdrawtime},
@@ -250,6 +261,7 @@ static void M_DrawRenderStats(void)
 	perfstatcol_t        tictime_col =  {20,  20, V_GRAYMAP,          tictime_row};
 
 	perfstatcol_t    rendercalls_col =  {90, 115, V_BLUEMAP,      rendercalls_row};
+	perfstatcol_t     textlayout_col =  {20,  20, V_BLUEMAP,       textlayout_row};
 
 	perfstatcol_t      batchtime_col =  {90, 115, V_REDMAP,         batchtime_row};
 
@@ -306,6 +318,10 @@ static void M_DrawRenderStats(void)
 	draw_row += half_row;
 	M_DrawPerfTiming(&tictime_col);
 
+	draw_row += half_row;
+	M_DrawPerfCount(&textlayout_col);
+	ps_textlayout_hits = ps_textlayout_lookups = 0;
+
 	if (rendering)
 	{
 		draw_row = 10;
@@ -416,6 +432,11 @@ static void M_DrawTickStats(void)
 		{0}
 	};
 
+	perfstatrow_t misc_time_row[] = {
+		{"chkline", "Line collision: ", &ps_checkline_time},
+		{0}
+	};
+
 	perfstatcol_t               tictime_col  =  {20,  20, V_YELLOWMAP,               tictime_row};
 	perfstatcol_t          thinker_time_col  =  {24,  24, V_YELLOWMAP,          thinker_time_row};
 	perfstatcol_t detailed_thinker_time_col  =  {28,  28, V_YELLOWMAP, detailed_thinker_time_row};
@@ -427,6 +448,7 @@ static void M_DrawTickStats(void)
 	perfstatcol_t          nothinkcount_col  =  {98, 123, V_BLUEMAP,            nothinkcount_row};
 	perfstatcol_t detailed_thinkercount_col2 =  {94, 119, V_BLUEMAP,   detailed_thinkercount_row2};
 	perfstatcol_t            misc_calls_col  = {170, 216, V_PURPLEMAP,            misc_calls_row};
+	perfstatcol_t             misc_time_col  = {170, 216, V_PURPLEMAP,             misc_time_row};
 
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
@@ -455,11 +477,12 @@ static void M_DrawTickStats(void)
 			}
 			else if (i == THINK_DYNSLOPE)
 				dynslopethcount++;
-			else if (i == THINK_PRECIP)
-				precipcount++;
 		}
 	}
 
+	if (precip.cells)
+		precipcount = (int)precip.count;
+
 	draw_row = 10;
 	M_DrawPerfTiming(&tictime_col);
 	M_DrawPerfTiming(&thinker_time_col);
@@ -488,6 +511,40 @@ static void M_DrawTickStats(void)
 	}
 
 	M_DrawPerfCount(&misc_calls_col);
+	M_DrawPerfTiming(&misc_time_col);
+}
+
+#define ACS_PROFILE_ROWS 46
+
+static void M_DrawACSStats(void)
+{
+	acsprofileinfo_t rows[ACS_PROFILE_ROWS];
+	const size_t count = ACS_GetProfile(rows, ACS_PROFILE_ROWS);
+	const precise_t precision = I_GetPrecisePrecision() / 1000000;
+	char s[128];
+	size_t i;
+	int y = 4;
+
+	snprintf(s, sizeof s, "%-32s %8s %6s %8s", "ACS_Tick:", va("%ld", (long)(ps_acs_time / precision)), "runs", "codes");
+	V_DrawSmallString(2, y, V_MONOSPACE | V_YELLOWMAP, s);
+	y += 4;
+
+	for (i = 0; i < count; i++)
+	{
+		// Keep the end of the name, where the script is
+		const char *name = rows[i].name;
+		size_t len = strlen(name);
+		if (len > 32)
+			name += len - 32;
+
+		if (rows[i].callfunc)
+			snprintf(s, sizeof s, "%-32s %8ld %6u", name, (long)(rows[i].time / precision), rows[i].runs);
+		else
+			snprintf(s, sizeof s, "%-32s %8ld %6u %8u", name, (long)(rows[i].time / precision), rows[i].runs, rows[i].codes);
+
+		V_DrawSmallString(2, y, V_MONOSPACE | (rows[i].callfunc ? V_GRAYMAP : 0), s);
+		y += 4;
+	}
 }
 
 void M_DrawPerfStats(void)
@@ -615,6 +672,21 @@ void M_DrawPerfStats(void)
 			}
 		}
 	}
+	else if (cv_perfstats.value == PS_ACS) // acs scripts and functions
+	{
+		if (G_GamestateUsesLevel() == false)
+			return;
+
+		if (vid.width < 640 || vid.height < 400) // low resolution
+		{
+			// it's not gonna fit very well..
+			V_DrawThinString(30, 30, V_MONOSPACE | V_YELLOWMAP, "Not available for resolutions below 640x400");
+		}
+		else // high resolution
+		{
+			M_DrawACSStats();
+		}
+	}
 	else if (cv_perfstats.value == PS_THINKFRAME) // lua thinkframe
 	{
 		if (G_GamestateUsesLevel() == false)
@@ -28,6 +28,7 @@ typedef enum
 	PS_LOGIC,
 	PS_BOT,
 	PS_THINKFRAME,
+	PS_ACS,
 } ps_types_t;
 
 extern precise_t ps_tictime;
@@ -41,6 +42,7 @@ extern precise_t ps_thlist_times[];
 extern precise_t ps_acs_time;
 
 extern int       ps_checkposition_calls;
+extern precise_t ps_checkline_time;
 
 extern precise_t ps_lua_thinkframe_time;
 extern int       ps_lua_mobjhooks;
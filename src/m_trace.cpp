@@ -0,0 +1,455 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_trace.cpp
+/// \brief Always-on event trace, saved as Chrome trace JSON
+///
+/// Every scope goes into one ring of slots. Claiming a slot is a single
+/// fetch_add, and each slot carries a sequence number that readers check
+/// before and after copying it out, so any thread can write without a lock
+/// and a reader can never see half an event. Once the ring wraps, the
+/// oldest events are written over.
+///
+/// Saved traces open in chrome://tracing or ui.perfetto.dev.
+
+#include "m_trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "core/thread_pool.h"
+
+#include "d_main.h" // srb2home
+#include "doomdef.h"
+#include "doomstat.h"
+#include "i_system.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+constexpr std::size_t kRingSize = 1 << 16;
+constexpr std::size_t kMaxThreads = 64;
+constexpr std::size_t kThreadNameSize = 32;
+
+// Files tracelog rotates through
+constexpr int kLogFiles = 4;
+
+// tracelog writes whenever this much of the ring is waiting, or once a second
+constexpr uint64_t kLogBatch = kRingSize / 4;
+
+struct Slot
+{
+	// 2n+1 while event n is being written, 2n+2 once it has been
+	std::atomic<uint64_t> seq {0};
+	std::atomic<const char*> name {nullptr};
+	std::atomic<precise_t> start {0};
+	std::atomic<precise_t> duration {0};
+	std::atomic<uint32_t> thread {0};
+};
+
+struct Event
+{
+	const char* name;
+	precise_t start;
+	precise_t duration;
+	uint32_t thread;
+};
+
+struct ThreadName
+{
+	std::atomic<bool> set {false};
+	std::array<char, kThreadNameSize> name {};
+};
+
+Slot g_ring[kRingSize];
+std::atomic<uint64_t> g_next {0};
+std::atomic<bool> g_enabled {true};
+
+std::atomic<uint32_t> g_num_threads {0};
+ThreadName g_thread_names[kMaxThreads];
+thread_local uint32_t t_thread = UINT32_MAX;
+
+// A save in progress on the thread pool; the log file belongs to it until it's done
+std::atomic<bool> g_writing {false};
+std::atomic<bool> g_write_failed {false};
+
+struct TraceLog
+{
+	FILE* file = nullptr;
+	int index = 0;
+	std::size_t size = 0;
+};
+
+TraceLog g_log;
+uint64_t g_logged = 0; // events up to here have been handed to the log
+precise_t g_last_log = 0;
+
+uint32_t thread_index()
+{
+	if (t_thread == UINT32_MAX)
+	{
+		t_thread = std::min<uint32_t>(g_num_threads.fetch_add(1, std::memory_order_relaxed), kMaxThreads - 1);
+	}
+	return t_thread;
+}
+
+void record(const char* name, precise_t start, precise_t duration)
+{
+	if (!g_enabled.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	const uint64_t n = g_next.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = g_ring[n % kRingSize];
+
+	slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.duration.store(duration, std::memory_order_relaxed);
+	slot.thread.store(thread_index(), std::memory_order_relaxed);
+	slot.seq.store(2 * n + 2, std::memory_order_release);
+}
+
+/// Copies out events [from, to). Stops early at one that's still being written, so it's picked up next time.
+/// @return where it stopped
+uint64_t snapshot(uint64_t from, uint64_t to, std::vector<Event>& out)
+{
+	from = std::max(from, to > kRingSize ? to - kRingSize : 0);
+
+	for (uint64_t n = from; n < to; n++)
+	{
+		const Slot& slot = g_ring[n % kRingSize];
+		const uint64_t before = slot.seq.load(std::memory_order_acquire);
+
+		if (before <= 2 * n + 1)
+		{
+			return n;
+		}
+		if (before != 2 * n + 2)
+		{
+			// Already written over by a newer event
+			continue;
+		}
+
+		Event ev {
+			slot.name.load(std::memory_order_relaxed),
+			slot.start.load(std::memory_order_relaxed),
+			slot.duration.load(std::memory_order_relaxed),
+			slot.thread.load(std::memory_order_relaxed),
+		};
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) == before && ev.name)
+		{
+			out.push_back(ev);
+		}
+	}
+
+	return to;
+}
+
+void append_escaped(std::string& out, const char* s)
+{
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+		{
+			out += '\\';
+		}
+		if (static_cast<unsigned char>(*s) >= 0x20)
+		{
+			out += *s;
+		}
+	}
+}
+
+/// Each one ends in a comma, as the array format allows.
+std::string format_events(const std::vector<Event>& events, uint64_t precision, uint64_t dropped, precise_t now)
+{
+	const double to_us = 1000000.0 / static_cast<double>(precision);
+	std::string out;
+
+	out.reserve(events.size() * 96);
+
+	for (uint32_t i = 0; i < std::min<uint32_t>(g_num_threads.load(std::memory_order_relaxed), kMaxThreads); i++)
+	{
+		const ThreadName& thread = g_thread_names[i];
+		if (!thread.set.load(std::memory_order_acquire))
+		{
+			continue;
+		}
+
+		out += fmt::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":")", i);
+		append_escaped(out, thread.name.data());
+		out += "\"}},\n";
+	}
+
+	if (dropped)
+	{
+		out += fmt::format(
+			R"({{"name":"trace events dropped","ph":"i","s":"g","pid":1,"tid":0,"ts":{:.3f},"args":{{"count":{}}}}},)"
+			"\n",
+			now * to_us,
+			dropped
+		);
+	}
+
+	for (const Event& ev : events)
+	{
+		out += R"({"name":")";
+		append_escaped(out, ev.name);
+		out += fmt::format(
+			R"(","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}},)"
+			"\n",
+			ev.thread,
+			ev.start * to_us,
+			ev.duration * to_us
+		);
+	}
+
+	return out;
+}
+
+fs::path trace_dir()
+{
+	return fs::path {srb2home} / "traces";
+}
+
+void run_job(void (*job)(void*), void* data)
+{
+	g_writing.store(true, std::memory_order_relaxed);
+
+	if (srb2::g_main_threadpool)
+	{
+		srb2::g_main_threadpool->schedule([job, data]() { job(data); });
+		srb2::g_main_threadpool->notify();
+	}
+	else
+	{
+		job(data);
+	}
+}
+
+struct DumpJob
+{
+	fs::path path;
+	std::vector<Event> events;
+	uint64_t precision;
+	precise_t now;
+};
+
+void dump_job(void* data)
+{
+	DumpJob* job = static_cast<DumpJob*>(data);
+	std::string text = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	text += format_events(job->events, job->precision, 0, job->now);
+	if (text.size() > 2 && text.compare(text.size() - 2, 2, ",\n") == 0)
+	{
+		text.erase(text.size() - 2); // the last comma
+		text += '\n';
+	}
+	text += "]}\n";
+
+	FILE* f = std::fopen(job->path.string().c_str(), "wb");
+	if (!f || std::fwrite(text.data(), text.size(), 1, f) != 1)
+	{
+		g_write_failed.store(true, std::memory_order_relaxed);
+	}
+	if (f)
+	{
+		std::fclose(f);
+	}
+
+	delete job;
+	g_writing.store(false, std::memory_order_release);
+}
+
+struct LogJob
+{
+	std::vector<Event> events;
+	uint64_t precision;
+	uint64_t dropped;
+	precise_t now;
+	std::size_t limit;
+};
+
+bool open_log(TraceLog& log)
+{
+	std::error_code ec;
+	fs::create_directories(trace_dir(), ec);
+
+	const fs::path path = trace_dir() / fmt::format("tracelog-{}.json", log.index);
+	log.file = std::fopen(path.string().c_str(), "wb");
+	if (!log.file)
+	{
+		return false;
+	}
+
+	// The array format doesn't need closing, so the file is valid however far it got
+	log.size = std::fwrite("[\n", 1, 2, log.file);
+	return true;
+}
+
+void log_job(void* data)
+{
+	LogJob* job = static_cast<LogJob*>(data);
+	TraceLog& log = g_log;
+
+	if (log.file && log.size >= job->limit)
+	{
+		std::fclose(log.file);
+		log.file = nullptr;
+		log.index = (log.index + 1) % kLogFiles;
+	}
+
+	if (log.file || open_log(log))
+	{
+		const std::string text = format_events(job->events, job->precision, job->dropped, job->now);
+		if (std::fwrite(text.data(), text.size(), 1, log.file) == 1 && std::fflush(log.file) == 0)
+		{
+			log.size += text.size();
+		}
+		else
+		{
+			g_write_failed.store(true, std::memory_order_relaxed);
+		}
+	}
+	else
+	{
+		g_write_failed.store(true, std::memory_order_relaxed);
+	}
+
+	delete job;
+	g_writing.store(false, std::memory_order_release);
+}
+
+} // namespace
+
+extern "C" void TraceEvents_OnChange(void);
+void TraceEvents_OnChange(void)
+{
+	g_enabled.store(cv_traceevents.value != 0, std::memory_order_relaxed);
+}
+
+void M_TraceEvent(const char *name, precise_t start)
+{
+	const precise_t now = I_GetPreciseTime();
+	record(name, start, now - start);
+}
+
+void M_TraceDuration(const char *name, precise_t duration)
+{
+	const precise_t now = I_GetPreciseTime();
+	record(name, now - duration, duration);
+}
+
+void M_TraceThreadName(const char *name)
+{
+	ThreadName& thread = g_thread_names[thread_index()];
+	std::snprintf(thread.name.data(), thread.name.size(), "%s", name);
+	thread.set.store(true, std::memory_order_release);
+}
+
+void M_TraceUpdate(void)
+{
+	if (g_writing.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	if (g_write_failed.exchange(false, std::memory_order_relaxed))
+	{
+		CONS_Alert(CONS_WARNING, "Couldn't save the event trace to %s\n", trace_dir().string().c_str());
+	}
+
+	if (!cv_tracelog.value || !g_enabled.load(std::memory_order_relaxed))
+	{
+		if (g_log.file)
+		{
+			std::fclose(g_log.file);
+			g_log.file = nullptr;
+		}
+		g_logged = g_next.load(std::memory_order_relaxed);
+		return;
+	}
+
+	const uint64_t next = g_next.load(std::memory_order_relaxed);
+	const precise_t now = I_GetPreciseTime();
+	const uint64_t precision = I_GetPrecisePrecision();
+
+	if (next - g_logged < kLogBatch && now - g_last_log < precision)
+	{
+		return;
+	}
+
+	LogJob* job = new LogJob {};
+	job->precision = precision;
+	job->now = now;
+	job->limit = static_cast<std::size_t>(cv_tracelog_size.value) << 20;
+	job->dropped = next > g_logged + kRingSize ? next - g_logged - kRingSize : 0;
+
+	g_logged = snapshot(g_logged, next, job->events);
+	g_last_log = now;
+
+	run_job(log_job, job);
+}
+
+void M_TraceDump_f(void)
+{
+	char name[64];
+
+	if (g_writing.load(std::memory_order_acquire))
+	{
+		CONS_Printf("The event trace is still being saved.\n");
+		return;
+	}
+
+	if (COM_Argc() > 1)
+	{
+		snprintf(name, sizeof name, "%s", COM_Argv(1));
+	}
+	else
+	{
+		const time_t t = time(NULL);
+		strftime(name, sizeof name, "trace-%Y%m%d-%H%M%S", localtime(&t));
+	}
+
+	if (strpbrk(name, "/\\:") || !strcmp(name, "..") || !name[0])
+	{
+		CONS_Printf("tracedump [file]: saves recent events to %s" PATHSEP "<file>.json\n", trace_dir().string().c_str());
+		return;
+	}
+
+	std::error_code ec;
+	fs::create_directories(trace_dir(), ec);
+
+	DumpJob* job = new DumpJob {};
+	job->path = trace_dir() / (std::string {name} + ".json");
+	job->precision = I_GetPrecisePrecision();
+	job->now = I_GetPreciseTime();
+
+	const uint64_t next = g_next.load(std::memory_order_relaxed);
+	snapshot(0, next, job->events);
+
+	CONS_Printf("Saving %s events to %s\n", sizeu1(job->events.size()), job->path.string().c_str());
+	run_job(dump_job, job);
+}
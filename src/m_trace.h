@@ -0,0 +1,54 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_trace.h
+/// \brief Always-on event trace, saved as Chrome trace JSON
+
+#ifndef __M_TRACE_H__
+#define __M_TRACE_H__
+
+#include "doomtype.h"
+#include "command.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern consvar_t cv_traceevents, cv_tracelog, cv_tracelog_size;
+
+/**	\brief	Records a scope that just ended, from any thread.
+
+	\param	name	must outlive the trace; in practice, a string literal
+	\param	start	I_GetPreciseTime when the scope started
+*/
+void M_TraceEvent(const char *name, precise_t start);
+
+/**	\brief	Same as M_TraceEvent, for the perfstats timers that are only
+			left holding how long they took.
+*/
+void M_TraceDuration(const char *name, precise_t duration);
+
+/**	\brief	Names the calling thread in saved traces.
+
+	\param	name	must outlive the trace
+*/
+void M_TraceThreadName(const char *name);
+
+/**	\brief	Once a tic; hands events to the thread pool to be written out
+			while tracelog is on.
+*/
+void M_TraceUpdate(void);
+
+// tracedump [file]
+void M_TraceDump_f(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __M_TRACE_H__
@@ -35,6 +35,8 @@ constexpr auto kBufferMethod = VideoFrame::BufferMethod::kEncoderAllocatedRGBA88
 }; // namespace
 
 Impl::Impl(Config cfg) :
+	offline_(cfg.offline),
+
 	max_size_(cfg.max_size),
 	max_duration_(cfg.max_duration),
 
@@ -73,7 +75,11 @@ std::unique_ptr<VideoEncoder> Impl::make_video_encoder(const Config cfg) const
 
 	const Config::Video& v = *cfg.video;
 
-	return container_->make_video_encoder({v.width, v.height, v.frame_rate, kBufferMethod});
+	// Offline recording is bound by encoding speed, so use
+	// every core instead of the live default.
+	const int threads = cfg.offline ? static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) : 0;
+
+	return container_->make_video_encoder({v.width, v.height, v.frame_rate, kBufferMethod, threads});
 }
 
 Impl::~Impl()
@@ -106,14 +112,20 @@ Impl::~Impl()
 
 std::optional<int> Impl::advance_video_pts()
 {
-	auto _ = queue_guard();
+	std::unique_lock lock(queue_mutex_);
 
 	// Don't let this queue grow out of hand. It's normal
 	// for encoding time to vary by a small margin and
 	// spend longer than one frame rate on a single
 	// frame. It should normalize though.
 
-	if (video_queue_.vec_.size() >= 3)
+	if (offline_)
+	{
+		// Nothing is lost by waiting, since the clock only
+		// moves when the caller says so.
+		drain_cond_.wait(lock, [this] { return video_queue_.vec_.size() < 3 || !valid_; });
+	}
+	else if (video_queue_.vec_.size() >= 3)
 	{
 		return {};
 	}
@@ -121,7 +133,8 @@ std::optional<int> Impl::advance_video_pts()
 	SRB2_ASSERT(video_encoder_ != nullptr);
 
 	const float tic_pts = video_encoder_->frame_rate() / static_cast<float>(TICRATE);
-	const int pts = ((I_GetTime() - epoch_) + FixedToFloat(g_time.timefrac)) * tic_pts;
+	const float tics = offline_ ? offline_clock_ : (I_GetTime() - epoch_) + FixedToFloat(g_time.timefrac);
+	const int pts = tics * tic_pts;
 
 	if (!video_queue_.advance(pts, 1))
 	{
@@ -140,7 +153,9 @@ void Impl::worker()
 		try
 		{
 			while ((qs = encode_queues()) == QueueState::kFlushed)
-				;
+			{
+				drain_cond_.notify_all();
+			}
 		}
 		catch (const std::exception& ex)
 		{
@@ -162,6 +177,13 @@ void Impl::worker()
 
 	// Breaking out of the loop ensures invalidation!
 	valid_ = false;
+
+	{
+		// Don't let an offline producer miss this.
+		auto _ = queue_guard();
+	}
+
+	drain_cond_.notify_all();
 }
 
 const char* AVRecorder::file_extension()
@@ -175,6 +197,15 @@ AVRecorder::AVRecorder(const Config config) : impl_(std::make_unique<Impl>(confi
 
 AVRecorder::~AVRecorder()
 {
+	// An offline recording must be completely written before
+	// the caller moves on (and likely quits).
+
+	if (impl_->offline_)
+	{
+		impl_.reset();
+		return;
+	}
+
 	// impl_ is destroyed in a background thread so it doesn't
 	// block the thread AVRecorder was destroyed in.
 	//
@@ -209,6 +240,18 @@ void AVRecorder::push_audio_samples(audio_buffer_t buffer)
 	impl_->wake_up_worker();
 }
 
+void AVRecorder::advance_offline_clock()
+{
+	SRB2_ASSERT(impl_->offline_);
+
+	impl_->advance_offline_clock();
+}
+
+bool AVRecorder::offline() const
+{
+	return impl_->offline_;
+}
+
 bool AVRecorder::invalid() const
 {
 	return !impl_->valid_;
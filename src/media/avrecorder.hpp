@@ -56,6 +56,12 @@ public:
 
 		std::optional<Audio> audio;
 		std::optional<Video> video;
+
+		// Offline recorders are not paced by the realtime
+		// clock. Video timestamps follow advance_offline_clock
+		// and, rather than dropping frames when the encoder
+		// falls behind, new_staging_video_frame waits for it.
+		bool offline = false;
 	};
 
 	// TODO: remove once hwr2 twodee is finished
@@ -91,6 +97,12 @@ public:
 
 	void push_staging_video_frame(StagingVideoFrame::instance_t frame);
 
+	// Offline recorders only. Advances the recording clock by
+	// one tic.
+	void advance_offline_clock();
+
+	bool offline() const;
+
 	// Proper name of the container format.
 	const char* format_name() const;
 
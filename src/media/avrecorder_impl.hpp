@@ -90,6 +90,8 @@ public:
 		time_unit_t time_scale() const;
 	};
 
+	const bool offline_;
+
 	const std::optional<std::size_t> max_size_;
 	std::optional<std::chrono::duration<float>> max_duration_;
 
@@ -126,6 +128,13 @@ public:
 	// Use to notify worker thread if queues were modified.
 	void wake_up_worker() { queue_cond_.notify_one(); }
 
+	void advance_offline_clock()
+	{
+		auto _ = queue_guard();
+
+		offline_clock_++;
+	}
+
 private:
 	enum class QueueState
 	{
@@ -136,11 +145,15 @@ private:
 
 	const tic_t epoch_;
 
+	// Only used by offline recorders. Guarded by queue_mutex_.
+	tic_t offline_clock_ = 0;
+
 	VideoEncoder::FrameCount video_frame_count_reference_ = {};
 
 	std::thread thread_;
 	mutable std::recursive_mutex queue_mutex_; // guards audio and video queues
 	std::condition_variable_any queue_cond_;
+	std::condition_variable_any drain_cond_; // signaled when the worker takes queued frames
 
 	std::unique_ptr<AudioEncoder> make_audio_encoder(const Config cfg) const;
 	std::unique_ptr<VideoEncoder> make_video_encoder(const Config cfg) const;
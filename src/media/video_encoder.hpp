@@ -26,6 +26,7 @@ public:
 		int height;
 		int frame_rate;
 		VideoFrame::BufferMethod buffer_method;
+		int threads = 0; // 0 = use encoder option
 	};
 
 	struct FrameCount
@@ -32,7 +32,7 @@ const vpx_codec_enc_cfg_t VP8Encoder::configure(const Config user)
 	vpx_codec_enc_cfg_t cfg;
 	vpx_codec_enc_config_default(kCodec, &cfg, 0);
 
-	cfg.g_threads = options_.get<int>("threads");
+	cfg.g_threads = user.threads > 0 ? user.threads : options_.get<int>("threads");
 
 	cfg.g_w = user.width;
 	cfg.g_h = user.height;
@@ -68,7 +68,11 @@ const vpx_codec_enc_cfg_t VP8Encoder::configure(const Config user)
 	return cfg;
 }
 
-VP8Encoder::VP8Encoder(Config config) : ctx_(config), img_(config.width, config.height), frame_rate_(config.frame_rate)
+VP8Encoder::VP8Encoder(Config config) :
+	ctx_(config),
+	img_(config.width, config.height),
+	frame_rate_(config.frame_rate),
+	thread_count_(config.threads > 0 ? config.threads : options_.get<int>("threads"))
 {
 	SRB2_ASSERT(config.buffer_method == VideoFrame::BufferMethod::kEncoderAllocatedRGBA8888);
 
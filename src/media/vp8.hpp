@@ -88,7 +88,7 @@ private:
 	ImgWrapper img_;
 
 	const int frame_rate_;
-	const int thread_count_ = options_.get<int>("threads");
+	const int thread_count_;
 	const int deadline_ = options_.get<int>("deadline");
 
 	mutable std::recursive_mutex frame_count_mutex_;
@@ -344,7 +344,7 @@ bool EggTV::select()
 				break;
 			}
 
-			if (cache_->replay(grid_index())->invalid())
+			if (cache_->replay(grid_index())->invalid() || cache_->replay(grid_index())->pending())
 			{
 				break;
 			}
@@ -825,6 +825,11 @@ void EggTV::draw_grid() const
 		{
 			std::shared_ptr<const Replay> replay = cache_->replay(idx);
 
+			if (replay && replay->pending())
+			{
+				replay = nullptr; // drawn like an empty cell until it's read
+			}
+
 			draw_cell(cell, replay.get());
 
 			cell = cell.x(GridOffsets::kCellWidth);
@@ -41,6 +41,8 @@ public:
 
 	explicit EggTV() : EggTVData() {}
 
+	using EggTVData::update_replays;
+
 	InputReaction input(int pid);
 
 	bool select();
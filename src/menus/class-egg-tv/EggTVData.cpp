@@ -91,6 +91,19 @@ EggTVData::EggTVData() : favorites_(ensure_array(favoritesFile_, "favorites"))
 	}
 }
 
+void EggTVData::update_replays()
+{
+	index_.update(
+		[this](const std::string& key, const menudemo_t& info)
+		{
+			if (cache_)
+			{
+				cache_->loaded(key, info);
+			}
+		}
+	);
+}
+
 json EggTVData::cache_favorites() const
 {
 	json object;
@@ -125,10 +138,13 @@ EggTVData::Folder::Cache::Cache(Folder& folder) : folder_(folder)
 					continue;
 				}
 
+				const auto mtime = entry.last_write_time();
+
 				replays_.emplace_back(
 					*this,
 					entry.path().filename(),
-					time_point_conv<time_point_t>(entry.last_write_time())
+					time_point_conv<time_point_t>(mtime),
+					ReplayIndex::Stat {entry.file_size(), static_cast<std::int64_t>(mtime.time_since_epoch().count())}
 				);
 			}
 			catch (const fs::filesystem_error& ex)
@@ -157,6 +173,16 @@ EggTVData::Folder::Cache::Cache(Folder& folder) : folder_(folder)
 
 	// Refresh folder size
 	folder_.size_ = replays_.size();
+
+	// Files deleted outside the game
+	std::unordered_set<std::string> keep;
+
+	for (const ReplayRef& ref : replays_)
+	{
+		keep.insert(ref.favorites_path());
+	}
+
+	folder_.tv().index_.prune(folder_.name(), keep);
 }
 
 std::shared_ptr<EggTVData::Replay> EggTVData::Folder::Cache::replay(std::size_t idx)
@@ -179,6 +205,16 @@ void EggTVData::Folder::Cache::release(const ReplayRef& ref)
 	folder_.size_--;
 }
 
+void EggTVData::Folder::Cache::loaded(const std::string& key, const menudemo_t& info)
+{
+	const auto& it = std::find_if(replays_.begin(), replays_.end(), [&key](const ReplayRef& b) { return b.favorites_path() == key; });
+
+	if (it != replays_.end() && it->peek())
+	{
+		it->peek()->load(info);
+	}
+}
+
 EggTVData::Folder::Folder(EggTVData& tv, const fs::directory_entry& entry) :
 	tv_(&tv),
 	name_(entry.path().filename().string())
@@ -207,17 +243,27 @@ EggTVData::Replay::Title::operator const std::string() const
 EggTVData::Replay::Replay(Folder::Cache::ReplayRef& ref) : ref_(&ref)
 {
 	const fs::path path = this->path();
+	ReplayIndex& index = ref_->cache().folder().tv().index_;
 
-	menudemo_t info = {};
+	if (path.native().size() >= sizeof menudemo_t::filepath)
+	{
+		return;
+	}
 
-	if (path.native().size() >= sizeof info.filepath)
+	if (std::optional<menudemo_t> info = index.find(ref_->favorites_path(), ref_->stat()))
 	{
+		load(*info);
 		return;
 	}
 
-	std::copy_n(path.string().c_str(), path.native().size() + 1, info.filepath);
+	// Read in the background; see EggTVData::update_replays
+	index.request(ref_->favorites_path(), path, ref_->stat());
+	pending_ = true;
+}
 
-	G_LoadDemoInfo(&info, /*allownonmultiplayer*/ false);
+void EggTVData::Replay::load(const menudemo_t& info)
+{
+	pending_ = false;
 
 	if (info.type != MD_LOADED)
 	{
@@ -303,6 +349,8 @@ EggTVData::Replay::~Replay()
 		print_error("{}", ex);
 	}
 
+	ref_->cache().folder().tv().index_.forget(ref_->favorites_path());
+
 	// Clear deleted replays from favorites too!
 	if (favorited())
 	{
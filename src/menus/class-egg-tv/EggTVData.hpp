@@ -19,6 +19,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -31,6 +32,8 @@
 #include "../../doomstat.h" // gametype_t
 #include "../../doomtype.h"
 
+#include "ReplayIndex.hpp"
+
 namespace srb2::menus::egg_tv
 {
 
@@ -40,6 +43,8 @@ private:
 	const std::filesystem::path root_ = std::filesystem::path{srb2home} / "media/replay/online";
 	const std::filesystem::path favoritesPath_ = root_ / "favorites.json";
 
+	ReplayIndex index_{root_ / "replayindex.ubj"};
+
 	nlohmann::json favoritesFile_ = cache_favorites();
 	nlohmann::json& favorites_;
 
@@ -53,6 +58,10 @@ public:
 
 	explicit EggTVData();
 
+	// Call once a frame; hands out replays that finished
+	// loading in the background.
+	void update_replays();
+
 	class Replay;
 
 	class Folder
@@ -64,14 +73,18 @@ public:
 			class ReplayRef
 			{
 			public:
-				explicit ReplayRef(Cache& cache, std::filesystem::path filename, time_point_t time) :
-					cache_(&cache), filename_(filename), time_(time)
+				explicit ReplayRef(Cache& cache, std::filesystem::path filename, time_point_t time, ReplayIndex::Stat stat) :
+					cache_(&cache), filename_(filename), time_(time), stat_(stat)
 				{
 				}
 
 				Cache& cache() const { return *cache_; }
 				const std::filesystem::path& filename() const { return filename_; }
 				const time_point_t& time() const { return time_; }
+				const ReplayIndex::Stat& stat() const { return stat_; }
+
+				// Without loading it
+				Replay* peek() const { return replay_.get(); }
 
 				std::shared_ptr<Replay> replay()
 				{
@@ -111,6 +124,7 @@ public:
 				Cache* cache_;
 				std::filesystem::path filename_;
 				time_point_t time_;
+				ReplayIndex::Stat stat_;
 				std::shared_ptr<Replay> replay_;
 				bool released_ = false;
 			};
@@ -119,6 +133,7 @@ public:
 
 			std::shared_ptr<Replay> replay(std::size_t idx);
 			void release(const ReplayRef& ref);
+			void loaded(const std::string& key, const menudemo_t& info);
 
 			std::size_t size() const { return folder_.size(); }
 			Folder& folder() const { return folder_; }
@@ -247,6 +262,7 @@ public:
 		void toggle_favorite() const;
 
 		bool invalid() const { return invalid_; }
+		bool pending() const { return pending_; } // still being read
 		bool favorited() const { return ref_->iterator_to_favorite() != ref_->favorites().end(); }
 
 		std::filesystem::path path() const { return ref_->cache().folder().path() / ref_->filename(); }
@@ -259,10 +275,13 @@ public:
 		const std::vector<Standing>& standings() const { return standings_; }
 		const Standing* winner() const { return standings_.empty() ? nullptr : &standings_.front(); }
 
+		void load(const menudemo_t& info);
+
 	private:
 		Folder::Cache::ReplayRef* ref_;
 
 		bool invalid_ = true;
+		bool pending_ = false;
 		bool erased_ = false;
 
 		std::vector<Standing> standings_;
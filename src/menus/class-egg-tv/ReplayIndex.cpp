@@ -0,0 +1,331 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include "ReplayIndex.hpp"
+
+#include "../../core/thread_pool.h"
+#include "../../doomdef.h" // CONS_Alert
+#include "../../doomstat.h"
+#include "../../g_game.h"
+#include "../../r_draw.h" // R_GetColorByName
+#include "../../r_skins.h"
+
+using namespace srb2::menus::egg_tv;
+
+namespace fs = std::filesystem;
+
+using nlohmann::json;
+
+namespace
+{
+
+// Bump this if what's stored changes.
+constexpr int kIndexVersion = 1;
+
+template <class... Args>
+void print_error(fmt::format_string<Args...> format, Args&&... args)
+{
+	CONS_Alert(CONS_ERROR, "Egg TV: %s\n", fmt::format(format, args...).c_str());
+}
+
+// Names rather than numbers, since those shift around as
+// addons are loaded.
+json to_json(const menudemo_t& info, const ReplayIndex::Stat& stat)
+{
+	json entry = {
+		{"size", stat.size},
+		{"mtime", stat.mtime},
+		{"type", info.type},
+	};
+
+	if (info.type != MD_LOADED)
+	{
+		return entry;
+	}
+
+	const char* map = G_BuildMapName(info.map + 1);
+
+	entry["title"] = info.title;
+	entry["map"] = map ? map : "";
+	entry["gametype"] = info.gametype >= 0 && info.gametype < numgametypes ? gametypes[info.gametype]->name : "";
+	entry["gp"] = info.gp;
+	entry["numlaps"] = info.numlaps;
+	entry["kartspeed"] = info.kartspeed;
+
+	json& standings = entry["standings"] = json::array();
+
+	for (const auto& data : info.standings)
+	{
+		if (!data.ranking)
+		{
+			break;
+		}
+
+		standings.push_back({
+			{"ranking", data.ranking},
+			{"name", data.name},
+			{"skin", data.skin < numskins ? skins[data.skin].name : ""},
+			{"color", data.color < numskincolors ? skincolors[data.color].name : ""},
+			{"timeorscore", data.timeorscore},
+		});
+	}
+
+	return entry;
+}
+
+menudemo_t from_json(const json& entry)
+{
+	menudemo_t info = {};
+
+	info.type = entry.at("type").get<menudemotype_e>();
+
+	if (info.type != MD_LOADED)
+	{
+		return info;
+	}
+
+	const std::string map = entry.at("map").get<std::string>();
+
+	strlcpy(info.title, entry.at("title").get<std::string>().c_str(), sizeof info.title);
+	info.map = map.empty() ? NEXTMAP_INVALID : G_MapNumber(map.c_str());
+	info.gametype = G_GetGametypeByName(entry.at("gametype").get<std::string>().c_str());
+	info.gp = entry.at("gp").get<UINT8>();
+	info.numlaps = entry.at("numlaps").get<UINT8>();
+	info.kartspeed = entry.at("kartspeed").get<SINT8>();
+
+	const json& standings = entry.at("standings");
+	const std::size_t count = std::min<std::size_t>(standings.size(), MAXPLAYERS);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const json& standing = standings[i];
+		auto& data = info.standings[i];
+
+		data.ranking = standing.at("ranking").get<UINT8>();
+		strlcpy(data.name, standing.at("name").get<std::string>().c_str(), sizeof data.name);
+
+		const INT32 skin = R_SkinAvailable(standing.at("skin").get<std::string>().c_str());
+
+		data.skin = skin >= 0 ? skin : UINT8_MAX;
+		data.color = R_GetColorByName(standing.at("color").get<std::string>().c_str());
+		data.timeorscore = standing.at("timeorscore").get<UINT32>();
+	}
+
+	return info;
+}
+
+}; // namespace
+
+ReplayIndex::ReplayIndex(fs::path path) : path_(std::move(path))
+{
+	try
+	{
+		std::ifstream f(path_, std::ios::binary);
+
+		if (!f.is_open())
+		{
+			return;
+		}
+
+		json object = json::from_ubjson(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+
+		// An old index is just thrown out.
+		if (object.value("version", 0) == kIndexVersion && object["replays"].is_object())
+		{
+			replays_ = std::move(object["replays"]);
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		print_error("{}", ex.what());
+	}
+}
+
+ReplayIndex::~ReplayIndex()
+{
+	save();
+}
+
+std::optional<menudemo_t> ReplayIndex::find(const std::string& key, const Stat& stat) const
+{
+	auto it = replays_.find(key);
+
+	if (it == replays_.end())
+	{
+		return {};
+	}
+
+	try
+	{
+		if (!(Stat {it->at("size").get<std::uintmax_t>(), it->at("mtime").get<std::int64_t>()} == stat))
+		{
+			return {}; // changed since
+		}
+
+		return from_json(*it);
+	}
+	catch (const std::exception&)
+	{
+		return {}; // malformed, read it again
+	}
+}
+
+void ReplayIndex::request(const std::string& key, const fs::path& path, const Stat& stat)
+{
+	if (!requested_.insert(key).second)
+	{
+		return;
+	}
+
+	queue_.push_back({key, path, stat});
+	pump();
+}
+
+void ReplayIndex::pump()
+{
+	while (reading_ < kMaxReading && !queue_.empty())
+	{
+		// Newest first
+		Request request = std::move(queue_.back());
+
+		queue_.pop_back();
+		reading_++;
+
+		srb2::schedule_or_run(
+			[shared = shared_, request = std::move(request)]()
+			{
+				Result result;
+
+				result.request = request;
+
+				try
+				{
+					std::ifstream f(result.request.path, std::ios::binary);
+
+					if (f.is_open())
+					{
+						result.data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+						result.ok = !f.bad();
+					}
+				}
+				catch (const std::exception&)
+				{
+					result.ok = false;
+				}
+
+				std::lock_guard lock(shared->mutex);
+				shared->done.push_back(std::move(result));
+			}
+		);
+	}
+}
+
+void ReplayIndex::update(const LoadedFunc& loaded)
+{
+	std::deque<Result> done;
+
+	{
+		std::lock_guard lock(shared_->mutex);
+		done.swap(shared_->done);
+	}
+
+	for (Result& result : done)
+	{
+		const std::string path = result.request.path.string();
+		menudemo_t info = {};
+
+		reading_--;
+		requested_.erase(result.request.key);
+
+		if (path.size() >= sizeof info.filepath)
+		{
+			continue;
+		}
+
+		std::copy_n(path.c_str(), path.size() + 1, info.filepath);
+
+		if (result.ok)
+		{
+			G_LoadDemoInfoFromMemory(&info, result.data.data(), result.data.size(), /*allownonmultiplayer*/ false);
+
+			replays_[result.request.key] = to_json(info, result.request.stat);
+			dirty_ = true;
+		}
+		else
+		{
+			print_error("Failed to read file '{}'.", path);
+			info.type = MD_INVALID;
+		}
+
+		loaded(result.request.key, info);
+	}
+
+	pump();
+}
+
+void ReplayIndex::forget(const std::string& key)
+{
+	dirty_ |= replays_.erase(key) > 0;
+}
+
+void ReplayIndex::prune(const std::string& folder, const std::unordered_set<std::string>& keep)
+{
+	const std::string prefix = folder + "/";
+
+	for (auto it = replays_.begin(); it != replays_.end();)
+	{
+		const std::string& key = it.key();
+
+		if (key.compare(0, prefix.size(), prefix) == 0 && !keep.count(key))
+		{
+			it = replays_.erase(it);
+			dirty_ = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void ReplayIndex::save()
+{
+	if (!dirty_)
+	{
+		return;
+	}
+
+	try
+	{
+		const std::vector<std::uint8_t> data = json::to_ubjson({
+			{"version", kIndexVersion},
+			{"replays", replays_},
+		});
+
+		std::ofstream f(path_, std::ios::binary);
+
+		f.write(reinterpret_cast<const char*>(data.data()), data.size());
+		dirty_ = false;
+	}
+	catch (const std::exception& ex)
+	{
+		print_error("{}", ex.what());
+	}
+}
@@ -0,0 +1,110 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __REPLAYINDEX_HPP__
+#define __REPLAYINDEX_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../../doomtype.h"
+#include "../../g_demo.h" // menudemo_t
+
+namespace srb2::menus::egg_tv
+{
+
+// Replay headers, kept on disk between visits so that
+// only new or changed files have to be read again. Files
+// that are missing are read on the thread pool, then
+// parsed on the main thread by update.
+class ReplayIndex
+{
+public:
+	struct Stat
+	{
+		std::uintmax_t size = 0;
+		std::int64_t mtime = 0;
+
+		bool operator==(const Stat& b) const { return size == b.size && mtime == b.mtime; }
+	};
+
+	using LoadedFunc = std::function<void(const std::string& key, const menudemo_t& info)>;
+
+	explicit ReplayIndex(std::filesystem::path path);
+	ReplayIndex(const ReplayIndex&) = delete;
+	ReplayIndex& operator=(const ReplayIndex&) = delete;
+	~ReplayIndex();
+
+	// The header of this file, if it hasn't changed since it was indexed.
+	std::optional<menudemo_t> find(const std::string& key, const Stat& stat) const;
+
+	// Read this file in the background. Later requests are
+	// served first, since they're what's on screen now.
+	void request(const std::string& key, const std::filesystem::path& path, const Stat& stat);
+
+	// Parse whatever was read since the last call.
+	void update(const LoadedFunc& loaded);
+
+	void forget(const std::string& key);
+
+	// Forget every file in this folder that isn't in keep.
+	void prune(const std::string& folder, const std::unordered_set<std::string>& keep);
+
+	void save();
+
+private:
+	struct Request
+	{
+		std::string key;
+		std::filesystem::path path;
+		Stat stat;
+	};
+
+	struct Result
+	{
+		Request request;
+		std::vector<UINT8> data;
+		bool ok = false;
+	};
+
+	// Outlives this object, if workers are still reading.
+	struct Shared
+	{
+		std::mutex mutex;
+		std::deque<Result> done;
+	};
+
+	static constexpr std::size_t kMaxReading = 4;
+
+	const std::filesystem::path path_;
+	nlohmann::json replays_ = nlohmann::json::object();
+	bool dirty_ = false;
+
+	std::shared_ptr<Shared> shared_ = std::make_shared<Shared>();
+	std::vector<Request> queue_;
+	std::unordered_set<std::string> requested_;
+	std::size_t reading_ = 0;
+
+	void pump();
+};
+
+}; // namespace srb2::menus::egg_tv
+
+#endif // __REPLAYINDEX_HPP__
@@ -27,6 +27,7 @@ std::unique_ptr<EggTV> g_egg_tv;
 
 void M_DrawEggTV()
 {
+	g_egg_tv->update_replays();
 	g_egg_tv->draw();
 }
 
@@ -73,9 +73,7 @@ typedef enum
 	// action in P_RunThinkers
 	NUM_ACTIVETHINKERLISTS,
 
-	THINK_PRECIP = NUM_ACTIVETHINKERLISTS,
-
-	NUM_THINKERLISTS
+	NUM_THINKERLISTS = NUM_ACTIVETHINKERLISTS
 } thinklistnum_t; /**< Thinker lists. */
 extern thinker_t thlist[];
 extern mobj_t *mobjcache;
@@ -260,7 +258,6 @@ void P_RespawnSpecials(void);
 fixed_t P_GetMobjDefaultScale(mobj_t *mobj);
 mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type);
 
-void P_CalculatePrecipFloor(precipmobj_t *mobj);
 void P_RecalcPrecipInSector(sector_t *sector);
 void P_PrecipitationEffects(void);
 
@@ -374,9 +371,6 @@ struct tm_t
 	fixed_t bbox[4];
 	INT32 flags;
 
-	precipmobj_t *precipthing;
-	fixed_t precipbbox[4];
-
 	// If "floatok" true, move would be ok
 	// if within "tm.floorz - tm.ceilingz".
 	boolean floatok;
@@ -418,8 +412,6 @@ extern void P_MapEnd(void);
 
 extern msecnode_t *sector_list;
 
-extern mprecipsecnode_t *precipsector_list;
-
 void P_UnsetThingPosition(mobj_t *thing);
 void P_SetThingPosition(mobj_t *thing);
 void P_SetUnderlayPosition(mobj_t *thing);
@@ -460,7 +452,6 @@ void P_CheckHoopPosition(mobj_t *hoopthing, fixed_t x, fixed_t y, fixed_t z, fix
 boolean P_CheckSector(sector_t *sector, boolean crunch);
 
 void P_DelSeclist(msecnode_t *node);
-void P_DelPrecipSeclist(mprecipsecnode_t *node);
 
 void P_CreateSecNodeList(mobj_t *thing, fixed_t x, fixed_t y);
 void P_Initsecnode(void);
@@ -491,7 +482,6 @@ extern INT32 bmapheight; // in mapblocks
 extern fixed_t bmaporgx;
 extern fixed_t bmaporgy; // origin of block map
 extern mobj_t **blocklinks; // for thing chains
-extern precipmobj_t **precipblocklinks; // special blockmap for precip rendering
 
 extern struct minimapinfo
 {
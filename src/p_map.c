@@ -92,7 +92,6 @@ static size_t numspechitint = 0U;
 
 
 msecnode_t *sector_list = NULL;
-mprecipsecnode_t *precipsector_list = NULL;
 camera_t *mapcampointer;
 
 //
@@ -2031,6 +2030,7 @@ boolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y, TryMoveResult_t *re
 	INT32 xl, xh, yl, yh, bx, by;
 	subsector_t *newsubsec;
 	boolean blockval = true;
+	precise_t linetime;
 
 	ps_checkposition_calls++;
 
@@ -2326,14 +2326,18 @@ boolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y, TryMoveResult_t *re
 	validcount++;
 
 	// check lines
+	linetime = I_GetPreciseTime();
+
 	for (bx = xl; bx <= xh; bx++)
 	{
 		for (by = yl; by <= yh; by++)
 		{
-			P_BlockLinesIterator(bx, by, PIT_CheckLine);
+			P_BlockLinesIteratorBox(bx, by, g_tm.bbox, PIT_CheckLine);
 		}
 	}
 
+	ps_checkline_time += I_GetPreciseTime() - linetime;
+
 	if (g_tm.blocking)
 	{
 		blockval = false;
@@ -4614,12 +4618,10 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 */
 
 static msecnode_t *headsecnode = NULL;
-static mprecipsecnode_t *headprecipsecnode = NULL;
 
 void P_Initsecnode(void)
 {
 	headsecnode = NULL;
-	headprecipsecnode = NULL;
 }
 
 // P_GetSecnode() retrieves a node from the freelist. The calling routine
@@ -4639,20 +4641,6 @@ static msecnode_t *P_GetSecnode(void)
 	return node;
 }
 
-static mprecipsecnode_t *P_GetPrecipSecnode(void)
-{
-	mprecipsecnode_t *node;
-
-	if (headprecipsecnode)
-	{
-		node = headprecipsecnode;
-		headprecipsecnode = headprecipsecnode->m_thinglist_next;
-	}
-	else
-		node = Z_Calloc(sizeof (*node), PU_LEVEL, NULL);
-	return node;
-}
-
 // P_PutSecnode() returns a node to the freelist.
 
 static inline void P_PutSecnode(msecnode_t *node)
@@ -4661,13 +4649,6 @@ static inline void P_PutSecnode(msecnode_t *node)
 	headsecnode = node;
 }
 
-// Tails 08-25-2002
-static inline void P_PutPrecipSecnode(mprecipsecnode_t *node)
-{
-	node->m_thinglist_next = headprecipsecnode;
-	headprecipsecnode = node;
-}
-
 // P_AddSecnode() searches the current list to see if this sector is
 // already there. If not, it adds a sector node at the head of the list of
 // sectors this object appears in. This is called when creating a list of
@@ -4713,47 +4694,6 @@ static msecnode_t *P_AddSecnode(sector_t *s, mobj_t *thing, msecnode_t *nextnode
 	return node;
 }
 
-// More crazy crap Tails 08-25-2002
-static mprecipsecnode_t *P_AddPrecipSecnode(sector_t *s, precipmobj_t *thing, mprecipsecnode_t *nextnode)
-{
-	mprecipsecnode_t *node;
-
-	node = nextnode;
-	while (node)
-	{
-		if (node->m_sector == s) // Already have a node for this sector?
-		{
-			node->m_thing = thing; // Yes. Setting m_thing says 'keep it'.
-			return nextnode;
-		}
-		node = node->m_sectorlist_next;
-	}
-
-	// Couldn't find an existing node for this sector. Add one at the head
-	// of the list.
-
-	node = P_GetPrecipSecnode();
-
-	// mark new nodes unvisited.
-	node->visited = 0;
-
-	node->m_sector = s; // sector
-	node->m_thing = thing; // mobj
-	node->m_sectorlist_prev = NULL; // prev node on Thing thread
-	node->m_sectorlist_next = nextnode; // next node on Thing thread
-	if (nextnode)
-		nextnode->m_sectorlist_prev = node; // set back link on Thing
-
-	// Add new node at head of sector thread starting at s->touching_thinglist
-
-	node->m_thinglist_prev = NULL; // prev node on sector thread
-	node->m_thinglist_next = s->touching_preciplist; // next node on sector thread
-	if (s->touching_preciplist)
-		node->m_thinglist_next->m_thinglist_prev = node;
-	s->touching_preciplist = node;
-	return node;
-}
-
 // P_DelSecnode() deletes a sector node from the list of
 // sectors this object appears in. Returns a pointer to the next node
 // on the linked list, or NULL.
@@ -4796,45 +4736,6 @@ static msecnode_t *P_DelSecnode(msecnode_t *node)
 	return tn;
 }
 
-// Tails 08-25-2002
-static mprecipsecnode_t *P_DelPrecipSecnode(mprecipsecnode_t *node)
-{
-	mprecipsecnode_t *tp; // prev node on thing thread
-	mprecipsecnode_t *tn; // next node on thing thread
-	mprecipsecnode_t *sp; // prev node on sector thread
-	mprecipsecnode_t *sn; // next node on sector thread
-
-	if (!node)
-		return NULL;
-
-	// Unlink from the Thing thread. The Thing thread begins at
-	// sector_list and not from mobj_t->touching_sectorlist.
-
-	tp = node->m_sectorlist_prev;
-	tn = node->m_sectorlist_next;
-	if (tp)
-		tp->m_sectorlist_next = tn;
-	if (tn)
-		tn->m_sectorlist_prev = tp;
-
-	// Unlink from the sector thread. This thread begins at
-	// sector_t->touching_thinglist.
-
-	sp = node->m_thinglist_prev;
-	sn = node->m_thinglist_next;
-	if (sp)
-		sp->m_thinglist_next = sn;
-	else
-		node->m_sector->touching_preciplist = sn;
-	if (sn)
-		sn->m_thinglist_prev = sp;
-
-	// Return this node to the freelist
-
-	P_PutPrecipSecnode(node);
-	return tn;
-}
-
 // Delete an entire sector list
 void P_DelSeclist(msecnode_t *node)
 {
@@ -4842,13 +4743,6 @@ void P_DelSeclist(msecnode_t *node)
 		node = P_DelSecnode(node);
 }
 
-// Tails 08-25-2002
-void P_DelPrecipSeclist(mprecipsecnode_t *node)
-{
-	while (node)
-		node = P_DelPrecipSecnode(node);
-}
-
 // PIT_GetSectors
 // Locates all the sectors the object is in by looking at the lines that
 // cross through it. You have already decided that the object is allowed
@@ -4889,41 +4783,6 @@ static inline BlockItReturn_t PIT_GetSectors(line_t *ld)
 	return BMIT_CONTINUE;
 }
 
-// Tails 08-25-2002
-static inline BlockItReturn_t PIT_GetPrecipSectors(line_t *ld)
-{
-	if (g_tm.precipbbox[BOXRIGHT] <= ld->bbox[BOXLEFT] ||
-		g_tm.precipbbox[BOXLEFT] >= ld->bbox[BOXRIGHT] ||
-		g_tm.precipbbox[BOXTOP] <= ld->bbox[BOXBOTTOM] ||
-		g_tm.precipbbox[BOXBOTTOM] >= ld->bbox[BOXTOP])
-	return BMIT_CONTINUE;
-
-	if (P_BoxOnLineSide(g_tm.precipbbox, ld) != -1)
-		return BMIT_CONTINUE;
-
-	if (ld->polyobj) // line belongs to a polyobject, don't add it
-		return BMIT_CONTINUE;
-
-	// This line crosses through the object.
-
-	// Collect the sector(s) from the line and add to the
-	// sector_list you're examining. If the Thing ends up being
-	// allowed to move to this position, then the sector_list
-	// will be attached to the Thing's mobj_t at touching_sectorlist.
-
-	precipsector_list = P_AddPrecipSecnode(ld->frontsector, g_tm.precipthing, precipsector_list);
-
-	// Don't assume all lines are 2-sided, since some Things
-	// like MT_TFOG are allowed regardless of whether their radius takes
-	// them beyond an impassable linedef.
-
-	// Use sidedefs instead of 2s flag to determine two-sidedness.
-	if (ld->backsector)
-		precipsector_list = P_AddPrecipSecnode(ld->backsector, g_tm.precipthing, precipsector_list);
-
-	return BMIT_CONTINUE;
-}
-
 // P_CreateSecNodeList alters/creates the sector_list that shows what sectors
 // the object resides in.
 
@@ -4997,73 +4856,6 @@ void P_CreateSecNodeList(mobj_t *thing, fixed_t x, fixed_t y)
 	P_RestoreTMStruct(ptm);
 }
 
-// More crazy crap Tails 08-25-2002
-void P_CreatePrecipSecNodeList(precipmobj_t *thing,fixed_t x,fixed_t y)
-{
-	INT32 xl, xh, yl, yh, bx, by;
-	mprecipsecnode_t *node = precipsector_list;
-	tm_t ptm = g_tm; /* cph - see comment at func end */
-
-	// First, clear out the existing m_thing fields. As each node is
-	// added or verified as needed, m_thing will be set properly. When
-	// finished, delete all nodes where m_thing is still NULL. These
-	// represent the sectors the Thing has vacated.
-
-	while (node)
-	{
-		node->m_thing = NULL;
-		node = node->m_sectorlist_next;
-	}
-
-	g_tm.precipthing = thing;
-
-	g_tm.precipbbox[BOXTOP] = y + 2*FRACUNIT;
-	g_tm.precipbbox[BOXBOTTOM] = y - 2*FRACUNIT;
-	g_tm.precipbbox[BOXRIGHT] = x + 2*FRACUNIT;
-	g_tm.precipbbox[BOXLEFT] = x - 2*FRACUNIT;
-
-	validcount++; // used to make sure we only process a line once
-
-	xl = (unsigned)(g_tm.precipbbox[BOXLEFT] - bmaporgx)>>MAPBLOCKSHIFT;
-	xh = (unsigned)(g_tm.precipbbox[BOXRIGHT] - bmaporgx)>>MAPBLOCKSHIFT;
-	yl = (unsigned)(g_tm.precipbbox[BOXBOTTOM] - bmaporgy)>>MAPBLOCKSHIFT;
-	yh = (unsigned)(g_tm.precipbbox[BOXTOP] - bmaporgy)>>MAPBLOCKSHIFT;
-
-	BMBOUNDFIX(xl, xh, yl, yh);
-
-	for (bx = xl; bx <= xh; bx++)
-		for (by = yl; by <= yh; by++)
-			P_BlockLinesIterator(bx, by, PIT_GetPrecipSectors);
-
-	// Add the sector of the (x, y) point to sector_list.
-	precipsector_list = P_AddPrecipSecnode(thing->subsector->sector, thing, precipsector_list);
-
-	// Now delete any nodes that won't be used. These are the ones where
-	// m_thing is still NULL.
-	node = precipsector_list;
-	while (node)
-	{
-		if (!node->m_thing)
-		{
-			if (node == precipsector_list)
-				precipsector_list = node->m_sectorlist_next;
-			node = P_DelPrecipSecnode(node);
-		}
-		else
-			node = node->m_sectorlist_next;
-	}
-
-	/* cph -
-	* This is the strife we get into for using global variables. g_tm.thing
-	*  is being used by several different functions calling
-	*  P_BlockThingIterator, including functions that can be called *from*
-	*  P_BlockThingIterator. Using a global g_tm.thing is not reentrant.
-	* OTOH for Boom/MBF demos we have to preserve the buggy behavior.
-	*  Fun. We restore its previous value unless we're in a Boom/MBF demo.
-	*/
-	P_RestoreTMStruct(ptm);
-}
-
 /* cphipps 2004/08/30 -
  * Must clear g_tm.thing at tic end, as it might contain a pointer to a removed thinker, or the level might have ended/been ended and we clear the objects it was pointing too. Hopefully we don't need to carry this between tics for sync. */
 void P_MapStart(void)
@@ -0,0 +1,361 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_mapcache.cpp
+/// \brief Compiled cache of UDMF map data
+
+#include "p_mapcache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include <fmt/format.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPCACHE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cxxutil.hpp"
+#include "io/streams.hpp"
+
+#include "d_main.h" // srb2home
+#include "doomdef.h"
+
+using namespace srb2;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+// Bump whenever the layout changes, or the parsers start needing something the cache doesn't keep.
+constexpr uint32_t kMapCacheVersion = 1;
+constexpr char kMapCacheMagic[4] = {'R', 'R', 'M', 'C'};
+
+// magic, version, key, textmap size, parse time, udmf version, 5 counts, blocks, pairs, strings, blockmap hash,
+// blockmap count
+// Set on a value's string offset if it was quoted in the TEXTMAP
+constexpr uint32_t kQuotedFlag = 0x80000000;
+
+constexpr std::size_t kHeaderSize = 4 + 4 + 16 + 4 + 4 + 4 + 5 * 4 + 4 + 4 + 4 + 4 + 4;
+
+uint32_t load_u32(const std::byte* p)
+{
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+		(static_cast<uint32_t>(p[3]) << 24);
+}
+
+fs::path cache_path(const MapCacheKey& key)
+{
+	std::string name;
+	for (uint8_t b : key)
+	{
+		name += fmt::format("{:02x}", b);
+	}
+	return fs::path {srb2home} / "cache" / "maps" / (name + ".rrmc");
+}
+
+} // namespace
+
+/// The cache file, memory-mapped where the platform allows it and read into memory otherwise.
+struct MapCache::Mapping
+{
+	const std::byte* data = nullptr;
+	std::size_t size = 0;
+
+#ifdef MAPCACHE_MMAP
+	void* map = nullptr;
+
+	~Mapping()
+	{
+		if (map)
+		{
+			munmap(map, size);
+		}
+	}
+
+	bool open(const fs::path& path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		size = static_cast<std::size_t>(st.st_size);
+		void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (p == MAP_FAILED)
+		{
+			return false;
+		}
+
+		map = p;
+		data = static_cast<const std::byte*>(p);
+		return true;
+	}
+#else
+	std::vector<std::byte> contents;
+
+	bool open(const fs::path& path)
+	{
+		try
+		{
+			io::FileStream file {path.string(), io::FileStreamMode::kRead};
+			contents = io::read_to_vec(file);
+		}
+		catch (...)
+		{
+			return false;
+		}
+
+		data = contents.data();
+		size = contents.size();
+		return size > 0;
+	}
+#endif
+};
+
+MapCache::MapCache() = default;
+MapCache::~MapCache() = default;
+
+std::unique_ptr<MapCache> MapCache::open(const MapCacheKey& key, uint32_t textmap_size)
+{
+	std::unique_ptr<MapCache> cache {new MapCache()};
+	cache->file_ = std::make_unique<Mapping>();
+
+	if (!cache->file_->open(cache_path(key)))
+	{
+		return nullptr;
+	}
+
+	const std::byte* p = cache->file_->data;
+	const std::size_t size = cache->file_->size;
+
+	if (size < kHeaderSize || std::memcmp(p, kMapCacheMagic, 4) != 0 || load_u32(p + 4) != kMapCacheVersion)
+	{
+		return nullptr;
+	}
+	if (std::memcmp(p + 8, key.data(), key.size()) != 0 || load_u32(p + 24) != textmap_size)
+	{
+		return nullptr;
+	}
+
+	cache->parse_us_ = load_u32(p + 28);
+	cache->udmf_version_ = static_cast<int32_t>(load_u32(p + 32));
+	cache->counts_.vertexes = load_u32(p + 36);
+	cache->counts_.sectors = load_u32(p + 40);
+	cache->counts_.lines = load_u32(p + 44);
+	cache->counts_.sides = load_u32(p + 48);
+	cache->counts_.things = load_u32(p + 52);
+	const uint32_t num_blocks = load_u32(p + 56);
+	cache->num_pairs_ = load_u32(p + 60);
+	cache->strings_size_ = load_u32(p + 64);
+	cache->blockmap_vertex_hash_ = load_u32(p + 68);
+	cache->blockmap_count_ = load_u32(p + 72);
+
+	// The position tables in p_setup only hold this many of each
+	const MapCacheCounts& c = cache->counts_;
+	if (c.vertexes > UINT16_MAX || c.sectors > UINT16_MAX || c.lines > UINT16_MAX || c.sides > UINT16_MAX ||
+		c.things > UINT16_MAX || num_blocks != c.total())
+	{
+		return nullptr;
+	}
+
+	const uint64_t expected = kHeaderSize + (static_cast<uint64_t>(num_blocks) + 1) * 4 +
+		static_cast<uint64_t>(cache->num_pairs_) * 8 + cache->strings_size_ +
+		static_cast<uint64_t>(cache->blockmap_count_) * 4;
+	if (expected != size || cache->strings_size_ == 0)
+	{
+		return nullptr;
+	}
+
+	cache->blocks_ = p + kHeaderSize;
+	cache->pairs_ = cache->blocks_ + (static_cast<std::size_t>(num_blocks) + 1) * 4;
+	cache->strings_ = reinterpret_cast<const char*>(cache->pairs_ + static_cast<std::size_t>(cache->num_pairs_) * 8);
+	cache->blockmap_ = reinterpret_cast<const std::byte*>(cache->strings_ + cache->strings_size_);
+
+	// Validate everything up front, so that parsing can trust the offsets
+	if (cache->strings_[cache->strings_size_ - 1] != '\0')
+	{
+		return nullptr;
+	}
+	uint32_t last = 0;
+	for (uint32_t i = 0; i <= num_blocks; i++)
+	{
+		uint32_t start = load_u32(cache->blocks_ + i * 4);
+		if (start < last || start > cache->num_pairs_)
+		{
+			return nullptr;
+		}
+		last = start;
+	}
+	if (last != cache->num_pairs_)
+	{
+		return nullptr;
+	}
+	for (uint32_t i = 0; i < cache->num_pairs_ * 2; i++)
+	{
+		if ((load_u32(cache->pairs_ + i * 4) & ~kQuotedFlag) >= cache->strings_size_)
+		{
+			return nullptr;
+		}
+	}
+
+	return cache;
+}
+
+void MapCache::parse_block(uint32_t block, std::size_t num, void (*parser)(uint32_t, const char*, const char*)) const
+{
+	SRB2_ASSERT(block < counts_.total());
+
+	const uint32_t start = load_u32(blocks_ + block * 4);
+	const uint32_t end = load_u32(blocks_ + (block + 1) * 4);
+
+	for (uint32_t i = start; i < end; i++)
+	{
+		const char* key = strings_ + load_u32(pairs_ + i * 8);
+		const uint32_t value_offset = load_u32(pairs_ + i * 8 + 4);
+		const char* value = strings_ + (value_offset & ~kQuotedFlag);
+		value_is_string_ = (value_offset & kQuotedFlag) != 0;
+		parser(static_cast<uint32_t>(num), key, value);
+	}
+	value_is_string_ = false;
+}
+
+bool MapCache::blockmap(uint32_t vertex_hash, std::vector<int32_t>& out) const
+{
+	if (blockmap_count_ == 0 || vertex_hash != blockmap_vertex_hash_)
+	{
+		return false;
+	}
+
+	out.resize(blockmap_count_);
+	for (uint32_t i = 0; i < blockmap_count_; i++)
+	{
+		out[i] = static_cast<int32_t>(load_u32(blockmap_ + i * 4));
+	}
+	return true;
+}
+
+MapCacheWriter::MapCacheWriter() = default;
+
+uint32_t MapCacheWriter::intern(std::string_view string)
+{
+	auto it = interned_.find(std::string {string});
+	if (it != interned_.end())
+	{
+		return it->second;
+	}
+
+	uint32_t offset = static_cast<uint32_t>(strings_.size());
+	strings_.insert(strings_.end(), string.begin(), string.end());
+	strings_.push_back('\0');
+	interned_.emplace(string, offset);
+	return offset;
+}
+
+void MapCacheWriter::begin_block()
+{
+	block_starts_.push_back(static_cast<uint32_t>(pairs_.size() / 2));
+}
+
+void MapCacheWriter::add(const char* key, const char* value, bool value_is_string)
+{
+	pairs_.push_back(intern(key));
+	pairs_.push_back(intern(value) | (value_is_string ? kQuotedFlag : 0));
+}
+
+void MapCacheWriter::set_blockmap(const int32_t* lump, std::size_t count, uint32_t vertex_hash)
+{
+	blockmap_.assign(lump, lump + count);
+	blockmap_vertex_hash_ = vertex_hash;
+}
+
+void MapCacheWriter::write(
+	const MapCacheKey& key,
+	uint32_t textmap_size,
+	const MapCacheCounts& counts,
+	int32_t udmf_version,
+	uint32_t parse_us
+) const
+{
+	if (block_starts_.size() != counts.total() || strings_.size() >= kQuotedFlag)
+	{
+		// Not every block went through TextmapParse; don't cache a partial map
+		return;
+	}
+
+	fs::path path = cache_path(key);
+	fs::path temp = path;
+	temp += ".tmp";
+
+	try
+	{
+		fs::create_directories(path.parent_path());
+
+		io::VecStream out;
+
+		io::write_exact(out, tcb::as_bytes(tcb::span(kMapCacheMagic)));
+		io::write(kMapCacheVersion, out);
+		io::write_exact(out, tcb::as_bytes(tcb::span(key)));
+		io::write(textmap_size, out);
+		io::write(parse_us, out);
+		io::write(udmf_version, out);
+		io::write(counts.vertexes, out);
+		io::write(counts.sectors, out);
+		io::write(counts.lines, out);
+		io::write(counts.sides, out);
+		io::write(counts.things, out);
+		io::write(static_cast<uint32_t>(block_starts_.size()), out);
+		io::write(static_cast<uint32_t>(pairs_.size() / 2), out);
+		io::write(static_cast<uint32_t>(strings_.size()), out);
+		io::write(blockmap_vertex_hash_, out);
+		io::write(static_cast<uint32_t>(blockmap_.size()), out);
+
+		for (uint32_t start : block_starts_)
+		{
+			io::write(start, out);
+		}
+		io::write(static_cast<uint32_t>(pairs_.size() / 2), out);
+		for (uint32_t offset : pairs_)
+		{
+			io::write(offset, out);
+		}
+		io::write_exact(out, tcb::as_bytes(tcb::span(strings_)));
+		for (int32_t word : blockmap_)
+		{
+			io::write(word, out);
+		}
+
+		io::FileStream file {temp.string(), io::FileStreamMode::kWrite};
+		io::write_exact(file, tcb::as_bytes(tcb::span(out.vector())));
+		file.close();
+
+		// Only a complete file ever has the real name
+		fs::rename(temp, path);
+	}
+	catch (const std::exception& ex)
+	{
+		CONS_Alert(CONS_WARNING, "Couldn't write map cache %s: %s\n", path.string().c_str(), ex.what());
+		std::error_code ec;
+		fs::remove(temp, ec);
+	}
+}
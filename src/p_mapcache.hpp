@@ -0,0 +1,119 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_mapcache.hpp
+/// \brief Compiled cache of UDMF map data
+
+#ifndef __P_MAPCACHE_HPP__
+#define __P_MAPCACHE_HPP__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace srb2
+{
+
+/// Number of blocks of each kind in a TEXTMAP, in the order P_LoadTextmap parses them.
+struct MapCacheCounts
+{
+	uint32_t vertexes;
+	uint32_t sectors;
+	uint32_t lines;
+	uint32_t sides;
+	uint32_t things;
+
+	uint32_t total() const noexcept { return vertexes + sectors + lines + sides + things; }
+};
+
+using MapCacheKey = std::array<uint8_t, 16>;
+
+/// A TEXTMAP compiled to its blocks' key/value pairs, plus the blockmap generated from it. Texture, flat and
+/// colormap lookups depend on which addons are loaded, so the cache stops short of the final level structures and
+/// the values still go through the usual field parsers; what it saves is tokenizing and counting the text, and
+/// building the blockmap.
+///
+/// Cache files live in srb2home/cache/maps and are named after the map's MD5 (see P_MakeMapMD5).
+class MapCache
+{
+	struct Mapping;
+
+	std::unique_ptr<Mapping> file_;
+
+	MapCacheCounts counts_ {};
+	int32_t udmf_version_ = 0;
+	uint32_t parse_us_ = 0;
+
+	const std::byte* blocks_ = nullptr;
+	const std::byte* pairs_ = nullptr;
+	uint32_t num_pairs_ = 0;
+	const char* strings_ = nullptr;
+	uint32_t strings_size_ = 0;
+	const std::byte* blockmap_ = nullptr;
+	uint32_t blockmap_count_ = 0;
+	uint32_t blockmap_vertex_hash_ = 0;
+	mutable bool value_is_string_ = false;
+
+	MapCache();
+
+public:
+	MapCache(const MapCache&) = delete;
+	MapCache& operator=(const MapCache&) = delete;
+	~MapCache();
+
+	/// @return the cache for this TEXTMAP, or null if there isn't a valid one
+	static std::unique_ptr<MapCache> open(const MapCacheKey& key, uint32_t textmap_size);
+
+	const MapCacheCounts& counts() const noexcept { return counts_; }
+	int32_t udmf_version() const noexcept { return udmf_version_; }
+
+	/// Time it took to parse the TEXTMAP when the cache was written, in microseconds.
+	uint32_t parse_us() const noexcept { return parse_us_; }
+
+	/// Feed one block's fields to a TEXTMAP field parser, exactly as TextmapParse would have.
+	void parse_block(uint32_t block, std::size_t num, void (*parser)(uint32_t, const char*, const char*)) const;
+
+	/// Stands in for M_TokenizerJustReadString while parse_block is calling the parser.
+	bool value_is_string() const noexcept { return value_is_string_; }
+
+	/// @param vertex_hash hash of the level's vertices after the BSP was loaded
+	/// @return false if the cache has no blockmap for these vertices
+	bool blockmap(uint32_t vertex_hash, std::vector<int32_t>& out) const;
+};
+
+/// Records a TEXTMAP as it is parsed, then writes it out as a MapCache.
+class MapCacheWriter
+{
+	std::vector<uint32_t> block_starts_;
+	std::vector<uint32_t> pairs_;
+	std::vector<char> strings_;
+	std::unordered_map<std::string, uint32_t> interned_;
+	std::vector<int32_t> blockmap_;
+	uint32_t blockmap_vertex_hash_ = 0;
+
+	uint32_t intern(std::string_view string);
+
+public:
+	MapCacheWriter();
+
+	void begin_block();
+	void add(const char* key, const char* value, bool value_is_string);
+	void set_blockmap(const int32_t* lump, std::size_t count, uint32_t vertex_hash);
+
+	/// Problems are reported to the console; a failed write only means the next load parses the text again.
+	void write(const MapCacheKey& key, uint32_t textmap_size, const MapCacheCounts& counts, int32_t udmf_version, uint32_t parse_us) const;
+};
+
+} // namespace srb2
+
+#endif // __P_MAPCACHE_HPP__
@@ -26,6 +26,11 @@
 #include "p_slopes.h"
 #include "z_zone.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCKLINECACHE_SSE2
+#include <emmintrin.h>
+#endif
+
 //
 // P_ClosestPointOnLine
 // Finds the closest point on a given line to the supplied point
@@ -1090,18 +1095,6 @@ void P_UnsetThingPosition(mobj_t *thing)
 	}
 }
 
-void P_UnsetPrecipThingPosition(precipmobj_t *thing)
-{
-	precipmobj_t **bprev = thing->bprev;
-	precipmobj_t  *bnext = thing->bnext;
-
-	if (bprev && (*bprev = bnext) != NULL)  // unlink from block map
-		bnext->bprev = bprev;
-
-	precipsector_list = thing->touching_sectorlist;
-	thing->touching_sectorlist = NULL; //to be restored by P_SetPrecipThingPosition
-}
-
 static void P_LinkToBlockMap(mobj_t *thing, mobj_t **bmap)
 {
 	const INT32 blockx = (unsigned)(thing->x - bmaporgx) >> MAPBLOCKSHIFT;
@@ -1243,19 +1236,6 @@ void P_SetUnderlayPosition(mobj_t *thing)
 	sector_list = NULL; // clear for next time
 }
 
-void P_SetPrecipitationThingPosition(precipmobj_t *thing)
-{
-	thing->subsector = R_PointInSubsector(thing->x, thing->y);
-
-	P_CreatePrecipSecNodeList(thing, thing->x, thing->y);
-	thing->touching_sectorlist = precipsector_list; // Attach to Thing's precipmobj_t
-	precipsector_list = NULL; // clear for next time
-
-	// NOTE: this works because bnext/bprev are at the same
-	// offsets in precipmobj_t and mobj_t
-	P_LinkToBlockMap((mobj_t*)thing, (mobj_t**)precipblocklinks);
-}
-
 //
 // BLOCK MAP ITERATORS
 // For each line/thing in the given mapblock,
@@ -1273,17 +1253,10 @@ void P_SetPrecipitationThingPosition(precipmobj_t *thing)
 // to P_BlockLinesIterator, then make one or more calls
 // to it.
 //
-boolean P_BlockLinesIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(line_t *))
+// Runs func on the polyobject lines in a block.
+static BlockItReturn_t P_BlockPolyLinesIterator(INT32 offset, BlockItReturn_t (*func)(line_t *))
 {
-	INT32 offset;
-	const INT32 *list; // Big blockmap
 	polymaplink_t *plink; // haleyjd 02/22/06
-	line_t *ld;
-
-	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
-		return true;
-
-	offset = y*bmapwidth + x;
 
 	// haleyjd 02/22/06: consider polyobject lines
 	plink = polyblocklinks[offset];
@@ -1307,19 +1280,39 @@ boolean P_BlockLinesIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(line_t *)
 				po->lines[i]->validcount = validcount;
 				ret = func(po->lines[i]);
 
-				if (ret == BMIT_ABORT)
+				if (ret != BMIT_CONTINUE)
 				{
-					return false;
-				}
-				else if (ret == BMIT_STOP)
-				{
-					return true;
+					return ret;
 				}
 			}
 		}
 		plink = (polymaplink_t *)(plink->link.next);
 	}
 
+	return BMIT_CONTINUE;
+}
+
+boolean P_BlockLinesIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(line_t *))
+{
+	INT32 offset;
+	const INT32 *list; // Big blockmap
+	line_t *ld;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return true;
+
+	offset = y*bmapwidth + x;
+
+	switch (P_BlockPolyLinesIterator(offset, func))
+	{
+		case BMIT_ABORT:
+			return false;
+		case BMIT_STOP:
+			return true;
+		default:
+			break;
+	}
+
 	offset = *(blockmap + offset); // offset = blockmap[y*bmapwidth+x];
 
 	// First index is really empty, so +1 it.
@@ -1347,6 +1340,230 @@ boolean P_BlockLinesIterator(INT32 x, INT32 y, BlockItReturn_t (*func)(line_t *)
 	return true; // Everything was checked.
 }
 
+//
+// Block line cache
+//
+// The lines of each block, packed next to each other with everything
+// needed to tell whether they touch a box, so that the lines a box
+// misses are thrown out without going anywhere near line_t. Polyobject
+// lines move, so they always go through to the callback.
+//
+
+#define LINECACHE_ALWAYS 0xFF // slopetype of lines that always reach the callback
+
+typedef struct
+{
+	INT32 *start; // first entry of each block, and one past the last
+	INT32 *line;
+	fixed_t *left, *right, *bottom, *top;
+	fixed_t *x, *y, *dx, *dy;
+	UINT8 *slopetype;
+} blocklinecache_t;
+
+static blocklinecache_t *blocklinecache;
+
+//
+// P_BuildBlockLineCache
+// Call once the blockmap is loaded and polyobjects are set up.
+//
+void P_BuildBlockLineCache(void)
+{
+	const INT32 numblocks = bmapwidth * bmapheight;
+	blocklinecache_t *cache;
+	const INT32 *list;
+	INT32 b, n = 0;
+
+	blocklinecache = NULL;
+
+	if (blockmap == NULL || numblocks <= 0)
+		return;
+
+	for (b = 0; b < numblocks; b++)
+		for (list = blockmaplump + blockmap[b] + 1; *list != -1; list++)
+			n++;
+
+	// Freeing the level sets blocklinecache back to NULL
+	cache = Z_Calloc(sizeof (*cache), PU_LEVEL, &blocklinecache);
+	cache->start = Z_Malloc(sizeof (*cache->start) * (numblocks + 1), PU_LEVEL, NULL);
+	cache->line = Z_Malloc(sizeof (*cache->line) * (n + 1), PU_LEVEL, NULL);
+	cache->left = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->right = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->bottom = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->top = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->x = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->y = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->dx = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->dy = Z_Malloc(sizeof (fixed_t) * (n + 1), PU_LEVEL, NULL);
+	cache->slopetype = Z_Malloc(n + 1, PU_LEVEL, NULL);
+
+	n = 0;
+	for (b = 0; b < numblocks; b++)
+	{
+		cache->start[b] = n;
+
+		for (list = blockmaplump + blockmap[b] + 1; *list != -1; list++, n++)
+		{
+			const line_t *ld = &lines[*list];
+
+			cache->line[n] = *list;
+
+			if (ld->polyobj)
+			{
+				cache->left[n] = cache->bottom[n] = INT32_MIN;
+				cache->right[n] = cache->top[n] = INT32_MAX;
+				cache->slopetype[n] = LINECACHE_ALWAYS;
+				continue;
+			}
+
+			cache->left[n] = ld->bbox[BOXLEFT];
+			cache->right[n] = ld->bbox[BOXRIGHT];
+			cache->bottom[n] = ld->bbox[BOXBOTTOM];
+			cache->top[n] = ld->bbox[BOXTOP];
+			cache->x[n] = ld->v1->x;
+			cache->y[n] = ld->v1->y;
+			cache->dx[n] = ld->dx;
+			cache->dy[n] = ld->dy;
+			cache->slopetype[n] = (UINT8)ld->slopetype;
+		}
+	}
+	cache->start[numblocks] = n;
+}
+
+// P_PointOnLineSide, on a cached line
+static inline INT32 P_PointOnCachedLineSide(fixed_t x, fixed_t y, const blocklinecache_t *cache, INT32 i)
+{
+	const fixed_t lx = cache->x[i], ly = cache->y[i], ldx = cache->dx[i], ldy = cache->dy[i];
+	return
+		!ldx ? x <= lx ? ldy > 0 : ldy < 0 :
+		!ldy ? y <= ly ? ldx < 0 : ldx > 0 :
+		((INT64)y - ly) * ldx >= ldy * ((INT64)x - lx);
+}
+
+// P_BoxOnLineSide(box, line) == -1, on a cached line
+static boolean P_BoxCrossesCachedLine(const fixed_t *box, const blocklinecache_t *cache, INT32 i)
+{
+	INT32 p;
+
+	switch (cache->slopetype[i])
+	{
+		case LINECACHE_ALWAYS:
+			return true;
+		default:
+		case ST_HORIZONTAL:
+			p = box[BOXTOP] > cache->y[i];
+			return (box[BOXBOTTOM] > cache->y[i]) != p;
+		case ST_VERTICAL:
+			p = box[BOXRIGHT] < cache->x[i];
+			return (box[BOXLEFT] < cache->x[i]) != p;
+		case ST_POSITIVE:
+			p = P_PointOnCachedLineSide(box[BOXLEFT], box[BOXTOP], cache, i);
+			return P_PointOnCachedLineSide(box[BOXRIGHT], box[BOXBOTTOM], cache, i) != p;
+		case ST_NEGATIVE:
+			p = P_PointOnCachedLineSide(box[BOXRIGHT], box[BOXTOP], cache, i);
+			return P_PointOnCachedLineSide(box[BOXLEFT], box[BOXBOTTOM], cache, i) != p;
+	}
+}
+
+//
+// P_BlockLinesIteratorBox
+// P_BlockLinesIterator, for callbacks that ignore any line that box
+// doesn't cross (bounding boxes overlapping, then P_BoxOnLineSide).
+// Those lines are skipped without being marked with validcount.
+//
+boolean P_BlockLinesIteratorBox(INT32 x, INT32 y, const fixed_t *box, BlockItReturn_t (*func)(line_t *))
+{
+	const blocklinecache_t *cache = blocklinecache;
+	INT32 offset, i, end;
+
+	if (cache == NULL)
+		return P_BlockLinesIterator(x, y, func);
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return true;
+
+	offset = y*bmapwidth + x;
+
+	switch (P_BlockPolyLinesIterator(offset, func))
+	{
+		case BMIT_ABORT:
+			return false;
+		case BMIT_STOP:
+			return true;
+		default:
+			break;
+	}
+
+	i = cache->start[offset];
+	end = cache->start[offset + 1];
+
+	while (i < end)
+	{
+		UINT32 mask;
+		INT32 count, k;
+
+#ifdef BLOCKLINECACHE_SSE2
+		if (end - i >= 4)
+		{
+			// box right > line left, line right > box left, and the same for y
+			const __m128i bleft = _mm_set1_epi32(box[BOXLEFT]);
+			const __m128i bright = _mm_set1_epi32(box[BOXRIGHT]);
+			const __m128i bbottom = _mm_set1_epi32(box[BOXBOTTOM]);
+			const __m128i btop = _mm_set1_epi32(box[BOXTOP]);
+			__m128i hit;
+
+			hit = _mm_cmpgt_epi32(bright, _mm_loadu_si128((const __m128i *)(cache->left + i)));
+			hit = _mm_and_si128(hit, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(cache->right + i)), bleft));
+			hit = _mm_and_si128(hit, _mm_cmpgt_epi32(btop, _mm_loadu_si128((const __m128i *)(cache->bottom + i))));
+			hit = _mm_and_si128(hit, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(cache->top + i)), bbottom));
+
+			mask = (UINT32)_mm_movemask_ps(_mm_castsi128_ps(hit));
+			count = 4;
+		}
+		else
+#endif
+		{
+			mask = (box[BOXRIGHT] > cache->left[i] && cache->right[i] > box[BOXLEFT]
+				&& box[BOXTOP] > cache->bottom[i] && cache->top[i] > box[BOXBOTTOM]);
+			count = 1;
+		}
+
+		for (k = 0; k < count; k++)
+		{
+			BlockItReturn_t ret;
+			line_t *ld;
+
+			if (!(mask & (1u << k)) || !P_BoxCrossesCachedLine(box, cache, i + k))
+				continue;
+
+			ld = &lines[cache->line[i + k]];
+
+			if (ld->validcount == validcount)
+				continue; // Line has already been checked.
+
+			ld->validcount = validcount;
+			ret = func(ld);
+
+			if (ret == BMIT_ABORT)
+			{
+				return false;
+			}
+			else if (ret == BMIT_STOP)
+			{
+				return true;
+			}
+
+			// The callback could have moved things,
+			// so test the rest of the batch again.
+			count = k + 1;
+			break;
+		}
+
+		i += count;
+	}
+
+	return true; // Everything was checked.
+}
+
 
 //
 // P_BlockThingsIterator
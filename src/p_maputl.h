@@ -55,9 +55,6 @@ void P_CameraLineOpening(line_t *plinedef, opening_t *open);
 fixed_t P_InterceptVector(const divline_t *v2, const divline_t *v1);
 INT32 P_BoxOnLineSide(const fixed_t *tmbox, const line_t *ld);
 line_t * P_FindNearestLine(const fixed_t x, const fixed_t y, const sector_t *, const INT32 special);
-void P_UnsetPrecipThingPosition(precipmobj_t *thing);
-void P_SetPrecipitationThingPosition(precipmobj_t *thing);
-void P_CreatePrecipSecNodeList(precipmobj_t *thing, fixed_t x,fixed_t y);
 void P_HitSpecialLines(mobj_t *thing, fixed_t x, fixed_t y, fixed_t momx, fixed_t momy);
 
 boolean P_GetMidtextureTopBottom(line_t *linedef, fixed_t x, fixed_t y, fixed_t *return_top, fixed_t *return_bottom);
@@ -88,6 +85,8 @@ typedef enum
 } BlockItReturn_t;
 
 boolean P_BlockLinesIterator(INT32 x, INT32 y, BlockItReturn_t(*func)(line_t *));
+boolean P_BlockLinesIteratorBox(INT32 x, INT32 y, const fixed_t *box, BlockItReturn_t(*func)(line_t *));
+void P_BuildBlockLineCache(void);
 boolean P_BlockThingsIterator(INT32 x, INT32 y, BlockItReturn_t(*func)(mobj_t *));
 
 #define PT_ADDLINES		(1)
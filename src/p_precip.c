@@ -0,0 +1,677 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_precip.c
+/// \brief Precipitation particles
+///
+/// Rain and snow used to be thousands of separately allocated mobjs, each
+/// stepped on its own as it was drawn. Nearly all of them are just falling, so
+/// a cell's worth of particles is now stepped at once, four at a time where
+/// SSE2 is available, and only the ones that land or change state take the
+/// long way round.
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "g_game.h"
+#include "info.h"
+#include "m_random.h"
+#include "p_local.h"
+#include "p_precip.h"
+#include "p_slopes.h"
+#include "p_tick.h"
+#include "r_main.h"
+#include "r_sky.h"
+#include "r_state.h"
+#include "z_zone.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PRECIP_SSE2
+#include <emmintrin.h>
+#endif
+
+precipsystem_t precip;
+
+//
+// P_ReservePrecip
+//
+// Makes room for n more particles.
+//
+static void P_ReservePrecip(UINT32 n)
+{
+	UINT32 capacity = precip.capacity;
+
+	if (precip.count + n <= capacity)
+		return;
+
+	if (capacity < 1024)
+		capacity = 1024;
+	while (capacity < precip.count + n)
+		capacity *= 2;
+
+#define GROW(field) precip.field = Z_Realloc(precip.field, capacity * sizeof (*precip.field), PU_LEVEL, &precip.field)
+	GROW(x);
+	GROW(y);
+	GROW(z);
+	GROW(old_z);
+	GROW(floorz);
+	GROW(ceilingz);
+	GROW(tics);
+	GROW(flags);
+	GROW(frame);
+	GROW(state);
+	GROW(anim_duration);
+	GROW(subsector);
+#undef GROW
+
+	precip.capacity = capacity;
+}
+
+void P_ClearPrecipitation(void)
+{
+#define FREE(field) if (precip.field) Z_Free(precip.field)
+	FREE(x);
+	FREE(y);
+	FREE(z);
+	FREE(old_z);
+	FREE(floorz);
+	FREE(ceilingz);
+	FREE(tics);
+	FREE(flags);
+	FREE(frame);
+	FREE(state);
+	FREE(anim_duration);
+	FREE(subsector);
+	FREE(cells);
+	FREE(sectorfirst);
+	FREE(sectorlist);
+#undef FREE
+
+	// The pointers were already cleared if they went with the last level
+	precip.count = precip.capacity = 0;
+}
+
+//
+// P_SetupPrecipAnimation
+//
+// Same as P_SetupStateAnimation, minus player sprites.
+//
+static void P_SetupPrecipAnimation(UINT32 i, const state_t *st)
+{
+	if (!(st->frame & FF_ANIMATE))
+		return;
+
+	if (st->var1 <= 0 || st->var2 == 0)
+	{
+		precip.frame[i] &= ~FF_ANIMATE;
+		return; // Crash/stupidity prevention
+	}
+
+	precip.anim_duration[i] = (UINT16)st->var2;
+
+	if (st->frame & FF_GLOBALANIM)
+	{
+		precip.anim_duration[i] -= (leveltime % st->var2);
+		precip.frame[i] += (leveltime / st->var2) % (st->var1 + 1);
+		if (!thinkersCompleted)
+			precip.anim_duration[i]++;
+	}
+	else if (st->frame & FF_RANDOMANIM)
+	{
+		precip.frame[i] += M_RandomKey(st->var1 + 1);
+		precip.anim_duration[i] -= M_RandomKey(st->var2);
+	}
+}
+
+//
+// P_CyclePrecipAnimation
+//
+// Same as P_CycleStateAnimation, minus player sprites.
+//
+static void P_CyclePrecipAnimation(UINT32 i)
+{
+	const state_t *st = &states[precip.state[i]];
+	const UINT8 start = st->frame & FF_FRAMEMASK;
+	UINT8 frame;
+
+	if (!(precip.frame[i] & FF_ANIMATE) || --precip.anim_duration[i] != 0)
+		return;
+
+	precip.anim_duration[i] = (UINT16)st->var2;
+
+	frame = precip.frame[i] & FF_FRAMEMASK;
+
+	if ((precip.frame[i] & FF_REVERSEANIM ? (start - (--frame)) : ((++frame) - start)) > st->var1)
+		frame = start;
+
+	precip.frame[i] = frame | (precip.frame[i] & ~FF_FRAMEMASK);
+}
+
+static boolean P_SetPrecipState(UINT32 i, statenum_t statenum)
+{
+	const state_t *st;
+
+	if (statenum == S_NULL)
+	{
+		precip.flags[i] |= PCF_REMOVED;
+		return false;
+	}
+
+	st = &states[statenum];
+	precip.state[i] = statenum;
+	precip.tics[i] = st->tics;
+	precip.frame[i] = st->frame;
+	P_SetupPrecipAnimation(i, st);
+
+	if (st->tics != -1 || (precip.frame[i] & FF_ANIMATE) || statenum == S_RAINRETURN)
+		precip.flags[i] |= PCF_TIMED;
+	else
+		precip.flags[i] &= ~PCF_TIMED;
+
+	return true;
+}
+
+static void P_CalculatePrecipFloor(UINT32 i)
+{
+	// recalculate floorz each time
+	const sector_t *mobjsecsubsec = precip.subsector[i]->sector;
+	const fixed_t x = precip.x[i];
+	const fixed_t y = precip.y[i];
+	boolean setWater = false;
+
+	precip.flags[i] &= ~PCF_INVISIBLE;
+	precip.floorz[i] = P_GetSectorFloorZAt(mobjsecsubsec, x, y);
+	precip.ceilingz[i] = P_GetSectorCeilingZAt(mobjsecsubsec, x, y);
+
+	if (mobjsecsubsec->ffloors)
+	{
+		ffloor_t *rover;
+		fixed_t height;
+
+		for (rover = mobjsecsubsec->ffloors; rover; rover = rover->next)
+		{
+			// If it exists, it'll get rained on.
+			if (!(rover->fofflags & FOF_EXISTS))
+				continue;
+
+			if (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES)
+			{
+				if (!(rover->fofflags & FOF_SWIMMABLE))
+					continue;
+
+				if (setWater == false)
+				{
+					precip.ceilingz[i] = P_GetFFloorTopZAt(rover, x, y);
+					precip.floorz[i] = P_GetFFloorBottomZAt(rover, x, y);
+					setWater = true;
+				}
+				else
+				{
+					height = P_GetFFloorTopZAt(rover, x, y);
+					if (height > precip.ceilingz[i])
+						precip.ceilingz[i] = height;
+
+					height = P_GetFFloorBottomZAt(rover, x, y);
+					if (height < precip.floorz[i])
+						precip.floorz[i] = height;
+				}
+			}
+			else
+			{
+				if (!(rover->fofflags & FOF_BLOCKOTHERS) && !(rover->fofflags & FOF_SWIMMABLE))
+					continue;
+
+				height = P_GetFFloorTopZAt(rover, x, y);
+				if (height > precip.floorz[i])
+					precip.floorz[i] = height;
+			}
+		}
+	}
+
+	if ((precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES) && setWater == false)
+	{
+		precip.flags[i] |= PCF_INVISIBLE;
+	}
+}
+
+void P_RecalcPrecipInSector(sector_t *sector)
+{
+	UINT32 k;
+	size_t s;
+
+	if (!sector)
+		return;
+
+	sector->moved = true; // Recalc lighting and things too, maybe
+
+	if (!precip.sectorfirst)
+		return;
+
+	s = sector - sectors;
+	for (k = precip.sectorfirst[s]; k < precip.sectorfirst[s + 1]; k++)
+		P_CalculatePrecipFloor(precip.sectorlist[k]);
+}
+
+//
+// P_PrecipStep
+//
+// Everything a particle can do in a tic, for the ones that
+// do more than fall.
+//
+static void P_PrecipStep(UINT32 i)
+{
+	const mobjinfo_t *info = &mobjinfo[precip.type];
+	const boolean flip = (precip.momz > 0);
+
+	if (precip.flags[i] & PCF_REMOVED)
+		return;
+
+	precip.old_z[i] = precip.z[i];
+	P_CyclePrecipAnimation(i);
+
+	if (precip.state[i] == S_RAINRETURN)
+	{
+		// Reset to ceiling!
+		if (!P_SetPrecipState(i, info->spawnstate))
+			return;
+
+		precip.z[i] = precip.old_z[i] = (flip) ? (precip.floorz[i]) : (precip.ceilingz[i]);
+		precip.flags[i] &= ~PCF_SPLASH;
+	}
+
+	if (precip.tics[i] != -1)
+	{
+		if (precip.tics[i])
+		{
+			precip.tics[i]--;
+		}
+
+		if (precip.tics[i] == 0)
+		{
+			const statenum_t next = states[precip.state[i]].nextstate;
+
+			if ((precip.flags[i] & PCF_SPLASH) && (next == S_NULL))
+			{
+				// HACK: sprite changes are 1 tic late, so you would see splashes on the ceiling if not for this state.
+				// We need to use the settings from the previous state, since some of those are NOT 1 tic late.
+				UINT32 frame = (precip.frame[i] & ~FF_FRAMEMASK);
+
+				if (!P_SetPrecipState(i, S_RAINRETURN))
+					return;
+
+				precip.frame[i] = frame;
+				return;
+			}
+			else
+			{
+				if (!P_SetPrecipState(i, next))
+					return;
+			}
+		}
+	}
+
+	if (precip.flags[i] & PCF_SPLASH)
+		return;
+
+	precip.z[i] += precip.momz;
+
+	// adjust height
+	if ((flip) ? (precip.z[i] >= precip.ceilingz[i]) : (precip.z[i] <= precip.floorz[i]))
+	{
+		if ((info->deathstate == S_NULL) || (precip.flags[i] & PCF_PIT)) // no splashes on sky or bottomless pits
+		{
+			precip.z[i] = precip.old_z[i] = (flip) ? (precip.floorz[i]) : (precip.ceilingz[i]);
+		}
+		else
+		{
+			if (!P_SetPrecipState(i, info->deathstate))
+				return;
+
+			precip.z[i] = precip.old_z[i] = (flip) ? (precip.ceilingz[i]) : (precip.floorz[i]);
+			precip.flags[i] |= PCF_SPLASH;
+		}
+	}
+}
+
+void P_PrecipThinkCell(precipcell_t *cell)
+{
+	const boolean flip = (precip.momz > 0);
+	const UINT32 end = cell->first + cell->count;
+	UINT32 i = cell->first;
+
+	if (cell->lastthink == leveltime)
+		return; // already thinked this tick
+
+	cell->lastthink = leveltime;
+
+#ifdef PRECIP_SSE2
+	{
+		const __m128i momz = _mm_set1_epi32(precip.momz);
+		const __m128i slow = _mm_set1_epi32(PCF_REMOVED|PCF_SPLASH|PCF_TIMED);
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 4 <= end; i += 4)
+		{
+			const __m128i z = _mm_loadu_si128((const __m128i *)&precip.z[i]);
+			const __m128i next = _mm_add_epi32(z, momz);
+			__m128i falling;
+			int mask, k;
+
+			_mm_storeu_si128((__m128i *)&precip.old_z[i], z);
+
+			// Lanes that don't land or change state this tic
+			falling = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i *)&precip.flags[i]), slow), zero);
+			if (flip)
+				falling = _mm_and_si128(falling, _mm_cmplt_epi32(next, _mm_loadu_si128((const __m128i *)&precip.ceilingz[i])));
+			else
+				falling = _mm_and_si128(falling, _mm_cmpgt_epi32(next, _mm_loadu_si128((const __m128i *)&precip.floorz[i])));
+
+			_mm_storeu_si128((__m128i *)&precip.z[i], _mm_or_si128(_mm_and_si128(falling, next), _mm_andnot_si128(falling, z)));
+
+			mask = _mm_movemask_ps(_mm_castsi128_ps(falling));
+			if (mask == 0xF)
+				continue;
+
+			for (k = 0; k < 4; k++)
+			{
+				if (!(mask & (1 << k)))
+					P_PrecipStep(i + k);
+			}
+		}
+	}
+#endif
+
+	for (; i < end; i++)
+	{
+		const fixed_t next = precip.z[i] + precip.momz;
+
+		if (!(precip.flags[i] & (PCF_REMOVED|PCF_SPLASH|PCF_TIMED))
+			&& ((flip) ? (next < precip.ceilingz[i]) : (next > precip.floorz[i])))
+		{
+			precip.old_z[i] = precip.z[i];
+			precip.z[i] = next;
+		}
+		else
+		{
+			P_PrecipStep(i);
+		}
+	}
+}
+
+static UINT32 P_SpawnPrecipParticle(fixed_t x, fixed_t y, fixed_t z, subsector_t *subsector)
+{
+	const mobjinfo_t *info = &mobjinfo[precip.type];
+	const sector_t *sector = subsector->sector;
+	const boolean flip = (precip.momz > 0);
+	fixed_t start_z;
+	UINT32 i;
+
+	P_ReservePrecip(1);
+	i = precip.count++;
+
+	precip.x[i] = x;
+	precip.y[i] = y;
+	precip.subsector[i] = subsector;
+	precip.flags[i] = 0;
+	precip.anim_duration[i] = 0;
+
+	P_SetPrecipState(i, info->spawnstate);
+
+	precip.floorz[i] = start_z = P_GetSectorFloorZAt(sector, x, y);
+	precip.ceilingz[i] = P_GetSectorCeilingZAt(sector, x, y);
+	precip.z[i] = precip.old_z[i] = z;
+
+	P_CalculatePrecipFloor(i);
+
+	if (precip.floorz[i] == start_z)
+	{
+		INT32 dmg = sector->damagetype;
+		boolean sFlag = (flip) ? (sector->flags & MSF_FLIPSPECIAL_CEILING) : (sector->flags & MSF_FLIPSPECIAL_FLOOR);
+		boolean pitFloor = ((dmg == SD_DEATHPIT) && sFlag);
+		boolean skyFloor = (flip) ? (sector->ceilingpic == skyflatnum) : (sector->floorpic == skyflatnum);
+
+		if (pitFloor || skyFloor)
+		{
+			precip.flags[i] |= PCF_PIT;
+		}
+	}
+
+	return i;
+}
+
+static void P_SpawnPrecipitationAt(fixed_t basex, fixed_t basey)
+{
+	INT32 j, k;
+
+	const mobjtype_t type = precip.type;
+	const UINT8 randomstates = (UINT8)mobjinfo[type].damage;
+	const boolean flip = (mobjinfo[type].speed < 0);
+
+	fixed_t i, x, y, z, height;
+
+	UINT16 numparticles = 0;
+	boolean condition = false;
+
+	subsector_t *precipsector = NULL;
+	UINT32 rainmo;
+
+	// If mobjscale < FRACUNIT, each blockmap cell covers
+	// more area so spawn more precipitation in that area.
+	for (i = 0; i < FRACUNIT; i += mapobjectscale)
+	{
+		x = basex + ((M_RandomKey(MAPBLOCKUNITS << 3) << FRACBITS) >> 3);
+		y = basey + ((M_RandomKey(MAPBLOCKUNITS << 3) << FRACBITS) >> 3);
+
+		precipsector = R_PointInSubsectorOrNull(x, y);
+
+		// No sector? Stop wasting time,
+		// move on to the next entry in the blockmap
+		if (!precipsector)
+			continue;
+
+		// Not in a sector with visible sky?
+		if (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES)
+		{
+			condition = false;
+
+			if (precipsector->sector->ffloors)
+			{
+				ffloor_t *rover;
+
+				for (rover = precipsector->sector->ffloors; rover; rover = rover->next)
+				{
+					if (!(rover->fofflags & FOF_EXISTS))
+						continue;
+
+					if (!(rover->fofflags & FOF_SWIMMABLE))
+						continue;
+
+					condition = true;
+					break;
+				}
+			}
+		}
+		else
+		{
+			condition = (precipsector->sector->ceilingpic == skyflatnum);
+		}
+
+		if (precipsector->sector->flags & MSF_INVERTPRECIP)
+		{
+			condition = !condition;
+		}
+
+		if (!condition)
+		{
+			continue;
+		}
+
+		height = precipsector->sector->ceilingheight - precipsector->sector->floorheight;
+		height = FixedDiv(height, mapobjectscale);
+
+		// Exists, but is too small for reasonable precipitation.
+		if (height < 64<<FRACBITS)
+			continue;
+
+		// Hack around a quirk of this entire system, where taller sectors look like they get less precipitation.
+		numparticles = 1 + (height / (MAPBLOCKUNITS<<4<<FRACBITS));
+
+		// Don't set z properly yet...
+		z = (flip) ? (precipsector->sector->floorheight) : (precipsector->sector->ceilingheight);
+
+		for (j = 0; j < numparticles; j++)
+		{
+			INT32 floorz;
+			INT32 ceilingz;
+
+			rainmo = P_SpawnPrecipParticle(x, y, z, precipsector);
+
+			if (randomstates > 0)
+			{
+				UINT8 mrand = M_RandomByte();
+				UINT8 threshold = UINT8_MAX / (randomstates + 1);
+				statenum_t st = mobjinfo[type].spawnstate;
+
+				for (k = 0; k < randomstates; k++)
+				{
+					if (mrand < (threshold * (k+1)))
+					{
+						P_SetPrecipState(rainmo, st+k+1);
+						break;
+					}
+				}
+			}
+
+			floorz = precip.floorz[rainmo] >> FRACBITS;
+			ceilingz = precip.ceilingz[rainmo] >> FRACBITS;
+
+			if (floorz < ceilingz)
+			{
+				// Randomly assign a height, now that floorz is set.
+				precip.z[rainmo] = M_RandomRange(floorz, ceilingz) << FRACBITS;
+			}
+			else
+			{
+				// ...except if the floor is above the ceiling.
+				precip.z[rainmo] = ceilingz << FRACBITS;
+			}
+
+			precip.old_z[rainmo] = precip.z[rainmo];
+		}
+	}
+}
+
+//
+// P_IndexPrecipBySector
+//
+// Particles never leave their sector, so which ones are in each
+// only needs working out once.
+//
+static void P_IndexPrecipBySector(void)
+{
+	UINT32 i;
+	size_t s;
+
+	precip.sectorfirst = Z_Calloc((numsectors + 1) * sizeof (*precip.sectorfirst), PU_LEVEL, &precip.sectorfirst);
+
+	if (precip.count == 0)
+		return;
+
+	precip.sectorlist = Z_Malloc(precip.count * sizeof (*precip.sectorlist), PU_LEVEL, &precip.sectorlist);
+
+	for (i = 0; i < precip.count; i++)
+		precip.sectorfirst[(precip.subsector[i]->sector - sectors) + 1]++;
+
+	for (s = 0; s < numsectors; s++)
+		precip.sectorfirst[s + 1] += precip.sectorfirst[s];
+
+	// Fill each sector from its end, leaving sectorfirst at the start
+	for (i = precip.count; i-- > 0;)
+	{
+		s = precip.subsector[i]->sector - sectors;
+		precip.sectorlist[--precip.sectorfirst[s + 1]] = i;
+	}
+
+	for (s = 0; s < numsectors; s++)
+		precip.sectorfirst[s] = precip.sectorfirst[s + 1];
+	precip.sectorfirst[numsectors] = precip.count;
+}
+
+void P_SpawnPrecipitation(void)
+{
+	INT32 i;
+
+	const mobjtype_t type = precipprops[curWeather].type;
+
+	fixed_t basex, basey;
+
+	P_ClearPrecipitation();
+
+	if (dedicated || !cv_drawdist_precip.value || type == MT_NULL)
+		return;
+
+	precip.type = type;
+	precip.momz = FixedMul(-mobjinfo[type].speed, mapobjectscale);
+	precip.cells = Z_Calloc(bmapwidth * bmapheight * sizeof (*precip.cells), PU_LEVEL, &precip.cells);
+
+	// Use the blockmap to narrow down our placing patterns
+	for (i = 0; i < bmapwidth*bmapheight; ++i)
+	{
+		basex = bmaporgx + (i % bmapwidth) * MAPBLOCKSIZE;
+		basey = bmaporgy + (i / bmapwidth) * MAPBLOCKSIZE;
+
+		precip.cells[i].first = precip.count;
+		P_SpawnPrecipitationAt(basex, basey);
+		precip.cells[i].count = precip.count - precip.cells[i].first;
+	}
+
+	P_IndexPrecipBySector();
+}
+
+void P_ChangePrecipitationType(mobjtype_t type, boolean recalcfloors)
+{
+	const UINT8 randomstates = (UINT8)mobjinfo[type].damage;
+	UINT32 i;
+
+	if (!precip.cells)
+		return;
+
+	precip.type = type;
+	precip.momz = FixedMul(-mobjinfo[type].speed, mapobjectscale);
+
+	for (i = 0; i < precip.count; i++)
+	{
+		statenum_t st = mobjinfo[type].spawnstate;
+
+		if (precip.flags[i] & PCF_REMOVED)
+			continue;
+
+		if (randomstates > 0)
+		{
+			UINT8 mrand = M_RandomByte();
+			UINT8 threshold = UINT8_MAX / (randomstates + 1);
+			UINT8 k;
+
+			for (k = 0; k < randomstates; k++)
+			{
+				if (mrand < (threshold * (k+1)))
+				{
+					st += k+1;
+					break;
+				}
+			}
+		}
+
+		precip.flags[i] &= ~(PCF_INVISIBLE|PCF_SPLASH);
+		P_SetPrecipState(i, st);
+
+		if (recalcfloors)
+		{
+			P_CalculatePrecipFloor(i);
+		}
+	}
+}
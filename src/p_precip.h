@@ -0,0 +1,87 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_precip.h
+/// \brief Precipitation particles
+
+#ifndef __P_PRECIP_H__
+#define __P_PRECIP_H__
+
+#include "doomtype.h"
+#include "info.h"
+#include "m_fixed.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// PRECIPITATION flags ?! ?! ?!
+//
+typedef enum {
+	PCF_REMOVED		= 1,		// Went to S_NULL, never stepped or drawn again.
+	PCF_SPLASH		= 1<<1,		// Splashed on the ground, return to the ceiling after the animation's over
+	PCF_INVISIBLE	= 1<<2,		// Don't draw.
+	PCF_PIT			= 1<<3,		// Above pit.
+	PCF_TIMED		= 1<<4,		// State ticks down or animates, so it can't just fall this tic.
+} precipflag_t;
+
+// The particles of one blockmap cell, which are stepped together the first
+// time the cell is drawn in a tic.
+struct precipcell_t
+{
+	UINT32 first; // index of its first particle
+	UINT32 count;
+	tic_t lastthink;
+};
+
+// Weather isn't networked, and particles never leave the blockmap cell they
+// were spawned in, so they're kept structure-of-arrays grouped by cell rather
+// than as thinkers.
+struct precipsystem_t
+{
+	UINT32 count;
+	UINT32 capacity;
+
+	// Particles only ever move vertically
+	fixed_t *x, *y;
+	fixed_t *z, *old_z;
+	fixed_t *floorz, *ceilingz;
+	INT32 *tics;
+	INT32 *flags; // precipflag_t
+	UINT32 *frame;
+	statenum_t *state;
+	UINT16 *anim_duration;
+	subsector_t **subsector;
+
+	precipcell_t *cells; // bmapwidth*bmapheight, NULL if there is no weather
+
+	// Particles by sector, for P_RecalcPrecipInSector
+	UINT32 *sectorfirst; // numsectors + 1
+	UINT32 *sectorlist;
+
+	mobjtype_t type;
+	fixed_t momz; // All of them fall at the same speed; upwards if positive
+};
+
+extern precipsystem_t precip;
+
+void P_SpawnPrecipitation(void);
+void P_ClearPrecipitation(void);
+
+// Reuses the existing particles for a different type of weather.
+void P_ChangePrecipitationType(mobjtype_t type, boolean recalcfloors);
+
+// Steps every particle in the cell, once per tic.
+void P_PrecipThinkCell(precipcell_t *cell);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __P_PRECIP_H__
@@ -0,0 +1,386 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_reject.cpp
+/// \brief Generated REJECT matrix for maps without one
+
+#include "p_reject.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+#include <tracy/tracy/Tracy.hpp>
+
+#include "core/thread_pool.h"
+
+using namespace srb2;
+
+namespace
+{
+
+// Slack on every clip, in map units. It only ever lets more through, so that rounding can't reject a pair that
+// can just barely see each other.
+constexpr double kSlack = 1.0;
+
+// Anything shorter than this stops being a way through.
+constexpr double kMinLength = 1.0 / 64.0;
+
+// Past these, a sector falls back to seeing everything it's connected to.
+constexpr uint32_t kMaxSteps = 1 << 14;
+constexpr uint32_t kMaxDepth = 256;
+
+// The matrix is a bit per pair; don't bother past 8 MB.
+constexpr uint32_t kMaxSectors = 8192;
+
+struct Vec2
+{
+	double x;
+	double y;
+};
+
+struct Seg
+{
+	Vec2 a;
+	Vec2 b;
+};
+
+/// One way through a line. The sector it leads to is on the left of a -> b.
+struct Portal
+{
+	Seg seg;
+	uint32_t to;
+	uint32_t line;
+};
+
+double length(const Vec2& a, const Vec2& b)
+{
+	return std::hypot(b.x - a.x, b.y - a.y);
+}
+
+/// @return distance of p from the line through a and b, positive on the left
+double side(const Vec2& a, const Vec2& b, const Vec2& p)
+{
+	const double dx = b.x - a.x;
+	const double dy = b.y - a.y;
+	return (dx * (p.y - a.y) - dy * (p.x - a.x)) / std::hypot(dx, dy);
+}
+
+/// Cuts s down to the part on the given side of the line through a and b.
+/// @return false if nothing is left
+bool clip(Seg& s, const Vec2& a, const Vec2& b, double sign)
+{
+	const double d0 = sign * side(a, b, s.a) + kSlack;
+	const double d1 = sign * side(a, b, s.b) + kSlack;
+
+	if (d0 < 0.0 && d1 < 0.0)
+	{
+		return false;
+	}
+
+	if (d0 < 0.0 || d1 < 0.0)
+	{
+		const double t = d0 / (d0 - d1);
+		const Vec2 cut = {s.a.x + (s.b.x - s.a.x) * t, s.a.y + (s.b.y - s.a.y) * t};
+		(d0 < 0.0 ? s.a : s.b) = cut;
+	}
+
+	return length(s.a, s.b) >= kMinLength;
+}
+
+/// Cuts s down to the part that can be seen from source through pass, s and source being on opposite sides of pass.
+/// The bounds are the lines through an end of each that have source and pass on opposite sides.
+bool clip_to_separators(Seg& s, const Seg& source, const Seg& pass)
+{
+	const Vec2 src[2] = {source.a, source.b};
+	const Vec2 pas[2] = {pass.a, pass.b};
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			const Vec2& a = src[i];
+			const Vec2& b = pas[j];
+
+			if (length(a, b) < kMinLength)
+			{
+				continue;
+			}
+
+			const double ds = side(a, b, src[i ^ 1]);
+			const double dp = side(a, b, pas[j ^ 1]);
+
+			if (ds > kSlack && dp < -kSlack)
+			{
+				if (!clip(s, a, b, -1.0))
+				{
+					return false;
+				}
+			}
+			else if (ds < -kSlack && dp > kSlack)
+			{
+				if (!clip(s, a, b, 1.0))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+struct RejectBuilder::State
+{
+	uint32_t num_sectors = 0;
+	uint32_t num_lines = 0;
+	std::vector<Portal> portals; // grouped by the sector they lead out of
+	std::vector<uint32_t> first; // num_sectors + 1
+	std::size_t words = 0; // per row of visible
+	std::vector<uint64_t> visible;
+
+	std::atomic<uint32_t> next_sector {0};
+	std::mutex mutex;
+	std::condition_variable cond;
+	uint32_t jobs_running = 0;
+
+	void run();
+	void flow_from(uint32_t sector, std::vector<uint8_t>& on_path, std::vector<uint32_t>& stack);
+};
+
+namespace
+{
+
+struct Flow
+{
+	const std::vector<Portal>& portals;
+	const std::vector<uint32_t>& first;
+	uint64_t* row;
+	std::vector<uint8_t>& on_path;
+	uint32_t steps = 0;
+	bool overflow = false;
+
+	void mark(uint32_t sector) { row[sector >> 6] |= uint64_t {1} << (sector & 63); }
+
+	void recurse(uint32_t sector, const Seg& source, const Seg& pass, uint32_t depth)
+	{
+		if (++steps > kMaxSteps || depth > kMaxDepth)
+		{
+			overflow = true;
+			return;
+		}
+
+		for (uint32_t k = first[sector]; k < first[sector + 1]; k++)
+		{
+			const Portal& q = portals[k];
+
+			// A straight line crosses each line once at most
+			if (on_path[q.line])
+			{
+				continue;
+			}
+
+			// Beyond the pass, and within what the source can see through it
+			Seg target = q.seg;
+			if (!clip(target, pass.a, pass.b, 1.0) || !clip_to_separators(target, source, pass))
+			{
+				continue;
+			}
+
+			mark(q.to);
+
+			// Only the part of the source that can see the target matters past here
+			Seg narrowed = source;
+			if (!clip(narrowed, pass.a, pass.b, -1.0) || !clip_to_separators(narrowed, target, pass))
+			{
+				continue;
+			}
+
+			on_path[q.line] = 1;
+			recurse(q.to, narrowed, target, depth + 1);
+			on_path[q.line] = 0;
+
+			if (overflow)
+			{
+				return;
+			}
+		}
+	}
+};
+
+} // namespace
+
+void RejectBuilder::State::flow_from(uint32_t sector, std::vector<uint8_t>& on_path, std::vector<uint32_t>& stack)
+{
+	uint64_t* row = &visible[sector * words];
+	Flow flow {portals, first, row, on_path};
+
+	flow.mark(sector);
+
+	for (uint32_t k = first[sector]; k < first[sector + 1] && !flow.overflow; k++)
+	{
+		const Portal& p = portals[k];
+
+		flow.mark(p.to);
+		on_path[p.line] = 1;
+		flow.recurse(p.to, p.seg, p.seg, 0);
+		on_path[p.line] = 0;
+	}
+
+	if (!flow.overflow)
+	{
+		return;
+	}
+
+	// Too complicated to work out; see everything that's connected at all
+	std::fill(on_path.begin(), on_path.end(), 0);
+	std::fill(row, row + words, 0);
+	flow.mark(sector);
+	stack.assign(1, sector);
+
+	while (!stack.empty())
+	{
+		const uint32_t cur = stack.back();
+		stack.pop_back();
+
+		for (uint32_t k = first[cur]; k < first[cur + 1]; k++)
+		{
+			const uint32_t to = portals[k].to;
+			if (!(row[to >> 6] & (uint64_t {1} << (to & 63))))
+			{
+				flow.mark(to);
+				stack.push_back(to);
+			}
+		}
+	}
+}
+
+void RejectBuilder::State::run()
+{
+	ZoneScoped;
+
+	std::vector<uint8_t> on_path(num_lines);
+	std::vector<uint32_t> stack;
+
+	for (uint32_t sector = next_sector++; sector < num_sectors; sector = next_sector++)
+	{
+		flow_from(sector, on_path, stack);
+	}
+
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		jobs_running--;
+	}
+	cond.notify_all();
+}
+
+RejectBuilder::RejectBuilder(uint32_t num_sectors, std::vector<Line> lines) : state_(std::make_shared<State>())
+{
+	State& state = *state_;
+
+	if (num_sectors == 0 || num_sectors > kMaxSectors)
+	{
+		return;
+	}
+
+	state.num_sectors = num_sectors;
+	state.num_lines = static_cast<uint32_t>(lines.size());
+	state.words = (num_sectors + 63) / 64;
+	state.visible.resize(state.words * num_sectors);
+
+	// Two portals per line, one each way, grouped by the sector they leave
+	state.first.assign(num_sectors + 1, 0);
+	for (const Line& line : lines)
+	{
+		state.first[line.front + 1]++;
+		state.first[line.back + 1]++;
+	}
+	for (uint32_t i = 0; i < num_sectors; i++)
+	{
+		state.first[i + 1] += state.first[i];
+	}
+
+	std::vector<uint32_t> fill(state.first.begin(), state.first.end() - 1);
+	state.portals.resize(lines.size() * 2);
+	for (uint32_t i = 0; i < lines.size(); i++)
+	{
+		const Line& line = lines[i];
+		const Vec2 v1 = {line.x1, line.y1};
+		const Vec2 v2 = {line.x2, line.y2};
+
+		// The back sector is on the left of v1 -> v2
+		state.portals[fill[line.front]++] = {{v1, v2}, line.back, i};
+		state.portals[fill[line.back]++] = {{v2, v1}, line.front, i};
+	}
+
+	if (!g_main_threadpool)
+	{
+		state.jobs_running = 1;
+		state.run();
+		return;
+	}
+
+	// These run for most of the level load; leave a worker free for
+	// everything else scheduled meanwhile.
+	const std::size_t workers = g_main_threadpool->size();
+	const uint32_t jobs = static_cast<uint32_t>(std::max<std::size_t>(1, std::min<std::size_t>(workers > 1 ? workers - 1 : 1, num_sectors)));
+	state.jobs_running = jobs;
+	for (uint32_t i = 0; i < jobs; i++)
+	{
+		g_main_threadpool->schedule([state = state_]() { state->run(); });
+	}
+	g_main_threadpool->notify();
+}
+
+RejectBuilder::~RejectBuilder() = default;
+
+std::vector<uint8_t> RejectBuilder::join()
+{
+	ZoneScoped;
+
+	State& state = *state_;
+	std::vector<uint8_t> matrix;
+
+	if (state.num_sectors == 0)
+	{
+		return matrix;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(state.mutex);
+		state.cond.wait(lock, [&state] { return state.jobs_running == 0; });
+	}
+
+	const uint32_t n = state.num_sectors;
+	const std::size_t words = state.words;
+	auto seen = [&state, words](uint32_t from, uint32_t to)
+	{
+		return (state.visible[from * words + (to >> 6)] >> (to & 63)) & 1;
+	};
+
+	matrix.resize((static_cast<std::size_t>(n) * n + 7) / 8);
+	for (uint32_t a = 0; a < n; a++)
+	{
+		for (uint32_t b = 0; b < n; b++)
+		{
+			// Either side finding a way through is enough
+			if (!seen(a, b) && !seen(b, a))
+			{
+				const std::size_t bit = static_cast<std::size_t>(a) * n + b;
+				matrix[bit >> 3] |= 1 << (bit & 7);
+			}
+		}
+	}
+
+	return matrix;
+}
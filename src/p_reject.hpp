@@ -0,0 +1,61 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_reject.hpp
+/// \brief Generated REJECT matrix for maps without one
+
+#ifndef __P_REJECT_HPP__
+#define __P_REJECT_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace srb2
+{
+
+/// Builds a sector-to-sector REJECT matrix in the background, from the lines that join two sectors.
+///
+/// A sector pair is only rejected when no straight line can get from one to the other through a chain of those
+/// lines, ignoring heights. Every sight and trace check already stops at lines that don't have a sector on both
+/// sides, so the matrix can only ever skip checks that would have failed anyway. Sectors whose visibility takes
+/// too long to work out are treated as seeing everything they are connected to.
+class RejectBuilder
+{
+public:
+	/// A line with a sector on both sides, in map units.
+	struct Line
+	{
+		uint32_t front;
+		uint32_t back;
+		double x1;
+		double y1;
+		double x2;
+		double y2;
+	};
+
+private:
+	struct State;
+
+	std::shared_ptr<State> state_;
+
+public:
+	/// Starts building right away, on the main thread pool if there is one.
+	RejectBuilder(uint32_t num_sectors, std::vector<Line> lines);
+	RejectBuilder(const RejectBuilder&) = delete;
+	RejectBuilder& operator=(const RejectBuilder&) = delete;
+	~RejectBuilder();
+
+	/// Waits for the build to finish.
+	/// @return the matrix in REJECT lump layout, or an empty vector if the map is too big for one
+	std::vector<uint8_t> join();
+};
+
+} // namespace srb2
+
+#endif // __P_REJECT_HPP__
@@ -52,6 +52,8 @@
 
 #include <tracy/tracy/TracyC.h>
 
+#include "core/thread_pool.h"
+
 savedata_t savedata;
 savedata_cup_t cupsavedata;
 
@@ -4001,6 +4003,319 @@ static void WriteMobjPointer(mobj_t *mobj)
 	WRITEUINT32(current_savebuffer->p, SaveMobjnum(mobj));
 }
 
+static void P_NetArchiveThinker(savebuffer_t *save, const thinker_t *th)
+{
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	{
+		SaveMobjThinker(save, th, tc_mobj);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
+	{
+		SaveCeilingThinker(save, th, tc_ceiling);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_CrushCeiling)
+	{
+		SaveCeilingThinker(save, th, tc_crushceiling);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MoveFloor)
+	{
+		SaveFloormoveThinker(save, th, tc_floor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_LightningFlash)
+	{
+		SaveLightflashThinker(save, th, tc_flash);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
+	{
+		SaveStrobeThinker(save, th, tc_strobe);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Glow)
+	{
+		SaveGlowThinker(save, th, tc_glow);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_FireFlicker)
+	{
+		SaveFireflickerThinker(save, th, tc_fireflicker);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MoveElevator)
+	{
+		SaveElevatorThinker(save, th, tc_elevator);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_ContinuousFalling)
+	{
+		SaveContinuousFallThinker(save, th, tc_continuousfalling);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_ThwompSector)
+	{
+		SaveThwompThinker(save, th, tc_thwomp);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_NoEnemiesSector)
+	{
+		SaveNoEnemiesThinker(save, th, tc_noenemies);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_EachTimeThinker)
+	{
+		SaveEachTimeThinker(save, th, tc_eachtime);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_RaiseSector)
+	{
+		SaveRaiseThinker(save, th, tc_raisesector);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_CameraScanner)
+	{
+		SaveElevatorThinker(save, th, tc_camerascanner);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Scroll)
+	{
+		SaveScrollThinker(save, th, tc_scroll);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Friction)
+	{
+		SaveFrictionThinker(save, th, tc_friction);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Pusher)
+	{
+		SavePusherThinker(save, th, tc_pusher);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_BounceCheese)
+	{
+		SaveBounceCheeseThinker(save, th, tc_bouncecheese);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_StartCrumble)
+	{
+		SaveCrumbleThinker(save, th, tc_startcrumble);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MarioBlock)
+	{
+		SaveMarioBlockThinker(save, th, tc_marioblock);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MarioBlockChecker)
+	{
+		SaveMarioCheckThinker(save, th, tc_marioblockchecker);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_FloatSector)
+	{
+		SaveFloatThinker(save, th, tc_floatsector);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_LaserFlash)
+	{
+		SaveLaserThinker(save, th, tc_laserflash);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_LightFade)
+	{
+		SaveLightlevelThinker(save, th, tc_lightfade);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_ExecutorDelay)
+	{
+		SaveExecutorThinker(save, th, tc_executor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Disappear)
+	{
+		SaveDisappearThinker(save, th, tc_disappear);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Fade)
+	{
+		SaveFadeThinker(save, th, tc_fade);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_FadeColormap)
+	{
+		SaveFadeColormapThinker(save, th, tc_fadecolormap);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PlaneDisplace)
+	{
+		SavePlaneDisplaceThinker(save, th, tc_planedisplace);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjRotate)
+	{
+		SavePolyrotatetThinker(save, th, tc_polyrotate);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjMove)
+	{
+		SavePolymoveThinker(save, th, tc_polymove);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjWaypoint)
+	{
+		SavePolywaypointThinker(save, th, tc_polywaypoint);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyDoorSlide)
+	{
+		SavePolyslidedoorThinker(save, th, tc_polyslidedoor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyDoorSwing)
+	{
+		SavePolyswingdoorThinker(save, th, tc_polyswingdoor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjFlag)
+	{
+		SavePolymoveThinker(save, th, tc_polyflag);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjDisplace)
+	{
+		SavePolydisplaceThinker(save, th, tc_polydisplace);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjRotDisplace)
+	{
+		SavePolyrotdisplaceThinker(save, th, tc_polyrotdisplace);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjFade)
+	{
+		SavePolyfadeThinker(save, th, tc_polyfade);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeLine)
+	{
+		SaveDynamicLineSlopeThinker(save, th, tc_dynslopeline);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeVert)
+	{
+		SaveDynamicVertexSlopeThinker(save, th, tc_dynslopevert);
+		return;
+	}
+#ifdef PARANOIA
+	else
+		I_Assert(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed); // wait garbage collection
+#endif
+}
+
+// Mobjs are most of a netsave, so they're written on the thread pool while the main
+// thread gets on with everything that comes before them, and copied in afterwards.
+// Each job takes a run of the list and is given as much room as the whole save has left.
+#define MOBJSPERJOB 512
+#define MAXMOBJJOBS 8
+
+static struct
+{
+	const thinker_t **thinkers;
+	size_t numthinkers, maxthinkers;
+	UINT8 *buffers;
+	size_t bufsize, maxbuffers;
+	size_t lengths[MAXMOBJJOBS];
+	size_t numjobs;
+	srb2tpbatch_t *batch;
+} mobjarchive;
+
+static void P_ArchiveMobjJob(void *data, size_t job)
+{
+	TracyCZone(__zone, true);
+
+	const thinker_t **thinkers = mobjarchive.thinkers;
+	size_t start = mobjarchive.numthinkers * job / mobjarchive.numjobs;
+	size_t end = mobjarchive.numthinkers * (job + 1) / mobjarchive.numjobs;
+	savebuffer_t save;
+
+	(void)data;
+
+	save.buffer = save.p = mobjarchive.buffers + job * mobjarchive.bufsize;
+	save.size = mobjarchive.bufsize;
+	save.end = save.buffer + save.size;
+
+	for (; start < end; start++)
+		P_NetArchiveThinker(&save, thinkers[start]);
+
+	mobjarchive.lengths[job] = save.p - save.buffer;
+
+	TracyCZoneEnd(__zone);
+}
+
+// Needs every mobjnum assigned first.
+static void P_StartArchivingMobjs(const savebuffer_t *save)
+{
+	const thinker_t *th;
+	size_t n = 0;
+
+	mobjarchive.batch = NULL;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+		n++;
+
+	mobjarchive.numjobs = min(n / MOBJSPERJOB, MAXMOBJJOBS);
+	if (mobjarchive.numjobs < 2)
+		return; // not worth it
+
+	if (n > mobjarchive.maxthinkers)
+	{
+		mobjarchive.thinkers = Z_Realloc(mobjarchive.thinkers, n * sizeof (*mobjarchive.thinkers), PU_STATIC, NULL);
+		mobjarchive.maxthinkers = n;
+	}
+
+	mobjarchive.numthinkers = 0;
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+		mobjarchive.thinkers[mobjarchive.numthinkers++] = th;
+
+	mobjarchive.bufsize = P_SaveBufferRemaining(save);
+	if (mobjarchive.numjobs * mobjarchive.bufsize > mobjarchive.maxbuffers)
+	{
+		mobjarchive.maxbuffers = mobjarchive.numjobs * mobjarchive.bufsize;
+		mobjarchive.buffers = Z_Realloc(mobjarchive.buffers, mobjarchive.maxbuffers, PU_STATIC, NULL);
+	}
+
+	mobjarchive.batch = I_ThreadPoolStartBatch(P_ArchiveMobjJob, NULL, mobjarchive.numjobs);
+}
+
+// Copies the mobjs in, in list order.
+// Returns how many thinkers there were, not counting removed ones.
+static UINT32 P_FinishArchivingMobjs(savebuffer_t *save)
+{
+	UINT32 numsaved = 0;
+	size_t i;
+
+	I_ThreadPoolFinishBatch(mobjarchive.batch);
+	mobjarchive.batch = NULL;
+
+	for (i = 0; i < mobjarchive.numjobs; i++)
+	{
+		M_Memcpy(save->p, mobjarchive.buffers + i * mobjarchive.bufsize, mobjarchive.lengths[i]);
+		save->p += mobjarchive.lengths[i];
+	}
+
+	for (i = 0; i < mobjarchive.numthinkers; i++)
+	{
+		if (mobjarchive.thinkers[i]->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
+			numsaved++;
+	}
+
+	return numsaved;
+}
+
 static void P_NetArchiveThinkers(savebuffer_t *save)
 {
 	TracyCZone(__zone, true);
@@ -4015,225 +4330,22 @@ static void P_NetArchiveThinkers(savebuffer_t *save)
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
 		UINT32 numsaved = 0;
+
+		if (i == THINK_MOBJ && mobjarchive.batch)
+		{
+			numsaved = P_FinishArchivingMobjs(save);
+			CONS_Debug(DBG_NETPLAY, "%u thinkers saved in list %d\n", numsaved, i);
+			WRITEUINT8(save->p, tc_end);
+			continue;
+		}
+
 		// save off the current thinkers
 		for (th = thlist[i].next; th != &thlist[i]; th = th->next)
 		{
-			if (!(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
-			 || th->function.acp1 == (actionf_p1)P_NullPrecipThinker))
+			if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
 				numsaved++;
 
-			if (th->function.acp1 == (actionf_p1)P_MobjThinker)
-			{
-				SaveMobjThinker(save, th, tc_mobj);
-				continue;
-			}
-	#ifdef PARANOIA
-			else if (th->function.acp1 == (actionf_p1)P_NullPrecipThinker);
-	#endif
-			else if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
-			{
-				SaveCeilingThinker(save, th, tc_ceiling);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_CrushCeiling)
-			{
-				SaveCeilingThinker(save, th, tc_crushceiling);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MoveFloor)
-			{
-				SaveFloormoveThinker(save, th, tc_floor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_LightningFlash)
-			{
-				SaveLightflashThinker(save, th, tc_flash);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
-			{
-				SaveStrobeThinker(save, th, tc_strobe);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Glow)
-			{
-				SaveGlowThinker(save, th, tc_glow);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_FireFlicker)
-			{
-				SaveFireflickerThinker(save, th, tc_fireflicker);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MoveElevator)
-			{
-				SaveElevatorThinker(save, th, tc_elevator);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_ContinuousFalling)
-			{
-				SaveContinuousFallThinker(save, th, tc_continuousfalling);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_ThwompSector)
-			{
-				SaveThwompThinker(save, th, tc_thwomp);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_NoEnemiesSector)
-			{
-				SaveNoEnemiesThinker(save, th, tc_noenemies);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_EachTimeThinker)
-			{
-				SaveEachTimeThinker(save, th, tc_eachtime);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_RaiseSector)
-			{
-				SaveRaiseThinker(save, th, tc_raisesector);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_CameraScanner)
-			{
-				SaveElevatorThinker(save, th, tc_camerascanner);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Scroll)
-			{
-				SaveScrollThinker(save, th, tc_scroll);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Friction)
-			{
-				SaveFrictionThinker(save, th, tc_friction);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Pusher)
-			{
-				SavePusherThinker(save, th, tc_pusher);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_BounceCheese)
-			{
-				SaveBounceCheeseThinker(save, th, tc_bouncecheese);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_StartCrumble)
-			{
-				SaveCrumbleThinker(save, th, tc_startcrumble);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MarioBlock)
-			{
-				SaveMarioBlockThinker(save, th, tc_marioblock);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MarioBlockChecker)
-			{
-				SaveMarioCheckThinker(save, th, tc_marioblockchecker);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_FloatSector)
-			{
-				SaveFloatThinker(save, th, tc_floatsector);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_LaserFlash)
-			{
-				SaveLaserThinker(save, th, tc_laserflash);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_LightFade)
-			{
-				SaveLightlevelThinker(save, th, tc_lightfade);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_ExecutorDelay)
-			{
-				SaveExecutorThinker(save, th, tc_executor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Disappear)
-			{
-				SaveDisappearThinker(save, th, tc_disappear);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Fade)
-			{
-				SaveFadeThinker(save, th, tc_fade);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_FadeColormap)
-			{
-				SaveFadeColormapThinker(save, th, tc_fadecolormap);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PlaneDisplace)
-			{
-				SavePlaneDisplaceThinker(save, th, tc_planedisplace);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjRotate)
-			{
-				SavePolyrotatetThinker(save, th, tc_polyrotate);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjMove)
-			{
-				SavePolymoveThinker(save, th, tc_polymove);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjWaypoint)
-			{
-				SavePolywaypointThinker(save, th, tc_polywaypoint);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyDoorSlide)
-			{
-				SavePolyslidedoorThinker(save, th, tc_polyslidedoor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyDoorSwing)
-			{
-				SavePolyswingdoorThinker(save, th, tc_polyswingdoor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjFlag)
-			{
-				SavePolymoveThinker(save, th, tc_polyflag);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjDisplace)
-			{
-				SavePolydisplaceThinker(save, th, tc_polydisplace);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjRotDisplace)
-			{
-				SavePolyrotdisplaceThinker(save, th, tc_polyrotdisplace);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjFade)
-			{
-				SavePolyfadeThinker(save, th, tc_polyfade);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeLine)
-			{
-				SaveDynamicLineSlopeThinker(save, th, tc_dynslopeline);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeVert)
-			{
-				SaveDynamicVertexSlopeThinker(save, th, tc_dynslopevert);
-				continue;
-			}
-#ifdef PARANOIA
-			else
-				I_Assert(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed); // wait garbage collection
-#endif
+			P_NetArchiveThinker(save, th);
 		}
 
 		CONS_Debug(DBG_NETPLAY, "%u thinkers saved in list %d\n", numsaved, i);
@@ -5450,7 +5562,7 @@ static void P_NetUnArchiveThinkers(savebuffer_t *save)
 
 			currentthinker->references = 0; // Heinous but this is the only place the assertion in P_UnlinkThinkers is wrong
 
-			if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker || currentthinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
+			if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
 				P_RemoveSavegameMobj((mobj_t *)currentthinker); // item isn't saved, don't remove it
 			else
 			{
@@ -7003,6 +7115,8 @@ void P_SaveNetGame(savebuffer_t *save, boolean resending)
 				continue;
 			mobj->mobjnum = i++;
 		}
+
+		P_StartArchivingMobjs(save);
 	}
 
 	K_SaveEndCamera(save);
@@ -13,6 +13,8 @@
 /// \brief Do all the WAD I/O, get map description, set up initial state and misc. LUTs
 
 #include <algorithm>
+#include <cmath>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -65,6 +67,7 @@
 #include "m_argv.h"
 
 #include "p_polyobj.h"
+#include "p_precip.h"
 
 #include "v_video.h"
 
@@ -75,6 +78,8 @@
 #include "f_finale.h" // wipes
 
 #include "md5.h" // map MD5
+#include "p_mapcache.hpp"
+#include "p_reject.hpp"
 
 // for MapLoad hook
 #include "lua_script.h"
@@ -185,7 +190,6 @@ INT32 *blockmaplump; // Big blockmap
 fixed_t bmaporgx, bmaporgy;
 // for thing chains
 mobj_t **blocklinks;
-precipmobj_t **precipblocklinks;
 
 // REJECT
 // For fast sight rejection.
@@ -1004,8 +1008,6 @@ static void P_InitializeSector(sector_t *ss)
 
 	ss->floorspeed = ss->ceilspeed = 0;
 
-	ss->touching_preciplist = NULL;
-
 	ss->f_slope = NULL;
 	ss->c_slope = NULL;
 	ss->hasslope = false;
@@ -1438,6 +1440,25 @@ UINT32 sidesPos[UINT16_MAX];
 UINT32 vertexesPos[UINT16_MAX];
 UINT32 sectorsPos[UINT16_MAX];
 
+// Compiled TEXTMAP of the map being loaded. Blocks are read from mapcache
+// when it had a valid one, and recorded into mapcachewriter otherwise.
+static std::unique_ptr<srb2::MapCache> mapcache;
+static std::unique_ptr<srb2::MapCacheWriter> mapcachewriter;
+static precise_t mapcacheparsetime;
+
+// The lumps of the last map loaded, kept across level loads so that loading
+// it again (gamestate resyncs, retries) doesn't read them from the WAD, hash
+// them, open its map cache or build its reject matrix again. This doesn't
+// skip the parse: the level structures are PU_LEVEL, and P_LoadLevel still
+// builds them, sets up the BSP and spawns things every time.
+static virtres_t *residentmapvirt;
+static lumpnum_t residentmaplumpnum = LUMPERROR;
+static UINT16 residentmapnumwadfiles;
+static unsigned char residentmapmd5[16];
+static std::unique_ptr<srb2::MapCache> residentmapcache;
+static std::vector<UINT8> residentmapreject;
+static boolean residentmapreused;
+
 // Determine total amount of map data in TEXTMAP.
 static boolean TextmapCount(size_t size)
 {
@@ -1519,7 +1540,7 @@ static void ParseUserProperty(mapUserProperties_t *user, const char *param, cons
 {
 	if (fastncmp(param, "user_", 5) && strlen(param) > 5)
 	{
-		const boolean valIsString = M_TokenizerJustReadString();
+		const boolean valIsString = mapcache ? mapcache->value_is_string() : M_TokenizerJustReadString();
 		const char *key = param + 5;
 		const size_t valLen = strlen(val);
 		UINT8 numberType = PROP_NUM_TYPE_INT;
@@ -2122,6 +2143,16 @@ static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, cons
 {
 	const char *param, *val;
 
+	// From the map cache, dataPos is a block number
+	if (mapcache)
+	{
+		mapcache->parse_block(dataPos, num, parser);
+		return;
+	}
+
+	if (mapcachewriter)
+		mapcachewriter->begin_block();
+
 	M_TokenizerSetEndPos(dataPos);
 	param = M_TokenizerRead(0);
 	if (!fastcmp(param, "{"))
@@ -2136,6 +2167,8 @@ static void TextmapParse(UINT32 dataPos, size_t num, void (*parser)(UINT32, cons
 		if (fastcmp(param, "}"))
 			break;
 		val = M_TokenizerRead(1);
+		if (mapcachewriter)
+			mapcachewriter->add(param, val, M_TokenizerJustReadString());
 		parser(num, param, val);
 	}
 }
@@ -3476,6 +3509,99 @@ static void P_ProcessLinedefsAfterSidedefs(void)
 	}
 }
 
+/** Tries to load the compiled TEXTMAP for this map from the map cache.
+  * If there isn't one, starts recording the text as it's parsed, so the
+  * next load of this map can skip the tokenizer.
+  *
+  * \param textmap The TEXTMAP lump.
+  * \return True if the cache was loaded, and the element counts set.
+  */
+static boolean P_OpenMapCache(const virtlump_t *textmap)
+{
+	srb2::MapCacheKey key;
+	UINT32 i;
+
+	mapcacheparsetime = I_GetPreciseTime();
+
+	if (M_CheckParm("-nomapcache"))
+		return false;
+
+	M_Memcpy(key.data(), mapmd5, key.size());
+
+	if (residentmapcache)
+		mapcache = std::move(residentmapcache);
+	else
+		mapcache = srb2::MapCache::open(key, textmap->size);
+
+	if (!mapcache)
+	{
+		mapcachewriter = std::make_unique<srb2::MapCacheWriter>();
+		return false;
+	}
+
+	const srb2::MapCacheCounts &counts = mapcache->counts();
+	UINT32 block = 0;
+
+	numvertexes = counts.vertexes;
+	numsectors = counts.sectors;
+	numlines = counts.lines;
+	numsides = counts.sides;
+	nummapthings = counts.things;
+	udmf_version = mapcache->udmf_version();
+
+	// Blocks are stored in the order P_LoadTextmap parses them
+	for (i = 0; i < numvertexes; i++)
+		vertexesPos[i] = block++;
+	for (i = 0; i < numsectors; i++)
+		sectorsPos[i] = block++;
+	for (i = 0; i < numlines; i++)
+		linesPos[i] = block++;
+	for (i = 0; i < numsides; i++)
+		sidesPos[i] = block++;
+	for (i = 0; i < nummapthings; i++)
+		mapthingsPos[i] = block++;
+
+	return true;
+}
+
+/** Writes out the map cache recorded during this load, and reports how
+  * long the TEXTMAP took to load either way.
+  */
+static void P_CloseMapCache(void)
+{
+	const double parsems = (double)(I_GetPreciseTime() - mapcacheparsetime) * 1000.0 / I_GetPrecisePrecision();
+
+	if (mapcache)
+	{
+		CONS_Debug(DBG_SETUP, "Map loaded from cache in %.2f ms (parsing the TEXTMAP took %.2f ms)\n",
+			parsems, mapcache->parse_us() / 1000.0);
+
+		// Keep it open for as long as the map is resident
+		residentmapcache = std::move(mapcache);
+	}
+	else if (mapcachewriter)
+	{
+		srb2::MapCacheKey key;
+		const srb2::MapCacheCounts counts = {
+			static_cast<uint32_t>(numvertexes),
+			static_cast<uint32_t>(numsectors),
+			static_cast<uint32_t>(numlines),
+			static_cast<uint32_t>(numsides),
+			static_cast<uint32_t>(nummapthings)
+		};
+
+		M_Memcpy(key.data(), mapmd5, key.size());
+		const UINT32 textmapsize = vres_Find(curmapvirt, "TEXTMAP")->size;
+		mapcachewriter->write(key, textmapsize, counts, udmf_version, static_cast<uint32_t>(parsems * 1000.0));
+		CONS_Debug(DBG_SETUP, "Map TEXTMAP parsed in %.2f ms, cached for next time\n", parsems);
+
+		residentmapcache = srb2::MapCache::open(key, textmapsize);
+	}
+
+	mapcache.reset();
+	mapcachewriter.reset();
+}
+
 static boolean P_LoadMapData(const virtres_t *virt)
 {
 	TracyCZone(__zone, true);
@@ -3483,13 +3609,16 @@ static boolean P_LoadMapData(const virtres_t *virt)
 	virtlump_t *virtvertexes = NULL, *virtsectors = NULL, *virtsidedefs = NULL, *virtlinedefs = NULL, *virtthings = NULL;
 
 	// Count map data.
-	if (udmf) // Count how many entries for each type we got in textmap.
+	if (udmf && P_OpenMapCache(vres_Find(virt, "TEXTMAP")))
+		; // Counts come from the cache.
+	else if (udmf) // Count how many entries for each type we got in textmap.
 	{
 		virtlump_t *textmap = vres_Find(virt, "TEXTMAP");
 		M_TokenizerOpen((char *)textmap->data, textmap->size);
 		if (!TextmapCount(textmap->size))
 		{
 			M_TokenizerClose();
+			mapcachewriter.reset();
 			TracyCZoneEnd(__zone);
 			return false;
 		}
@@ -3549,7 +3678,9 @@ static boolean P_LoadMapData(const virtres_t *virt)
 	numlevelflats = 0;
 
 	// Load map data.
-	if (udmf)
+	if (udmf && mapcache)
+		P_LoadTextmap();
+	else if (udmf)
 	{
 		P_LoadTextmap();
 		M_TokenizerClose();
@@ -4137,6 +4268,21 @@ static void P_ReadBlockMapLump(INT16 *wadblockmaplump, size_t count)
 	}
 }
 
+// Allocates the per-block chains for the blockmap that was just loaded or built.
+static void P_SetupBlockLinks(void)
+{
+	size_t count;
+
+	// clear out mobj chains
+	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
+	blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	blockmap = blockmaplump+4;
+
+	// haleyjd 2/22/06: setup polyobject blockmap
+	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
+	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+}
+
 // This needs to be a separate function
 // because making both the WAD and PK3 loading code use
 // the same functions is trickier than it looks for blockmap
@@ -4157,17 +4303,33 @@ static boolean P_LoadBlockMap(UINT8 *data, size_t count)
 	bmapwidth = blockmaplump[2];
 	bmapheight = blockmaplump[3];
 
-	// clear out mobj chains
-	count = sizeof (*blocklinks)* bmapwidth*bmapheight;
-	blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-	blockmap = blockmaplump+4;
+	P_SetupBlockLinks();
 
-	// haleyjd 2/22/06: setup polyobject blockmap
-	count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
-	polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	return true;
+}
 
-	count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-	precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+/** Loads the blockmap P_CreateBlockMap made for this map last time,
+  * from the map cache.
+  *
+  * \param vertexhash P_VertexHash of the loaded vertices.
+  * \return False if the cache doesn't have a usable blockmap.
+  */
+static boolean P_LoadCachedBlockMap(UINT32 vertexhash)
+{
+	std::vector<INT32> cached;
+
+	if (!mapcache || !mapcache->blockmap(vertexhash, cached) || cached.size() < 6)
+		return false;
+
+	blockmaplump = static_cast<INT32*>(Z_Malloc(sizeof (*blockmaplump) * cached.size(), PU_LEVEL, NULL));
+	M_Memcpy(blockmaplump, cached.data(), sizeof (*blockmaplump) * cached.size());
+
+	bmaporgx = blockmaplump[0]<<FRACBITS;
+	bmaporgy = blockmaplump[1]<<FRACBITS;
+	bmapwidth = blockmaplump[2];
+	bmapheight = blockmaplump[3];
+
+	P_SetupBlockLinks();
 
 	return true;
 }
@@ -4234,9 +4396,11 @@ static boolean LineInBlock(fixed_t cx1, fixed_t cy1, fixed_t cx2, fixed_t cy2, f
 //
 // Please note: This section of code is not interchangable with TeamTNT's
 // code which attempts to fix the same problem.
-static void P_CreateBlockMap(void)
+//
+// Returns the number of words in blockmaplump.
+static size_t P_CreateBlockMap(void)
 {
-	size_t i;
+	size_t i, count;
 	fixed_t minx = INT32_MAX, miny = INT32_MAX, maxx = INT32_MIN, maxy = INT32_MIN;
 	// First find limits of map
 
@@ -4343,32 +4507,51 @@ static void P_CreateBlockMap(void)
 
 			// Now we simply iterate block-by-block until we reach the end block.
 			for (curblockx = bxstart; curblockx <= bxend; curblockx++)
-			for (curblocky = bystart; curblocky <= byend; curblocky++)
 			{
-				size_t b = curblocky * bmapwidth + curblockx;
+				INT32 rowstart = bystart, rowend = byend;
 
-				if (b >= tot)
-					continue;
-
-				if (!straight && !(LineInBlock((fixed_t)x, (fixed_t)y, (fixed_t)v2x, (fixed_t)v2y, (fixed_t)(curblockx << MAPBTOFRAC), (fixed_t)(curblocky << MAPBTOFRAC))))
-					continue;
-
-				// Increase size of allocated list if necessary
-				if (bmap[b].n >= bmap[b].nalloc)
+				// A diagonal line only touches a run of rows in each column,
+				// so only test the rows around where it is in this column.
+				// The run is the same one testing every row would find.
+				if (!straight && v2x != x)
 				{
-					// Graue 02-29-2004: make code more readable, don't realloc a null pointer
-					// (because it crashes for me, and because the comp.lang.c FAQ says so)
-					if (bmap[b].nalloc == 0)
-						bmap[b].nalloc = 8;
-					else
-						bmap[b].nalloc *= 2;
-					bmap[b].list = static_cast<INT32*>(Z_Realloc(bmap[b].list, bmap[b].nalloc * sizeof (*bmap->list), PU_CACHE, &bmap[b].list));
-					if (!bmap[b].list)
-						I_Error("Out of Memory in P_CreateBlockMap");
+					const double colx1 = std::max<double>(curblockx << MAPBTOFRAC, std::min(x, v2x));
+					const double colx2 = std::min<double>((curblockx + 1) << MAPBTOFRAC, std::max(x, v2x));
+					const double slope = (double)(v2y - y) / (v2x - x);
+					const double coly1 = y + (colx1 - x) * slope;
+					const double coly2 = y + (colx2 - x) * slope;
+
+					rowstart = std::max(rowstart, ((INT32)std::floor(std::min(coly1, coly2)) >> MAPBTOFRAC) - 1);
+					rowend = std::min(rowend, ((INT32)std::floor(std::max(coly1, coly2)) >> MAPBTOFRAC) + 1);
 				}
 
-				// Add linedef to end of list
-				bmap[b].list[bmap[b].n++] = (INT32)i;
+				for (curblocky = rowstart; curblocky <= rowend; curblocky++)
+				{
+					size_t b = curblocky * bmapwidth + curblockx;
+
+					if (b >= tot)
+						continue;
+
+					if (!straight && !(LineInBlock((fixed_t)x, (fixed_t)y, (fixed_t)v2x, (fixed_t)v2y, (fixed_t)(curblockx << MAPBTOFRAC), (fixed_t)(curblocky << MAPBTOFRAC))))
+						continue;
+
+					// Increase size of allocated list if necessary
+					if (bmap[b].n >= bmap[b].nalloc)
+					{
+						// Graue 02-29-2004: make code more readable, don't realloc a null pointer
+						// (because it crashes for me, and because the comp.lang.c FAQ says so)
+						if (bmap[b].nalloc == 0)
+							bmap[b].nalloc = 8;
+						else
+							bmap[b].nalloc *= 2;
+						bmap[b].list = static_cast<INT32*>(Z_Realloc(bmap[b].list, bmap[b].nalloc * sizeof (*bmap->list), PU_CACHE, &bmap[b].list));
+						if (!bmap[b].list)
+							I_Error("Out of Memory in P_CreateBlockMap");
+					}
+
+					// Add linedef to end of list
+					bmap[b].list[bmap[b].n++] = (INT32)i;
+				}
 			}
 		}
 
@@ -4377,9 +4560,9 @@ static void P_CreateBlockMap(void)
 		// Compression of empty blocks is performed by reserving two offset words
 		// at tot and tot+1.
 		//
-		// 4 words, unused if this routine is called, are reserved at the start.
+		// 4 words are reserved at the start for the header.
 		{
-			size_t count = tot + 6; // we need at least 1 word per block, plus reserved's
+			count = tot + 6; // we need at least 1 word per block, plus reserved's
 
 			for (i = 0; i < tot; i++)
 				if (bmap[i].n)
@@ -4387,6 +4570,12 @@ static void P_CreateBlockMap(void)
 
 			// Allocate blockmap lump with computed count
 			blockmaplump = static_cast<INT32*>(Z_Calloc(sizeof (*blockmaplump) * count, PU_LEVEL, NULL));
+
+			// Fill in the header like a BLOCKMAP lump's, so the map cache can load it back
+			blockmaplump[0] = minx;
+			blockmaplump[1] = miny;
+			blockmaplump[2] = (INT32)bmapwidth;
+			blockmaplump[3] = (INT32)bmapheight;
 		}
 
 		// Now compress the blockmap.
@@ -4413,19 +4602,36 @@ static void P_CreateBlockMap(void)
 			free(bmap); // Free uncompressed blockmap
 		}
 	}
-	{
-		size_t count = sizeof (*blocklinks) * bmapwidth * bmapheight;
-		// clear out mobj chains (copied from from P_LoadBlockMap)
-		blocklinks = static_cast<mobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
-		blockmap = blockmaplump + 4;
 
-		// haleyjd 2/22/06: setup polyobject blockmap
-		count = sizeof(*polyblocklinks) * bmapwidth * bmapheight;
-		polyblocklinks = static_cast<polymaplink_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	P_SetupBlockLinks();
+
+	return count;
+}
+
+// FNV-1a over the vertex coordinates, which is all P_CreateBlockMap's
+// result depends on besides the linedefs already covered by the map MD5.
+static UINT32 P_VertexHash(void)
+{
+	UINT32 hash = 2166136261u;
+	size_t i;
+
+	auto mix = [&hash](UINT32 value)
+	{
+		for (int b = 0; b < 4; b++)
+		{
+			hash ^= (value >> (b * 8)) & 0xFF;
+			hash *= 16777619u;
+		}
+	};
 
-		count = sizeof (*precipblocklinks)* bmapwidth*bmapheight;
-		precipblocklinks = static_cast<precipmobj_t**>(Z_Calloc(count, PU_LEVEL, NULL));
+	mix((UINT32)numvertexes);
+	for (i = 0; i < numvertexes; i++)
+	{
+		mix((UINT32)vertexes[i].x);
+		mix((UINT32)vertexes[i].y);
 	}
+
+	return hash;
 }
 
 // PK3 version
@@ -4444,6 +4650,64 @@ static void P_LoadReject(UINT8 *data, size_t count)
 	}
 }
 
+// Most UDMF maps come without a REJECT lump, which would leave every
+// sight check walking the BSP. Build one on the thread pool while the
+// rest of the level loads.
+static std::unique_ptr<srb2::RejectBuilder> rejectbuilder;
+
+static void P_StartRejectBuilder(void)
+{
+	std::vector<srb2::RejectBuilder::Line> portals;
+	size_t i;
+
+	rejectbuilder.reset();
+
+	if (rejectmatrix)
+		return;
+
+	// Same lumps, same sectors: the one built last time still holds
+	if (residentmapreused && !residentmapreject.empty())
+		return;
+
+	// Every line with a sector on both sides, whether or not it's
+	// flagged two-sided, since the flag can be changed later.
+	for (i = 0; i < numlines; i++)
+	{
+		const line_t *ld = &lines[i];
+
+		if (!ld->frontsector || !ld->backsector || ld->frontsector == ld->backsector)
+			continue;
+
+		portals.push_back({
+			static_cast<uint32_t>(ld->frontsector - sectors),
+			static_cast<uint32_t>(ld->backsector - sectors),
+			ld->v1->x / (double)FRACUNIT, ld->v1->y / (double)FRACUNIT,
+			ld->v2->x / (double)FRACUNIT, ld->v2->y / (double)FRACUNIT
+		});
+	}
+
+	rejectbuilder = std::make_unique<srb2::RejectBuilder>(static_cast<uint32_t>(numsectors), std::move(portals));
+}
+
+static void P_FinishRejectBuilder(void)
+{
+	if (rejectbuilder)
+	{
+		residentmapreject = rejectbuilder->join();
+		rejectbuilder.reset();
+	}
+	else if (rejectmatrix || !residentmapreused)
+		return;
+
+	// Polyobjects move their lines around, so the map can change
+	// under the matrix.
+	if (residentmapreject.empty() || numPolyObjects)
+		return;
+
+	rejectmatrix = static_cast<UINT8*>(Z_Malloc(residentmapreject.size(), PU_LEVEL, NULL));
+	M_Memcpy(rejectmatrix, residentmapreject.data(), residentmapreject.size());
+}
+
 static void P_LoadMapLUT(const virtres_t *virt)
 {
 	virtlump_t* virtblockmap = vres_Find(virt, "BLOCKMAP");
@@ -4455,8 +4719,23 @@ static void P_LoadMapLUT(const virtres_t *virt)
 	else
 		rejectmatrix = NULL;
 
-	if (!(virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size)))
-		P_CreateBlockMap();
+	if (virtblockmap && P_LoadBlockMap(virtblockmap->data, virtblockmap->size))
+		return;
+
+	if (mapcache || mapcachewriter)
+	{
+		const UINT32 vertexhash = P_VertexHash();
+
+		if (P_LoadCachedBlockMap(vertexhash))
+			return;
+
+		const size_t count = P_CreateBlockMap();
+		if (mapcachewriter)
+			mapcachewriter->set_blockmap(blockmaplump, count, vertexhash);
+		return;
+	}
+
+	P_CreateBlockMap();
 }
 
 //
@@ -7542,8 +7821,16 @@ static boolean P_LoadMapFromFile(void)
 	udmf = textmap != NULL;
 	udmf_version = 0;
 
+	// Needed up front, to find this map in the map cache
+	if (residentmapreused)
+		M_Memcpy(mapmd5, residentmapmd5, sizeof mapmd5);
+	else
+		P_MakeMapMD5(curmapvirt, &mapmd5);
+
 	if (!P_LoadMapData(curmapvirt))
 	{
+		mapcache.reset();
+		mapcachewriter.reset();
 		TracyCZoneEnd(__zone);
 		return false;
 	}
@@ -7551,6 +7838,11 @@ static boolean P_LoadMapFromFile(void)
 	P_LoadMapBSP(curmapvirt);
 	P_LoadMapLUT(curmapvirt);
 
+	if (udmf)
+		P_CloseMapCache();
+
+	P_StartRejectBuilder();
+
 	P_LinkMapData();
 
 	if (!udmf)
@@ -7577,12 +7869,166 @@ static boolean P_LoadMapFromFile(void)
 		if (sectors[i].tags.count)
 			spawnsectors[i].tags.tags = static_cast<mtag_t*>(memcpy(Z_Malloc(sectors[i].tags.count*sizeof(mtag_t), PU_LEVEL, NULL), sectors[i].tags.tags, sectors[i].tags.count*sizeof(mtag_t)));
 
-	P_MakeMapMD5(curmapvirt, &mapmd5);
-
 	TracyCZoneEnd(__zone);
 	return true;
 }
 
+static void P_FreeResidentMapLumps(void)
+{
+	if (residentmapvirt)
+	{
+		virtres_t *temp = residentmapvirt;
+		residentmapvirt = NULL;
+		if (curmapvirt == temp)
+			curmapvirt = NULL;
+		vres_Free(temp);
+	}
+
+	residentmaplumpnum = LUMPERROR;
+	residentmapcache.reset();
+	residentmapreject = {};
+}
+
+/** Gets the lumps of a map, from memory if they are the ones that are
+  * already resident.
+  *
+  * \param lumpnum Map marker lump.
+  * \return Virtual resource of the map.
+  */
+static virtres_t *P_GetResidentMapLumps(lumpnum_t lumpnum)
+{
+	residentmapreused = (residentmapvirt != NULL
+		&& residentmaplumpnum == lumpnum
+		&& residentmapnumwadfiles == numwadfiles
+		&& !M_CheckParm("-noresidentmap"));
+
+	if (residentmapreused)
+		return residentmapvirt;
+
+	P_FreeResidentMapLumps();
+	return vres_GetMap(lumpnum);
+}
+
+/** Keeps the lumps of the map that was just loaded, see
+  * P_GetResidentMapLumps. A map in a PK3 has lumps of its own, which are
+  * just kept; a map in a WAD shares its lumps with the WAD lump cache,
+  * so those are copied.
+  *
+  * \param virt Virtual resource of the map.
+  * \param lumpnum Map marker lump.
+  */
+static void P_KeepResidentMapLumps(virtres_t *virt, lumpnum_t lumpnum)
+{
+	virtres_t *resident;
+	size_t i;
+
+	if (virt == residentmapvirt || M_CheckParm("-noresidentmap"))
+		return;
+
+	if (W_IsLumpWad(lumpnum))
+	{
+		Z_ChangeTag(virt, PU_STATIC);
+		Z_ChangeTag(virt->vlumps, PU_STATIC);
+		for (i = 0; i < virt->numlumps; i++)
+		{
+			if (virt->vlumps[i].data)
+				Z_ChangeTag(virt->vlumps[i].data, PU_STATIC);
+		}
+
+		residentmapvirt = virt;
+		residentmaplumpnum = lumpnum;
+		residentmapnumwadfiles = numwadfiles;
+		M_Memcpy(residentmapmd5, mapmd5, sizeof residentmapmd5);
+		return;
+	}
+
+	resident = static_cast<virtres_t*>(Z_Malloc(sizeof(virtres_t), PU_STATIC, NULL));
+	resident->numlumps = virt->numlumps;
+	resident->vlumps = static_cast<virtlump_t*>(Z_Malloc(sizeof(virtlump_t) * virt->numlumps, PU_STATIC, NULL));
+
+	for (i = 0; i < virt->numlumps; i++)
+	{
+		resident->vlumps[i] = virt->vlumps[i];
+		resident->vlumps[i].data = NULL;
+		if (virt->vlumps[i].data)
+		{
+			resident->vlumps[i].data = static_cast<UINT8*>(Z_Malloc(virt->vlumps[i].size, PU_STATIC, NULL));
+			M_Memcpy(resident->vlumps[i].data, virt->vlumps[i].data, virt->vlumps[i].size);
+		}
+	}
+
+	residentmapvirt = resident;
+	residentmaplumpnum = lumpnum;
+	residentmapnumwadfiles = numwadfiles;
+	M_Memcpy(residentmapmd5, mapmd5, sizeof residentmapmd5);
+}
+
+/** Starts reading a map's lumps, music and sky patches on the thread
+  * pool, so that P_LoadLevel finds them already in memory. Call this as
+  * soon as the next map is known.
+  *
+  * This only takes the reads and inflates off the main thread. Texture
+  * and flat composition go through the zone heap and the patch cache, and
+  * music is set up by the sound backend, so those still run on the main
+  * thread when the level loads.
+  *
+  * \param map Map number, as in nextmap.
+  * \param encore Whether to read the Encore music instead.
+  */
+void P_PrefetchLevel(INT16 map, boolean encore)
+{
+	std::vector<lumpnum_t> lumps;
+	const mapheader_t *mapheader;
+	lumpnum_t lumpnum;
+	UINT8 i, nummusic;
+	INT32 sky;
+
+	W_FlushPrefetchedLumps();
+
+	if (map < 0 || map >= nummapheaders || !mapheaderinfo[map] || mapheaderinfo[map]->lumpnum == LUMPERROR)
+		return;
+
+	mapheader = mapheaderinfo[map];
+	lumpnum = mapheader->lumpnum;
+
+	// Nothing to read if P_GetResidentMapLumps will reuse them
+	if (lumpnum != residentmaplumpnum || residentmapvirt == NULL || residentmapnumwadfiles != numwadfiles)
+	{
+		lumps.push_back(lumpnum);
+
+		// The same lumps vres_GetMap reads, for maps not in a PK3
+		if (!W_IsLumpWad(lumpnum))
+		{
+			for (lumpnum++; LUMPNUM(lumpnum) < wadfiles[WADFILENUM(lumpnum)]->numlumps && W_LumpLength(lumpnum) > 0; lumpnum++)
+				lumps.push_back(lumpnum);
+		}
+	}
+
+	// Any of them could be picked
+	nummusic = (encore && mapheader->encoremusname_size) ? mapheader->encoremusname_size : mapheader->musname_size;
+
+	for (i = 0; i < nummusic && i < MAXMUSNAMES; i++)
+	{
+		const char *music = (encore && mapheader->encoremusname_size) ? mapheader->encoremusname[i] : mapheader->musname[i];
+
+		if (music[0] && (lumpnum = W_CheckNumForLongName(va("O_%s", music))) != LUMPERROR)
+			lumps.push_back(lumpnum);
+	}
+
+	// The sky is composed the first time the level is drawn
+	sky = R_CheckTextureNumForName(mapheader->skytexture);
+
+	if (sky > 0 && !texturecache[sky])
+	{
+		INT16 p;
+
+		for (p = 0; p < textures[sky]->patchcount; p++)
+			lumps.push_back((textures[sky]->patches[p].wad << 16) + textures[sky]->patches[p].lump);
+	}
+
+	W_PrefetchLumps(lumps.data(), lumps.size());
+}
+
 //
 // LEVEL INITIALIZATION FUNCTIONS
 //
@@ -8283,6 +8729,7 @@ void P_LoadLevelMusic(void)
 {
 	mapheader_t* mapheader = mapheaderinfo[gamemap-1];
 	const char *music = mapheader->musname[0];
+	UINT8 i;
 
 	if (encoremode && mapheader->encoremusname_size
 	&& mapmusrng < mapheader->encoremusname_size)
@@ -8294,6 +8741,15 @@ void P_LoadLevelMusic(void)
 		music = mapheader->musname[mapmusrng];
 	}
 
+	// P_PrefetchLevel read every track that could be picked; let go of the rest
+	for (i = 0; i < MAXMUSNAMES; i++)
+	{
+		if (i < mapheader->musname_size && stricmp(mapheader->musname[i], music))
+			W_DropPrefetchedLump(W_CheckNumForLongName(va("O_%s", mapheader->musname[i])));
+		if (i < mapheader->encoremusname_size && stricmp(mapheader->encoremusname[i], music))
+			W_DropPrefetchedLump(W_CheckNumForLongName(va("O_%s", mapheader->encoremusname[i])));
+	}
+
 	if (P_UseContinuousLevelMusic())
 	{
 		if (!stricmp(Music_Song("level_nosync"), music))
@@ -8624,7 +9080,7 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	if (lastloadedmaplumpnum == LUMPERROR)
 		I_Error("Map %s not found.\n", maplumpname);
 
-	curmapvirt = vres_GetMap(lastloadedmaplumpnum);
+	curmapvirt = P_GetResidentMapLumps(lastloadedmaplumpnum);
 
 	if (mapheaderinfo[gamemap-1])
 	{
@@ -8749,6 +9205,8 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 		ACS_LoadLevelScripts(gamemap-1);
 	}
 
+	P_KeepResidentMapLumps(curmapvirt, lastloadedmaplumpnum);
+
 	// Now safe to free.
 	// We do the following silly
 	// construction because vres_Free
@@ -8757,7 +9215,8 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	{
 		virtres_t *temp = curmapvirt;
 		curmapvirt = NULL;
-		vres_Free(temp);
+		if (temp != residentmapvirt)
+			vres_Free(temp);
 	}
 
 	if (!reloadinggamestate)
@@ -8784,6 +9243,10 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 
 	oldbest = G_GetBestTime(gamemap - 1);
 
+	P_FinishRejectBuilder();
+
+	P_BuildBlockLineCache();
+
 	P_MapEnd(); // tm.thing is no longer needed from this point onwards
 
 	if (!udmf && !P_CanWriteTextmap())
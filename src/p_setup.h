@@ -111,6 +111,7 @@ void P_ResetLevelMusic(void);
 boolean P_UseContinuousLevelMusic(void);
 void P_LoadLevelMusic(void);
 boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate);
+void P_PrefetchLevel(INT16 map, boolean encore);
 void P_PostLoadLevel(void);
 #ifdef HWRENDER
 void HWR_LoadLevel(void);
@@ -33,6 +33,7 @@
 #include "r_main.h" //Two extra includes.
 #include "r_sky.h"
 #include "p_polyobj.h"
+#include "p_precip.h"
 #include "p_slopes.h"
 #include "hu_stuff.h"
 #include "m_misc.h"
@@ -1823,7 +1824,7 @@ void P_SwitchWeather(preciptype_t newWeather)
 	}
 	else
 	{
-		if (precipprops[curWeather].type != MT_NULL)
+		if (precipprops[curWeather].type != MT_NULL && precip.cells)
 		{
 			// There are already existing weather particles to reuse.
 			swap = precipprops[newWeather].type;
@@ -1834,73 +1835,12 @@ void P_SwitchWeather(preciptype_t newWeather)
 
 	if (purge == true)
 	{
-		thinker_t *think;
-		thinker_t *next;
-		precipmobj_t *precipmobj;
-
-		for (think = thlist[THINK_PRECIP].next; think != &thlist[THINK_PRECIP]; think = next)
-		{
-			next = think->next;
-
-			if (think->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-				continue; // not a precipmobj thinker
-
-			precipmobj = (precipmobj_t *)think;
-			P_FreePrecipMobj(precipmobj);
-		}
+		P_ClearPrecipitation();
 	}
 	else if (swap != MT_NULL) // Rather than respawn all that crap, reuse it!
 	{
-		UINT8 randomstates = (UINT8)mobjinfo[swap].damage;
-		thinker_t *think;
-		precipmobj_t *precipmobj;
-		statenum_t st;
-
-		for (think = thlist[THINK_PRECIP].next; think != &thlist[THINK_PRECIP]; think = think->next)
-		{
-			if (think->function.acp1 != (actionf_p1)P_NullPrecipThinker)
-				continue; // not a precipmobj thinker
-
-			precipmobj = (precipmobj_t *)think;
-
-			precipmobj->flags = mobjinfo[swap].flags;
-
-			st = mobjinfo[swap].spawnstate;
-
-			if (randomstates > 0)
-			{
-				UINT8 mrand = M_RandomByte();
-				UINT8 threshold = UINT8_MAX / (randomstates + 1);
-				UINT8 i;
-
-				for (i = 0; i < randomstates; i++)
-				{
-					if (mrand < (threshold * (i+1)))
-					{
-						st += i+1;
-						break;
-					}
-				}
-			}
-
-			precipmobj->state = &states[st];
-			precipmobj->tics = precipmobj->state->tics;
-			precipmobj->sprite = precipmobj->state->sprite;
-			precipmobj->frame = precipmobj->state->frame;
-
-			precipmobj->momz = FixedMul(-mobjinfo[swap].speed, mapobjectscale);
-			precipmobj->precipflags &= ~(PCF_INVISIBLE|PCF_FLIP);
-
-			if (precipmobj->momz > 0)
-			{
-				precipmobj->precipflags |= PCF_FLIP;
-			}
-
-			if ((oldEffects & PRECIPFX_WATERPARTICLES) != (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES))
-			{
-				P_CalculatePrecipFloor(precipmobj);
-			}
-		}
+		P_ChangePrecipitationType(swap,
+			(oldEffects & PRECIPFX_WATERPARTICLES) != (precipprops[curWeather].effects & PRECIPFX_WATERPARTICLES));
 	}
 
 	if (swap == MT_NULL && precipprops[curWeather].type != MT_NULL)
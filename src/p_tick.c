@@ -14,6 +14,7 @@
 
 #include "doomstat.h"
 #include "d_main.h"
+#include "g_demoanalysis.h"
 #include "g_game.h"
 #include "g_input.h"
 #include "p_local.h"
@@ -21,11 +22,13 @@
 #include "s_sound.h"
 #include "st_stuff.h"
 #include "p_polyobj.h"
+#include "p_precip.h"
 #include "m_random.h"
 #include "m_cond.h" // gamedata->playtime
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "m_perfstats.h"
+#include "m_trace.h"
 #include "i_system.h" // I_GetPreciseTime
 #include "i_video.h" // rendermode
 #include "r_main.h"
@@ -165,7 +168,7 @@ void Command_Numthinkers_f(void)
 		CONS_Printf(M_GetText("numthinkers <#>: Count number of thinkers\n"));
 		CONS_Printf(
 			"\t1: P_MobjThinker\n"
-			"\t2: P_NullPrecipThinker\n"
+			"\t2: Precipitation particles\n"
 			"\t3: T_Friction\n"
 			"\t4: T_Pusher\n"
 			"\t5: P_RemoveThinkerDelayed\n");
@@ -182,10 +185,9 @@ void Command_Numthinkers_f(void)
 			CONS_Printf(M_GetText("Number of %s: "), "P_MobjThinker");
 			break;
 		case 2:
-			start = end = THINK_PRECIP;
-			action = (actionf_p1)P_NullPrecipThinker;
-			CONS_Printf(M_GetText("Number of %s: "), "P_NullPrecipThinker");
-			break;
+			// Not thinkers anymore
+			CONS_Printf(M_GetText("Number of %s: %u\n"), "precipitation particles", precip.cells ? precip.count : 0);
+			return;
 		case 3:
 			start = end = THINK_MAIN;
 			action = (actionf_p1)T_Friction;
@@ -554,6 +556,13 @@ mobj_t *P_SetTarget2(mobj_t **mop, mobj_t *targ
 // Rewritten to delete nodes implicitly, by making currentthinker
 // external and using P_RemoveThinkerDelayed() implicitly.
 //
+static const char *const thinklistnames[NUM_ACTIVETHINKERLISTS] = {
+	"Polyobject thinkers",
+	"Main thinkers",
+	"Mobj thinkers",
+	"Dynamic slope thinkers",
+};
+
 static void P_RunThinkers(void)
 {
 	size_t i;
@@ -569,6 +578,7 @@ static void P_RunThinkers(void)
 			currentthinker->function.acp1(currentthinker);
 		}
 		ps_thlist_times[i] = I_GetPreciseTime() - ps_thlist_times[i];
+		M_TraceDuration(thinklistnames[i], ps_thlist_times[i]);
 	}
 
 	if (gametyperules & GTR_CIRCUIT)
@@ -583,6 +593,7 @@ static void P_RunThinkers(void)
 	ps_acs_time = I_GetPreciseTime();
 	ACS_Tick();
 	ps_acs_time = I_GetPreciseTime() - ps_acs_time;
+	M_TraceDuration("ACS_Tick", ps_acs_time);
 }
 
 //
@@ -921,6 +932,7 @@ void P_Ticker(boolean run)
 
 		ps_lua_mobjhooks = 0;
 		ps_checkposition_calls = 0;
+		ps_checkline_time = 0;
 
 		LUA_HOOK(PreThinkFrame);
 
@@ -938,6 +950,7 @@ void P_Ticker(boolean run)
 		}
 
 		ps_playerthink_time = I_GetPreciseTime() - ps_playerthink_time;
+		M_TraceDuration("P_PlayerThink", ps_playerthink_time);
 
 		if (gamedata && gamestate == GS_LEVEL && !demo.playback)
 		{
@@ -1067,6 +1080,7 @@ void P_Ticker(boolean run)
 		ps_thinkertime = I_GetPreciseTime();
 		P_RunThinkers();
 		ps_thinkertime = I_GetPreciseTime() - ps_thinkertime;
+		M_TraceDuration("P_RunThinkers", ps_thinkertime);
 		thinkersCompleted = true;
 
 		// Run any "after all the other thinkers" stuff
@@ -1190,6 +1204,7 @@ void P_Ticker(boolean run)
 		ps_lua_thinkframe_time = I_GetPreciseTime();
 		LUA_HookThinkFrame();
 		ps_lua_thinkframe_time = I_GetPreciseTime() - ps_lua_thinkframe_time;
+		M_TraceDuration("LUA_HookThinkFrame", ps_lua_thinkframe_time);
 	}
 
 	if (run)
@@ -1383,7 +1398,8 @@ void P_Ticker(boolean run)
 
 	P_MapEnd();
 
-	if (demo.playback)
+	// Nothing is rewound during analysis, so it isn't timed either
+	if (demo.playback && !G_DemoAnalysisActive())
 		G_StoreRewindInfo();
 
 	for (i = 0; i < MAXPLAYERS; i++)
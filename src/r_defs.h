@@ -549,9 +549,6 @@ struct sector_t
 	// Current speed of ceiling/floor. For Knuckles to hold onto stuff.
 	fixed_t floorspeed, ceilspeed;
 
-	// list of precipitation mobjs in sector
-	mprecipsecnode_t *touching_preciplist;
-
 	// Eternity engine slope
 	pslope_t *f_slope; // floor slope
 	pslope_t *c_slope; // ceiling slope
@@ -703,17 +700,6 @@ struct msecnode_t
 	boolean visited; // used in search algorithms
 };
 
-struct mprecipsecnode_t
-{
-	sector_t *m_sector; // a sector containing this object
-	precipmobj_t *m_thing;  // this object
-	mprecipsecnode_t *m_sectorlist_prev;  // prev msecnode_t for this thing
-	mprecipsecnode_t *m_sectorlist_next;  // next msecnode_t for this thing
-	mprecipsecnode_t *m_thinglist_prev;  // prev msecnode_t for this sector
-	mprecipsecnode_t *m_thinglist_next;  // next msecnode_t for this sector
-	boolean visited; // used in search algorithms
-};
-
 // for now, only used in hardware mode
 // maybe later for software as well?
 // that's why it's moved here
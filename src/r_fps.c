@@ -19,6 +19,7 @@
 #include "g_game.h"
 #include "i_video.h"
 #include "r_plane.h"
+#include "p_precip.h"
 #include "p_spec.h"
 #include "r_state.h"
 #include "z_zone.h"
@@ -293,35 +294,17 @@ void R_InterpolateMobjState(mobj_t *mobj, fixed_t frac, interpmobjstate_t *out)
 	}
 }
 
-void R_InterpolatePrecipMobjState(precipmobj_t *mobj, fixed_t frac, interpmobjstate_t *out)
+void R_InterpolatePrecipState(UINT32 i, fixed_t frac, interpmobjstate_t *out)
 {
-	if (frac == FRACUNIT)
-	{
-		out->x = mobj->x;
-		out->y = mobj->y;
-		out->z = mobj->z;
-		out->scale = mapobjectscale;
-		out->subsector = mobj->subsector;
-		out->angle = mobj->angle;
-		out->spritexscale = mobj->spritexscale;
-		out->spriteyscale = mobj->spriteyscale;
-		out->spritexoffset = mobj->spritexoffset;
-		out->spriteyoffset = mobj->spriteyoffset;
-		return;
-	}
-
-	out->x = R_LerpFixed(mobj->old_x, mobj->x, frac);
-	out->y = R_LerpFixed(mobj->old_y, mobj->y, frac);
-	out->z = R_LerpFixed(mobj->old_z, mobj->z, frac);
+	// Only ever moves up and down
+	out->x = precip.x[i];
+	out->y = precip.y[i];
+	out->z = (frac == FRACUNIT) ? precip.z[i] : R_LerpFixed(precip.old_z[i], precip.z[i], frac);
 	out->scale = mapobjectscale;
-	out->spritexscale = R_LerpFixed(mobj->old_spritexscale, mobj->spritexscale, frac);
-	out->spriteyscale = R_LerpFixed(mobj->old_spriteyscale, mobj->spriteyscale, frac);
-	out->spritexoffset = R_LerpFixed(mobj->old_spritexoffset, mobj->spritexoffset, frac);
-	out->spriteyoffset = R_LerpFixed(mobj->old_spriteyoffset, mobj->spriteyoffset, frac);
-
-	out->subsector = R_PointInSubsector(out->x, out->y);
-
-	out->angle = R_LerpAngle(mobj->old_angle, mobj->angle, frac);
+	out->subsector = precip.subsector[i];
+	out->angle = 0;
+	out->spritexscale = out->spriteyscale = FRACUNIT;
+	out->spritexoffset = out->spriteyoffset = 0;
 }
 
 static void AddInterpolator(levelinterpolator_t* interpolator)
@@ -518,6 +501,23 @@ void R_ClearLevelInterpolatorState(thinker_t *thinker)
 	}
 }
 
+void R_ClearSectorInterpolatorState(sector_t *sector)
+{
+	size_t i;
+
+	for (i = 0; i < levelinterpolators_len; i++)
+	{
+		levelinterpolator_t *interp = levelinterpolators[i];
+
+		if (interp->type == LVLINTERP_SectorPlane && interp->sectorplane.sector == sector)
+		{
+			// Do it twice to make the old state match the new
+			UpdateLevelInterpolatorState(interp);
+			UpdateLevelInterpolatorState(interp);
+		}
+	}
+}
+
 void R_ApplyLevelInterpolators(fixed_t frac)
 {
 	size_t i, ii;
@@ -755,26 +755,3 @@ void R_ResetMobjInterpolationState(mobj_t *mobj)
 
 	mobj->resetinterp = false;
 }
-
-//
-// P_ResetPrecipitationMobjInterpolationState
-//
-// Reset the rendering interpolation state of the precipmobj.
-//
-void R_ResetPrecipitationMobjInterpolationState(precipmobj_t *mobj)
-{
-	mobj->old_x2 = mobj->old_x;
-	mobj->old_y2 = mobj->old_y;
-	mobj->old_z2 = mobj->old_z;
-	mobj->old_angle2 = mobj->old_angle;
-	mobj->old_pitch2 = mobj->old_pitch;
-	mobj->old_roll2 = mobj->old_roll;
-	mobj->old_x = mobj->x;
-	mobj->old_y = mobj->y;
-	mobj->old_z = mobj->z;
-	mobj->old_angle = mobj->angle;
-	mobj->old_spritexscale = mobj->spritexscale;
-	mobj->old_spriteyscale = mobj->spriteyscale;
-	mobj->old_spritexoffset = mobj->spritexoffset;
-	mobj->old_spriteyoffset = mobj->spriteyoffset;
-}
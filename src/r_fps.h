@@ -141,8 +141,8 @@ angle_t R_InterpolateAngle(angle_t from, angle_t to);
 
 // Evaluate the interpolated mobj state for the given mobj
 void R_InterpolateMobjState(mobj_t *mobj, fixed_t frac, interpmobjstate_t *out);
-// Evaluate the interpolated mobj state for the given precipmobj
-void R_InterpolatePrecipMobjState(precipmobj_t *mobj, fixed_t frac, interpmobjstate_t *out);
+// Evaluate the interpolated mobj state for the given precipitation particle
+void R_InterpolatePrecipState(UINT32 i, fixed_t frac, interpmobjstate_t *out);
 
 void R_CreateInterpolator_SectorPlane(thinker_t *thinker, sector_t *sector, boolean ceiling);
 void R_CreateInterpolator_SectorScroll(thinker_t *thinker, sector_t *sector, boolean ceiling);
@@ -156,6 +156,8 @@ void R_InitializeLevelInterpolators(void);
 void R_UpdateLevelInterpolators(void);
 // Clear states for all level interpolators for the thinker
 void R_ClearLevelInterpolatorState(thinker_t *thinker);
+// Clear states for the plane interpolators of the sector, after its heights were set directly
+void R_ClearSectorInterpolatorState(sector_t *sector);
 // Apply level interpolators to the actual game state
 void R_ApplyLevelInterpolators(fixed_t frac);
 // Restore level interpolators to the real game state
@@ -171,7 +173,6 @@ void R_AddMobjInterpolator(mobj_t *mobj);
 void R_RemoveMobjInterpolator(mobj_t *mobj);
 void R_UpdateMobjInterpolators(void);
 void R_ResetMobjInterpolationState(mobj_t *mobj);
-void R_ResetPrecipitationMobjInterpolationState(precipmobj_t *mobj);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,798 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_gfxcache.cpp
+/// \brief Disk cache of converted PNGs and rotated sprites
+///
+/// Everything lives in one append-only pack file. Each entry is keyed by an
+/// MD5 of the lump's contents and everything else the conversion depends on,
+/// so addons can come and go without anything going stale. The pack is mapped
+/// at startup, and once the first lookup sees it loaded its pages are read in
+/// on the thread pool, so the lookups after don't have to wait on the disk.
+/// Without mmap, entries are read from the file as they're looked up.
+///
+/// Only the instance holding pack.rrgc.lock writes, and it never truncates a
+/// pack another instance may be reading: starting over builds a new file and
+/// renames it into place. Every entry carries a CRC, checked on each hit.
+
+#include "r_gfxcache.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GFXCACHE_MMAP
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include <tracy/tracy/Tracy.hpp>
+#include <zlib.h>
+
+#include "core/thread_pool.h"
+
+#include "d_main.h" // srb2home
+#include "doomdef.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "md5.h"
+#include "v_video.h" // pMasterPalette
+#include "w_wad.h"
+#include "z_zone.h"
+
+using namespace srb2;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+// Bump whenever the entry layout, or what any conversion produces, changes.
+constexpr uint32_t kGfxCacheVersion = 2;
+constexpr char kGfxCacheMagic[4] = {'R', 'R', 'G', 'C'};
+constexpr char kEntryMagic[4] = {'G', 'F', 'X', 'E'};
+
+constexpr std::size_t kHeaderSize = 4 + 4;
+
+// magic, key, size, CRC, 4 meta
+constexpr std::size_t kEntryHeaderSize = 4 + GFXCACHE_KEYSIZE + 4 + 4 + 4 * 4;
+constexpr std::size_t kEntrySizeOffset = 4 + GFXCACHE_KEYSIZE;
+constexpr std::size_t kEntryCRCOffset = kEntrySizeOffset + 4;
+constexpr std::size_t kEntryMetaOffset = kEntryCRCOffset + 4;
+
+// What each kind of key is salted with, so that different conversions of the same lump can't collide
+constexpr uint32_t kPNGKind = 1;
+constexpr uint32_t kRotationKind = 2;
+
+constexpr std::size_t kPageSize = 4096;
+
+// Paged in by each warming job
+constexpr std::size_t kWarmChunk = 4 << 20;
+
+using Key = std::array<uint8_t, GFXCACHE_KEYSIZE>;
+
+struct KeyHash
+{
+	std::size_t operator()(const Key& key) const noexcept
+	{
+		std::size_t h;
+		std::memcpy(&h, key.data(), sizeof h); // it's already an MD5
+		return h;
+	}
+};
+
+struct Entry
+{
+	std::size_t offset; // of the picture
+	uint32_t size;
+	uint32_t crc;
+	std::array<int32_t, 4> meta;
+};
+
+uint32_t load_u32(const std::byte* p)
+{
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+		(static_cast<uint32_t>(p[3]) << 24);
+}
+
+void store_u32(std::byte* p, uint32_t v)
+{
+	p[0] = static_cast<std::byte>(v);
+	p[1] = static_cast<std::byte>(v >> 8);
+	p[2] = static_cast<std::byte>(v >> 16);
+	p[3] = static_cast<std::byte>(v >> 24);
+}
+
+std::size_t padded(std::size_t size)
+{
+	return (size + 3) & ~static_cast<std::size_t>(3);
+}
+
+Key make_key(const std::vector<uint8_t>& buffer)
+{
+	Key key;
+	md5_buffer(reinterpret_cast<const char*>(buffer.data()), buffer.size(), key.data());
+	return key;
+}
+
+template <typename T>
+void append(std::vector<uint8_t>& buffer, const T& value)
+{
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+	buffer.insert(buffer.end(), p, p + sizeof value);
+}
+
+} // namespace
+
+/// The pack file as it was at startup: memory-mapped where the platform allows it, and read an entry at a time
+/// otherwise.
+struct GfxCacheMapping
+{
+	std::size_t size = 0;
+
+	~GfxCacheMapping() { close(); }
+
+#ifdef GFXCACHE_MMAP
+	const std::byte* data = nullptr;
+	void* map = nullptr;
+
+	void close()
+	{
+		if (map)
+		{
+			munmap(map, size);
+		}
+		map = nullptr;
+		data = nullptr;
+		size = 0;
+	}
+
+	bool open(const fs::path& path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		size = static_cast<std::size_t>(st.st_size);
+		void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED)
+		{
+			return false;
+		}
+
+		map = p;
+		data = static_cast<const std::byte*>(p);
+		return true;
+	}
+
+	// Valid until the mapping is closed
+	const std::byte* view(std::size_t pos, std::size_t) { return data + pos; }
+#else
+	std::FILE* fp = nullptr;
+	std::vector<std::byte> scratch;
+
+	void close()
+	{
+		if (fp)
+		{
+			std::fclose(fp);
+		}
+		fp = nullptr;
+		scratch.clear();
+		scratch.shrink_to_fit();
+		size = 0;
+	}
+
+	bool open(const fs::path& path)
+	{
+		fp = std::fopen(path.string().c_str(), "rb");
+		if (!fp)
+		{
+			return false;
+		}
+
+		const long end = std::fseek(fp, 0, SEEK_END) == 0 ? std::ftell(fp) : -1;
+		if (end <= 0)
+		{
+			close();
+			return false;
+		}
+
+		size = static_cast<std::size_t>(end);
+		return true;
+	}
+
+	// Valid until the next view
+	const std::byte* view(std::size_t pos, std::size_t n)
+	{
+		scratch.resize(std::max<std::size_t>(n, 1));
+		if (std::fseek(fp, static_cast<long>(pos), SEEK_SET) != 0 || (n && std::fread(scratch.data(), n, 1, fp) != 1))
+		{
+			return nullptr;
+		}
+		return scratch.data();
+	}
+#endif
+};
+
+namespace
+{
+
+/// Held by whichever instance writes to the pack, for as long as it runs.
+class GfxCacheLock
+{
+public:
+	GfxCacheLock() = default;
+	GfxCacheLock(const GfxCacheLock&) = delete;
+	GfxCacheLock& operator=(const GfxCacheLock&) = delete;
+
+#if defined(_WIN32)
+	~GfxCacheLock()
+	{
+		if (handle_ != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(handle_);
+		}
+	}
+
+	bool acquire(const fs::path& path)
+	{
+		OVERLAPPED overlapped = {};
+
+		handle_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle_ == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		if (!LockFileEx(handle_, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped))
+		{
+			CloseHandle(handle_);
+			handle_ = INVALID_HANDLE_VALUE;
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	HANDLE handle_ = INVALID_HANDLE_VALUE;
+#elif defined(GFXCACHE_MMAP)
+	~GfxCacheLock()
+	{
+		if (fd_ >= 0)
+		{
+			::close(fd_);
+		}
+	}
+
+	bool acquire(const fs::path& path)
+	{
+		fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd_ < 0)
+		{
+			return false;
+		}
+
+		if (flock(fd_, LOCK_EX | LOCK_NB) != 0)
+		{
+			::close(fd_);
+			fd_ = -1;
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	int fd_ = -1;
+#else
+	// Nothing to lock with, so nothing is written
+	bool acquire(const fs::path&) { return false; }
+#endif
+};
+
+// The end of the last whole entry in the pack as it is now, or 0 if it isn't a pack this version reads.
+std::size_t pack_end(std::FILE* f)
+{
+	std::byte header[kEntryHeaderSize];
+
+	const long size = std::fseek(f, 0, SEEK_END) == 0 ? std::ftell(f) : -1;
+	if (size < static_cast<long>(kHeaderSize) || std::fseek(f, 0, SEEK_SET) != 0 ||
+		std::fread(header, kHeaderSize, 1, f) != 1 || std::memcmp(header, kGfxCacheMagic, 4) != 0 ||
+		load_u32(header + 4) != kGfxCacheVersion)
+	{
+		return 0;
+	}
+
+	const std::size_t filesize = static_cast<std::size_t>(size);
+	std::size_t pos = kHeaderSize;
+
+	while (pos + kEntryHeaderSize <= filesize)
+	{
+		if (std::fseek(f, static_cast<long>(pos), SEEK_SET) != 0 || std::fread(header, sizeof header, 1, f) != 1 ||
+			std::memcmp(header, kEntryMagic, 4) != 0)
+		{
+			break;
+		}
+
+		const std::size_t entrysize = load_u32(header + kEntrySizeOffset);
+		if (entrysize > filesize - pos - kEntryHeaderSize)
+		{
+			break;
+		}
+
+		pos = std::min(pos + kEntryHeaderSize + padded(entrysize), filesize);
+	}
+
+	return pos;
+}
+
+struct GfxCache
+{
+	fs::path path;
+	std::size_t budget = 0;
+
+	GfxCacheMapping file;
+	std::unordered_map<Key, Entry, KeyHash> index;
+	std::size_t end = 0; // of the last whole entry; once writing, of the pack as it is now
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool ready = false;
+
+	// Only ever touched on the main thread, once ready
+	GfxCacheLock lock;
+	FILE* out = nullptr;
+	bool out_failed = false;
+	bool warming = false;
+	std::unordered_set<Key, KeyHash> added;
+	std::unordered_map<lumpnum_t, Key> lump_digests;
+
+	~GfxCache()
+	{
+		if (out)
+		{
+			std::fclose(out);
+		}
+	}
+
+	void load();
+	void warm(std::size_t start, std::size_t stop);
+	void schedule_warm();
+	void wait();
+	bool open_output();
+	bool start_over();
+};
+
+std::shared_ptr<GfxCache> g_gfxcache;
+
+void GfxCache::load()
+{
+	ZoneScoped;
+
+	const std::byte* header = file.open(path) && file.size >= kHeaderSize ? file.view(0, kHeaderSize) : nullptr;
+
+	if (header && std::memcmp(header, kGfxCacheMagic, 4) == 0 && load_u32(header + 4) == kGfxCacheVersion &&
+		file.size <= budget)
+	{
+		std::size_t pos = kHeaderSize;
+
+		// Anything after the first entry that doesn't add up was cut short; it's written over
+		while (pos + kEntryHeaderSize <= file.size)
+		{
+			const std::byte* p = file.view(pos, kEntryHeaderSize);
+			if (!p || std::memcmp(p, kEntryMagic, 4) != 0)
+			{
+				break;
+			}
+
+			Key key;
+			std::memcpy(key.data(), p + 4, key.size());
+
+			Entry entry;
+			entry.offset = pos + kEntryHeaderSize;
+			entry.size = load_u32(p + kEntrySizeOffset);
+			entry.crc = load_u32(p + kEntryCRCOffset);
+			for (int i = 0; i < 4; i++)
+			{
+				entry.meta[i] = static_cast<int32_t>(load_u32(p + kEntryMetaOffset + i * 4));
+			}
+
+			if (entry.size > file.size - entry.offset)
+			{
+				break;
+			}
+
+			// A later copy replaces one that failed its CRC
+			index.insert_or_assign(key, entry);
+			pos = std::min(entry.offset + padded(entry.size), file.size);
+		}
+
+		end = pos;
+	}
+	else
+	{
+		// Missing, from another version, or over budget: start again
+		file.close();
+	}
+
+	{
+		std::lock_guard<std::mutex> _(mutex);
+		ready = true;
+	}
+	cond.notify_all();
+}
+
+// Scheduled from the main thread; the pool only takes jobs from there
+void GfxCache::schedule_warm()
+{
+	if (warming || !g_main_threadpool)
+	{
+		return;
+	}
+
+	warming = true;
+
+	for (std::size_t start = 0; start < end; start += kWarmChunk)
+	{
+		const std::size_t stop = std::min(start + kWarmChunk, end);
+		g_main_threadpool->schedule([cache = g_gfxcache, start, stop]() { cache->warm(start, stop); });
+	}
+	g_main_threadpool->notify();
+}
+
+void GfxCache::warm(std::size_t start, std::size_t stop)
+{
+	ZoneScoped;
+
+#ifdef GFXCACHE_MMAP
+	// Touch a byte of every page, so the lookups don't fault on the disk later
+	volatile std::byte sink {};
+	for (std::size_t pos = start; pos < stop; pos += kPageSize)
+	{
+		sink = file.data[pos];
+	}
+	(void)sink;
+#else
+	// Read as they're looked up
+	(void)start;
+	(void)stop;
+#endif
+}
+
+void GfxCache::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	cond.wait(lock, [this] { return ready; });
+}
+
+bool GfxCache::open_output()
+{
+	if (out)
+	{
+		return true;
+	}
+	if (out_failed)
+	{
+		return false;
+	}
+
+	out_failed = true;
+
+	std::error_code ec;
+	fs::create_directories(path.parent_path(), ec);
+
+	// Another instance is already writing to it
+	if (!lock.acquire(fs::path {path} += ".lock"))
+	{
+		return false;
+	}
+
+	// Other instances may have added to the pack, or started it over, since it was indexed here
+	out = std::fopen(path.string().c_str(), "r+b");
+	end = out ? pack_end(out) : 0;
+
+	if (!end || end > budget)
+	{
+		if (out)
+		{
+			std::fclose(out);
+			out = nullptr;
+		}
+
+		if (!start_over())
+		{
+			CONS_Alert(CONS_WARNING, "Couldn't open graphics cache %s\n", path.string().c_str());
+			return false;
+		}
+	}
+	else if (std::fseek(out, static_cast<long>(end), SEEK_SET) != 0)
+	{
+		std::fclose(out);
+		out = nullptr;
+		return false;
+	}
+#ifdef GFXCACHE_MMAP
+	else
+	{
+		// Drop whatever was cut short, so it can't be mistaken for an entry later.
+		// Nothing past the end was ever indexed, so no mapping ever reads it.
+		(void)!ftruncate(fileno(out), static_cast<off_t>(end));
+	}
+#endif
+
+	out_failed = false;
+	return true;
+}
+
+// Built on the side and renamed into place, so that instances still reading the old pack keep it whole.
+// Where the old one can't be replaced while it's open, nothing is written this time.
+bool GfxCache::start_over()
+{
+	const fs::path next = fs::path {path} += ".new";
+	std::byte header[kHeaderSize];
+	std::error_code ec;
+
+	std::memcpy(header, kGfxCacheMagic, 4);
+	store_u32(header + 4, kGfxCacheVersion);
+
+	std::FILE* f = std::fopen(next.string().c_str(), "wb");
+	if (!f)
+	{
+		return false;
+	}
+
+	const bool written = std::fwrite(header, sizeof header, 1, f) == 1;
+	if (std::fclose(f) != 0 || !written)
+	{
+		fs::remove(next, ec);
+		return false;
+	}
+
+	fs::rename(next, path, ec);
+	if (ec)
+	{
+		fs::remove(next, ec);
+		return false;
+	}
+
+	out = std::fopen(path.string().c_str(), "r+b");
+	if (!out || std::fseek(out, static_cast<long>(kHeaderSize), SEEK_SET) != 0)
+	{
+		if (out)
+		{
+			std::fclose(out);
+			out = nullptr;
+		}
+		return false;
+	}
+
+	end = kHeaderSize;
+	return true;
+}
+
+GfxCache* get_cache()
+{
+	if (!g_gfxcache)
+	{
+		return nullptr;
+	}
+
+	g_gfxcache->wait();
+	g_gfxcache->schedule_warm();
+	return g_gfxcache.get();
+}
+
+} // namespace
+
+void R_InitGfxCache(void)
+{
+	if (dedicated || M_CheckParm("-nogfxcache") || cv_gfxcache_budget.value <= 0)
+	{
+		return;
+	}
+
+	g_gfxcache = std::make_shared<GfxCache>();
+	g_gfxcache->path = fs::path {srb2home} / "cache" / "gfx" / "pack.rrgc";
+	g_gfxcache->budget = static_cast<std::size_t>(cv_gfxcache_budget.value) << 20;
+
+	schedule_or_run([cache = g_gfxcache]() { cache->load(); });
+}
+
+boolean R_GfxCachePNGKey(const UINT8 *png, size_t size, pictureformat_t outformat, pictureflags_t flags, UINT8 *key)
+{
+	std::vector<uint8_t> buffer;
+	Key digest;
+
+	// Internal patches are full of pointers; and truecolor PNGs are matched to the palette
+	if (!g_gfxcache || Picture_IsInternalPatchFormat(outformat) || !pMasterPalette)
+	{
+		return false;
+	}
+
+	md5_buffer(reinterpret_cast<const char*>(png), size, digest.data());
+
+	append(buffer, kPNGKind);
+	buffer.insert(buffer.end(), digest.begin(), digest.end());
+	append(buffer, static_cast<uint32_t>(outformat));
+	append(buffer, static_cast<uint32_t>(flags));
+	append(buffer, static_cast<uint64_t>(size));
+	for (int i = 0; i < 256; i++)
+	{
+		append(buffer, pMasterPalette[i].rgba);
+	}
+
+	const Key k = make_key(buffer);
+	std::memcpy(key, k.data(), k.size());
+	return true;
+}
+
+boolean R_GfxCacheRotationKey(lumpnum_t lump, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip, UINT8 *key)
+{
+	std::vector<uint8_t> buffer;
+	GfxCache* cache = get_cache();
+
+	// A truecolor PNG sprite is matched to the palette before it's rotated
+	if (!cache || lump == LUMPERROR || !pMasterPalette)
+	{
+		return false;
+	}
+
+	// Each lump is only read and hashed the first time one of its angles is needed
+	auto it = cache->lump_digests.find(lump);
+	if (it == cache->lump_digests.end())
+	{
+		const size_t size = W_LumpLength(lump);
+		const void* data = W_CacheLumpNum(lump, PU_CACHE);
+		Key digest;
+
+		if (!size || !data)
+		{
+			return false;
+		}
+
+		md5_buffer(static_cast<const char*>(data), size, digest.data());
+		it = cache->lump_digests.emplace(lump, digest).first;
+	}
+
+	append(buffer, kRotationKind);
+	buffer.insert(buffer.end(), it->second.begin(), it->second.end());
+	append(buffer, static_cast<int32_t>(angle));
+	append(buffer, static_cast<int32_t>(xpivot));
+	append(buffer, static_cast<int32_t>(ypivot));
+	append(buffer, static_cast<uint8_t>(flip ? 1 : 0));
+	for (int i = 0; i < 256; i++)
+	{
+		append(buffer, pMasterPalette[i].rgba);
+	}
+
+	const Key k = make_key(buffer);
+	std::memcpy(key, k.data(), k.size());
+	return true;
+}
+
+const void *R_GfxCacheFind(const UINT8 *key, INT32 *meta, size_t *size)
+{
+	GfxCache* cache = get_cache();
+	Key k;
+
+	if (!cache)
+	{
+		return NULL;
+	}
+
+	std::memcpy(k.data(), key, k.size());
+
+	auto it = cache->index.find(k);
+	if (it == cache->index.end())
+	{
+		return NULL;
+	}
+
+	const Entry& entry = it->second;
+	const std::byte* data = cache->file.view(entry.offset, entry.size);
+
+	// Checked on every hit; a bad one is converted again, and stored again after it
+	if (!data || crc32(0L, reinterpret_cast<const Bytef*>(data), entry.size) != entry.crc)
+	{
+		cache->index.erase(it);
+		return NULL;
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		meta[i] = entry.meta[i];
+	}
+	*size = entry.size;
+	return data;
+}
+
+void R_GfxCacheStore(const UINT8 *key, const INT32 *meta, const void *data, size_t size)
+{
+	GfxCache* cache = get_cache();
+	Key k;
+
+	if (!cache || size > UINT32_MAX)
+	{
+		return;
+	}
+
+	std::memcpy(k.data(), key, k.size());
+
+	if (cache->index.count(k) || cache->added.count(k))
+	{
+		return;
+	}
+
+	// Full; the next session starts the file over
+	if (cache->end + kEntryHeaderSize + padded(size) > cache->budget)
+	{
+		return;
+	}
+
+	if (!cache->open_output())
+	{
+		return;
+	}
+
+	std::byte header[kEntryHeaderSize];
+	const std::byte zero[4] = {};
+
+	std::memcpy(header, kEntryMagic, 4);
+	std::memcpy(header + 4, k.data(), k.size());
+	store_u32(header + kEntrySizeOffset, static_cast<uint32_t>(size));
+	store_u32(header + kEntryCRCOffset, static_cast<uint32_t>(crc32(0L, static_cast<const Bytef*>(data), static_cast<uInt>(size))));
+	for (int i = 0; i < 4; i++)
+	{
+		store_u32(header + kEntryMetaOffset + i * 4, static_cast<uint32_t>(meta[i]));
+	}
+
+	// An entry that's cut short fails the size check when the pack is next indexed, which stops there
+	if (std::fwrite(header, sizeof header, 1, cache->out) != 1 ||
+		(size && std::fwrite(data, size, 1, cache->out) != 1) ||
+		(padded(size) != size && std::fwrite(zero, padded(size) - size, 1, cache->out) != 1) ||
+		std::fflush(cache->out) != 0)
+	{
+		CONS_Alert(CONS_WARNING, "Couldn't write to graphics cache %s\n", cache->path.string().c_str());
+		std::fclose(cache->out);
+		cache->out = nullptr;
+		cache->out_failed = true;
+		return;
+	}
+
+	cache->end += kEntryHeaderSize + padded(size);
+	cache->added.insert(k);
+}
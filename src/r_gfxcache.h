@@ -0,0 +1,64 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_gfxcache.h
+/// \brief Disk cache of converted PNGs and rotated sprites
+
+#ifndef __R_GFXCACHE_H__
+#define __R_GFXCACHE_H__
+
+#include "doomtype.h"
+#include "command.h"
+#include "r_picformats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GFXCACHE_KEYSIZE 16
+
+// Size of the cache file, in megabytes; 0 turns the cache off.
+extern consvar_t cv_gfxcache_budget;
+
+/**	\brief	Opens srb2home/cache/gfx/pack.rrgc, indexing it and paging it in
+			on the thread pool. Lookups made before that's done wait for it.
+			Only one running instance writes to it, the first to store anything.
+*/
+void R_InitGfxCache(void);
+
+/**	\brief	Key for a PNG lump converted by Picture_PNGConvert.
+
+	\return	false if this conversion can't be cached
+*/
+boolean R_GfxCachePNGKey(const UINT8 *png, size_t size, pictureformat_t outformat, pictureflags_t flags, UINT8 *key);
+
+/**	\brief	Key for one angle of a sprite lump rotated by RotatedPatch_DoRotation.
+
+	\return	false if this rotation can't be cached
+*/
+boolean R_GfxCacheRotationKey(lumpnum_t lump, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip, UINT8 *key);
+
+/**	\brief	Looks up a cached picture.
+
+	\param	key	from one of the key functions
+	\param	meta	filled with the four values it was stored with
+	\param	size	filled with the size of the picture
+	\return	the picture, read-only and valid until the next lookup, or NULL
+*/
+const void *R_GfxCacheFind(const UINT8 *key, INT32 *meta, size_t *size);
+
+/**	\brief	Adds a picture to the cache file, if the budget allows.
+			Failing to write only means it's converted again next time.
+*/
+void R_GfxCacheStore(const UINT8 *key, const INT32 *meta, const void *data, size_t size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __R_GFXCACHE_H__
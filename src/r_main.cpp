@@ -38,6 +38,7 @@
 #include "r_portal.h"
 #include "r_main.h"
 #include "i_system.h" // I_GetPreciseTime
+#include "m_trace.h"
 #include "doomstat.h" // MAXSPLITSCREENPLAYERS
 #include "r_fps.h" // Frame interpolation/uncapped
 #include "core/thread_pool.h"
@@ -1546,6 +1547,7 @@ void R_RenderPlayerView(void)
 	R_RenderViewpoint(&masks[nummasks - 1], nummasks - 1);
 
 	ps_bsptime = I_GetPreciseTime() - ps_bsptime;
+	M_TraceDuration("R_RenderViewpoint", ps_bsptime);
 #ifdef TIMING
 	RDMSR(0x10, &mycount);
 	mytotal += mycount; // 64bit add
@@ -12,6 +12,7 @@
 /// \brief Patch rotation.
 
 #include "r_patchrotation.h"
+#include "r_gfxcache.h"
 #include "r_things.h" // FEETADJUST
 #include "z_zone.h"
 #include "w_wad.h"
@@ -117,6 +118,9 @@ patch_t *Patch_GetRotated(patch_t *patch, INT32 angle, boolean flip)
 	return rotsprite->patches[angle];
 }
 
+static void RotatedPatch_Rotate(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip, const UINT8 *cachekey);
+static boolean RotatedPatch_FromCache(rotsprite_t *rotsprite, INT32 idx, const UINT8 *cachekey);
+
 patch_t *Patch_GetRotatedSprite(
 	spriteframe_t *sprite,
 	size_t frame, size_t spriteangle,
@@ -147,6 +151,8 @@ patch_t *Patch_GetRotatedSprite(
 		patch_t *patch;
 		INT32 xpivot = 0, ypivot = 0;
 		lumpnum_t lump = sprite->lumppat[spriteangle];
+		UINT8 cachekey[GFXCACHE_KEYSIZE];
+		boolean cacheable;
 
 		if (lump == LUMPERROR)
 			return NULL;
@@ -169,7 +175,9 @@ patch_t *Patch_GetRotatedSprite(
 			ypivot = patch->height / 2;
 		}
 
-		RotatedPatch_DoRotation(rotsprite, patch, rotationangle, xpivot, ypivot, flip);
+		cacheable = R_GfxCacheRotationKey(lump, rotationangle, xpivot, ypivot, flip, cachekey);
+		if (!cacheable || !RotatedPatch_FromCache(rotsprite, idx, cachekey))
+			RotatedPatch_Rotate(rotsprite, patch, rotationangle, xpivot, ypivot, flip, cacheable ? cachekey : NULL);
 
 		//BP: we cannot use special tric in hardware mode because feet in ground caused by z-buffer
 		if (adjustfeet)
@@ -216,9 +224,39 @@ static void RotatedPatch_CalculateDimensions(
 	*newheight = max(height, max(h1, h2));
 }
 
+// Makes a rotated picture into the patch for that angle.
+static void RotatedPatch_Store(rotsprite_t *rotsprite, INT32 idx, UINT16 *raw, INT32 width, INT32 height, INT32 leftoffset, INT32 topoffset)
+{
+	patch_t *rotated = (patch_t *)Picture_Convert(PICFMT_FLAT16, raw, PICFMT_PATCH, 0, NULL, width, height, 0, 0, 0);
+
+	Z_ChangeTag(rotated, PU_PATCH_ROTATED);
+	Z_SetUser(rotated, (void **)(&rotsprite->patches[idx]));
+
+	rotated->leftoffset = leftoffset;
+	rotated->topoffset = topoffset;
+}
+
+// The rotated picture is read straight out of the cache; it stays valid until the next lookup.
+static boolean RotatedPatch_FromCache(rotsprite_t *rotsprite, INT32 idx, const UINT8 *cachekey)
+{
+	INT32 meta[4];
+	size_t size;
+	const void *cached = R_GfxCacheFind(cachekey, meta, &size);
+
+	if (!cached || meta[0] <= 0 || meta[1] <= 0 || size != (size_t)meta[0] * meta[1] * sizeof(UINT16))
+		return false;
+
+	RotatedPatch_Store(rotsprite, idx, (UINT16 *)cached, meta[0], meta[1], meta[2], meta[3]);
+	return true;
+}
+
 void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip)
 {
-	patch_t *rotated;
+	RotatedPatch_Rotate(rotsprite, patch, angle, xpivot, ypivot, flip, NULL);
+}
+
+static void RotatedPatch_Rotate(rotsprite_t *rotsprite, patch_t *patch, INT32 angle, INT32 xpivot, INT32 ypivot, boolean flip, const UINT8 *cachekey)
+{
 	UINT16 *rawdst, *rawconv;
 	size_t size;
 	pictureflags_t bflip = (flip) ? PICFLAGS_XFLIP : 0;
@@ -341,14 +379,14 @@ void RotatedPatch_DoRotation(rotsprite_t *rotsprite, patch_t *patch, INT32 angle
 		height = newheight;
 	}
 
-	// make patch
-	rotated = (patch_t *)Picture_Convert(PICFMT_FLAT16, rawconv, PICFMT_PATCH, 0, NULL, width, height, 0, 0, 0);
+	if (cachekey)
+	{
+		const INT32 meta[4] = {width, height, ox, oy};
+		R_GfxCacheStore(cachekey, meta, rawconv, (size_t)width * height * sizeof(UINT16));
+	}
 
-	Z_ChangeTag(rotated, PU_PATCH_ROTATED);
-	Z_SetUser(rotated, (void **)(&rotsprite->patches[idx]));
+	// make patch
+	RotatedPatch_Store(rotsprite, idx, rawconv, width, height, ox, oy);
 	Z_Free(rawconv);
-
-	rotated->leftoffset = ox;
-	rotated->topoffset = oy;
 }
 #endif
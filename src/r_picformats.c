@@ -25,6 +25,7 @@
 #include "z_zone.h"
 #include "w_wad.h"
 #include "r_main.h" // R_PointToAngle
+#include "r_gfxcache.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_glob.h"
@@ -1096,6 +1097,10 @@ void *Picture_PNGConvert(
 	INT32 pngwidth, pngheight;
 	INT16 loffs = 0, toffs = 0;
 
+	UINT8 cachekey[GFXCACHE_KEYSIZE];
+	boolean cacheable;
+	INT32 cachemeta[4];
+
 	if (png == NULL)
 		I_Error("Picture_PNGConvert: picture was NULL!");
 
@@ -1108,6 +1113,28 @@ void *Picture_PNGConvert(
 	if (leftoffset == NULL)
 		leftoffset = &loffs;
 
+	// Converted before?
+	cacheable = R_GfxCachePNGKey(png, insize, outformat, flags, cachekey);
+	if (cacheable)
+	{
+		size_t cachedsize;
+		const void *cached = R_GfxCacheFind(cachekey, cachemeta, &cachedsize);
+
+		if (cached)
+		{
+			flat = Z_Malloc(cachedsize, PU_STATIC, NULL);
+			M_Memcpy(flat, cached, cachedsize);
+
+			*w = cachemeta[0];
+			*h = cachemeta[1];
+			*topoffset = (INT16)cachemeta[2];
+			*leftoffset = (INT16)cachemeta[3];
+			if (outsize)
+				*outsize = cachedsize;
+			return flat;
+		}
+	}
+
 	row_pointers = PNG_Read(png, w, h, topoffset, leftoffset, &palette, insize);
 	width = *w;
 	height = *h;
@@ -1135,6 +1162,11 @@ void *Picture_PNGConvert(
 	if (outsize)
 		*outsize = flatsize;
 
+	cachemeta[0] = *w;
+	cachemeta[1] = *h;
+	cachemeta[2] = *topoffset;
+	cachemeta[3] = *leftoffset;
+
 	// Convert the image
 	flat = Z_Calloc(flatsize, PU_STATIC, NULL);
 
@@ -1293,11 +1325,19 @@ void *Picture_PNGConvert(
 		}
 
 		// Now, convert it!
-		converted = Picture_PatchConvert(informat, flat, outformat, insize, outsize, (INT16)width, (INT16)height, *leftoffset, *topoffset, flags);
+		converted = Picture_PatchConvert(informat, flat, outformat, insize, &flatsize, (INT16)width, (INT16)height, *leftoffset, *topoffset, flags);
 		Z_Free(flat);
+
+		if (outsize)
+			*outsize = flatsize;
+		if (cacheable)
+			R_GfxCacheStore(cachekey, cachemeta, converted, flatsize);
 		return converted;
 	}
 
+	if (cacheable)
+		R_GfxCacheStore(cachekey, cachemeta, flat, flatsize);
+
 	// Return the converted flat!
 	return flat;
 }
@@ -36,6 +36,7 @@
 #include "r_splats.h"
 #include "p_tick.h"
 #include "p_local.h"
+#include "p_precip.h"
 #include "p_slopes.h"
 #include "d_netfil.h" // blargh. for nameonly().
 #include "m_cheat.h" // objectplace
@@ -838,9 +839,7 @@ UINT8 *R_GetSpriteTranslation(vissprite_t *vis)
 {
 	if (vis->cut & SC_PRECIP)
 	{
-		// Simplified func, less safe properties to check
-		if (vis->mobj->color)
-			R_GetTranslationColormap(TC_DEFAULT, static_cast<skincolornum_t>(vis->mobj->color), GTC_CACHE);
+		// Precipitation is never colored
 		return NULL;
 	}
 
@@ -2581,7 +2580,7 @@ static void R_ProjectSprite(mobj_t *thing)
 	++objectsdrawn;
 }
 
-static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
+static void R_ProjectPrecipitationSprite(UINT32 i)
 {
 	fixed_t tr_x, tr_y;
 	fixed_t tx, tz;
@@ -2604,23 +2603,21 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	UINT32 blendmode;
 	UINT32 trans;
 
+	const spritenum_t sprite = states[precip.state[i]].sprite;
+	const UINT32 frame = precip.frame[i];
+	sector_t *const sector = precip.subsector[i]->sector;
+
 	// uncapped/interpolation
 	interpmobjstate_t interp = {0};
 
-	// okay... this is a hack, but weather isn't networked, so it should be ok
-	if (!P_PrecipThinker(thing))
-	{
-		return;
-	}
-
 	// do interpolation
 	if (R_UsingFrameInterpolation() && !paused)
 	{
-		R_InterpolatePrecipMobjState(thing, rendertimefrac, &interp);
+		R_InterpolatePrecipState(i, rendertimefrac, &interp);
 	}
 	else
 	{
-		R_InterpolatePrecipMobjState(thing, FRACUNIT, &interp);
+		R_InterpolatePrecipState(i, FRACUNIT, &interp);
 	}
 
 	this_scale = interp.scale;
@@ -2646,27 +2643,27 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	yscale = FixedDiv(projectiony[viewssnum], tz);
 
 	// decide which patch to use for sprite relative to player
-	if ((unsigned)thing->sprite >= numsprites)
+	if ((unsigned)sprite >= numsprites)
 	{
 		CONS_Debug(DBG_RENDER, "R_ProjectPrecipitationSprite: invalid sprite number %d\n",
-			thing->sprite);
+			sprite);
 		return;
 	}
 
-	sprdef = &sprites[thing->sprite];
+	sprdef = &sprites[sprite];
 
-	if ((UINT8)(thing->frame&FF_FRAMEMASK) >= sprdef->numframes)
+	if ((UINT8)(frame&FF_FRAMEMASK) >= sprdef->numframes)
 	{
 		CONS_Debug(DBG_RENDER, "R_ProjectPrecipitationSprite: invalid sprite frame %d : %d for %s\n",
-			thing->sprite, thing->frame, sprnames[thing->sprite]);
+			sprite, frame, sprnames[sprite]);
 		return;
 	}
 
-	sprframe = &sprdef->spriteframes[thing->frame & FF_FRAMEMASK];
+	sprframe = &sprdef->spriteframes[frame & FF_FRAMEMASK];
 
 #ifdef PARANOIA
 	if (!sprframe)
-		I_Error("R_ProjectPrecipitationSprite: sprframes NULL for sprite %d\n", thing->sprite);
+		I_Error("R_ProjectPrecipitationSprite: sprframes NULL for sprite %d\n", sprite);
 #endif
 
 	// use single rotation for all views
@@ -2701,19 +2698,19 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	gzt = interp.z + FixedMul(spritecachedinfo[lump].topoffset, this_scale);
 	gz = gzt - FixedMul(spritecachedinfo[lump].height, this_scale);
 
-	if (thing->subsector->sector->cullheight)
+	if (sector->cullheight)
 	{
-		if (R_DoCulling(thing->subsector->sector->cullheight, viewsector->cullheight, viewz, gz, gzt))
+		if (R_DoCulling(sector->cullheight, viewsector->cullheight, viewz, gz, gzt))
 			return;
 	}
 
 	// Determine the blendmode and translucency value
 	{
-		blendmode = (thing->frame & FF_BLENDMASK) >> FF_BLENDSHIFT;
+		blendmode = (frame & FF_BLENDMASK) >> FF_BLENDSHIFT;
 		if (blendmode)
 			blendmode++; // realign to constants
 
-		trans = (thing->frame & FF_TRANSMASK) >> FF_TRANSSHIFT;
+		trans = (frame & FF_TRANSMASK) >> FF_TRANSSHIFT;
 		if (trans >= NUMTRANSMAPS)
 			return; // cap
 	}
@@ -2745,7 +2742,7 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	vis->x2test = 0;
 
 	vis->xscale = xscale; //SoM: 4/17/2000
-	vis->sector = thing->subsector->sector;
+	vis->sector = sector;
 	vis->szt = (INT16)((centeryfrac - FixedMul(vis->gzt - viewz, yscale))>>FRACBITS);
 	vis->sz = (INT16)((centeryfrac - FixedMul(vis->gz - viewz, yscale))>>FRACBITS);
 
@@ -2760,16 +2757,16 @@ static void R_ProjectPrecipitationSprite(precipmobj_t *thing)
 	//Fab: lumppat is the lump number of the patch to use, this is different
 	//     than lumpid for sprites-in-pwad : the graphics are patched
 	vis->patch = static_cast<patch_t*>(W_CachePatchNum(sprframe->lumppat[0], PU_SPRITE));
-	vis->bright = R_CacheSpriteBrightMap(&spriteinfo[thing->sprite],
-			thing->frame & FF_FRAMEMASK);
+	vis->bright = R_CacheSpriteBrightMap(&spriteinfo[sprite],
+			frame & FF_FRAMEMASK);
 
 	vis->transmap = R_GetBlendTable(blendmode, trans);
 
-	vis->mobj = (mobj_t *)thing;
+	vis->mobj = NULL; // particles aren't mobjs; SC_PRECIP says so
 	vis->mobjflags = 0;
 	vis->cut = SC_PRECIP;
-	vis->extra_colormap = thing->subsector->sector->extra_colormap;
-	vis->heightsec = thing->subsector->sector->heightsec;
+	vis->extra_colormap = sector->extra_colormap;
+	vis->heightsec = sector->heightsec;
 
 	// Fullbright
 	vis->colormap = colormaps;
@@ -2855,10 +2852,10 @@ void R_AddPrecipitationSprites(void)
 	const fixed_t drawdist = cv_drawdist_precip.value * mapobjectscale;
 
 	INT32 xl, xh, yl, yh, bx, by;
-	precipmobj_t *th, *next;
+	UINT32 i;
 
 	// no, no infinite draw distance for precipitation. this option at zero is supposed to turn it off
-	if (drawdist == 0)
+	if (drawdist == 0 || !precip.cells)
 	{
 		return;
 	}
@@ -2875,14 +2872,21 @@ void R_AddPrecipitationSprites(void)
 	{
 		for (by = yl; by <= yh; by++)
 		{
-			for (th = precipblocklinks[(by * bmapwidth) + bx]; th; th = next)
+			precipcell_t *cell = &precip.cells[(by * bmapwidth) + bx];
+
+			if (!cell->count || !R_PrecipCellVisible(bx, by))
 			{
-				// Store this beforehand because R_ProjectPrecipitionSprite may free th (see P_PrecipThinker)
-				next = th->bnext;
+				continue;
+			}
+
+			// okay... this is a hack, but weather isn't networked, so it should be ok
+			P_PrecipThinkCell(cell);
 
-				if (R_PrecipThingVisible(th))
+			for (i = cell->first; i < cell->first + cell->count; i++)
+			{
+				if (R_PrecipThingVisible(i))
 				{
-					R_ProjectPrecipitationSprite(th);
+					R_ProjectPrecipitationSprite(i);
 				}
 			}
 		}
@@ -3305,7 +3309,7 @@ static void R_CreateDrawNodes(maskcount_t* mask, drawnode_t* head, boolean temps
 					{
 						fixed_t z1 = 0, z2 = 0;
 
-						if (rover->mobj->z - viewz > 0)
+						if (((rover->cut & SC_PRECIP) ? rover->pz : rover->mobj->z) - viewz > 0)
 						{
 							z1 = rover->pz;
 							z2 = r2->sprite->pz;
@@ -3830,10 +3834,46 @@ boolean R_ThingWithinDist (mobj_t *thing, fixed_t limit_dist)
 	return true;
 }
 
+// How far past its blockmap cell a particle's sprite can reach
+#define PRECIPCELLMARGIN (32*FRACUNIT)
+
+/* Check if any of a blockmap cell's precipitation may be drawn from our current view. */
+boolean R_PrecipCellVisible (INT32 bx, INT32 by)
+{
+	const fixed_t margin = FixedMul(PRECIPCELLMARGIN, mapobjectscale);
+	const fixed_t left = bmaporgx + (bx << MAPBLOCKSHIFT) - margin;
+	const fixed_t bottom = bmaporgy + (by << MAPBLOCKSHIFT) - margin;
+	const fixed_t right = left + MAPBLOCKSIZE + 2*margin;
+	const fixed_t top = bottom + MAPBLOCKSIZE + 2*margin;
+	const fixed_t corners[4][2] = {{left, bottom}, {right, bottom}, {left, top}, {right, top}};
+	INT32 behind = 0, leftof = 0, rightof = 0;
+	INT32 i;
+
+	// The same tests R_ProjectPrecipitationSprite makes, against all four corners.
+	// Each one is a half-plane, so if every corner fails it, so does everything in between.
+	for (i = 0; i < 4; i++)
+	{
+		const INT64 tr_x = (INT64)corners[i][0] - viewx;
+		const INT64 tr_y = (INT64)corners[i][1] - viewy;
+		const INT64 tz = (tr_x * viewcos + tr_y * viewsin) >> FRACBITS;
+		const INT64 tx = (tr_x * viewsin - tr_y * viewcos) >> FRACBITS;
+		const INT64 limit = ((tz * fovtan[viewssnum]) >> FRACBITS) << 2;
+
+		if (tz < 0)
+			behind++;
+		if (tx > limit)
+			rightof++;
+		else if (tx < -limit)
+			leftof++;
+	}
+
+	return (behind < 4 && rightof < 4 && leftof < 4);
+}
+
 /* Check if precipitation may be drawn from our current view. */
-boolean R_PrecipThingVisible (precipmobj_t *precipthing)
+boolean R_PrecipThingVisible (UINT32 i)
 {
-	if (( precipthing->precipflags & PCF_INVISIBLE ))
+	if (( precip.flags[i] & (PCF_INVISIBLE|PCF_REMOVED) ))
 		return false;
 
 	return true;
@@ -0,0 +1,379 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "null_rhi.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "../../cxxutil.hpp"
+
+using namespace srb2;
+using namespace rhi;
+
+NullRhi::NullRhi() = default;
+
+NullRhi::~NullRhi() = default;
+
+Handle<RenderPass> NullRhi::create_render_pass(const RenderPassDesc& desc)
+{
+	return render_pass_slab_.insert(NullRenderPass {{}, desc});
+}
+
+void NullRhi::destroy_render_pass(Handle<RenderPass> handle)
+{
+	SRB2_ASSERT(render_pass_slab_.is_valid(handle) == true);
+	render_pass_slab_.remove(handle);
+}
+
+Handle<Pipeline> NullRhi::create_pipeline(const PipelineDesc& desc)
+{
+	return pipeline_slab_.insert(NullPipeline {{}, desc});
+}
+
+void NullRhi::destroy_pipeline(Handle<Pipeline> handle)
+{
+	SRB2_ASSERT(pipeline_slab_.is_valid(handle) == true);
+	pipeline_slab_.remove(handle);
+}
+
+Handle<Texture> NullRhi::create_texture(const TextureDesc& desc)
+{
+	stats_.textures_created++;
+	return texture_slab_.insert(NullTexture {{}, desc});
+}
+
+void NullRhi::destroy_texture(Handle<Texture> handle)
+{
+	SRB2_ASSERT(texture_slab_.is_valid(handle) == true);
+	texture_slab_.remove(handle);
+}
+
+Handle<Buffer> NullRhi::create_buffer(const BufferDesc& desc)
+{
+	stats_.buffers_created++;
+	return buffer_slab_.insert(NullBuffer {{}, desc});
+}
+
+void NullRhi::destroy_buffer(Handle<Buffer> handle)
+{
+	SRB2_ASSERT(buffer_slab_.is_valid(handle) == true);
+	buffer_slab_.remove(handle);
+}
+
+Handle<Renderbuffer> NullRhi::create_renderbuffer(const RenderbufferDesc& desc)
+{
+	return renderbuffer_slab_.insert(NullRenderbuffer {{}, desc});
+}
+
+void NullRhi::destroy_renderbuffer(Handle<Renderbuffer> handle)
+{
+	SRB2_ASSERT(renderbuffer_slab_.is_valid(handle) == true);
+	renderbuffer_slab_.remove(handle);
+}
+
+TextureDetails NullRhi::get_texture_details(Handle<Texture> texture)
+{
+	SRB2_ASSERT(texture_slab_.is_valid(texture));
+	auto& t = texture_slab_[texture];
+
+	TextureDetails ret {};
+	ret.format = t.desc.format;
+	ret.width = t.desc.width;
+	ret.height = t.desc.height;
+
+	return ret;
+}
+
+Rect NullRhi::get_renderbuffer_size(Handle<Renderbuffer> renderbuffer)
+{
+	SRB2_ASSERT(renderbuffer_slab_.is_valid(renderbuffer));
+	auto& rb = renderbuffer_slab_[renderbuffer];
+
+	return {0, 0, rb.desc.width, rb.desc.height};
+}
+
+uint32_t NullRhi::get_buffer_size(Handle<Buffer> buffer)
+{
+	SRB2_ASSERT(buffer_slab_.is_valid(buffer));
+	return buffer_slab_[buffer].desc.size;
+}
+
+void NullRhi::update_buffer(
+	Handle<GraphicsContext> ctx,
+	Handle<Buffer> buffer,
+	uint32_t offset,
+	tcb::span<const std::byte> data
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(ctx.generation() == graphics_context_generation_);
+	SRB2_ASSERT(buffer_slab_.is_valid(buffer) == true);
+	auto& b = buffer_slab_[buffer];
+	SRB2_ASSERT(offset < b.desc.size && offset + data.size() <= b.desc.size);
+
+	stats_.buffer_uploads++;
+	stats_.buffer_upload_bytes += data.size_bytes();
+}
+
+void NullRhi::update_texture(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> texture,
+	Rect region,
+	srb2::rhi::PixelFormat data_format,
+	tcb::span<const std::byte> data
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(ctx.generation() == graphics_context_generation_);
+	SRB2_ASSERT(texture_slab_.is_valid(texture) == true);
+	auto& t = texture_slab_[texture];
+	SRB2_ASSERT(region.x >= 0 && region.y >= 0);
+	SRB2_ASSERT(region.x + region.w <= t.desc.width && region.y + region.h <= t.desc.height);
+	(void)data_format;
+
+	stats_.texture_uploads++;
+	stats_.texture_upload_bytes += data.size_bytes();
+}
+
+void NullRhi::update_texture_settings(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> texture,
+	TextureWrapMode u_wrap,
+	TextureWrapMode v_wrap,
+	TextureFilterMode min,
+	TextureFilterMode mag
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(texture_slab_.is_valid(texture) == true);
+	auto& t = texture_slab_[texture];
+	t.desc.u_wrap = u_wrap;
+	t.desc.v_wrap = v_wrap;
+	t.desc.min = min;
+	t.desc.mag = mag;
+}
+
+Handle<UniformSet> NullRhi::create_uniform_set(Handle<GraphicsContext> ctx, const CreateUniformSetInfo& info)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(ctx.generation() == graphics_context_generation_);
+	(void)info;
+
+	stats_.uniform_sets++;
+	return uniform_set_slab_.insert(NullUniformSet {});
+}
+
+Handle<BindingSet>
+NullRhi::create_binding_set(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline, const CreateBindingSetInfo& info)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(ctx.generation() == graphics_context_generation_);
+	SRB2_ASSERT(pipeline_slab_.is_valid(pipeline) == true);
+	auto& pl = pipeline_slab_[pipeline];
+	SRB2_ASSERT(info.vertex_buffers.size() == pl.desc.vertex_input.buffer_layouts.size());
+	SRB2_ASSERT(info.sampler_textures.size() == pl.desc.sampler_input.enabled_samplers.size());
+
+	for (auto& binding : info.sampler_textures)
+	{
+		SRB2_ASSERT(texture_slab_.is_valid(binding.texture) == true);
+	}
+
+	stats_.binding_sets++;
+	return binding_set_slab_.insert(NullBindingSet {});
+}
+
+Handle<GraphicsContext> NullRhi::begin_graphics()
+{
+	SRB2_ASSERT(graphics_context_active_ == false);
+	graphics_context_active_ = true;
+	return Handle<GraphicsContext>(0, graphics_context_generation_);
+}
+
+void NullRhi::end_graphics(Handle<GraphicsContext> ctx)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(ctx.generation() == graphics_context_generation_);
+	SRB2_ASSERT(current_pipeline_.has_value() == false && render_pass_active_ == false);
+	graphics_context_generation_ += 1;
+	if (graphics_context_generation_ == 0)
+	{
+		graphics_context_generation_ = 1;
+	}
+	graphics_context_active_ = false;
+}
+
+void NullRhi::begin_default_render_pass(Handle<GraphicsContext> ctx, bool clear)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(render_pass_active_ == false);
+	(void)ctx;
+	(void)clear;
+
+	render_pass_active_ = true;
+	stats_.render_passes++;
+}
+
+void NullRhi::begin_render_pass(Handle<GraphicsContext> ctx, const RenderPassBeginInfo& info)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(render_pass_active_ == false);
+	SRB2_ASSERT(render_pass_slab_.is_valid(info.render_pass) == true);
+	SRB2_ASSERT(texture_slab_.is_valid(info.color_attachment) == true);
+	(void)ctx;
+
+	render_pass_active_ = true;
+	stats_.render_passes++;
+}
+
+void NullRhi::end_render_pass(Handle<GraphicsContext> ctx)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(render_pass_active_ == true);
+	(void)ctx;
+
+	current_pipeline_ = std::nullopt;
+	render_pass_active_ = false;
+}
+
+void NullRhi::bind_pipeline(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(render_pass_active_ == true);
+	SRB2_ASSERT(pipeline_slab_.is_valid(pipeline) == true);
+	(void)ctx;
+
+	current_pipeline_ = pipeline;
+	stats_.pipeline_binds++;
+}
+
+void NullRhi::bind_uniform_set(Handle<GraphicsContext> ctx, uint32_t slot, Handle<UniformSet> set)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(current_pipeline_.has_value());
+	SRB2_ASSERT(uniform_set_slab_.is_valid(set) == true);
+	(void)ctx;
+	(void)slot;
+}
+
+void NullRhi::bind_binding_set(Handle<GraphicsContext> ctx, Handle<BindingSet> set)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(current_pipeline_.has_value());
+	SRB2_ASSERT(binding_set_slab_.is_valid(set) == true);
+	(void)ctx;
+}
+
+void NullRhi::bind_index_buffer(Handle<GraphicsContext> ctx, Handle<Buffer> buffer)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(buffer_slab_.is_valid(buffer) == true);
+	SRB2_ASSERT(buffer_slab_[buffer].desc.type == BufferType::kIndexBuffer);
+	(void)ctx;
+}
+
+void NullRhi::set_scissor(Handle<GraphicsContext> ctx, const Rect& rect)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	(void)ctx;
+	(void)rect;
+}
+
+void NullRhi::set_viewport(Handle<GraphicsContext> ctx, const Rect& rect)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	(void)ctx;
+	(void)rect;
+}
+
+void NullRhi::draw(Handle<GraphicsContext> ctx, uint32_t vertex_count, uint32_t first_vertex)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(current_pipeline_.has_value());
+	(void)ctx;
+	(void)first_vertex;
+
+	stats_.draw_calls++;
+	stats_.vertices_drawn += vertex_count;
+}
+
+void NullRhi::draw_indexed(Handle<GraphicsContext> ctx, uint32_t index_count, uint32_t first_index)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(current_pipeline_.has_value());
+	(void)ctx;
+	(void)first_index;
+
+	stats_.draw_calls++;
+	stats_.vertices_drawn += index_count;
+}
+
+void NullRhi::read_pixels(Handle<GraphicsContext> ctx, const Rect& rect, PixelFormat format, tcb::span<std::byte> out)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(render_pass_active_ == true);
+	(void)ctx;
+	(void)rect;
+	(void)format;
+
+	std::fill(out.begin(), out.end(), std::byte {0});
+}
+
+void NullRhi::copy_framebuffer_to_texture(
+	Handle<GraphicsContext> ctx,
+	Handle<Texture> dst_tex,
+	const Rect& dst_region,
+	const Rect& src_region
+)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	SRB2_ASSERT(render_pass_active_ == true);
+	SRB2_ASSERT(texture_slab_.is_valid(dst_tex));
+	(void)ctx;
+	(void)dst_region;
+	(void)src_region;
+}
+
+void NullRhi::set_stencil_reference(Handle<GraphicsContext> ctx, CullMode face, uint8_t reference)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	(void)ctx;
+	(void)face;
+	(void)reference;
+}
+
+void NullRhi::set_stencil_compare_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	(void)ctx;
+	(void)face;
+	(void)mask;
+}
+
+void NullRhi::set_stencil_write_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask)
+{
+	SRB2_ASSERT(graphics_context_active_ == true);
+	(void)ctx;
+	(void)face;
+	(void)mask;
+}
+
+void NullRhi::present()
+{
+	SRB2_ASSERT(graphics_context_active_ == false);
+}
+
+void NullRhi::finish()
+{
+	SRB2_ASSERT(graphics_context_active_ == false);
+
+	binding_set_slab_.clear();
+	uniform_set_slab_.clear();
+}
@@ -0,0 +1,175 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Ronald "Eidolon" Kinard
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_RHI_NULL_RHI_HPP__
+#define __SRB2_RHI_NULL_RHI_HPP__
+
+#include <cstdint>
+#include <optional>
+
+#include "../rhi.hpp"
+
+namespace srb2::rhi
+{
+
+/// @brief Work submitted to a NullRhi since the last reset_stats.
+struct NullRhiStats
+{
+	uint32_t draw_calls = 0;
+	uint64_t vertices_drawn = 0; ///< indices for indexed draws
+	uint32_t pipeline_binds = 0;
+	uint32_t binding_sets = 0;
+	uint32_t uniform_sets = 0;
+	uint32_t render_passes = 0;
+	uint32_t textures_created = 0;
+	uint32_t texture_uploads = 0;
+	uint64_t texture_upload_bytes = 0;
+	uint32_t buffers_created = 0;
+	uint32_t buffer_uploads = 0;
+	uint64_t buffer_upload_bytes = 0;
+};
+
+struct NullTexture : public rhi::Texture
+{
+	rhi::TextureDesc desc;
+};
+
+struct NullBuffer : public rhi::Buffer
+{
+	rhi::BufferDesc desc;
+};
+
+struct NullRenderPass : public rhi::RenderPass
+{
+	rhi::RenderPassDesc desc;
+};
+
+struct NullRenderbuffer : public rhi::Renderbuffer
+{
+	rhi::RenderbufferDesc desc;
+};
+
+struct NullPipeline : public rhi::Pipeline
+{
+	rhi::PipelineDesc desc;
+};
+
+struct NullUniformSet : public rhi::UniformSet
+{
+};
+
+struct NullBindingSet : public rhi::BindingSet
+{
+};
+
+/// @brief A device which validates and counts the work it is given but renders nothing. Lets the CPU side of hwr2
+/// run, and be measured, without a GPU.
+class NullRhi final : public Rhi
+{
+	Slab<NullRenderPass> render_pass_slab_;
+	Slab<NullTexture> texture_slab_;
+	Slab<NullBuffer> buffer_slab_;
+	Slab<NullRenderbuffer> renderbuffer_slab_;
+	Slab<NullPipeline> pipeline_slab_;
+	Slab<NullUniformSet> uniform_set_slab_;
+	Slab<NullBindingSet> binding_set_slab_;
+
+	bool graphics_context_active_ = false;
+	uint32_t graphics_context_generation_ = 1;
+	bool render_pass_active_ = false;
+	std::optional<Handle<Pipeline>> current_pipeline_;
+
+	NullRhiStats stats_;
+
+public:
+	NullRhi();
+	virtual ~NullRhi();
+
+	const NullRhiStats& stats() const noexcept { return stats_; }
+	void reset_stats() noexcept { stats_ = {}; }
+
+	virtual Handle<RenderPass> create_render_pass(const RenderPassDesc& desc) override;
+	virtual void destroy_render_pass(Handle<RenderPass> handle) override;
+	virtual Handle<Pipeline> create_pipeline(const PipelineDesc& desc) override;
+	virtual void destroy_pipeline(Handle<Pipeline> handle) override;
+
+	virtual Handle<Texture> create_texture(const TextureDesc& desc) override;
+	virtual void destroy_texture(Handle<Texture> handle) override;
+	virtual Handle<Buffer> create_buffer(const BufferDesc& desc) override;
+	virtual void destroy_buffer(Handle<Buffer> handle) override;
+	virtual Handle<Renderbuffer> create_renderbuffer(const RenderbufferDesc& desc) override;
+	virtual void destroy_renderbuffer(Handle<Renderbuffer> handle) override;
+
+	virtual TextureDetails get_texture_details(Handle<Texture> texture) override;
+	virtual Rect get_renderbuffer_size(Handle<Renderbuffer> renderbuffer) override;
+	virtual uint32_t get_buffer_size(Handle<Buffer> buffer) override;
+
+	virtual void update_buffer(
+		Handle<GraphicsContext> ctx,
+		Handle<Buffer> buffer,
+		uint32_t offset,
+		tcb::span<const std::byte> data
+	) override;
+	virtual void update_texture(
+		Handle<GraphicsContext> ctx,
+		Handle<Texture> texture,
+		Rect region,
+		srb2::rhi::PixelFormat data_format,
+		tcb::span<const std::byte> data
+	) override;
+	virtual void update_texture_settings(
+		Handle<GraphicsContext> ctx,
+		Handle<Texture> texture,
+		TextureWrapMode u_wrap,
+		TextureWrapMode v_wrap,
+		TextureFilterMode min,
+		TextureFilterMode mag
+	) override;
+	virtual Handle<UniformSet>
+	create_uniform_set(Handle<GraphicsContext> ctx, const CreateUniformSetInfo& info) override;
+	virtual Handle<BindingSet>
+	create_binding_set(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline, const CreateBindingSetInfo& info)
+		override;
+
+	virtual Handle<GraphicsContext> begin_graphics() override;
+	virtual void end_graphics(Handle<GraphicsContext> ctx) override;
+
+	// Graphics context functions
+	virtual void begin_default_render_pass(Handle<GraphicsContext> ctx, bool clear) override;
+	virtual void begin_render_pass(Handle<GraphicsContext> ctx, const RenderPassBeginInfo& info) override;
+	virtual void end_render_pass(Handle<GraphicsContext> ctx) override;
+	virtual void bind_pipeline(Handle<GraphicsContext> ctx, Handle<Pipeline> pipeline) override;
+	virtual void bind_uniform_set(Handle<GraphicsContext> ctx, uint32_t slot, Handle<UniformSet> set) override;
+	virtual void bind_binding_set(Handle<GraphicsContext> ctx, Handle<BindingSet> set) override;
+	virtual void bind_index_buffer(Handle<GraphicsContext> ctx, Handle<Buffer> buffer) override;
+	virtual void set_scissor(Handle<GraphicsContext> ctx, const Rect& rect) override;
+	virtual void set_viewport(Handle<GraphicsContext> ctx, const Rect& rect) override;
+	virtual void draw(Handle<GraphicsContext> ctx, uint32_t vertex_count, uint32_t first_vertex) override;
+	virtual void draw_indexed(Handle<GraphicsContext> ctx, uint32_t index_count, uint32_t first_index) override;
+	virtual void
+	read_pixels(Handle<GraphicsContext> ctx, const Rect& rect, PixelFormat format, tcb::span<std::byte> out) override;
+	virtual void copy_framebuffer_to_texture(
+		Handle<GraphicsContext> ctx,
+		Handle<Texture> dst_tex,
+		const Rect& dst_region,
+		const Rect& src_region
+	) override;
+	virtual void set_stencil_reference(Handle<GraphicsContext> ctx, CullMode face, uint8_t reference) override;
+	virtual void set_stencil_compare_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask) override;
+	virtual void set_stencil_write_mask(Handle<GraphicsContext> ctx, CullMode face, uint8_t mask) override;
+
+	virtual void present() override;
+
+	virtual void finish() override;
+};
+
+} // namespace srb2::rhi
+
+#endif // __SRB2_RHI_NULL_RHI_HPP__
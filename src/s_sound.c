@@ -59,6 +59,7 @@ static void Command_RestartAudio_f(void);
 static void Command_PlaySound(void);
 static void Got_PlaySound(const UINT8 **p, INT32 playernum);
 static void Command_MusicDef_f(void);
+static void Command_SoundBench_f(void);
 
 void Captioning_OnChange(void);
 void Captioning_OnChange(void)
@@ -194,6 +195,9 @@ static INT32 S_getChannel(const void *origin, sfxinfo_t *sfxinfo)
 
 void S_RegisterSoundStuff(void)
 {
+	// Renders offline, so this is also usable on dedicated servers and headless CI machines
+	COM_AddDebugCommand("soundbench", Command_SoundBench_f);
+
 	if (dedicated)
 	{
 		sound_disabled = true;
@@ -2436,6 +2440,34 @@ static void Command_RestartAudio_f(void)
 	S_AttemptToRestoreMusic();
 }
 
+#define SOUNDBENCH_MAXVOICES 1024
+
+static void Command_SoundBench_f(void)
+{
+	INT32 seconds = 10;
+	INT32 voices = 32;
+
+	if (COM_Argc() > 1)
+		seconds = atoi(COM_Argv(1));
+	if (COM_Argc() > 2)
+		voices = atoi(COM_Argv(2));
+
+	if (seconds <= 0 || voices <= 0)
+	{
+		CONS_Printf("soundbench [seconds] [voices]: Renders a synthetic mix offline and reports mixer timing.\n");
+		return;
+	}
+
+	// Every voice gets its own buffers
+	if (voices > SOUNDBENCH_MAXVOICES)
+	{
+		CONS_Printf("Only benchmarking %d voices.\n", SOUNDBENCH_MAXVOICES);
+		voices = SOUNDBENCH_MAXVOICES;
+	}
+
+	I_BenchmarkSoundMixer((UINT32)seconds, (UINT32)voices);
+}
+
 static void Command_PlaySound(void)
 {
 	const char *sound;
@@ -0,0 +1,351 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_lobby.cpp
+/// \brief Hosting several dedicated lobbies from one loaded process
+///
+/// Everything D_SRB2Main loads before networking starts (WADs, textures,
+/// skins, SOCs) never changes afterwards, so lobbies are forked off once it is
+/// done and share those pages copy-on-write with the supervisor.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined (__unix__) || defined (__APPLE__)
+#define HAVE_LOBBIES
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "../core/thread_pool.h"
+#include "../d_main.h"
+#include "../doomdef.h"
+#include "../g_game.h"
+#include "../i_lobby.h"
+#include "../m_argv.h"
+#include "../m_misc.h"
+
+#ifdef HAVE_LOBBIES
+
+// Same as DEFAULTPORT in i_tcp.c
+#define LOBBY_BASEPORT 5029
+
+// A lobby that goes down sooner than this after starting waits out the rest
+// before it's started again, so that one that can't get going doesn't spin.
+#define LOBBY_MINUPTIME 10
+
+// How often the supervisor reports memory use, in seconds
+#define LOBBY_REPORTINTERVAL 300
+
+struct lobby_t
+{
+	INT32 num;
+	pid_t pid;
+	time_t started;
+	time_t restartat;
+	boolean done;
+};
+
+static volatile sig_atomic_t lobbyquit = 0;
+static struct sigaction oldint, oldterm, oldchld;
+
+static void I_LobbyQuitHandler(int num)
+{
+	(void)num;
+	lobbyquit = 1;
+}
+
+static void I_LobbyChildHandler(int num)
+{
+	// Only here so the supervisor's sleep is cut short
+	(void)num;
+}
+
+static void I_SetLobbyArg(std::vector<char *> &args, const char *parm, const char *value)
+{
+	for (size_t i = 0; i + 1 < args.size(); i++)
+	{
+		if (!strcasecmp(args[i], parm))
+		{
+			args[i + 1] = strdup(value);
+			return;
+		}
+	}
+
+	args.push_back(strdup(parm));
+	args.push_back(strdup(value));
+}
+
+// Runs in the new process; gives it everything that can't be shared with the other lobbies.
+static void I_SetupLobby(INT32 num, INT32 baseport)
+{
+	char buf[MAX_WADPATH];
+
+#ifdef __linux__
+	// Don't outlive the supervisor
+	prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+
+	sigaction(SIGINT, &oldint, NULL);
+	sigaction(SIGTERM, &oldterm, NULL);
+	sigaction(SIGCHLD, &oldchld, NULL);
+
+	// The supervisor stopped its pool before forking
+	I_ThreadPoolInit();
+
+#ifdef LOGMESSAGES
+	if (logstream)
+	{
+		std::string name = logfilename;
+		size_t dot = name.rfind('.');
+		size_t sep = name.find_last_of("/\\");
+
+		if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+			dot = name.size();
+		name.insert(dot, "-lobby" + std::to_string(num));
+
+		fclose(logstream);
+		logstream = fopen(name.c_str(), "w");
+		strlcpy(logfilename, name.c_str(), sizeof logfilename);
+	}
+#endif
+
+	// New command line, so that -port reads as this lobby's
+	{
+		std::vector<char *> args(myargv, myargv + myargc);
+		I_SetLobbyArg(args, "-port", std::to_string(baseport + num - 1).c_str());
+		args.push_back(NULL);
+
+		char **argv = (char **)malloc(args.size() * sizeof (char *));
+		memcpy(argv, args.data(), args.size() * sizeof (char *));
+		myargc = (INT32)args.size() - 1;
+		myargv = argv;
+	}
+
+	snprintf(configfile, sizeof configfile, "%s" PATHSEP "lobby%d.cfg", srb2home, num);
+	configfile[sizeof configfile - 1] = '\0';
+
+	snprintf(buf, sizeof buf, "lobby%d-%s", num, gamedatafilename);
+	strlcpy(gamedatafilename, buf, sizeof gamedatafilename);
+}
+
+// @return true in the new lobby process
+static boolean I_ForkLobby(lobby_t &lobby, INT32 baseport)
+{
+	pid_t pid;
+
+	// Keep buffered output from being written twice
+	fflush(NULL);
+
+	pid = fork();
+	if (pid == 0)
+	{
+		I_SetupLobby(lobby.num, baseport);
+		return true;
+	}
+
+	if (pid < 0)
+	{
+		CONS_Alert(CONS_ERROR, "Lobby %d couldn't be started: %s\n", lobby.num, strerror(errno));
+		lobby.pid = 0;
+		lobby.restartat = time(NULL) + LOBBY_MINUPTIME;
+		return false;
+	}
+
+	CONS_Printf("Lobby %d started (pid %d, port %d)\n", lobby.num, (int)pid, baseport + lobby.num - 1);
+	lobby.pid = pid;
+	lobby.started = time(NULL);
+	lobby.restartat = 0;
+	return false;
+}
+
+// Private pages are the lobby's own; shared ones are still the loaded assets.
+static void I_ReportLobbyMemory(const std::vector<lobby_t> &lobbies)
+{
+	for (const lobby_t &lobby : lobbies)
+	{
+		char path[64];
+		char line[256];
+		unsigned long kb;
+		unsigned long shared = 0, priv = 0, pss = 0;
+		FILE *f;
+
+		if (!lobby.pid)
+			continue;
+
+		snprintf(path, sizeof path, "/proc/%d/smaps_rollup", (int)lobby.pid);
+		f = fopen(path, "r");
+		if (!f)
+		{
+			CONS_Printf("Lobby %d: memory use unavailable\n", lobby.num);
+			continue;
+		}
+
+		while (fgets(line, sizeof line, f))
+		{
+			if (sscanf(line, "Shared_Clean: %lu", &kb) == 1 || sscanf(line, "Shared_Dirty: %lu", &kb) == 1)
+				shared += kb;
+			else if (sscanf(line, "Private_Clean: %lu", &kb) == 1 || sscanf(line, "Private_Dirty: %lu", &kb) == 1)
+				priv += kb;
+			else if (sscanf(line, "Pss: %lu", &kb) == 1)
+				pss = kb;
+		}
+		fclose(f);
+
+		CONS_Printf("Lobby %d: %lu KB private, %lu KB shared, %lu KB proportional\n", lobby.num, priv, shared, pss);
+	}
+}
+
+INT32 I_StartLobbies(void)
+{
+	std::vector<lobby_t> lobbies;
+	INT32 count, baseport = LOBBY_BASEPORT;
+	time_t nextreport;
+	struct sigaction sa;
+
+	if (!dedicated || !M_CheckParm("-lobbies") || !M_IsNextParm())
+		return 0;
+
+	count = atoi(M_GetNextParm());
+	if (count < 1)
+		return 0;
+
+	if ((M_CheckParm("-port") || M_CheckParm("-serverport")) && M_IsNextParm())
+		baseport = atoi(M_GetNextParm());
+
+	memset(&sa, 0, sizeof sa);
+	sigemptyset(&sa.sa_mask);
+	sa.sa_handler = I_LobbyQuitHandler;
+	sigaction(SIGINT, &sa, &oldint);
+	sigaction(SIGTERM, &sa, &oldterm);
+	sa.sa_handler = I_LobbyChildHandler;
+	sa.sa_flags = SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &sa, &oldchld);
+
+	// Nothing may be half done in another thread when the lobbies are
+	// forked. Waiting for idle only drains the queues, so stop the pool
+	// outright: shutdown joins every worker, including any still running
+	// a task. The supervisor never needs it again, and each lobby starts
+	// its own.
+	I_ThreadPoolShutdown();
+
+	CONS_Printf("Hosting %d lobbies\n", count);
+
+	for (INT32 i = 1; i <= count; i++)
+	{
+		lobby_t lobby = {i, 0, 0, 0, false};
+		lobbies.push_back(lobby);
+		if (I_ForkLobby(lobbies.back(), baseport))
+			return i;
+	}
+
+	nextreport = time(NULL) + LOBBY_MINUPTIME;
+
+	for (;;)
+	{
+		boolean running = false;
+		time_t now;
+		pid_t pid;
+		int status;
+
+		while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+		{
+			for (lobby_t &lobby : lobbies)
+			{
+				if (lobby.pid != pid)
+					continue;
+
+				lobby.pid = 0;
+				if (lobbyquit || (WIFEXITED(status) && WEXITSTATUS(status) == 0))
+				{
+					CONS_Printf("Lobby %d quit\n", lobby.num);
+					lobby.done = true;
+				}
+				else
+				{
+					if (WIFSIGNALED(status))
+						CONS_Alert(CONS_WARNING, "Lobby %d died from signal %d\n", lobby.num, WTERMSIG(status));
+					else
+						CONS_Alert(CONS_WARNING, "Lobby %d exited with status %d\n", lobby.num, WEXITSTATUS(status));
+					lobby.restartat = lobby.started + LOBBY_MINUPTIME;
+				}
+			}
+		}
+
+		now = time(NULL);
+
+		for (lobby_t &lobby : lobbies)
+		{
+			if (lobby.done)
+				continue;
+
+			if (!lobby.pid && lobbyquit)
+			{
+				lobby.done = true;
+				continue;
+			}
+
+			if (!lobby.pid && now >= lobby.restartat)
+			{
+				if (I_ForkLobby(lobby, baseport))
+					return lobby.num;
+			}
+
+			running = true;
+		}
+
+		if (!running)
+			break;
+
+		if (lobbyquit == 1)
+		{
+			CONS_Printf("Shutting down lobbies\n");
+			for (const lobby_t &lobby : lobbies)
+			{
+				if (lobby.pid)
+					kill(lobby.pid, SIGTERM);
+			}
+			lobbyquit = 2;
+		}
+
+		if (now >= nextreport)
+		{
+			I_ReportLobbyMemory(lobbies);
+			nextreport = now + LOBBY_REPORTINTERVAL;
+		}
+
+		// SIGCHLD cuts this short
+		sleep(1);
+	}
+
+	CONS_Printf("All lobbies have quit\n");
+	fflush(NULL);
+	_exit(0);
+}
+
+#else
+
+INT32 I_StartLobbies(void)
+{
+	if (dedicated && M_CheckParm("-lobbies"))
+		CONS_Alert(CONS_WARNING, "-lobbies is not supported on this platform\n");
+	return 0;
+}
+
+#endif
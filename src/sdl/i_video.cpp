@@ -22,6 +22,7 @@
 
 #include "../rhi/rhi.hpp"
 #include "../rhi/gl2/gl2_rhi.hpp"
+#include "../rhi/null/null_rhi.hpp"
 #include "rhi_gl2_platform.hpp"
 
 #ifdef _MSC_VER
@@ -113,6 +114,8 @@ boolean allow_fullscreen = false;
 static SDL_bool disable_fullscreen = SDL_FALSE;
 #define USE_FULLSCREEN (disable_fullscreen||!allow_fullscreen)?0:cv_fullscreen.value
 static SDL_bool disable_mouse = SDL_FALSE;
+// Render through a device that draws nothing, so the game runs without a GPU
+static SDL_bool null_rhi = SDL_FALSE;
 #define USE_MOUSEINPUT (!disable_mouse && cv_usemouse.value && havefocus)
 #define MOUSE_MENU false //(!disable_mouse && cv_usemouse.value && menuactive && !USE_FULLSCREEN)
 #define MOUSEBUTTONS_MAX MOUSEBUTTONS
@@ -418,6 +421,17 @@ static void VID_Command_ModeList_f(void)
 
 }
 
+static void VID_Command_Bench2d_f (void)
+{
+	if (COM_Argc() > 2)
+	{
+		CONS_Printf(M_GetText("bench2d [iterations]: time the 2D renderer on the next frame\n"));
+		return;
+	}
+
+	I_BenchmarkTwodee(COM_Argc() == 2 ? atoi(COM_Argv(1)) : 100);
+}
+
 static void VID_Command_Mode_f (void)
 {
 	INT32 modenum;
@@ -1080,7 +1094,7 @@ void I_GetEvent(void)
 	}
 
 	// Send all relative mouse movement as one single mouse event.
-	if (mousemovex || mousemovey)
+	if (window && (mousemovex || mousemovey))
 	{
 		event_t event;
 		int wwidth, wheight;
@@ -1406,6 +1420,17 @@ static SDL_bool Impl_CreateContext(void)
 	}
 #endif
 
+	if (null_rhi)
+	{
+		init_imgui();
+		if (!g_rhi)
+		{
+			g_rhi = std::make_unique<rhi::NullRhi>();
+			g_rhi_generation += 1;
+		}
+		return SDL_TRUE;
+	}
+
 	// RHI always uses OpenGL 2.0 (for now)
 
 	if (!sdlglcontext)
@@ -1547,6 +1572,10 @@ static SDL_bool Impl_CreateWindow(SDL_bool fullscreen)
 	if (window != NULL)
 		return SDL_FALSE;
 
+	// The null RHI never presents anything, so it runs without a window
+	if (null_rhi && rendermode != render_opengl)
+		return Impl_CreateContext();
+
 	if (fullscreen)
 		flags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
 
@@ -1605,11 +1634,13 @@ void I_StartupGraphics(void)
 	COM_AddCommand ("vid_info", VID_Command_Info_f);
 	COM_AddCommand ("vid_modelist", VID_Command_ModeList_f);
 	COM_AddCommand ("vid_mode", VID_Command_Mode_f);
+	COM_AddCommand ("bench2d", VID_Command_Bench2d_f);
 	{
 		extern CVarList *cvlist_graphics_driver;
 		CV_RegisterList(cvlist_graphics_driver);
 	}
 	disable_mouse = static_cast<SDL_bool>(M_CheckParm("-nomouse"));
+	null_rhi = M_CheckParm("-nullrhi") ? SDL_TRUE : SDL_FALSE;
 	disable_fullscreen = M_CheckParm("-win") ? SDL_TRUE : SDL_FALSE;
 
 	keyboard_started = true;
@@ -1687,7 +1718,7 @@ void I_StartupGraphics(void)
 
 	VID_SetMode(VID_GetModeForSize(BASEVIDWIDTH, BASEVIDHEIGHT));
 
-	if (M_CheckParm("-nomousegrab"))
+	if (M_CheckParm("-nomousegrab") || window == NULL)
 		mousegrabok = SDL_FALSE;
 	realwidth = (Uint16)vid.width;
 	realheight = (Uint16)vid.height;
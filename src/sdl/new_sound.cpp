@@ -16,12 +16,14 @@
 #include <tracy/tracy/Tracy.hpp>
 
 #include "../audio/chunk_load.hpp"
+#include "../audio/dsp.hpp"
 #include "../audio/gain.hpp"
 #include "../audio/mixer.hpp"
 #include "../audio/music_player.hpp"
 #include "../audio/resample.hpp"
 #include "../audio/sound_chunk.hpp"
 #include "../audio/sound_effect_player.hpp"
+#include "../audio/voice_mixer.hpp"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
 
@@ -31,6 +33,7 @@
 
 #include "../doomdef.h"
 #include "../i_sound.h"
+#include "../i_system.h"
 #include "../s_sound.h"
 #include "../sounds.h"
 #include "../w_wad.h"
@@ -50,6 +53,7 @@ using srb2::audio::Sample;
 using srb2::audio::SoundChunk;
 using srb2::audio::SoundEffectPlayer;
 using srb2::audio::Source;
+using srb2::audio::VoiceMixer;
 using namespace srb2;
 using namespace srb2::io;
 
@@ -58,7 +62,7 @@ UINT8 sound_started = false;
 
 static unique_ptr<Gain<2>> master_gain;
 static shared_ptr<Mixer<2>> master;
-static shared_ptr<Mixer<2>> mixer_sound_effects;
+static shared_ptr<VoiceMixer> mixer_sound_effects;
 static shared_ptr<Mixer<2>> mixer_music;
 static shared_ptr<MusicPlayer> music_player;
 static shared_ptr<Resampler<2>> resample_music_player;
@@ -66,8 +70,6 @@ static shared_ptr<Gain<2>> gain_sound_effects;
 static shared_ptr<Gain<2>> gain_music_player;
 static shared_ptr<Gain<2>> gain_music_channel;
 
-static vector<shared_ptr<SoundEffectPlayer>> sound_effect_channels;
-
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 static shared_ptr<srb2::media::AVRecorder> av_recorder;
 #endif
@@ -102,13 +104,8 @@ void I_FreeSfx(sfxinfo_t* sfx)
 		auto _ = srb2::finally([chunk]() { delete chunk; });
 
 		// Stop any channels playing this chunk
-		for (auto& player : sound_effect_channels)
-		{
-			if (player->is_playing_chunk(chunk))
-			{
-				player->reset();
-			}
-		}
+		if (mixer_sound_effects)
+			mixer_sound_effects->stop_chunk(chunk);
 	}
 	sfx->data = nullptr;
 	sfx->lumpnum = LUMPERROR;
@@ -141,23 +138,14 @@ void audio_callback(void* userdata, Uint8* buffer, int len)
 		Sample<2>* float_buffer = reinterpret_cast<Sample<2>*>(buffer);
 		size_t float_len = len / 8;
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = Sample<2> {0.f, 0.f};
-		}
+		audio::dsp_zero(audio::sample_floats(float_buffer), float_len * 2);
 
 		if (!master_gain)
 			return;
 
 		master_gain->generate(tcb::span {float_buffer, float_len});
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = {
-				std::clamp(float_buffer[i].amplitudes[0], -1.f, 1.f),
-				std::clamp(float_buffer[i].amplitudes[1], -1.f, 1.f),
-			};
-		}
+		audio::dsp_clamp(audio::sample_floats(float_buffer), float_len * 2);
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 		if (av_recorder)
 			av_recorder->push_audio_samples(tcb::span {float_buffer, float_len});
@@ -202,7 +190,7 @@ void initialize_sound()
 		master_gain = make_unique<Gain<2>>();
 		master = make_shared<Mixer<2>>();
 		master_gain->bind(master);
-		mixer_sound_effects = make_shared<Mixer<2>>();
+		mixer_sound_effects = make_shared<VoiceMixer>(static_cast<size_t>(cv_numChannels.value));
 		mixer_music = make_shared<Mixer<2>>();
 		music_player = make_shared<MusicPlayer>();
 		resample_music_player = make_shared<Resampler<2>>(music_player, 1.f);
@@ -215,13 +203,6 @@ void initialize_sound()
 		master->add_source(gain_sound_effects);
 		master->add_source(gain_music_channel);
 		mixer_music->add_source(gain_music_player);
-		sound_effect_channels.clear();
-		for (size_t i = 0; i < static_cast<size_t>(cv_numChannels.value); i++)
-		{
-			shared_ptr<SoundEffectPlayer> player = make_shared<SoundEffectPlayer>();
-			sound_effect_channels.push_back(player);
-			mixer_sound_effects->add_source(player);
-		}
 	}
 
 	sound_started = true;
@@ -269,18 +250,21 @@ INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priori
 
 	SdlAudioLockHandle _;
 
-	if (channel >= 0 && static_cast<size_t>(channel) >= sound_effect_channels.size())
+	if (!mixer_sound_effects)
+		return -1;
+
+	if (channel >= 0 && static_cast<size_t>(channel) >= mixer_sound_effects->size())
 		return -1;
 
-	shared_ptr<SoundEffectPlayer> player_channel;
+	SoundEffectPlayer* player_channel = nullptr;
 	if (channel < 0)
 	{
 		// find a free sfx channel
-		for (size_t i = 0; i < sound_effect_channels.size(); i++)
+		for (size_t i = 0; i < mixer_sound_effects->size(); i++)
 		{
-			if (sound_effect_channels[i]->finished())
+			if ((*mixer_sound_effects)[i].finished())
 			{
-				player_channel = sound_effect_channels[i];
+				player_channel = &(*mixer_sound_effects)[i];
 				channel = i;
 				break;
 			}
@@ -288,7 +272,7 @@ INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priori
 	}
 	else
 	{
-		player_channel = sound_effect_channels[channel];
+		player_channel = &(*mixer_sound_effects)[channel];
 	}
 
 	if (!player_channel)
@@ -310,7 +294,7 @@ void I_StopSound(INT32 handle)
 {
 	SdlAudioLockHandle _;
 
-	if (sound_effect_channels.empty())
+	if (!mixer_sound_effects)
 		return;
 
 	if (handle < 0)
@@ -318,10 +302,10 @@ void I_StopSound(INT32 handle)
 
 	size_t index = handle;
 
-	if (index >= sound_effect_channels.size())
+	if (index >= mixer_sound_effects->size())
 		return;
 
-	sound_effect_channels[index]->reset();
+	(*mixer_sound_effects)[index].reset();
 }
 
 boolean I_SoundIsPlaying(INT32 handle)
@@ -329,7 +313,7 @@ boolean I_SoundIsPlaying(INT32 handle)
 	SdlAudioLockHandle _;
 
 	// Handle is channel index
-	if (sound_effect_channels.empty())
+	if (!mixer_sound_effects)
 		return 0;
 
 	if (handle < 0)
@@ -337,10 +321,10 @@ boolean I_SoundIsPlaying(INT32 handle)
 
 	size_t index = handle;
 
-	if (index >= sound_effect_channels.size())
+	if (index >= mixer_sound_effects->size())
 		return 0;
 
-	return sound_effect_channels[index]->finished() ? 0 : 1;
+	return (*mixer_sound_effects)[index].finished() ? 0 : 1;
 }
 
 void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
@@ -349,7 +333,7 @@ void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 
 	SdlAudioLockHandle _;
 
-	if (sound_effect_channels.empty())
+	if (!mixer_sound_effects)
 		return;
 
 	if (handle < 0)
@@ -357,15 +341,15 @@ void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 
 	size_t index = handle;
 
-	if (index >= sound_effect_channels.size())
+	if (index >= mixer_sound_effects->size())
 		return;
 
-	shared_ptr<SoundEffectPlayer>& channel = sound_effect_channels[index];
-	if (!channel->finished())
+	SoundEffectPlayer& channel = (*mixer_sound_effects)[index];
+	if (!channel.finished())
 	{
 		float vol_float = static_cast<float>(vol) / 255.f;
 		float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-		channel->update(vol_float, sep_float);
+		channel.update(vol_float, sep_float);
 	}
 }
 
@@ -818,9 +802,147 @@ boolean I_FadeInPlaySong(UINT32 ms, boolean looping)
 void I_UpdateAudioRecorder(void)
 {
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
-	// must be locked since av_recorder is used by audio_callback
+	{
+		// must be locked since av_recorder is used by audio_callback
+		SdlAudioLockHandle _;
+
+		av_recorder = g_av_recorder;
+	}
+
+	if (sound_started)
+	{
+		// Offline recordings are fed by I_RenderOfflineAudio, which pulls from the same graph as the callback
+		SDL_PauseAudio(av_recorder && av_recorder->offline() ? SDL_TRUE : SDL_FALSE);
+	}
+#endif
+}
+
+void I_RenderOfflineAudio(UINT32 tics)
+{
+#ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 	SdlAudioLockHandle _;
 
-	av_recorder = g_av_recorder;
+	if (!av_recorder || !av_recorder->offline() || !master_gain)
+		return;
+
+	static vector<Sample<2>> buffer;
+	buffer.resize(static_cast<size_t>(tics) * audio::kSampleRate / TICRATE);
+
+	// The game may be running far faster than realtime, so the music decoder has to be allowed to catch up
+	if (music_player)
+		music_player->wait_decoded();
+
+	audio::dsp_zero(audio::sample_floats(buffer.data()), buffer.size() * 2);
+	master_gain->generate(tcb::span {buffer});
+	audio::dsp_clamp(audio::sample_floats(buffer.data()), buffer.size() * 2);
+
+	av_recorder->push_audio_samples(tcb::span {buffer});
+#else
+	(void)tics;
 #endif
 }
+
+/// ------------------------
+//  MIXER BENCHMARK
+/// ------------------------
+
+namespace
+{
+
+class BenchmarkToneSource : public Source<2>
+{
+public:
+	explicit BenchmarkToneSource(float frequency) : step_(frequency / audio::kSampleRate) {}
+
+	virtual size_t generate(tcb::span<Sample<2>> buffer) override final
+	{
+		for (auto& sample : buffer)
+		{
+			float amplitude = std::sin(phase_ * 6.2831853f) * 0.25f;
+			sample = Sample<2> {amplitude, amplitude};
+			phase_ += step_;
+			phase_ -= std::floor(phase_);
+		}
+		return buffer.size();
+	}
+
+private:
+	float step_;
+	float phase_ {0.f};
+};
+
+} // namespace
+
+void I_BenchmarkSoundMixer(UINT32 seconds, UINT32 voices)
+{
+	// Everything here is local to the benchmark; the live audio graph and device are untouched.
+	constexpr size_t kNumChunks = 8;
+	vector<SoundChunk> chunks(kNumChunks);
+	for (size_t i = 0; i < kNumChunks; i++)
+	{
+		// Quarter-second to two-second chirps, so voices finish and restart at staggered times
+		size_t length = audio::kSampleRate / 4 * (i + 1);
+		float step = (220.f + 110.f * i) / audio::kSampleRate;
+		chunks[i].samples.resize(length);
+		for (size_t j = 0; j < length; j++)
+		{
+			chunks[i].samples[j] = Sample<1> {std::sin(j * step * 6.2831853f) * 0.5f};
+		}
+	}
+
+	auto bench_master = make_unique<Gain<2>>();
+	auto bench_mix = make_shared<Mixer<2>>();
+	auto bench_voices = make_shared<VoiceMixer>(voices);
+	auto bench_sfx_gain = make_shared<Gain<2>>();
+	auto bench_music = make_shared<Resampler<2>>(make_shared<BenchmarkToneSource>(440.f), 1.1f);
+	auto bench_music_gain = make_shared<Gain<2>>();
+	bench_master->bind(bench_mix);
+	bench_sfx_gain->bind(bench_voices);
+	bench_music_gain->bind(bench_music);
+	bench_mix->add_source(bench_sfx_gain);
+	bench_mix->add_source(bench_music_gain);
+	bench_master->gain(0.8f);
+	bench_sfx_gain->gain(0.9f);
+	bench_music_gain->gain(0.7f);
+
+	const size_t block_size = std::max(cv_soundmixingbuffersize.value, 64);
+	const size_t total_frames = static_cast<size_t>(seconds) * audio::kSampleRate;
+	vector<Sample<2>> block(block_size);
+
+	precise_t worst = 0;
+	size_t blocks = 0;
+	size_t starts = 0;
+	precise_t begin = I_GetPreciseTime();
+
+	for (size_t rendered = 0; rendered < total_frames; rendered += block_size)
+	{
+		precise_t block_begin = I_GetPreciseTime();
+
+		for (size_t i = 0; i < bench_voices->size(); i++)
+		{
+			SoundEffectPlayer& voice = (*bench_voices)[i];
+			if (voice.finished())
+			{
+				float sep = static_cast<float>(i % 7) / 3.f - 1.f;
+				voice.start(&chunks[(i + blocks) % kNumChunks], 0.5f, sep);
+				starts++;
+			}
+		}
+
+		bench_master->generate(tcb::span {block});
+		audio::dsp_clamp(audio::sample_floats(block.data()), block.size() * 2);
+
+		worst = std::max(worst, I_GetPreciseTime() - block_begin);
+		blocks++;
+	}
+
+	const double precision = static_cast<double>(I_GetPrecisePrecision());
+	const double elapsed = (I_GetPreciseTime() - begin) / precision;
+	const double block_seconds = static_cast<double>(block_size) / audio::kSampleRate;
+
+	CONS_Printf("soundbench: %u voices, %u seconds, %s blocks of %s frames, %s voice starts\n",
+		voices, seconds, sizeu1(blocks), sizeu2(block_size), sizeu3(starts));
+	CONS_Printf("  total %.3f ms (%.1fx realtime)\n", elapsed * 1000.0, elapsed > 0.0 ? seconds / elapsed : 0.0);
+	CONS_Printf("  block avg %.2f us, worst %.2f us, budget %.2f us\n",
+		blocks ? elapsed * 1e6 / blocks : 0.0, worst * 1e6 / precision, block_seconds * 1e6);
+}
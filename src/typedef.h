@@ -26,6 +26,9 @@ extern "C" {
 
 #define TYPEDEF(id) TYPEDEF2 (id, id)
 
+// acs/interface.h
+TYPEDEF (acsprofileinfo_t);
+
 // am_map.h
 TYPEDEF (fpoint_t);
 TYPEDEF (fline_t);
@@ -304,7 +307,6 @@ TYPEDEF (opening_t);
 
 // p_mobj.h
 TYPEDEF (mobj_t);
-TYPEDEF (precipmobj_t);
 TYPEDEF (actioncache_t);
 
 // p_polyobj.h
@@ -327,6 +329,10 @@ TYPEDEF (polyrotdisplacedata_t);
 TYPEDEF (polyflagdata_t);
 TYPEDEF (polyfadedata_t);
 
+// p_precip.h
+TYPEDEF (precipcell_t);
+TYPEDEF (precipsystem_t);
+
 // p_saveg.h
 TYPEDEF (savedata_t);
 TYPEDEF (savedata_cup_t);
@@ -397,7 +403,6 @@ TYPEDEF (line_t);
 TYPEDEF (side_t);
 TYPEDEF (subsector_t);
 TYPEDEF (msecnode_t);
-TYPEDEF (mprecipsecnode_t);
 TYPEDEF (lightmap_t);
 TYPEDEF (seg_t);
 
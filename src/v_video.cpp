@@ -15,7 +15,12 @@
 ///        Functions to blit a block to the screen.
 
 #include <cmath>
+#include <list>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <tracy/tracy/Tracy.hpp>
 
@@ -2524,41 +2529,143 @@ static UINT8 V_GetButtonCodeWidth(UINT8 c)
 	return x;
 }
 
-void V_DrawStringScaled(
-		fixed_t    x,
-		fixed_t    y,
+// Laying out a string walks every character through the font, color codes
+// and spacing, and HUD code measures and draws the same strings every frame.
+// So both go through a cache of laid out strings, keyed on everything the
+// layout depends on. Where one lands on screen, and what of it gets clipped,
+// is worked out as it's drawn.
+
+int ps_textlayout_hits = 0;
+int ps_textlayout_lookups = 0;
+
+namespace
+{
+
+struct TextGlyph
+{
+	fixed_t x, y; // from the string's origin, character offsets included
+	fixed_t pen; // where the pen was, for clipping at the right edge
+	fixed_t line; // top of the line, for clipping at the bottom
+	INT32 lineno;
+	INT32 dance; // counter for V_DanceYOffset, or -1 to stay put
+	INT32 color; // V_CHARCOLORMASK bits in effect
+	patch_t *patch; // nullptr for a button prompt
+	INT32 button_x, button_y;
+	Draw::Button button;
+	std::optional<bool> pressed;
+};
+
+struct TextLayout
+{
+	std::optional<fixed_t> width;
+	std::optional<std::vector<TextGlyph>> glyphs;
+};
+
+// Every flag that changes the layout, rather than how it's drawn
+constexpr INT32 kTextLayoutFlags = V_STRINGDANCE|V_SPACINGMASK|V_CHARCOLORMASK|V_FORCEUPPERCASE|V_NOSCALESTART;
+
+constexpr std::size_t kTextLayoutCacheSize = 1024;
+
+class TextLayoutCache
+{
+	using Entry = std::pair<std::string, TextLayout>;
+
+	std::list<Entry> entries_; // most recently used first
+	std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+
+public:
+	TextLayout& get(fixed_t scale, fixed_t spacescale, fixed_t lfscale, INT32 flags, int fontno, const char* s)
+	{
+		const bool noscalestart = (flags & V_NOSCALESTART);
+		const INT32 params[] = {
+			scale,
+			spacescale,
+			lfscale,
+			flags & kTextLayoutFlags,
+			fontno,
+			noscalestart ? vid.dupx : 0,
+			noscalestart ? vid.dupy : 0,
+		};
+
+		std::string key(s);
+		key.push_back('\0');
+		key.append(reinterpret_cast<const char*>(params), sizeof params);
+
+		// Keep the hit rate going without overflowing when nothing reads it
+		if (ps_textlayout_lookups >= (1 << 24))
+		{
+			ps_textlayout_lookups /= 2;
+			ps_textlayout_hits /= 2;
+		}
+
+		auto it = index_.find(key);
+		if (it != index_.end())
+		{
+			entries_.splice(entries_.begin(), entries_, it->second);
+			return it->second->second;
+		}
+
+		if (entries_.size() >= kTextLayoutCacheSize)
+		{
+			index_.erase(entries_.back().first);
+			entries_.pop_back();
+		}
+
+		entries_.emplace_front(std::move(key), TextLayout {});
+		index_.emplace(entries_.front().first, entries_.begin());
+		return entries_.front().second;
+	}
+
+	void clear()
+	{
+		index_.clear();
+		entries_.clear();
+	}
+};
+
+TextLayoutCache g_text_layouts;
+
+} // namespace
+
+void V_ClearStringLayouts(void)
+{
+	g_text_layouts.clear();
+}
+
+// Lays out a string at the origin, with nothing clipped; V_DrawStringScaled
+// places and clips it.
+static std::vector<TextGlyph> V_LayoutString(
 		fixed_t      scale,
 		fixed_t spacescale,
 		fixed_t    lfscale,
 		INT32      flags,
-		const UINT8 *colormap,
 		int        fontno,
 		const char *s)
 {
+	std::vector<TextGlyph> glyphs;
+
 	INT32     hchw;/* half-width for centering */
 
 	INT32     dupx;
 	INT32     dupy;
 
-	fixed_t  right;
-	fixed_t    bot;
-
 	font_t   *font;
 
 	boolean uppercase;
-	boolean notcolored;
 
 	boolean   dance;
 	boolean nodanceoverride;
 	INT32     dancecounter;
+	INT32     danceat;
+
+	INT32     color;
+	INT32     lineno;
 
 	fixed_t cx, cy;
 
-	fixed_t cxoff, cyoff;
+	fixed_t cxoff;
 	fixed_t cw;
 
-	fixed_t   left;
-
 	int c;
 
 	uppercase  = ((flags & V_FORCEUPPERCASE) == V_FORCEUPPERCASE);
@@ -2567,17 +2674,13 @@ void V_DrawStringScaled(
 	dance           = (flags & V_STRINGDANCE) != 0;
 	nodanceoverride = !dance;
 	dancecounter    = 0;
+	danceat        = -1;
 
 	/* Some of these flags get overloaded in this function so
 	   don't pass them on. */
 	flags &= ~(V_PARAMMASK);
 
-	if (colormap == NULL)
-	{
-		colormap   =  V_GetStringColormap(( flags & V_CHARCOLORMASK ));
-	}
-
-	notcolored = !colormap;
+	color      = ( flags & V_CHARCOLORMASK );
 
 	font       = &fontv[fontno];
 
@@ -2610,28 +2713,16 @@ void V_DrawStringScaled(
 		fontspec.chw      *=     dupx;
 		fontspec.spacew   *=     dupx;
 		fontspec.lfh      *=     dupy;
-
-		right     = vid.width;
 	}
 	else
 	{
 		dupx      = 1;
 		dupy      = 1;
-
-		right     = ( vid.width / vid.dupx );
-		if (!( flags & V_SNAPTOLEFT ))
-		{
-			left   = ( right - BASEVIDWIDTH )/ 2;/* left edge of drawable area */
-			right -= left;
-		}
 	}
 
-	right      <<=               FRACBITS;
-	bot          = vid.height << FRACBITS;
-
-	cx = x;
-	cy = y;
-	cyoff = 0;
+	cx = 0;
+	cy = 0;
+	lineno = 0;
 
 	for (; ( c = *s ); ++s, ++dancecounter)
 	{
@@ -2639,19 +2730,14 @@ void V_DrawStringScaled(
 		{
 			case '\n':
 				cy += fontspec.lfh;
-				if (cy >= bot)
-					return;
-				cx  =   x;
+				cx  =   0;
+				lineno++;
 				break;
 			default:
 				if (( c & 0xF0 ) == 0x80)
 				{
-					if (notcolored)
-					{
-						colormap = V_GetStringColormap(
-								( ( c & 0x7f )<< V_CHARCOLORSHIFT )&
-								V_CHARCOLORMASK);
-					}
+					color = ( ( c & 0x7f )<< V_CHARCOLORSHIFT )&
+							V_CHARCOLORMASK;
 					if (nodanceoverride)
 					{
 						dance = false;
@@ -2661,8 +2747,15 @@ void V_DrawStringScaled(
 				{
 					dance = true;
 				}
-				else if (cx < right)
+				else
 				{
+					TextGlyph glyph {};
+
+					glyph.pen    = cx;
+					glyph.line   = cy;
+					glyph.lineno = lineno;
+					glyph.color  = color;
+
 					if (uppercase)
 					{
 						c = toupper(c);
@@ -2683,9 +2776,11 @@ void V_DrawStringScaled(
 
 					if (dance)
 					{
-						cyoff = V_DanceYOffset(dancecounter) * FRACUNIT;
+						danceat = dancecounter;
 					}
 
+					glyph.dance = danceat;
+
 					if (( c & 0xB0 ) & 0x80) // button prompts
 					{
 						using srb2::Draw;
@@ -2739,11 +2834,13 @@ void V_DrawStringScaled(
 
 							cw = V_GetButtonCodeWidth(c) * dupx;
 							cxoff = (*fontspec.dim_fn)(scale, fontspec.chw, hchw, dupx, &cw);
-							Draw(
-								FixedToFloat(cx + cxoff) - (bt_inst->x * dupx),
-								FixedToFloat(cy + cyoff) - ((bt_inst->y + fontspec.button_yofs) * dupy))
-								.flags(flags)
-								.small_button(bt_inst->type, bt_translate_press());
+							glyph.x        = cx + cxoff;
+							glyph.y        = cy;
+							glyph.button_x = bt_inst->x * dupx;
+							glyph.button_y = (bt_inst->y + fontspec.button_yofs) * dupy;
+							glyph.button   = bt_inst->type;
+							glyph.pressed  = bt_translate_press();
+							glyphs.push_back(glyph);
 							cx += cw;
 						}
 						break;
@@ -2756,8 +2853,10 @@ void V_DrawStringScaled(
 						fixed_t patchxofs = SHORT (font->font[c]->leftoffset) * dupx * scale;
 						cw = SHORT (font->font[c]->width) * dupx;
 						cxoff = (*fontspec.dim_fn)(scale, fontspec.chw, hchw, dupx, &cw);
-						V_DrawFixedPatch(cx + cxoff + patchxofs, cy + cyoff, scale,
-								flags, font->font[c], colormap);
+						glyph.x     = cx + cxoff + patchxofs;
+						glyph.y     = cy;
+						glyph.patch = font->font[c];
+						glyphs.push_back(glyph);
 						cx += cw;
 					}
 					else
@@ -2765,9 +2864,110 @@ void V_DrawStringScaled(
 				}
 		}
 	}
+
+	return glyphs;
 }
 
-fixed_t V_StringScaledWidth(
+void V_DrawStringScaled(
+		fixed_t    x,
+		fixed_t    y,
+		fixed_t      scale,
+		fixed_t spacescale,
+		fixed_t    lfscale,
+		INT32      flags,
+		const UINT8 *colormap,
+		int        fontno,
+		const char *s)
+{
+	TextLayout &layout = g_text_layouts.get(scale, spacescale, lfscale, flags, fontno, s);
+
+	fixed_t  right;
+	fixed_t    bot;
+
+	fixed_t   left;
+
+	boolean notcolored;
+	INT32   color;
+
+	ps_textlayout_lookups++;
+
+	if (layout.glyphs)
+		ps_textlayout_hits++;
+	else
+		layout.glyphs = V_LayoutString(scale, spacescale, lfscale, flags, fontno, s);
+
+	flags	&= ~(V_FLIP);/* These two (V_FORCEUPPERCASE) share a bit. */
+
+	/* Some of these flags get overloaded in this function so
+	   don't pass them on. */
+	flags &= ~(V_PARAMMASK);
+
+	color      = ( flags & V_CHARCOLORMASK );
+
+	if (colormap == NULL)
+	{
+		colormap   =  V_GetStringColormap(color);
+	}
+
+	notcolored = !colormap;
+
+	if (( flags & V_NOSCALESTART ))
+	{
+		right     = vid.width;
+	}
+	else
+	{
+		right     = ( vid.width / vid.dupx );
+		if (!( flags & V_SNAPTOLEFT ))
+		{
+			left   = ( right - BASEVIDWIDTH )/ 2;/* left edge of drawable area */
+			right -= left;
+		}
+	}
+
+	right      <<=               FRACBITS;
+	bot          = vid.height << FRACBITS;
+
+	for (const TextGlyph &glyph : *layout.glyphs)
+	{
+		fixed_t cyoff = 0;
+
+		// Nothing past the bottom of the screen, nor the right edge
+		if (glyph.lineno > 0 && y + glyph.line >= bot)
+			return;
+
+		if (x + glyph.pen >= right)
+			continue;
+
+		if (notcolored && glyph.color != color)
+		{
+			color    = glyph.color;
+			colormap = V_GetStringColormap(color);
+		}
+
+		if (glyph.dance >= 0)
+		{
+			cyoff = V_DanceYOffset(glyph.dance) * FRACUNIT;
+		}
+
+		if (glyph.patch)
+		{
+			V_DrawFixedPatch(x + glyph.x, y + glyph.y + cyoff, scale,
+					flags, glyph.patch, colormap);
+		}
+		else
+		{
+			Draw(
+				FixedToFloat(x + glyph.x) - glyph.button_x,
+				FixedToFloat(y + glyph.y + cyoff) - glyph.button_y)
+				.flags(flags)
+				.small_button(glyph.button, glyph.pressed);
+		}
+	}
+}
+
+// What V_StringScaledWidth reports when the string isn't cached
+static fixed_t V_MeasureString(
 		fixed_t      scale,
 		fixed_t spacescale,
 		fixed_t    lfscale,
@@ -2892,6 +3092,26 @@ fixed_t V_StringScaledWidth(
 	return fullwidth;
 }
 
+fixed_t V_StringScaledWidth(
+		fixed_t      scale,
+		fixed_t spacescale,
+		fixed_t    lfscale,
+		INT32      flags,
+		int        fontno,
+		const char *s)
+{
+	TextLayout &layout = g_text_layouts.get(scale, spacescale, lfscale, flags, fontno, s);
+
+	ps_textlayout_lookups++;
+
+	if (layout.width)
+		ps_textlayout_hits++;
+	else
+		layout.width = V_MeasureString(scale, spacescale, lfscale, flags, fontno, s);
+
+	return *layout.width;
+}
+
 // Modify a string to wordwrap at any given width.
 char * V_ScaledWordWrap(
 		fixed_t          w,
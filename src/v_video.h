@@ -296,6 +296,13 @@ fixed_t V_StringScaledWidth(
 		int        fontno,
 		const char *s);
 
+// Both of the above go through a cache of laid out strings.
+// Clear it when font graphics are reloaded.
+void V_ClearStringLayouts(void);
+
+extern int ps_textlayout_hits;
+extern int ps_textlayout_lookups;
+
 char * V_ScaledWordWrap(
 		fixed_t          w,
 		fixed_t      scale,
@@ -43,6 +43,12 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -72,6 +78,7 @@
 #include "g_game.h" // G_SetGameModified
 
 #include "k_terrain.h"
+#include "core/thread_pool.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -1616,6 +1623,163 @@ void zerr(int ret)
 }
 #endif
 
+namespace
+{
+
+struct PrefetchedLump
+{
+	std::mutex mutex;
+	bool done = false;
+	std::vector<UINT8> data; // empty if it couldn't be read
+};
+
+// Main thread only; workers hold their own reference.
+std::unordered_map<lumpnum_t, std::shared_ptr<PrefetchedLump>> prefetchedlumps;
+
+// Runs on a worker: no zone memory, no console. Anything that
+// goes wrong is left for the ordinary read to report.
+std::vector<UINT8> W_ReadLumpFromDisk(const std::string &filename, unsigned long position, unsigned long disksize, size_t size, compmethod compression)
+{
+	std::vector<UINT8> raw(disksize);
+	std::vector<UINT8> data;
+	FILE *handle = fopen(filename.c_str(), "rb");
+
+	if (!handle)
+		return {};
+
+	if (fseek(handle, (long)position, SEEK_SET) != 0 || fread(raw.data(), 1, disksize, handle) < disksize)
+	{
+		fclose(handle);
+		return {};
+	}
+
+	fclose(handle);
+
+	switch (compression)
+	{
+	case CM_NOCOMPRESSION:
+		if (disksize != size)
+			return {};
+		return raw;
+#ifdef ZWAD
+	case CM_LZF:
+		data.resize(size);
+		if (lzf_decompress(raw.data(), disksize, data.data(), size) != size)
+			return {};
+		return data;
+#endif
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE:
+		{
+			z_stream strm = {};
+			int zErr;
+
+			data.resize(size);
+
+			strm.total_in = strm.avail_in = disksize;
+			strm.total_out = strm.avail_out = size;
+			strm.next_in = raw.data();
+			strm.next_out = data.data();
+
+			if (inflateInit2(&strm, -15) != Z_OK)
+				return {};
+			zErr = inflate(&strm, Z_SYNC_FLUSH);
+			(void)inflateEnd(&strm);
+
+			if ((zErr != Z_OK && zErr != Z_STREAM_END) || strm.total_out != size)
+				return {};
+			return data;
+		}
+#endif
+	default:
+		return {};
+	}
+}
+
+// Copies from a prefetched lump. If it's still being read, the main
+// thread works through the pool's queue meanwhile, as wait_idle does.
+boolean W_ReadPrefetchedLump(lumpnum_t lumpnum, void *dest, size_t size, size_t offset, size_t lumpsize)
+{
+	auto it = prefetchedlumps.find(lumpnum);
+
+	if (it == prefetchedlumps.end())
+		return false;
+
+	std::shared_ptr<PrefetchedLump> lump = it->second;
+
+	auto done = [&lump]
+	{
+		std::lock_guard<std::mutex> lock(lump->mutex);
+		return lump->done;
+	};
+
+	while (!done())
+	{
+		if (!srb2::g_main_threadpool || !srb2::g_main_threadpool->work_one())
+			std::this_thread::yield();
+	}
+
+	if (lump->data.size() != lumpsize)
+	{
+		prefetchedlumps.erase(it);
+		return false;
+	}
+
+	M_Memcpy(dest, lump->data.data() + offset, size);
+
+	// Read in full, so it's in the lump cache now
+	if (offset == 0 && size == lumpsize)
+		prefetchedlumps.erase(it);
+
+	return true;
+}
+
+}; // namespace
+
+void W_PrefetchLumps(const lumpnum_t *lumps, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		const UINT16 wad = WADFILENUM(lumps[i]);
+		const UINT16 lump = LUMPNUM(lumps[i]);
+		const lumpinfo_t *l;
+
+		if (!TestValidLump(wad, lump) || wadfiles[wad]->lumpcache[lump] || prefetchedlumps.count(lumps[i]))
+			continue;
+
+		l = wadfiles[wad]->lumpinfo + lump;
+
+		if (!l->size)
+			continue;
+
+		auto prefetched = std::make_shared<PrefetchedLump>();
+		prefetchedlumps.emplace(lumps[i], prefetched);
+
+		srb2::schedule_or_run(
+			[prefetched, filename = std::string(wadfiles[wad]->filename), position = l->position, disksize = l->disksize, size = l->size, compression = l->compression]()
+			{
+				std::vector<UINT8> data = W_ReadLumpFromDisk(filename, position, disksize, size, compression);
+
+				std::lock_guard<std::mutex> lock(prefetched->mutex);
+				prefetched->data = std::move(data);
+				prefetched->done = true;
+			}
+		);
+	}
+}
+
+void W_DropPrefetchedLump(lumpnum_t lumpnum)
+{
+	prefetchedlumps.erase(lumpnum);
+}
+
+void W_FlushPrefetchedLumps(void)
+{
+	prefetchedlumps.clear();
+}
+
 /** Reads bytes from the head of a lump.
   * Note: If the lump is compressed, the whole thing has to be read anyway.
   *
@@ -1645,6 +1809,16 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	if (!size || size+offset > lumpsize)
 		size = lumpsize - offset;
 
+	// Already read in the background
+	if (!prefetchedlumps.empty() && W_ReadPrefetchedLump((wad<<16) + lump, dest, size, offset, lumpsize))
+	{
+#ifdef NO_PNG_LUMPS
+		if (Picture_IsLumpPNG((UINT8 *)dest, size))
+			Picture_ThrowPNGError(wadfiles[wad]->lumpinfo[lump].fullname, wadfiles[wad]->filename);
+#endif
+		return size;
+	}
+
 	// Let's get the raw lump data.
 	// We setup the desired file handle to read the lump data.
 	l = wadfiles[wad]->lumpinfo + lump;
@@ -194,6 +194,12 @@ size_t W_ReadLumpHeader(lumpnum_t lump, void *dest, size_t size, size_t offest);
 void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest);
 void W_ReadLump(lumpnum_t lump, void *dest);
 
+// Reads and decompresses these lumps on the thread pool. Until flushed, or
+// read in full once, W_ReadLumpHeaderPwad copies them from memory instead.
+void W_PrefetchLumps(const lumpnum_t *lumps, size_t count);
+void W_DropPrefetchedLump(lumpnum_t lumpnum);
+void W_FlushPrefetchedLumps(void);
+
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);